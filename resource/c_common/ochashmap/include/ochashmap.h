@@ -0,0 +1,165 @@
+/* *****************************************************************
+ *
+ * Copyright 2017 Open Connectivity Foundation
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/**
+ * @file
+ *
+ * This file defines a generic open addressing hash map.
+ *
+ * The map stores key and value pointers only; it never copies or frees the
+ * memory they point to. A key must therefore stay valid and unchanged for as
+ * long as its entry is in the map. The usual pattern is to use a field of the
+ * value itself (e.g. a URI string or a token) as the key.
+ *
+ * The map is not thread safe; callers serialize access with their own lock.
+ */
+
+#ifndef OC_HASHMAP_H_
+#define OC_HASHMAP_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+typedef struct oc_hashmap_t *oc_hashmap;
+
+/**
+ * Computes the hash of a key.
+ */
+typedef uint32_t (*oc_hashmap_hash_func)(const void *key);
+
+/**
+ * Compares two keys.
+ *
+ * @return  true if both keys are equal.
+ */
+typedef bool (*oc_hashmap_equal_func)(const void *key1, const void *key2);
+
+/**
+ * Called for each entry by ::oc_hashmap_foreach.
+ *
+ * @return  false to stop the iteration.
+ */
+typedef bool (*oc_hashmap_visit_func)(const void *key, void *value, void *context);
+
+/**
+ * Creates a new hash map.
+ *
+ * @param[in]  hash   Hash function for the keys.
+ * @param[in]  equal  Equality function for the keys.
+ *
+ * @return  Reference to newly created map, NULL on allocation failure or invalid parameter.
+ */
+oc_hashmap oc_hashmap_new(oc_hashmap_hash_func hash, oc_hashmap_equal_func equal);
+
+/**
+ * Frees the hash map. Keys and values are not freed.
+ *
+ * @param[in]  map  Optional map to be freed.
+ */
+void oc_hashmap_free(oc_hashmap map);
+
+/**
+ * Inserts a value, replacing the value of an existing equal key.
+ *
+ * @param[in]  map    Map to insert into.
+ * @param[in]  key    Key of the entry; must outlive the entry.
+ * @param[in]  value  Value of the entry.
+ *
+ * @return  true on success, false on allocation failure or invalid parameter.
+ */
+bool oc_hashmap_put(oc_hashmap map, const void *key, void *value);
+
+/**
+ * Looks up a value.
+ *
+ * @param[in]  map  Map to search.
+ * @param[in]  key  Key to look for.
+ *
+ * @return  The value stored for @p key, NULL if not found.
+ */
+void *oc_hashmap_get(const oc_hashmap map, const void *key);
+
+/**
+ * Removes an entry.
+ *
+ * @param[in]  map  Map to remove from.
+ * @param[in]  key  Key of the entry.
+ *
+ * @return  The value that was stored for @p key, NULL if not found.
+ */
+void *oc_hashmap_remove(oc_hashmap map, const void *key);
+
+/**
+ * Removes all entries without shrinking the map.
+ *
+ * @param[in]  map  Map to clear.
+ */
+void oc_hashmap_clear(oc_hashmap map);
+
+/**
+ * Number of entries in the map.
+ *
+ * @param[in]  map  Map to query.
+ *
+ * @return  Number of entries, 0 if @p map is NULL.
+ */
+size_t oc_hashmap_size(const oc_hashmap map);
+
+/**
+ * Calls @p visit for each entry, in no particular order. The map must not be
+ * modified during the iteration.
+ *
+ * @param[in]  map      Map to iterate.
+ * @param[in]  visit    Callback invoked for each entry.
+ * @param[in]  context  Opaque pointer passed to @p visit.
+ */
+void oc_hashmap_foreach(const oc_hashmap map, oc_hashmap_visit_func visit, void *context);
+
+/**
+ * FNV-1a hash of a memory block. Helper for composite keys.
+ *
+ * @param[in]  data  Data to hash.
+ * @param[in]  size  Size of @p data in bytes.
+ * @param[in]  seed  Previous hash to chain with, or 0.
+ */
+uint32_t oc_hashmap_hash_bytes(const void *data, size_t size, uint32_t seed);
+
+/** Hash function for NUL terminated string keys. */
+uint32_t oc_hashmap_hash_string(const void *key);
+
+/** Equality function for NUL terminated string keys. */
+bool oc_hashmap_equal_string(const void *key1, const void *key2);
+
+/** Hash function for keys compared by address. */
+uint32_t oc_hashmap_hash_pointer(const void *key);
+
+/** Equality function for keys compared by address. */
+bool oc_hashmap_equal_pointer(const void *key1, const void *key2);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* OC_HASHMAP_H_ */
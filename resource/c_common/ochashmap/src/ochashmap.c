@@ -0,0 +1,290 @@
+/* *****************************************************************
+ *
+ * Copyright 2017 Open Connectivity Foundation
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/**
+ * @file
+ * This file implements a linear probing hash map with backward shift deletion,
+ * so lookups never have to skip over tombstones.
+ */
+
+#include "ochashmap.h"
+#include "oic_malloc.h"
+#include "logger.h"
+
+#include <string.h>
+
+/**
+ * TAG
+ * Logging tag for module name
+ */
+#define TAG "OIC_HASHMAP"
+
+/** Initial number of slots; must be a power of two. */
+#define OC_HASHMAP_INITIAL_CAPACITY (16)
+
+#define FNV_OFFSET_BASIS (2166136261u)
+#define FNV_PRIME        (16777619u)
+
+typedef struct
+{
+    /* Key of the entry, NULL for an empty slot. */
+    const void *key;
+    /* Value of the entry. */
+    void *value;
+    /* Cached hash of the key. */
+    uint32_t hash;
+} oc_hashmap_slot_t;
+
+typedef struct oc_hashmap_t
+{
+    oc_hashmap_hash_func hash;
+    oc_hashmap_equal_func equal;
+    oc_hashmap_slot_t *slots;
+    /* Number of slots; always a power of two. */
+    size_t capacity;
+    /* Number of used slots. */
+    size_t size;
+} oc_hashmap_t;
+
+static bool oc_hashmap_find_slot(const oc_hashmap map, const void *key, uint32_t hash,
+                                 size_t *index)
+{
+    size_t mask = map->capacity - 1;
+    for (size_t i = hash & mask; map->slots[i].key; i = (i + 1) & mask)
+    {
+        if ((map->slots[i].hash == hash) && map->equal(map->slots[i].key, key))
+        {
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void oc_hashmap_insert_slot(oc_hashmap_slot_t *slots, size_t capacity,
+                                   const oc_hashmap_slot_t *slot)
+{
+    size_t mask = capacity - 1;
+    size_t i = slot->hash & mask;
+    while (slots[i].key)
+    {
+        i = (i + 1) & mask;
+    }
+    slots[i] = *slot;
+}
+
+static bool oc_hashmap_resize(oc_hashmap map, size_t capacity)
+{
+    oc_hashmap_slot_t *slots = (oc_hashmap_slot_t *)OICCalloc(capacity, sizeof(oc_hashmap_slot_t));
+    if (!slots)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to grow oc_hashmap");
+        return false;
+    }
+
+    for (size_t i = 0; i < map->capacity; i++)
+    {
+        if (map->slots[i].key)
+        {
+            oc_hashmap_insert_slot(slots, capacity, &map->slots[i]);
+        }
+    }
+
+    OICFree(map->slots);
+    map->slots = slots;
+    map->capacity = capacity;
+    return true;
+}
+
+oc_hashmap oc_hashmap_new(oc_hashmap_hash_func hash, oc_hashmap_equal_func equal)
+{
+    if (!hash || !equal)
+    {
+        return NULL;
+    }
+
+    oc_hashmap map = (oc_hashmap)OICCalloc(1, sizeof(oc_hashmap_t));
+    if (!map)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to allocate oc_hashmap");
+        return NULL;
+    }
+
+    map->slots = (oc_hashmap_slot_t *)OICCalloc(OC_HASHMAP_INITIAL_CAPACITY,
+                                                sizeof(oc_hashmap_slot_t));
+    if (!map->slots)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to allocate oc_hashmap slots");
+        OICFree(map);
+        return NULL;
+    }
+
+    map->hash = hash;
+    map->equal = equal;
+    map->capacity = OC_HASHMAP_INITIAL_CAPACITY;
+    map->size = 0;
+    return map;
+}
+
+void oc_hashmap_free(oc_hashmap map)
+{
+    if (map)
+    {
+        OICFree(map->slots);
+        OICFree(map);
+    }
+}
+
+bool oc_hashmap_put(oc_hashmap map, const void *key, void *value)
+{
+    if (!map || !key)
+    {
+        return false;
+    }
+
+    uint32_t hash = map->hash(key);
+    size_t index = 0;
+    if (oc_hashmap_find_slot(map, key, hash, &index))
+    {
+        map->slots[index].key = key;
+        map->slots[index].value = value;
+        return true;
+    }
+
+    // Keep the load factor at or below 3/4.
+    if ((map->size + 1) * 4 > map->capacity * 3)
+    {
+        if (!oc_hashmap_resize(map, map->capacity * 2))
+        {
+            return false;
+        }
+    }
+
+    oc_hashmap_slot_t slot = { key, value, hash };
+    oc_hashmap_insert_slot(map->slots, map->capacity, &slot);
+    map->size++;
+    return true;
+}
+
+void *oc_hashmap_get(const oc_hashmap map, const void *key)
+{
+    size_t index = 0;
+    if (map && key && oc_hashmap_find_slot(map, key, map->hash(key), &index))
+    {
+        return map->slots[index].value;
+    }
+    return NULL;
+}
+
+void *oc_hashmap_remove(oc_hashmap map, const void *key)
+{
+    size_t index = 0;
+    if (!map || !key || !oc_hashmap_find_slot(map, key, map->hash(key), &index))
+    {
+        return NULL;
+    }
+
+    void *value = map->slots[index].value;
+    size_t mask = map->capacity - 1;
+    size_t hole = index;
+
+    // Shift back every following entry of the probe run that may legally occupy the hole.
+    for (size_t i = (hole + 1) & mask; map->slots[i].key; i = (i + 1) & mask)
+    {
+        size_t home = map->slots[i].hash & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            map->slots[hole] = map->slots[i];
+            hole = i;
+        }
+    }
+
+    memset(&map->slots[hole], 0, sizeof(oc_hashmap_slot_t));
+    map->size--;
+    return value;
+}
+
+void oc_hashmap_clear(oc_hashmap map)
+{
+    if (map)
+    {
+        memset(map->slots, 0, map->capacity * sizeof(oc_hashmap_slot_t));
+        map->size = 0;
+    }
+}
+
+size_t oc_hashmap_size(const oc_hashmap map)
+{
+    return map ? map->size : 0;
+}
+
+void oc_hashmap_foreach(const oc_hashmap map, oc_hashmap_visit_func visit, void *context)
+{
+    if (!map || !visit)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < map->capacity; i++)
+    {
+        if (map->slots[i].key && !visit(map->slots[i].key, map->slots[i].value, context))
+        {
+            return;
+        }
+    }
+}
+
+uint32_t oc_hashmap_hash_bytes(const void *data, size_t size, uint32_t seed)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint32_t hash = seed ? seed : FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint32_t oc_hashmap_hash_string(const void *key)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (const uint8_t *c = (const uint8_t *)key; *c; c++)
+    {
+        hash ^= *c;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+bool oc_hashmap_equal_string(const void *key1, const void *key2)
+{
+    return 0 == strcmp((const char *)key1, (const char *)key2);
+}
+
+uint32_t oc_hashmap_hash_pointer(const void *key)
+{
+    uintptr_t value = (uintptr_t)key;
+    return oc_hashmap_hash_bytes(&value, sizeof(value), 0);
+}
+
+bool oc_hashmap_equal_pointer(const void *key1, const void *key2)
+{
+    return key1 == key2;
+}
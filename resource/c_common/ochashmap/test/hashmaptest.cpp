@@ -0,0 +1,140 @@
+/* *****************************************************************
+ *
+ * Copyright 2017 Open Connectivity Foundation
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/**
+ * @file
+ *
+ * This file implement tests for the hash map.
+ */
+
+#include "ochashmap.h"
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+class HashMapTester : public testing::Test
+{
+  protected:
+    virtual void SetUp()
+    {
+        m_map = oc_hashmap_new(oc_hashmap_hash_string, oc_hashmap_equal_string);
+        ASSERT_TRUE(nullptr != m_map);
+    }
+    virtual void TearDown()
+    {
+        oc_hashmap_free(m_map);
+    }
+    oc_hashmap m_map;
+};
+
+static bool CountEntries(const void *, void *, void *context)
+{
+    (*(size_t *)context)++;
+    return true;
+}
+
+TEST(HashMapCreate, InvalidParams)
+{
+    EXPECT_EQ(nullptr, oc_hashmap_new(nullptr, oc_hashmap_equal_string));
+    EXPECT_EQ(nullptr, oc_hashmap_new(oc_hashmap_hash_string, nullptr));
+    oc_hashmap_free(nullptr);
+    EXPECT_EQ(0u, oc_hashmap_size(nullptr));
+}
+
+TEST_F(HashMapTester, PutGetRemove)
+{
+    int one = 1;
+    int two = 2;
+    EXPECT_TRUE(oc_hashmap_put(m_map, "/a/light", &one));
+    EXPECT_TRUE(oc_hashmap_put(m_map, "/a/fan", &two));
+    EXPECT_EQ(2u, oc_hashmap_size(m_map));
+
+    std::string key("/a/light");
+    EXPECT_EQ(&one, oc_hashmap_get(m_map, key.c_str()));
+    EXPECT_EQ(&two, oc_hashmap_get(m_map, "/a/fan"));
+    EXPECT_EQ(nullptr, oc_hashmap_get(m_map, "/a/door"));
+
+    EXPECT_EQ(&one, oc_hashmap_remove(m_map, "/a/light"));
+    EXPECT_EQ(nullptr, oc_hashmap_get(m_map, "/a/light"));
+    EXPECT_EQ(nullptr, oc_hashmap_remove(m_map, "/a/light"));
+    EXPECT_EQ(1u, oc_hashmap_size(m_map));
+}
+
+TEST_F(HashMapTester, PutReplacesExistingKey)
+{
+    int one = 1;
+    int two = 2;
+    EXPECT_TRUE(oc_hashmap_put(m_map, "/a/light", &one));
+    EXPECT_TRUE(oc_hashmap_put(m_map, "/a/light", &two));
+    EXPECT_EQ(1u, oc_hashmap_size(m_map));
+    EXPECT_EQ(&two, oc_hashmap_get(m_map, "/a/light"));
+}
+
+TEST_F(HashMapTester, GrowAndRemoveKeepsAllEntriesReachable)
+{
+    const size_t count = 5000;
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        keys.push_back("/res/" + std::to_string(i));
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        ASSERT_TRUE(oc_hashmap_put(m_map, keys[i].c_str(), &keys[i]));
+    }
+    EXPECT_EQ(count, oc_hashmap_size(m_map));
+
+    // Removing every other key exercises the backward shift of probe runs.
+    for (size_t i = 0; i < count; i += 2)
+    {
+        EXPECT_EQ(&keys[i], oc_hashmap_remove(m_map, keys[i].c_str()));
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        EXPECT_EQ((i % 2) ? &keys[i] : nullptr, oc_hashmap_get(m_map, keys[i].c_str()));
+    }
+
+    size_t visited = 0;
+    oc_hashmap_foreach(m_map, CountEntries, &visited);
+    EXPECT_EQ(count / 2, visited);
+
+    oc_hashmap_clear(m_map);
+    EXPECT_EQ(0u, oc_hashmap_size(m_map));
+    EXPECT_EQ(nullptr, oc_hashmap_get(m_map, keys[1].c_str()));
+}
+
+TEST(HashMapPointer, PointerKeys)
+{
+    oc_hashmap map = oc_hashmap_new(oc_hashmap_hash_pointer, oc_hashmap_equal_pointer);
+    ASSERT_TRUE(nullptr != map);
+
+    int values[64];
+    for (int i = 0; i < 64; i++)
+    {
+        EXPECT_TRUE(oc_hashmap_put(map, &values[i], &values[i]));
+    }
+    for (int i = 0; i < 64; i++)
+    {
+        EXPECT_EQ(&values[i], oc_hashmap_get(map, &values[i]));
+    }
+    int other = 0;
+    EXPECT_EQ(nullptr, oc_hashmap_get(map, &other));
+    oc_hashmap_free(map);
+}
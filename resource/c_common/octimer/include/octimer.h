@@ -20,7 +20,11 @@
 
 /**
  * @file
- * Time value functions.
+ * Time value functions and timers.
+ *
+ * Timers are kept in a heap ordered by expiry time and expire with millisecond
+ * resolution on a single timer thread, which sleeps until the earliest one is due.
+ * There is no limit on the number of pending timers.
  */
 
 #ifndef OCTIMER_H_
@@ -41,6 +45,8 @@ extern "C"
 #endif
 
 #include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 #ifndef WITH_ARDUINO
 #define SECS_PER_MIN  (60L)
@@ -81,8 +87,57 @@ time_t getRelativeIntervalOfWeek(struct tm *tp);
 time_t getSecondsFromAbsTime(struct tm *tp);
 
 int initThread();
+
+/**
+ * Starts the timer thread if it is not running yet, like ::initThread.
+ * Returns right away; the timers are run by the timer thread, not by the caller.
+ */
 void *loop(void *threadid);
+
+/**
+ * Schedules a timer. The timer thread is started by the first call.
+ *
+ * @param[in] timeoutMs  time until the timer expires, in milliseconds.
+ * @param[in] cb         function called on the timer thread when the timer expires.
+ *                       It may schedule and cancel timers; while it runs, later timers wait.
+ * @param[in] ctx        parameter passed to cb.
+ * @return id of the timer for ::oc_timer_cancel, -1 on failure.
+ */
+int OC_CALL oc_timer_schedule(uint64_t timeoutMs, TimerCallback cb, void *ctx);
+
+/**
+ * Cancels a pending timer. Does not wait for a callback that is already running.
+ *
+ * @param[in] id  id returned by ::oc_timer_schedule.
+ * @return true if the timer was pending and will not expire,
+ *         false if it already expired or is unknown.
+ */
+bool OC_CALL oc_timer_cancel(int id);
+
+/**
+ * Stops the timer thread, waits for it to end and drops the pending timers
+ * without calling them. The next scheduled timer starts the thread again.
+ * Must not be called from a timer callback, nor while timers are being scheduled
+ * or cancelled on other threads.
+ */
+void OC_CALL oc_timer_stop(void);
+
+/**
+ * Schedules a timer with a timeout in seconds, see ::oc_timer_schedule.
+ *
+ * @param[in]  seconds  time until the timer expires; must be positive.
+ * @param[out] id       id of the timer for ::unregisterTimer.
+ * @param[in]  cb       function called when the timer expires.
+ * @param[in]  ctx      parameter passed to cb.
+ * @return the time the timer expires, -1 on failure.
+ */
 time_t OC_CALL registerTimer(const time_t seconds, int *id, TimerCallback cb, void *ctx);
+
+/**
+ * Cancels a timer scheduled with ::registerTimer, see ::oc_timer_cancel.
+ *
+ * @param[in] id  id of the timer.
+ */
 void OC_CALL unregisterTimer(int id);
 
 #else
@@ -26,9 +26,6 @@
 #ifdef HAVE_WINDOWS_H
 #include <windows.h>
 #endif
-#ifdef HAVE_PTHREAD_H
-#include <pthread.h>
-#endif
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
@@ -48,15 +45,63 @@
 
 #define SECOND (1)
 
+#ifndef WITH_ARDUINO
+#include <limits.h>
+
+#include "ocatomic.h"
+#include "ochashmap.h"
+#include "octhread.h"
+#include "oic_malloc.h"
+#include "oic_time.h"
+#include "logger.h"
+
+#define TAG "OIC_TIMER"
+
+/** Initial capacity of the timer heap. */
+#define TIMER_HEAP_INITIAL_CAPACITY 16
+
+/** A pending timer. */
+typedef struct
+{
+    int id;                 /**< id returned to the caller. */
+    uint64_t dueTime;       /**< time the timer expires. in milliseconds. */
+    uint64_t sequence;      /**< order of scheduling, to expire timers due together in order. */
+    TimerCallback cb;       /**< function called when the timer expires. */
+    void *ctx;              /**< parameter of cb. */
+    size_t heapIndex;       /**< position in the timer heap. */
+} OCTimerEntry_t;
+
+/** Initialization state of the timer service: 0 none, 1 in progress, 2 done. */
+static volatile int32_t g_timerState = 0;
+
+/** Protects all of the timer state below. */
+static oc_mutex g_timerMutex = NULL;
+
+/** Wakes up the timer thread when an earlier timer is scheduled. */
+static oc_cond g_timerCond = NULL;
+
+/** Thread calling the timer callbacks. */
+static oc_thread g_timerThread = NULL;
+
+/** Set by ::oc_timer_stop to end the timer thread. */
+static bool g_timerStop = false;
+
+/** Pending timers; a binary min-heap ordered by due time. */
+static OCTimerEntry_t **g_timerHeap = NULL;
+static size_t g_timerCount = 0;
+static size_t g_timerCapacity = 0;
+
+/** Pending timers by id. */
+static oc_hashmap g_timersById = NULL;
+
+static int g_nextTimerId = 0;
+static uint64_t g_nextTimerSequence = 0;
+#else
 #define TIMEOUTS 10
 
 #define TIMEOUT_USED   1
 #define TIMEOUT_UNUSED  2
 
-#ifndef WITH_ARDUINO
-pthread_t thread_id = 0; // 0: initial thread id (meaningless)
-#endif
-
 struct timelist_t
 {
     int timeout_state;
@@ -65,6 +110,7 @@ struct timelist_t
     TimerCallback cb;
     void *ctx;
 } timeout_list[TIMEOUTS];
+#endif
 
 time_t timespec_diff(const time_t after, const time_t before)
 {
@@ -155,119 +201,350 @@ time_t getSecondsFromAbsTime(struct tm *tp)
     return delayed_time;
 }
 
-time_t OC_CALL registerTimer(const time_t seconds, int *id, TimerCallback cb, void *ctx)
+static uint32_t HashTimerId(const void *key)
 {
-    time_t now, then;
-    time_t next;
-    int i, idx;
+    return oc_hashmap_hash_bytes(key, sizeof(int), 0);
+}
 
-    if (0 == thread_id)
-    {
-        initThread();
-    }
+static bool EqualTimerId(const void *key1, const void *key2)
+{
+    return *(const int *)key1 == *(const int *)key2;
+}
 
-    if (seconds <= 0)
-        return -1 ;
+static bool TimerBefore(const OCTimerEntry_t *timer1, const OCTimerEntry_t *timer2)
+{
+    return (timer1->dueTime < timer2->dueTime)
+           || (timer1->dueTime == timer2->dueTime && timer1->sequence < timer2->sequence);
+}
 
-    // get the current time
-    time(&now);
+static void SetTimerAt(size_t index, OCTimerEntry_t *timer)
+{
+    g_timerHeap[index] = timer;
+    timer->heapIndex = index;
+}
 
-    for (idx = 0; idx < TIMEOUTS; ++idx)
-        if (!((timeout_list[idx].timeout_state & TIMEOUT_USED) & TIMEOUT_USED))
+static void SiftTimerUp(size_t index)
+{
+    OCTimerEntry_t *timer = g_timerHeap[index];
+    while (index > 0)
+    {
+        size_t parent = (index - 1) / 2;
+        if (!TimerBefore(timer, g_timerHeap[parent]))
+        {
             break;
+        }
+        SetTimerAt(index, g_timerHeap[parent]);
+        index = parent;
+    }
+    SetTimerAt(index, timer);
+}
 
-    if (TIMEOUTS == idx) // reach to end of timer list
-        return -1;
+static void SiftTimerDown(size_t index)
+{
+    OCTimerEntry_t *timer = g_timerHeap[index];
+    for (;;)
+    {
+        size_t child = 2 * index + 1;
+        if (child >= g_timerCount)
+        {
+            break;
+        }
+        if (child + 1 < g_timerCount && TimerBefore(g_timerHeap[child + 1], g_timerHeap[child]))
+        {
+            child++;
+        }
+        if (!TimerBefore(g_timerHeap[child], timer))
+        {
+            break;
+        }
+        SetTimerAt(index, g_timerHeap[child]);
+        index = child;
+    }
+    SetTimerAt(index, timer);
+}
 
-    // idx th timeout will be used.
-    // Reset and set state of the timer
-    timeout_list[idx].timeout_state = 0;
-    timeout_list[idx].timeout_state |= TIMEOUT_USED;
+/* Takes a timer out of the heap and the id map. Called with g_timerMutex held. */
+static void RemoveTimer(OCTimerEntry_t *timer)
+{
+    size_t index = timer->heapIndex;
+    g_timerCount--;
+    if (index < g_timerCount)
+    {
+        OCTimerEntry_t *moved = g_timerHeap[g_timerCount];
+        SetTimerAt(index, moved);
+        SiftTimerDown(index);
+        SiftTimerUp(moved->heapIndex);
+    }
+    g_timerHeap[g_timerCount] = NULL;
+    oc_hashmap_remove(g_timersById, &timer->id);
+}
 
-    // calculate when the timeout should fire
-    then = now;
-    timespec_add(&then, seconds);
+/*
+ * Calls the callbacks of the timers that are due. Called with g_timerMutex held;
+ * the mutex is released around each callback, so that it can schedule or cancel timers.
+ */
+static void RunDueTimers(void)
+{
+    while (g_timerCount > 0)
+    {
+        OCTimerEntry_t *timer = g_timerHeap[0];
+        if (timer->dueTime > OICGetCurrentTime(TIME_IN_MS))
+        {
+            break;
+        }
 
-    timeout_list[idx].timeout_time = then;
-    timeout_list[idx].timeout_seconds = seconds;
-    timeout_list[idx].ctx = ctx;
+        RemoveTimer(timer);
+        oc_mutex_unlock(g_timerMutex);
+        if (timer->cb)
+        {
+            timer->cb(timer->ctx);
+        }
+        OICFree(timer);
+        oc_mutex_lock(g_timerMutex);
+    }
+}
 
-    // printf( "\nbefore timeout_list[idx].cb = %X\n", timeout_list[idx].cb);
-    timeout_list[idx].cb = cb;
-    // printf( " after timeout_list[idx].cb = %X\n", timeout_list[idx].cb);
+static void *TimerThread(void *arg)
+{
+    (void)arg;
 
-    // How long till the next timeout?
-    next = seconds;
-    for (i = 0; i < TIMEOUTS; i++)
+    oc_mutex_lock(g_timerMutex);
+    while (!g_timerStop)
     {
-        if ((timeout_list[i].timeout_state & (TIMEOUT_USED | TIMEOUT_UNUSED)) == TIMEOUT_USED)
+        RunDueTimers();
+        if (g_timerStop)
+        {
+            break;
+        }
+        if (0 == g_timerCount)
         {
-            const time_t secs = timespec_diff(timeout_list[i].timeout_time, now);
+            oc_cond_wait(g_timerCond, g_timerMutex);
+            continue;
+        }
 
-            if (secs >= 0 && secs < next)
-                next = secs;
+        uint64_t currentTime = OICGetCurrentTime(TIME_IN_MS);
+        uint64_t dueTime = g_timerHeap[0]->dueTime;
+        if (dueTime > currentTime)
+        {
+            oc_cond_wait_for(g_timerCond, g_timerMutex, (dueTime - currentTime) * US_PER_MS);
         }
     }
-
-    *id = idx;
-    /* Return the timeout number. */
-    return timeout_list[idx].timeout_time;
+    oc_mutex_unlock(g_timerMutex);
+    return NULL;
 }
 
-void OC_CALL unregisterTimer(int idx)
+/* Creates the timer state and thread once. */
+static bool InitTimers(void)
 {
-    if (0 <= idx && idx < TIMEOUTS)
-        timeout_list[idx].timeout_state = TIMEOUT_UNUSED;
+    if (2 == oc_atomic_or(&g_timerState, 0))
+    {
+        return true;
+    }
+
+    if (!oc_atomic_cmpxchg(&g_timerState, 0, 1))
+    {
+        // Another thread initializes the timers.
+        int32_t state;
+        while (1 == (state = oc_atomic_or(&g_timerState, 0)))
+        {
+        }
+        return (2 == state);
+    }
+
+    g_timerMutex = oc_mutex_new();
+    g_timerCond = oc_cond_new();
+    g_timersById = oc_hashmap_new(HashTimerId, EqualTimerId);
+    g_timerStop = false;
+    if (g_timerMutex && g_timerCond && g_timersById
+        && (OC_THREAD_SUCCESS == oc_thread_new(&g_timerThread, TimerThread, NULL)))
+    {
+        oc_atomic_cmpxchg(&g_timerState, 1, 2);
+        return true;
+    }
+
+    OIC_LOG(ERROR, TAG, "Failed to start timer thread");
+    oc_hashmap_free(g_timersById);
+    g_timersById = NULL;
+    if (g_timerCond)
+    {
+        oc_cond_free(g_timerCond);
+        g_timerCond = NULL;
+    }
+    if (g_timerMutex)
+    {
+        oc_mutex_free(g_timerMutex);
+        g_timerMutex = NULL;
+    }
+    oc_atomic_cmpxchg(&g_timerState, 1, 0);
+    return false;
 }
 
-void checkTimeout()
+int OC_CALL oc_timer_schedule(uint64_t timeoutMs, TimerCallback cb, void *ctx)
 {
-    time_t now;
-    int i;
+    if (!InitTimers())
+    {
+        return -1;
+    }
 
-    time(&now);
+    OCTimerEntry_t *timer = (OCTimerEntry_t *)OICCalloc(1, sizeof(OCTimerEntry_t));
+    if (!timer)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to allocate timer");
+        return -1;
+    }
+    timer->cb = cb;
+    timer->ctx = ctx;
 
-    /* Check all timeouts that are used and armed, but not passed yet. */
-    for (i = 0; i < TIMEOUTS; i++)
+    oc_mutex_lock(g_timerMutex);
+
+    if (g_timerCount == g_timerCapacity)
     {
-        if ((timeout_list[i].timeout_state & (TIMEOUT_USED | TIMEOUT_UNUSED)) == TIMEOUT_USED)
+        size_t capacity = g_timerCapacity ? 2 * g_timerCapacity : TIMER_HEAP_INITIAL_CAPACITY;
+        OCTimerEntry_t **heap = (OCTimerEntry_t **)OICRealloc(g_timerHeap,
+                                                             capacity * sizeof(*heap));
+        if (!heap)
         {
-            const time_t seconds = timespec_diff(timeout_list[i].timeout_time, now);
-
-            if (seconds <= 0)
-            {
-                /* timeout [i] fires! */
-                timeout_list[i].timeout_state = TIMEOUT_UNUSED;
-                if (timeout_list[i].cb)
-                {
-                    timeout_list[i].cb(timeout_list[i].ctx);
-                }
-            }
+            oc_mutex_unlock(g_timerMutex);
+            OIC_LOG(ERROR, TAG, "Failed to grow timer heap");
+            OICFree(timer);
+            return -1;
         }
+        g_timerHeap = heap;
+        g_timerCapacity = capacity;
     }
+
+    // Ids are handed out in turn; skip those of timers that are still pending.
+    do
+    {
+        timer->id = g_nextTimerId;
+        g_nextTimerId = (INT_MAX == g_nextTimerId) ? 0 : g_nextTimerId + 1;
+    } while (oc_hashmap_get(g_timersById, &timer->id));
+
+    if (!oc_hashmap_put(g_timersById, &timer->id, timer))
+    {
+        oc_mutex_unlock(g_timerMutex);
+        OIC_LOG(ERROR, TAG, "Failed to add timer");
+        OICFree(timer);
+        return -1;
+    }
+
+    timer->dueTime = OICGetCurrentTime(TIME_IN_MS) + timeoutMs;
+    timer->sequence = g_nextTimerSequence++;
+    SetTimerAt(g_timerCount++, timer);
+    SiftTimerUp(timer->heapIndex);
+
+    // The timer thread sleeps until the earliest timer; wake it if that changed.
+    if (0 == timer->heapIndex)
+    {
+        oc_cond_signal(g_timerCond);
+    }
+
+    int id = timer->id;
+    oc_mutex_unlock(g_timerMutex);
+    return id;
 }
 
-void *loop(void *threadid)
+bool OC_CALL oc_timer_cancel(int id)
 {
-    (void)threadid;
-    for (;;)
+    if (2 != oc_atomic_or(&g_timerState, 0))
     {
-        sleep(SECOND);
-        checkTimeout();
+        return false;
     }
+
+    oc_mutex_lock(g_timerMutex);
+    OCTimerEntry_t *timer = (OCTimerEntry_t *)oc_hashmap_get(g_timersById, &id);
+    if (timer)
+    {
+        RemoveTimer(timer);
+    }
+    oc_mutex_unlock(g_timerMutex);
+
+    OICFree(timer);
+    return (NULL != timer);
 }
 
-int initThread()
+void OC_CALL oc_timer_stop(void)
 {
-    int res = pthread_create(&thread_id, NULL, loop, NULL);
+    if (!oc_atomic_cmpxchg(&g_timerState, 2, 1))
+    {
+        return;
+    }
+
+    oc_mutex_lock(g_timerMutex);
+    g_timerStop = true;
+    oc_cond_signal(g_timerCond);
+    oc_mutex_unlock(g_timerMutex);
 
-    if (res)
+    oc_thread_wait(g_timerThread);
+    oc_thread_free(g_timerThread);
+    g_timerThread = NULL;
+
+    // The thread is gone; drop the timers that did not expire.
+    for (size_t i = 0; i < g_timerCount; i++)
     {
-        printf("ERROR; return code from pthread_create() is %d\n", res);
+        OICFree(g_timerHeap[i]);
+    }
+    OICFree(g_timerHeap);
+    g_timerHeap = NULL;
+    g_timerCount = 0;
+    g_timerCapacity = 0;
+
+    oc_hashmap_free(g_timersById);
+    g_timersById = NULL;
+    oc_cond_free(g_timerCond);
+    g_timerCond = NULL;
+    oc_mutex_free(g_timerMutex);
+    g_timerMutex = NULL;
+
+    oc_atomic_cmpxchg(&g_timerState, 1, 0);
+}
+
+time_t OC_CALL registerTimer(const time_t seconds, int *id, TimerCallback cb, void *ctx)
+{
+    time_t then;
+
+    if (seconds <= 0)
+        return -1 ;
+
+    int timerId = oc_timer_schedule((uint64_t)seconds * MS_PER_SEC, cb, ctx);
+    if (timerId < 0)
         return -1;
+
+    // calculate when the timeout should fire
+    time(&then);
+    timespec_add(&then, seconds);
+
+    *id = timerId;
+    return then;
+}
+
+void OC_CALL unregisterTimer(int idx)
+{
+    oc_timer_cancel(idx);
+}
+
+void checkTimeout()
+{
+    if (2 != oc_atomic_or(&g_timerState, 0))
+    {
+        return;
     }
 
-    return 0;
+    oc_mutex_lock(g_timerMutex);
+    RunDueTimers();
+    oc_mutex_unlock(g_timerMutex);
+}
+
+void *loop(void *threadid)
+{
+    (void)threadid;
+    InitTimers();
+    return NULL;
+}
+
+int initThread()
+{
+    return InitTimers() ? 0 : -1;
 }
 #else   // WITH_ARDUINO
 time_t timeToSecondsFromNow(tmElements_t *t_then)
@@ -280,6 +557,42 @@ time_t timeToSecondsFromNow(tmElements_t *t_then)
     return (time_t) (then - t);
 }
 
+void OC_CALL oc_timer_stop(void)
+{
+    if (!oc_atomic_cmpxchg(&g_timerState, 2, 1))
+    {
+        return;
+    }
+
+    oc_mutex_lock(g_timerMutex);
+    g_timerStop = true;
+    oc_cond_signal(g_timerCond);
+    oc_mutex_unlock(g_timerMutex);
+
+    oc_thread_wait(g_timerThread);
+    oc_thread_free(g_timerThread);
+    g_timerThread = NULL;
+
+    // The thread is gone; drop the timers that did not expire.
+    for (size_t i = 0; i < g_timerCount; i++)
+    {
+        OICFree(g_timerHeap[i]);
+    }
+    OICFree(g_timerHeap);
+    g_timerHeap = NULL;
+    g_timerCount = 0;
+    g_timerCapacity = 0;
+
+    oc_hashmap_free(g_timersById);
+    g_timersById = NULL;
+    oc_cond_free(g_timerCond);
+    g_timerCond = NULL;
+    oc_mutex_free(g_timerMutex);
+    g_timerMutex = NULL;
+
+    oc_atomic_cmpxchg(&g_timerState, 1, 0);
+}
+
 time_t OC_CALL registerTimer(const time_t seconds, int *id, TimerCallback cb, void *ctx)
 {
     time_t t, then;
@@ -0,0 +1,159 @@
+/* *****************************************************************
+ *
+ * Copyright 2017 Open Connectivity Foundation
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/**
+ * @file
+ *
+ * This file implement tests for the timers.
+ */
+
+#include "octimer.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TimerTester : public testing::Test
+{
+  protected:
+    /** Records the order in which the timers of a test expire. */
+    struct Expiry
+    {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::vector<int> order;
+    };
+
+    static void OnTimer(void *ctx)
+    {
+        std::pair<Expiry *, int> *timer = (std::pair<Expiry *, int> *)ctx;
+        std::lock_guard<std::mutex> lock(timer->first->mutex);
+        timer->first->order.push_back(timer->second);
+        timer->first->cond.notify_all();
+    }
+
+    bool WaitForExpiries(size_t count, std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_expiry.mutex);
+        return m_expiry.cond.wait_for(lock, timeout,
+                                      [&]{ return m_expiry.order.size() >= count; });
+    }
+
+    Expiry m_expiry;
+};
+
+TEST_F(TimerTester, ExpireInOrderOfTimeout)
+{
+    const int timeouts[] = { 40, 10, 30, 20, 50 };
+    std::vector<std::pair<Expiry *, int>> timers;
+    for (int timeout : timeouts)
+    {
+        timers.push_back(std::make_pair(&m_expiry, timeout));
+    }
+    for (auto &timer : timers)
+    {
+        EXPECT_LE(0, oc_timer_schedule(timer.second, OnTimer, &timer));
+    }
+
+    ASSERT_TRUE(WaitForExpiries(timers.size(), std::chrono::seconds(5)));
+    EXPECT_EQ(std::vector<int>({ 10, 20, 30, 40, 50 }), m_expiry.order);
+}
+
+TEST_F(TimerTester, ExpireWithMillisecondResolution)
+{
+    std::pair<Expiry *, int> timer(&m_expiry, 0);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_LE(0, oc_timer_schedule(20, OnTimer, &timer));
+
+    ASSERT_TRUE(WaitForExpiries(1, std::chrono::seconds(5)));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_LE(std::chrono::milliseconds(19), elapsed);
+    EXPECT_GT(std::chrono::milliseconds(900), elapsed);
+}
+
+TEST_F(TimerTester, ManyTimers)
+{
+    const size_t count = 1000;
+    std::vector<std::pair<Expiry *, int>> timers;
+    for (size_t i = 0; i < count; i++)
+    {
+        timers.push_back(std::make_pair(&m_expiry, (int)i));
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        EXPECT_LE(0, oc_timer_schedule(i % 10, OnTimer, &timers[i]));
+    }
+
+    ASSERT_TRUE(WaitForExpiries(count, std::chrono::seconds(5)));
+    EXPECT_EQ(count, m_expiry.order.size());
+}
+
+TEST_F(TimerTester, Cancel)
+{
+    std::pair<Expiry *, int> cancelled(&m_expiry, 1);
+    std::pair<Expiry *, int> expired(&m_expiry, 2);
+    int id = oc_timer_schedule(20, OnTimer, &cancelled);
+    ASSERT_LE(0, id);
+    int expiredId = oc_timer_schedule(40, OnTimer, &expired);
+    ASSERT_LE(0, expiredId);
+    EXPECT_NE(id, expiredId);
+
+    EXPECT_TRUE(oc_timer_cancel(id));
+    EXPECT_FALSE(oc_timer_cancel(id));
+
+    ASSERT_TRUE(WaitForExpiries(1, std::chrono::seconds(5)));
+    EXPECT_EQ(std::vector<int>({ 2 }), m_expiry.order);
+    EXPECT_FALSE(oc_timer_cancel(expiredId));
+}
+
+TEST_F(TimerTester, RegisterTimerInSeconds)
+{
+    std::pair<Expiry *, int> timer(&m_expiry, 1);
+    int id = -1;
+    time_t now = time(NULL);
+    time_t then = registerTimer(1, &id, OnTimer, &timer);
+    EXPECT_LE(now + 1, then);
+    EXPECT_LE(0, id);
+
+    EXPECT_EQ(-1, registerTimer(0, &id, OnTimer, &timer));
+
+    ASSERT_TRUE(WaitForExpiries(1, std::chrono::seconds(5)));
+    EXPECT_LE(then, time(NULL));
+    unregisterTimer(id);
+}
+
+TEST_F(TimerTester, StopDropsPendingTimersAndRestarts)
+{
+    std::pair<Expiry *, int> dropped(&m_expiry, 1);
+    std::pair<Expiry *, int> restarted(&m_expiry, 2);
+
+    int id = oc_timer_schedule(50, OnTimer, &dropped);
+    EXPECT_LE(0, id);
+    oc_timer_stop();
+    EXPECT_FALSE(oc_timer_cancel(id));
+    oc_timer_stop();
+
+    EXPECT_LE(0, oc_timer_schedule(10, OnTimer, &restarted));
+    ASSERT_TRUE(WaitForExpiries(1, std::chrono::seconds(5)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::lock_guard<std::mutex> lock(m_expiry.mutex);
+    EXPECT_EQ(std::vector<int>({ 2 }), m_expiry.order);
+}
@@ -32,6 +32,9 @@
  */
 #include "cacommon.h"
 #include "casecurityinterface.h"
+#ifdef WITH_PROCESS_EVENT
+#include "ocevent.h"
+#endif
 
 #ifdef __cplusplus
 extern "C"
@@ -231,6 +234,14 @@ CATransportAdapter_t CAGetSelectedNetwork();
  */
 CAResult_t CAHandleRequestResponse();
 
+#ifdef WITH_PROCESS_EVENT
+/**
+ * Register an event to be signaled whenever there is data for ::CAHandleRequestResponse.
+ * @param[in]   event       event to signal, NULL to unregister.
+ */
+void CARegisterProcessEvent(oc_event event);
+#endif
+
 #ifdef RA_ADAPTER
 /**
  * Set Remote Access information for XMPP Client.
@@ -269,6 +269,40 @@ CAResult_t CAcloseSslConnection(const CAEndpoint_t *endpoint);
  */
 void CAcloseSslConnectionAll(CATransportAdapter_t transportType);
 
+/**
+ * Counters of (D)TLS session resumption.
+ */
+typedef struct
+{
+    uint32_t hits;      /**< Handshakes that resumed a cached session. */
+    uint32_t misses;    /**< Handshakes that offered or looked up a session and
+                             ran a full handshake. */
+} CASslSessionCacheStats_t;
+
+/**
+ * Configure (D)TLS session resumption. Client sessions are kept per remote
+ * endpoint, server sessions by session ID. Only sessions of certificate based
+ * cipher suites are resumed. Resumption is disabled by default.
+ *
+ * @param[in] maxEntries  max number of client and of server sessions kept,
+ *                        0 disables resumption and drops the cached sessions.
+ * @param[in] timeoutSec  lifetime of a cached session in seconds.
+ *
+ * @retval  ::CA_STATUS_OK    Successful.
+ * @retval  ::CA_STATUS_INVALID_PARAM Invalid timeout.
+ */
+CAResult_t CAsetSslSessionCache(size_t maxEntries, uint32_t timeoutSec);
+
+/**
+ * Get the session resumption counters.
+ *
+ * @param[out] stats  counters since the start of the process.
+ *
+ * @retval  ::CA_STATUS_OK    Successful.
+ * @retval  ::CA_STATUS_INVALID_PARAM stats is NULL.
+ */
+CAResult_t CAgetSslSessionCacheStats(CASslSessionCacheStats_t *stats);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
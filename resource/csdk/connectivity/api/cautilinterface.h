@@ -286,6 +286,16 @@ CAResult_t CAGetIpv6AddrScope(const char *addr, CATransportFlags_t *scopeLevel);
  */
 void CAUtilSetLogLevel(CAUtilLogLevel_t level, bool hidePrivateLogEntries);
 
+/**
+ * set the size of the message deduplication cache. Requests are remembered
+ * per remote endpoint and message ID for EXCHANGE_LIFETIME, and duplicate
+ * confirmable requests are answered with the response sent the first time.
+ * @param[in]  maxEntries       max number of remembered requests, 0 disables deduplication.
+ * @param[in]  maxResponseSize  max size of a remembered response, 0 disables resending.
+ * @return  ::CA_STATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
+ */
+CAResult_t CAUtilSetDeduplicationCacheSize(size_t maxEntries, size_t maxResponseSize);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif //__cplusplus
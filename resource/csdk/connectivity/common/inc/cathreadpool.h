@@ -52,10 +52,27 @@ typedef struct ca_thread_pool
     struct ca_thread_pool_details_t* details;
 }*ca_thread_pool_t;
 
+/**
+ * Thread pool counters, see ::ca_thread_pool_get_stats.
+ */
+typedef struct
+{
+    uint32_t numThreads;            /**< Number of started worker threads. */
+    uint32_t idleThreads;           /**< Number of workers waiting for a task. */
+    size_t queueDepth;              /**< Number of tasks waiting for a worker. */
+    size_t maxQueueDepth;           /**< Highest queueDepth seen. */
+    uint64_t tasksStarted;          /**< Number of tasks handed to a worker. */
+    uint64_t totalQueueLatencyUs;   /**< Sum of the time tasks spent queued, in microseconds. */
+    uint64_t maxQueueLatencyUs;     /**< Longest time a task spent queued, in microseconds. */
+} ca_thread_pool_stats_t;
+
 /**
  * This function creates a newly allocated thread pool.
+ * Worker threads are started on demand and then kept until the pool is freed.
+ * Tasks added while all workers are busy wait in a FIFO queue, so long running
+ * tasks (e.g. receive loops) permanently occupy a worker each.
  *
- * @param num_of_threads The number of worker thread used in this pool.
+ * @param num_of_threads The maximum number of worker threads used in this pool.
  * @param thread_pool_handle Handle to newly create thread pool.
  * @return Error code, CA_STATUS_OK if success, else error number.
  */
@@ -74,9 +91,20 @@ CAResult_t ca_thread_pool_init(int32_t num_of_threads, ca_thread_pool_t *thread_
 CAResult_t ca_thread_pool_add_task(ca_thread_pool_t thread_pool, ca_thread_func method,
                     void *data);
 
+/**
+ * This function gets a snapshot of the thread pool counters.
+ *
+ * @param thread_pool The thread pool structure.
+ * @param stats The counters are copied here.
+ *
+ * @return CA_STATUS_OK on success.
+ * @return Error on failure.
+ */
+CAResult_t ca_thread_pool_get_stats(ca_thread_pool_t thread_pool, ca_thread_pool_stats_t *stats);
+
 /**
  * This function stops all the worker threads (stop & exit). And frees all the allocated memory.
- * Function will return only after joining all threads executing the currently scheduled tasks.
+ * Function will return only after all queued tasks were run and all threads were joined.
  *
  * @param thread_pool The thread pool structure.
  */
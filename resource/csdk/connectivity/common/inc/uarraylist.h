@@ -88,6 +88,15 @@ void u_arraylist_shrink_to_fit(u_arraylist_t *list);
  */
 void *u_arraylist_get(const u_arraylist_t *list, size_t index);
 
+/**
+ * Replaces the data of the index in the array list.
+ * @param[in] list         pointer of array list.
+ * @param[in] index        index of array list.
+ * @param[in] data         pointer of data.
+ * @return true if success, false otherwise.
+ */
+bool u_arraylist_set(u_arraylist_t *list, size_t index, void *data);
+
 /**
  * Returns the index of the data from the array list.
  * @param[in] list         pointer of array list.
@@ -22,6 +22,11 @@
  * @file
  *
  * This file provides APIs related to thread pool.
+ *
+ * The pool starts worker threads on demand, up to the number given to
+ * ca_thread_pool_init(). Workers are long lived: they take tasks from a
+ * shared FIFO queue until the pool is freed. Task nodes are recycled so that
+ * steady state scheduling does not allocate.
  */
 
 #ifndef _GNU_SOURCE
@@ -35,6 +40,7 @@
 #include "cathreadpool.h"
 #include "logger.h"
 #include "oic_malloc.h"
+#include "oic_time.h"
 #include "uarraylist.h"
 #include "octhread.h"
 #include "platform_features.h"
@@ -42,44 +48,151 @@
 #define TAG PCF("OIC_CA_UTHREADPOOL")
 
 /**
- * empty struct to represent the details.  This implementation has no data
- * that it needs to keep track of, so it only uses NULL for the internal value.
+ * Maximum number of task nodes kept for reuse.
  */
-typedef struct ca_thread_pool_details_t
-{
-    u_arraylist_t* threads_list;
-    oc_mutex list_lock;
-} ca_thread_pool_details_t;
+#define CA_THREAD_POOL_MAX_FREE_TASKS (32)
 
 /**
- * struct to wrap the pthreads callback properly.  The function pointer for
- * pthreads requires a void* return value, however u_thread_func is a void.
+ * Queued task.
  */
-typedef struct ca_thread_pool_callback_info_t
+typedef struct ca_thread_pool_task_t
 {
     ca_thread_func func;
-    void* data;
-} ca_thread_pool_callback_info_t;
+    void *data;
+    uint64_t queuedTime;                    /**< Time the task was queued, in microseconds. */
+    struct ca_thread_pool_task_t *next;
+} ca_thread_pool_task_t;
+
+/**
+ * Pool state. All fields are guarded by list_lock.
+ */
+typedef struct ca_thread_pool_details_t
+{
+    u_arraylist_t* threads_list;            /**< Started workers. */
+    oc_mutex list_lock;
+    oc_cond task_cond;                      /**< Signaled when a task is queued or on stop. */
+    ca_thread_pool_task_t *queue_head;
+    ca_thread_pool_task_t *queue_tail;
+    ca_thread_pool_task_t *free_tasks;      /**< Recycled task nodes. */
+    size_t free_task_count;
+    uint32_t max_threads;
+    uint32_t idle_threads;
+    bool stop;
+    ca_thread_pool_stats_t stats;
+} ca_thread_pool_details_t;
 
 typedef struct ca_thread_pool_thread_info_t
 {
     oc_thread thread;
 } ca_thread_pool_thread_info_t;
 
-// passthrough function to convert the pthreads call to a u_thread_func call
-void* ca_thread_pool_pthreads_delegate(void* data)
+static ca_thread_pool_task_t *ca_thread_pool_pop_task(ca_thread_pool_details_t *details)
+{
+    ca_thread_pool_task_t *task = details->queue_head;
+    if (task)
+    {
+        details->queue_head = task->next;
+        if (!details->queue_head)
+        {
+            details->queue_tail = NULL;
+        }
+        details->stats.queueDepth--;
+    }
+    return task;
+}
+
+static void ca_thread_pool_release_task(ca_thread_pool_details_t *details,
+                                        ca_thread_pool_task_t *task)
 {
-    ca_thread_pool_callback_info_t* info = (ca_thread_pool_callback_info_t*)data;
-    info->func(info->data);
-    OICFree(info);
+    if (details->free_task_count < CA_THREAD_POOL_MAX_FREE_TASKS)
+    {
+        task->next = details->free_tasks;
+        details->free_tasks = task;
+        details->free_task_count++;
+    }
+    else
+    {
+        OICFree(task);
+    }
+}
+
+// worker loop: runs queued tasks until the pool is stopped and the queue is drained
+static void* ca_thread_pool_worker(void* data)
+{
+    ca_thread_pool_details_t* details = (ca_thread_pool_details_t*)data;
+
+    oc_mutex_lock(details->list_lock);
+    while (true)
+    {
+        while (!details->queue_head && !details->stop)
+        {
+            details->idle_threads++;
+            oc_cond_wait(details->task_cond, details->list_lock);
+            details->idle_threads--;
+        }
+
+        ca_thread_pool_task_t *task = ca_thread_pool_pop_task(details);
+        if (!task)
+        {
+            break;
+        }
+
+        uint64_t latency = OICGetCurrentTime(TIME_IN_US) - task->queuedTime;
+        details->stats.tasksStarted++;
+        details->stats.totalQueueLatencyUs += latency;
+        if (latency > details->stats.maxQueueLatencyUs)
+        {
+            details->stats.maxQueueLatencyUs = latency;
+        }
+
+        ca_thread_func func = task->func;
+        void *taskData = task->data;
+        ca_thread_pool_release_task(details, task);
+        oc_mutex_unlock(details->list_lock);
+
+        func(taskData);
+
+        oc_mutex_lock(details->list_lock);
+    }
+    oc_mutex_unlock(details->list_lock);
     return NULL;
 }
 
-// this implementation doesn't do a thread pool, so this function is essentially
-// a no-op besides creating a valid ca_thread_pool_t object.  It was determined after
-// reading through the existing implementation that the thread-pooling was unnecessary
-// for the posix platforms.  Behavior shouldn't be changed since previously num_of_threads
-// was greater than the number of requested threads.
+// must be called with list_lock held
+static CAResult_t ca_thread_pool_start_worker(ca_thread_pool_details_t *details)
+{
+    ca_thread_pool_thread_info_t *threadInfo =
+            (ca_thread_pool_thread_info_t *) OICCalloc(1, sizeof(ca_thread_pool_thread_info_t));
+    if (!threadInfo)
+    {
+        OIC_LOG(ERROR, TAG, "Memory allocation failed");
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+
+    if (!u_arraylist_add(details->threads_list, (void*) threadInfo))
+    {
+        OIC_LOG(ERROR, TAG, "Arraylist add failed");
+        OICFree(threadInfo);
+        return CA_STATUS_FAILED;
+    }
+
+    int thrRet = oc_thread_new(&threadInfo->thread, ca_thread_pool_worker, details);
+    if (thrRet != 0)
+    {
+        size_t index = 0;
+        if (u_arraylist_get_index(details->threads_list, threadInfo, &index))
+        {
+            u_arraylist_remove(details->threads_list, index);
+        }
+        OICFree(threadInfo);
+        OIC_LOG_V(ERROR, TAG, "Thread start failed with error %d", thrRet);
+        return CA_STATUS_FAILED;
+    }
+
+    details->stats.numThreads++;
+    return CA_STATUS_OK;
+}
+
 CAResult_t ca_thread_pool_init(int32_t num_of_threads, ca_thread_pool_t *thread_pool)
 {
     OIC_LOG(DEBUG, TAG, "IN");
@@ -104,7 +217,7 @@ CAResult_t ca_thread_pool_init(int32_t num_of_threads, ca_thread_pool_t *thread_
         return CA_MEMORY_ALLOC_FAILED;
     }
 
-    (*thread_pool)->details = OICMalloc(sizeof(struct ca_thread_pool_details_t));
+    (*thread_pool)->details = OICCalloc(1, sizeof(struct ca_thread_pool_details_t));
     if(!(*thread_pool)->details)
     {
         OIC_LOG(ERROR, TAG, "Failed to allocate for thread-pool details");
@@ -113,6 +226,7 @@ CAResult_t ca_thread_pool_init(int32_t num_of_threads, ca_thread_pool_t *thread_
         return CA_MEMORY_ALLOC_FAILED;
     }
 
+    (*thread_pool)->details->max_threads = (uint32_t)num_of_threads;
     (*thread_pool)->details->list_lock = oc_mutex_new();
 
     if(!(*thread_pool)->details->list_lock)
@@ -121,11 +235,21 @@ CAResult_t ca_thread_pool_init(int32_t num_of_threads, ca_thread_pool_t *thread_
         goto exit;
     }
 
+    (*thread_pool)->details->task_cond = oc_cond_new();
+
+    if(!(*thread_pool)->details->task_cond)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to create thread-pool condition");
+        oc_mutex_free((*thread_pool)->details->list_lock);
+        goto exit;
+    }
+
     (*thread_pool)->details->threads_list = u_arraylist_create();
 
     if(!(*thread_pool)->details->threads_list)
     {
         OIC_LOG(ERROR, TAG, "Failed to create thread-pool list");
+        oc_cond_free((*thread_pool)->details->task_cond);
         if(!oc_mutex_free((*thread_pool)->details->list_lock))
         {
             OIC_LOG(ERROR, TAG, "Failed to free thread-pool mutex");
@@ -154,56 +278,97 @@ CAResult_t ca_thread_pool_add_task(ca_thread_pool_t thread_pool, ca_thread_func
         return CA_STATUS_INVALID_PARAM;
     }
 
-    ca_thread_pool_callback_info_t* info = OICMalloc(sizeof(ca_thread_pool_callback_info_t));
-    if(!info)
+    ca_thread_pool_details_t *details = thread_pool->details;
+
+    oc_mutex_lock(details->list_lock);
+    if (details->stop)
     {
-        OIC_LOG(ERROR, TAG, "Failed to allocate for memory wrapper");
-        return CA_MEMORY_ALLOC_FAILED;
+        oc_mutex_unlock(details->list_lock);
+        OIC_LOG(ERROR, TAG, "thread pool is stopping");
+        return CA_STATUS_FAILED;
     }
 
-    info->func = method;
-    info->data = data;
+    ca_thread_pool_task_t *task = details->free_tasks;
+    if (task)
+    {
+        details->free_tasks = task->next;
+        details->free_task_count--;
+    }
+    else
+    {
+        task = (ca_thread_pool_task_t *) OICMalloc(sizeof(ca_thread_pool_task_t));
+        if (!task)
+        {
+            oc_mutex_unlock(details->list_lock);
+            OIC_LOG(ERROR, TAG, "Failed to allocate for task");
+            return CA_MEMORY_ALLOC_FAILED;
+        }
+    }
 
-    ca_thread_pool_thread_info_t *threadInfo =
-            (ca_thread_pool_thread_info_t *) OICCalloc(1, sizeof(ca_thread_pool_thread_info_t));
-    if (!threadInfo)
+    task->func = method;
+    task->data = data;
+    task->queuedTime = OICGetCurrentTime(TIME_IN_US);
+    task->next = NULL;
+    if (details->queue_tail)
     {
-        OIC_LOG(ERROR, TAG, "Memory allocation failed");
-        OICFree(info);
-        return CA_STATUS_FAILED;
+        details->queue_tail->next = task;
+    }
+    else
+    {
+        details->queue_head = task;
     }
+    details->queue_tail = task;
 
-    oc_mutex_lock(thread_pool->details->list_lock);
-    bool addResult = u_arraylist_add(thread_pool->details->threads_list, (void*) threadInfo);
-    if (!addResult)
+    details->stats.queueDepth++;
+    if (details->stats.queueDepth > details->stats.maxQueueDepth)
     {
-        // Note that this is considered non-fatal.
-        oc_mutex_unlock(thread_pool->details->list_lock);
-        OIC_LOG(ERROR, TAG, "Arraylist add failed");
-        OICFree(info);
-        OICFree(threadInfo);
-        return CA_STATUS_FAILED;
+        details->stats.maxQueueDepth = details->stats.queueDepth;
     }
 
-    int thrRet = oc_thread_new(&threadInfo->thread, ca_thread_pool_pthreads_delegate, info);
-    if (thrRet != 0)
+    // Start another worker only if the idle ones cannot take all queued tasks.
+    if (details->idle_threads < details->stats.queueDepth
+        && details->stats.numThreads < details->max_threads)
     {
-        size_t index = 0;
-        if (u_arraylist_get_index(thread_pool->details->threads_list, threadInfo, &index))
+        CAResult_t res = ca_thread_pool_start_worker(details);
+        if (CA_STATUS_OK != res && 0 == details->stats.numThreads)
         {
-            u_arraylist_remove(thread_pool->details->threads_list, index);
+            // Nobody would ever run the task.
+            details->queue_head = details->queue_tail = NULL;
+            details->stats.queueDepth--;
+            ca_thread_pool_release_task(details, task);
+            oc_mutex_unlock(details->list_lock);
+            return res;
         }
-        oc_mutex_unlock(thread_pool->details->list_lock);
-        OIC_LOG_V(ERROR, TAG, "Thread start failed with error %d", thrRet);
-        OICFree(info);
-        return CA_STATUS_FAILED;
     }
-    oc_mutex_unlock(thread_pool->details->list_lock);
+    else if (details->idle_threads < details->stats.queueDepth)
+    {
+        OIC_LOG_V(DEBUG, TAG, "All %u workers busy, %u tasks queued",
+                  details->max_threads, (unsigned int)details->stats.queueDepth);
+    }
+
+    oc_cond_signal(details->task_cond);
+    oc_mutex_unlock(details->list_lock);
 
     OIC_LOG(DEBUG, TAG, "OUT");
     return CA_STATUS_OK;
 }
 
+CAResult_t ca_thread_pool_get_stats(ca_thread_pool_t thread_pool, ca_thread_pool_stats_t *stats)
+{
+    if (NULL == thread_pool || NULL == stats)
+    {
+        OIC_LOG(ERROR, TAG, "thread_pool or stats was NULL");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    oc_mutex_lock(thread_pool->details->list_lock);
+    *stats = thread_pool->details->stats;
+    stats->idleThreads = thread_pool->details->idle_threads;
+    oc_mutex_unlock(thread_pool->details->list_lock);
+
+    return CA_STATUS_OK;
+}
+
 void ca_thread_pool_free(ca_thread_pool_t thread_pool)
 {
     OIC_LOG(DEBUG, TAG, "IN");
@@ -214,12 +379,19 @@ void ca_thread_pool_free(ca_thread_pool_t thread_pool)
         return;
     }
 
-    oc_mutex_lock(thread_pool->details->list_lock);
+    ca_thread_pool_details_t *details = thread_pool->details;
 
-    for (size_t i = 0; i < u_arraylist_length(thread_pool->details->threads_list); ++i)
+    // Workers drain the queue before they exit, so every accepted task still runs.
+    oc_mutex_lock(details->list_lock);
+    details->stop = true;
+    oc_cond_broadcast(details->task_cond);
+    oc_mutex_unlock(details->list_lock);
+
+    // No worker is started once stop is set, so the list can be walked unlocked.
+    for (size_t i = 0; i < u_arraylist_length(details->threads_list); ++i)
     {
         ca_thread_pool_thread_info_t *threadInfo = (ca_thread_pool_thread_info_t *)
-                u_arraylist_get(thread_pool->details->threads_list, i);
+                u_arraylist_get(details->threads_list, i);
         if (threadInfo)
         {
             if (threadInfo->thread)
@@ -231,12 +403,19 @@ void ca_thread_pool_free(ca_thread_pool_t thread_pool)
         }
     }
 
-    u_arraylist_free(&(thread_pool->details->threads_list));
+    u_arraylist_free(&(details->threads_list));
 
-    oc_mutex_unlock(thread_pool->details->list_lock);
-    oc_mutex_free(thread_pool->details->list_lock);
+    while (details->free_tasks)
+    {
+        ca_thread_pool_task_t *task = details->free_tasks;
+        details->free_tasks = task->next;
+        OICFree(task);
+    }
+
+    oc_cond_free(details->task_cond);
+    oc_mutex_free(details->list_lock);
 
-    OICFree(thread_pool->details);
+    OICFree(details);
     OICFree(thread_pool);
 
     OIC_LOG(DEBUG, TAG, "OUT");
@@ -125,6 +125,22 @@ void *u_arraylist_get(const u_arraylist_t *list, size_t index)
     return NULL;
 }
 
+bool u_arraylist_set(u_arraylist_t *list, size_t index, void *data)
+{
+    if (!list)
+    {
+        return false;
+    }
+
+    if ((index < list->length) && (list->data))
+    {
+        list->data[index] = data;
+        return true;
+    }
+
+    return false;
+}
+
 bool u_arraylist_get_index(const u_arraylist_t *list, const void *data, size_t *index)
 {
     if (!list || !data)
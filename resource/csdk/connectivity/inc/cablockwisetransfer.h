@@ -31,6 +31,7 @@
 #include <coap/coap.h>
 #include "cathreadpool.h"
 #include "octhread.h"
+#include "ochashmap.h"
 #include "uarraylist.h"
 #include "cacommon.h"
 #include "caprotocolmessage.h"
@@ -67,6 +68,9 @@ typedef struct
     /** array list on which the thread is operating. **/
     u_arraylist_t *dataList;
 
+    /** block data of dataList by block ID. **/
+    oc_hashmap dataMap;
+
     /** data list mutex for synchronization. **/
     oc_mutex blockDataListMutex;
 
@@ -102,6 +106,7 @@ typedef struct
     CAPayload_t payload;                /**< payload buffer. */
     size_t payloadLength;               /**< the total payload length to be received. */
     size_t receivedPayloadLen;          /**< currently received payload length. */
+    size_t payloadCapacity;             /**< allocated size of payload buffer. */
 } CABlockData_t;
 
 /**
@@ -318,7 +323,7 @@ CAResult_t CASetMoreBitFromBlock(size_t payloadLen, coap_block_t *block);
  * @return ::CASTATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
  */
 CAResult_t CAAddBlockOption(coap_pdu_t **pdu, const CAInfo_t *info,
-                            const CAEndpoint_t *endpoint, coap_list_t **options);
+                            const CAEndpoint_t *endpoint, CAPDUOptions_t *options);
 
 /**
  * Write the block option2 in pdu binary data.
@@ -329,7 +334,7 @@ CAResult_t CAAddBlockOption(coap_pdu_t **pdu, const CAInfo_t *info,
  * @return ::CASTATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
  */
 CAResult_t CAAddBlockOption2(coap_pdu_t **pdu, const CAInfo_t *info, size_t dataLength,
-                             const CABlockDataID_t *blockID, coap_list_t **options);
+                             const CABlockDataID_t *blockID, CAPDUOptions_t *options);
 
 /**
  * Write the block option1 in pdu binary data.
@@ -340,7 +345,7 @@ CAResult_t CAAddBlockOption2(coap_pdu_t **pdu, const CAInfo_t *info, size_t data
  * @return ::CASTATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
  */
 CAResult_t CAAddBlockOption1(coap_pdu_t **pdu, const CAInfo_t *info, size_t dataLength,
-                             const CABlockDataID_t *blockID, coap_list_t **options);
+                             const CABlockDataID_t *blockID, CAPDUOptions_t *options);
 
 /**
  * Add the block option in option list.
@@ -350,15 +355,15 @@ CAResult_t CAAddBlockOption1(coap_pdu_t **pdu, const CAInfo_t *info, size_t data
  * @return ::CASTATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
  */
 CAResult_t CAAddBlockOptionImpl(coap_block_t *block, uint8_t blockType,
-                                coap_list_t **options);
+                                CAPDUOptions_t *options);
 
 /**
  * Add the option list in pdu data.
  * @param[out]  pdu    pdu object.
- * @param[out]  options   option list.
+ * @param[in]   options   option list.
  * @return ::CASTATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
  */
-CAResult_t CAAddOptionToPDU(coap_pdu_t *pdu, coap_list_t **options);
+CAResult_t CAAddOptionToPDU(coap_pdu_t *pdu, const CAPDUOptions_t *options);
 
 /**
  * Add the size option in pdu data.
@@ -368,7 +373,7 @@ CAResult_t CAAddOptionToPDU(coap_pdu_t *pdu, coap_list_t **options);
  * @return ::CASTATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
  */
 CAResult_t CAAddBlockSizeOption(coap_pdu_t *pdu, uint16_t sizeType, size_t dataLength,
-                                coap_list_t **options);
+                                CAPDUOptions_t *options);
 
 /**
  * Get the size option from pdu data.
@@ -383,6 +388,9 @@ bool CAIsPayloadLengthInPduWithBlockSizeOption(coap_pdu_t *pdu,
 
 /**
  * update the total payload with the received payload.
+ * The full payload is reassembled, since the upper layer only handles complete
+ * payloads; blocks are not streamed to it as they arrive. The buffer is sized from
+ * the size option when there is one and grows geometrically otherwise.
  * @param[in]   currData    stored block data information.
  * @param[in]   receivedData    received CAData.
  * @param[in]   status  block-wise state.
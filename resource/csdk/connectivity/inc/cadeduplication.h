@@ -0,0 +1,112 @@
+/* ****************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/**
+ * @file
+ * This file contains the message deduplication store (RFC 7252, 4.5).
+ * Requests are remembered by remote endpoint and message ID for
+ * EXCHANGE_LIFETIME, together with the piggybacked response sent for them,
+ * so that a retransmitted request can be answered without passing it to
+ * the application again.
+ */
+
+#ifndef CA_DEDUPLICATION_H_
+#define CA_DEDUPLICATION_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cacommon.h"
+
+/** EXCHANGE_LIFETIME is 247 sec(CoAP). **/
+#define CA_EXCHANGE_LIFETIME_SEC            247
+
+#ifdef SINGLE_THREAD
+/** default number of remembered requests. **/
+#define CA_DEDUP_DEFAULT_MAX_ENTRIES        8
+
+/** default max size of a remembered response, responses are not kept by default. **/
+#define CA_DEDUP_DEFAULT_MAX_RESPONSE_SIZE  0
+#else
+/** default number of remembered requests. **/
+#define CA_DEDUP_DEFAULT_MAX_ENTRIES        64
+
+/** default max size of a remembered response. **/
+#define CA_DEDUP_DEFAULT_MAX_RESPONSE_SIZE  1024
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Initializes the deduplication store.
+ * @return  ::CA_STATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
+ */
+CAResult_t CADeduplicationInitialize(void);
+
+/**
+ * Terminates the deduplication store and frees the remembered requests.
+ */
+void CADeduplicationTerminate(void);
+
+/**
+ * Bounds the memory used by the deduplication store. May be called before
+ * or after ::CADeduplicationInitialize; the oldest requests are dropped if
+ * the store holds more than maxEntries.
+ * @param[in]   maxEntries          max number of remembered requests,
+ *                                  0 disables deduplication.
+ * @param[in]   maxResponseSize     max size of a remembered response,
+ *                                  0 disables resending responses.
+ * @return  ::CA_STATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
+ */
+CAResult_t CADeduplicationSetCacheSize(size_t maxEntries, size_t maxResponseSize);
+
+/**
+ * Checks whether a request was already received from the endpoint and
+ * remembers it otherwise.
+ * @param[in]   endpoint            remote endpoint of the request.
+ * @param[in]   messageId           message ID of the request.
+ * @param[out]  response            copy of the response sent for the request,
+ *                                  if any. Caller must free it with OICFree().
+ * @param[out]  responseLength      size of response.
+ * @return  true if the request is a duplicate.
+ */
+bool CADeduplicationCheckRequest(const CAEndpoint_t *endpoint, uint16_t messageId,
+                                 void **response, uint32_t *responseLength);
+
+/**
+ * Remembers the piggybacked response sent for a request, if the request is
+ * in the store.
+ * @param[in]   endpoint            remote endpoint of the request.
+ * @param[in]   messageId           message ID of the request and of the response.
+ * @param[in]   pdu                 response pdu data.
+ * @param[in]   size                size of pdu data.
+ */
+void CADeduplicationSaveResponse(const CAEndpoint_t *endpoint, uint16_t messageId,
+                                 const void *pdu, uint32_t size);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif  /* CA_DEDUPLICATION_H_ */
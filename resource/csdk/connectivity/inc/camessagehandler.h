@@ -28,6 +28,9 @@
 
 #include "cacommon.h"
 #include <coap/coap.h>
+#ifdef WITH_PROCESS_EVENT
+#include "ocevent.h"
+#endif
 
 #define CA_MEMORY_ALLOC_CHECK(arg) { if (NULL == arg) {OIC_LOG(ERROR, TAG, "Out of memory"); \
 goto memory_error_exit;} }
@@ -103,7 +106,9 @@ void CASetNetworkMonitorCallback(CANetworkMonitorCallback nwMonitorHandler);
  * @param[in] data    send data.
  */
 void CAAddDataToSendThread(CAData_t *data);
+#endif
 
+#ifndef SINGLE_THREAD
 /**
  * Add the data to the receive queue thread to notify received data.
  * @param[in] data    received data.
@@ -111,6 +116,14 @@ void CAAddDataToSendThread(CAData_t *data);
 void CAAddDataToReceiveThread(CAData_t *data);
 #endif
 
+#ifdef WITH_PROCESS_EVENT
+/**
+ * Set the event to be signaled whenever data is added to the receive queue.
+ * @param[in] event    event to signal, NULL to unset.
+ */
+void CASetProcessEvent(oc_event event);
+#endif
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -52,15 +52,61 @@ typedef uint32_t code_t;
 
 static const uint8_t PAYLOAD_MARKER = 1;
 
+/**
+ * Max number of options in a generated pdu. Each path segment and query parameter
+ * of the URI takes an option, so generating a pdu fails for a URI with more path
+ * segments and query parameters than this, less the other options of the pdu.
+ */
+#ifdef ARDUINO
+#define CA_PDU_MAX_OPTIONS (16)
+#else
+#define CA_PDU_MAX_OPTIONS (96)
+#endif
+
+/**
+ * Size of the buffer holding the URI options and the encoded integer options of a pdu.
+ */
+#define CA_PDU_OPTION_BUFFER_SIZE (CA_MAX_URI_LENGTH + CA_PDU_MAX_OPTIONS * sizeof(uint32_t))
+
+/**
+ * Option to be added to a pdu.
+ */
+typedef struct
+{
+    uint16_t key;                   /**< option number. */
+    uint16_t length;                /**< length of the value. */
+    const uint8_t *data;            /**< option value. */
+} CAPDUOption_t;
+
+/**
+ * Options of a pdu, kept sorted by option number so that they can be written to the
+ * pdu in one pass. It is meant to live on the stack of the sender: values of URI
+ * and integer options are held in its buffer, values of header options refer to
+ * the CAInfo_t they come from. Must not be copied once options are added.
+ * With CA_PDU_MAX_OPTIONS options and CA_PDU_OPTION_BUFFER_SIZE bytes of values,
+ * it takes about 2.4 KB of stack on 64-bit platforms.
+ */
+typedef struct
+{
+    size_t numOptions;                              /**< number of options. */
+    CAPDUOption_t options[CA_PDU_MAX_OPTIONS];      /**< options in option number order. */
+    size_t bufferLength;                            /**< used length of buffer. */
+    uint8_t buffer[CA_PDU_OPTION_BUFFER_SIZE];      /**< storage of option values. */
+} CAPDUOptions_t;
+
 /**
  * generates pdu structure from the given information.
  * @param[in]   code                 code of the pdu packet.
  * @param[in]   info                 pdu information.
  * @param[in]   endpoint             endpoint information.
- * @return  generated pdu.
+ * @param[out]  options              options of the pdu, still to be added to it when
+ *                                   blockwise transfer is used.
+ * @param[out]  transport            transport type of the pdu.
+ * @return  generated pdu, or NULL on failure, also when the pdu would need more than
+ *          CA_PDU_MAX_OPTIONS options.
  */
 coap_pdu_t *CAGeneratePDU(uint32_t code, const CAInfo_t *info, const CAEndpoint_t *endpoint,
-                          coap_list_t **optlist, coap_transport_t *transport);
+                          CAPDUOptions_t *options, coap_transport_t *transport);
 
 /**
  * extracts request information from received pdu.
@@ -97,11 +143,11 @@ CAResult_t CAGetErrorInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endp
  * @param[in]   code                 request or response code.
  * @param[in]   info                 information to create pdu.
  * @param[in]   endpoint             endpoint information.
- * @param[out]  options              options for the request and response.
+ * @param[in]   options              options for the request and response.
  * @return  generated pdu.
  */
 coap_pdu_t *CAGeneratePDUImpl(code_t code, const CAInfo_t *info,
-                              const CAEndpoint_t *endpoint, coap_list_t *options,
+                              const CAEndpoint_t *endpoint, const CAPDUOptions_t *options,
                               coap_transport_t *transport);
 
 /**
@@ -110,11 +156,11 @@ coap_pdu_t *CAGeneratePDUImpl(code_t code, const CAInfo_t *info,
  * @param[out]   options             options information.
  * @return  CA_STATUS_OK or ERROR CODES (CAResult_t error codes in cacommon.h).
  */
-CAResult_t CAParseURI(const char *uriInfo, coap_list_t **options);
+CAResult_t CAParseURI(const char *uriInfo, CAPDUOptions_t *options);
 
 /**
  * Helper that uses libcoap to parse either the path or the parameters of a URI
- * and populate the supplied options list.
+ * and populate the supplied options.
  *
  * @param[in]   str                  the input partial URI string (either path or query).
  * @param[in]   length               the length of the supplied partial URI.
@@ -124,7 +170,7 @@ CAResult_t CAParseURI(const char *uriInfo, coap_list_t **options);
  * @return  CA_STATUS_OK or ERROR CODES (CAResult_t error codes in cacommon.h).
  */
 CAResult_t CAParseUriPartial(const unsigned char *str, size_t length, uint16_t target,
-                             coap_list_t **optlist);
+                             CAPDUOptions_t *optlist);
 
 /**
  * create option list from header information in the info.
@@ -133,11 +179,11 @@ CAResult_t CAParseUriPartial(const unsigned char *str, size_t length, uint16_t t
  * @param[out]  optlist              options information.
  * @return  CA_STATUS_OK or ERROR CODES (CAResult_t error codes in cacommon.h).
  */
-CAResult_t CAParseHeadOption(uint32_t code, const CAInfo_t *info, coap_list_t **optlist);
+CAResult_t CAParseHeadOption(uint32_t code, const CAInfo_t *info, CAPDUOptions_t *optlist);
 
 /**
  * Helper to parse content format and accept format header options
- * and populate the supplied options list.
+ * and populate the supplied options.
  *
  * @param[in]   formatOption         CoAP format header option.
  * @param[in]   format               content or accept format.
@@ -148,25 +194,30 @@ CAResult_t CAParseHeadOption(uint32_t code, const CAInfo_t *info, coap_list_t **
  */
 
 CAResult_t CAParsePayloadFormatHeadOption(uint16_t formatOption, CAPayloadFormat_t format,
-        uint16_t versionOption, uint16_t version, coap_list_t **optlist);
+        uint16_t versionOption, uint16_t version, CAPDUOptions_t *optlist);
 
 /**
- * creates option node from key length and data.
- * @param[in]   key                  key for the that needs to be sent.
- * @param[in]   length               length of the data that needs to be sent.
- * @param[in]   data                 data that needs to be sent.
- * @return  created list.
+ * adds an option to the options of a pdu, after the options with the same key.
+ * The value of an option with integer format is re-encoded in the options buffer,
+ * any other value is referenced and has to outlive the options.
+ * @param[in,out]   options          options of the pdu.
+ * @param[in]       key              key for the that needs to be sent.
+ * @param[in]       length           length of the data that needs to be sent.
+ * @param[in]       data             data that needs to be sent.
+ * @return  CA_STATUS_OK or ERROR CODES (CAResult_t error codes in cacommon.h).
  */
-coap_list_t *CACreateNewOptionNode(uint16_t key, uint32_t length, const char *data);
+CAResult_t CAAddPDUOption(CAPDUOptions_t *options, uint16_t key, uint32_t length,
+                          const uint8_t *data);
 
 /**
- * order the inserted options.
- * need to replace queue head if new node has to be added before the existing queue head.
- * @param[in]   a                    option 1 for insertion.
- * @param[in]   b                    option 2 for insertion.
- * @return  0 or 1.
+ * adds an option with an integer value to the options of a pdu. The value is
+ * encoded in the options buffer.
+ * @param[in,out]   options          options of the pdu.
+ * @param[in]       key              key for the that needs to be sent.
+ * @param[in]       value            value that needs to be sent.
+ * @return  CA_STATUS_OK or ERROR CODES (CAResult_t error codes in cacommon.h).
  */
-int CAOrderOpts(void *a, void *b);
+CAResult_t CAAddPDUUintOption(CAPDUOptions_t *options, uint16_t key, uint32_t value);
 
 /**
  * number of options count.
@@ -69,6 +69,9 @@ typedef struct CATCPSessionInfo_t
     CAProtocol_t protocol;              /**< application-level protocol */
     CATCPConnectionState_t state;       /**< current tcp session state */
     bool isClient;                      /**< Host Mode of Operation. */
+    struct CATCPPendingData_t *pendingHead; /**< outbound data not yet written, oldest first */
+    struct CATCPPendingData_t *pendingTail; /**< most recently queued outbound data */
+    size_t pendingLen;                  /**< number of bytes waiting in the outbound queue */
     struct CATCPSessionInfo_t *next;    /**< Linked list; for multiple session list. */
 } CATCPSessionInfo_t;
 
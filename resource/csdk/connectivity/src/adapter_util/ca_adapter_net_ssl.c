@@ -36,6 +36,8 @@
 #include "byte_array.h"
 #include "octhread.h"
 #include "octimer.h"
+#include "ochashmap.h"
+#include "oic_time.h"
 
 // headers required for mbed TLS
 #include "mbedtls/platform.h"
@@ -44,6 +46,7 @@
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/pkcs12.h"
 #include "mbedtls/ssl_internal.h"
+#include "mbedtls/ssl_cache.h"
 #include "mbedtls/net_sockets.h"
 #include "mbedtls/oid.h"
 #ifdef __WITH_DTLS__
@@ -128,6 +131,11 @@
  * @brief TLS client and server random bytes length
  */
 #define RANDOM_LEN (32)
+/**
+ * @def PKIX_DIGEST_LEN
+ * @brief Length of the SHA-256 digest of the PKIX information
+ */
+#define PKIX_DIGEST_LEN (32)
 /**
  * @def SHA384_MAC_KEY_LENGTH
  * @brief MAC key length for SHA384 cipher suites
@@ -175,6 +183,12 @@
  */
 #define RETRANSMISSION_TIME 1
 
+/**
+ * @def SESSION_CACHE_DEFAULT_TIMEOUT
+ * @brief Default lifetime of a session cached for resumption in seconds
+ */
+#define SESSION_CACHE_DEFAULT_TIMEOUT (3600)
+
 /**@def SSL_CLOSE_NOTIFY(peer, ret)
  *
  * Notifies of existing \a peer about closing TLS connection.
@@ -376,6 +390,7 @@ typedef struct SslContext
 {
     u_arraylist_t *peerList;         /**< peer list which holds the mapping between
                                               peer id, it's n/w address and mbedTLS context. */
+    oc_hashmap peerMap;              /**< peers of peerList by n/w address. */
     mbedtls_entropy_context entropy;
     mbedtls_ctr_drbg_context rnd;
     mbedtls_x509_crt ca;
@@ -387,9 +402,14 @@ typedef struct SslContext
     mbedtls_ssl_config clientDtlsConf;
     mbedtls_ssl_config serverDtlsConf;
 
+    mbedtls_ssl_cache_context sessionCache; /**< server sessions for resumption. */
+    u_arraylist_t *clientSessions;   /**< client sessions for resumption,
+                                              least recently used first. */
+
     SslCipher_t cipher;
     SslCallbacks_t adapterCallbacks[MAX_SUPPORTED_ADAPTERS];
     mbedtls_x509_crl crl;
+    unsigned char pkixDigest[PKIX_DIGEST_LEN]; /**< digest of the loaded PKIX information. */
     bool cipherFlag[2];
     int selectedCipher;
 
@@ -406,6 +426,24 @@ typedef struct SslContext
  */
 static SslContext_t * g_caSslContext = NULL;
 
+/**
+ * @var g_sessionCacheMaxEntries
+ * @brief max number of client and of server sessions kept for resumption
+ */
+static size_t g_sessionCacheMaxEntries = 0;
+
+/**
+ * @var g_sessionCacheTimeout
+ * @brief lifetime of a session kept for resumption in seconds
+ */
+static uint32_t g_sessionCacheTimeout = SESSION_CACHE_DEFAULT_TIMEOUT;
+
+/**
+ * @var g_sessionCacheStats
+ * @brief session resumption counters
+ */
+static CASslSessionCacheStats_t g_sessionCacheStats = { 0, 0 };
+
 /**
  * @var g_getCredentialsCallback
  * @brief callback to get TLS credentials (same as for DTLS)
@@ -456,11 +494,23 @@ typedef struct SslEndPoint
     SslRecBuf_t recBuf;
     uint8_t master[MASTER_SECRET_LEN];
     uint8_t random[2*RANDOM_LEN];
+    bool resumeOffered;             /**< a cached session was offered to the server. */
+    bool resumed;                   /**< the handshake resumed a cached session. */
 #ifdef __WITH_DTLS__
     mbedtls_timing_delay_context timer;
 #endif // __WITH_DTLS__
 } SslEndPoint_t;
 
+/**
+ * Data structure for holding a client session kept for resumption.
+ */
+typedef struct SslClientSession
+{
+    CAEndpoint_t endpoint;
+    mbedtls_ssl_session session;
+    uint64_t expiryTime;
+} SslClientSession_t;
+
 void CAsetPskCredentialsCallback(CAgetPskCredentialsHandler credCallback)
 {
     // TODO Does this method needs protection of tlsContextMutex?
@@ -647,6 +697,45 @@ static void DeInitPkixInfo(PkiInfo_t * inf)
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
 }
 
+/**
+ * Computes the digest of the certificates, trust anchors and CRL that the
+ * sessions kept for resumption were verified against.
+ *
+ * @param[in]  inf    PKIX information
+ * @param[out]  digest    SHA-256 digest
+ *
+ * @return  true on success or false on error
+ */
+static bool DigestPkixInfo(const PkiInfo_t * inf, unsigned char * digest)
+{
+    const ByteArray_t * items[] = { &inf->crt, &inf->ca, &inf->crl };
+    mbedtls_md_context_t md;
+    int ret;
+
+    mbedtls_md_init(&md);
+    ret = mbedtls_md_setup(&md, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0);
+    if (0 == ret)
+    {
+        ret = mbedtls_md_starts(&md);
+    }
+    for (size_t i = 0; 0 == ret && i < sizeof(items) / sizeof(items[0]); i++)
+    {
+        // Length prefix, so that moving bytes between items changes the digest.
+        ret = mbedtls_md_update(&md, (const unsigned char *) &items[i]->len,
+                                sizeof(items[i]->len));
+        if (0 == ret && 0 < items[i]->len)
+        {
+            ret = mbedtls_md_update(&md, items[i]->data, items[i]->len);
+        }
+    }
+    if (0 == ret)
+    {
+        ret = mbedtls_md_finish(&md, digest);
+    }
+    mbedtls_md_free(&md);
+    return 0 == ret;
+}
+
 //Loads PKIX related information from SRM
 static int InitPKIX(CATransportAdapter_t adapter)
 {
@@ -667,6 +756,13 @@ static int InitPKIX(CATransportAdapter_t adapter)
 
     VERIFY_NON_NULL_RET(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL", -1);
 
+    if (!DigestPkixInfo(&pkiInfo, g_caSslContext->pkixDigest))
+    {
+        // The change can't be detected, so a random digest makes it look changed.
+        OIC_LOG(WARNING, NET_SSL_TAG, "Failed to digest PKIX info");
+        OCGetRandomBytes(g_caSslContext->pkixDigest, sizeof(g_caSslContext->pkixDigest));
+    }
+
     mbedtls_x509_crt_free(&g_caSslContext->ca);
     mbedtls_x509_crt_free(&g_caSslContext->crt);
     mbedtls_pk_free(&g_caSslContext->pkey);
@@ -807,6 +903,33 @@ static int GetPskCredentialsCallback(void * notUsed, mbedtls_ssl_context * ssl,
     OIC_LOG_V(WARNING, NET_SSL_TAG, "Out %s", __func__);
     return -1;
 }
+/**
+ * Checks whether two addresses belong to the same session. The port of
+ * BLE addresses is not compared.
+ */
+static bool IsSamePeer(const CAEndpoint_t *peer1, const CAEndpoint_t *peer2)
+{
+    return (peer1->adapter == peer2->adapter)
+           && (0 == strncmp(peer1->addr, peer2->addr, MAX_ADDR_STR_SIZE_CA))
+           && (peer1->port == peer2->port || CA_ADAPTER_GATT_BTLE == peer1->adapter);
+}
+
+static uint32_t HashPeer(const void *key)
+{
+    const CAEndpoint_t *peer = (const CAEndpoint_t *) key;
+    uint32_t hash = oc_hashmap_hash_bytes(&peer->adapter, sizeof(peer->adapter), 0);
+    if (CA_ADAPTER_GATT_BTLE != peer->adapter)
+    {
+        hash = oc_hashmap_hash_bytes(&peer->port, sizeof(peer->port), hash);
+    }
+    return oc_hashmap_hash_bytes(peer->addr, strnlen(peer->addr, MAX_ADDR_STR_SIZE_CA), hash);
+}
+
+static bool EqualPeer(const void *key1, const void *key2)
+{
+    return IsSamePeer((const CAEndpoint_t *) key1, (const CAEndpoint_t *) key2);
+}
+
 /**
  * Gets session corresponding for endpoint.
  *
@@ -826,6 +949,13 @@ static SslEndPoint_t *GetSslPeer(const CAEndpoint_t *peer)
     VERIFY_NON_NULL_RET(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL", NULL);
 
     SslEndPoint_t *tep = NULL;
+    if (g_caSslContext->peerMap)
+    {
+        tep = (SslEndPoint_t *) oc_hashmap_get(g_caSslContext->peerMap, peer);
+        OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+        return tep;
+    }
+
     listLength = u_arraylist_length(g_caSslContext->peerList);
     for (listIndex = 0; listIndex < listLength; listIndex++)
     {
@@ -839,9 +969,7 @@ static SslEndPoint_t *GetSslPeer(const CAEndpoint_t *peer)
                   peer->addr, peer->port, tep->sep.endpoint.addr, tep->sep.endpoint.port,
                   peer->adapter);
 
-        if((peer->adapter == tep->sep.endpoint.adapter)
-                && (0 == strncmp(peer->addr, tep->sep.endpoint.addr, MAX_ADDR_STR_SIZE_CA))
-                && (peer->port == tep->sep.endpoint.port || CA_ADAPTER_GATT_BTLE == peer->adapter))
+        if (IsSamePeer(peer, &tep->sep.endpoint))
         {
             OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
             return tep;
@@ -852,6 +980,67 @@ static SslEndPoint_t *GetSslPeer(const CAEndpoint_t *peer)
     return NULL;
 }
 
+/**
+ * Adds session to the peer list.
+ *
+ * @param[in]  tep    endpoint with session info
+ *
+ * @return  true on success
+ */
+static bool AddSslPeer(SslEndPoint_t *tep)
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+
+    if (!u_arraylist_add(g_caSslContext->peerList, (void *) tep))
+    {
+        return false;
+    }
+    // As for a search of the list, the first of peers with the same address is found.
+    if (g_caSslContext->peerMap && !oc_hashmap_get(g_caSslContext->peerMap, &tep->sep.endpoint)
+        && !oc_hashmap_put(g_caSslContext->peerMap, &tep->sep.endpoint, tep))
+    {
+        u_arraylist_remove(g_caSslContext->peerList, u_arraylist_length(g_caSslContext->peerList) - 1);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Removes session from the peer list. The session is not deleted.
+ *
+ * @param[in]  listIndex    index of the session in the peer list
+ */
+static void RemoveSslPeerAt(size_t listIndex)
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+
+    SslEndPoint_t *tep = (SslEndPoint_t *) u_arraylist_remove(g_caSslContext->peerList, listIndex);
+    if (NULL == tep || !g_caSslContext->peerMap
+        || tep != oc_hashmap_get(g_caSslContext->peerMap, &tep->sep.endpoint))
+    {
+        return;
+    }
+
+    oc_hashmap_remove(g_caSslContext->peerMap, &tep->sep.endpoint);
+
+    // Another session with the same address, if any, is found from now on.
+    size_t listLength = u_arraylist_length(g_caSslContext->peerList);
+    for (size_t i = 0; i < listLength; i++)
+    {
+        SslEndPoint_t *other = (SslEndPoint_t *) u_arraylist_get(g_caSslContext->peerList, i);
+        if (other && IsSamePeer(&tep->sep.endpoint, &other->sep.endpoint))
+        {
+            if (!oc_hashmap_put(g_caSslContext->peerMap, &other->sep.endpoint, other))
+            {
+                OIC_LOG(ERROR, NET_SSL_TAG, "Failed to index peer, searching the list");
+                oc_hashmap_free(g_caSslContext->peerMap);
+                g_caSslContext->peerMap = NULL;
+            }
+            return;
+        }
+    }
+}
+
 /**
  * Gets a copy of CA secure endpoint info corresponding for endpoint.
  *
@@ -1056,7 +1245,7 @@ static void RemovePeerFromList(CAEndpoint_t * endpoint)
         if(0 == strncmp(endpoint->addr, tep->sep.endpoint.addr, MAX_ADDR_STR_SIZE_CA)
                 && (endpoint->port == tep->sep.endpoint.port))
         {
-            u_arraylist_remove(g_caSslContext->peerList, listIndex);
+            RemoveSslPeerAt(listIndex);
             DeleteSslEndPoint(tep);
             return;
         }
@@ -1126,6 +1315,298 @@ static bool checkSslOperation(SslEndPoint_t*  peer,
     return true;
 }
 
+/**
+ * Checks whether a cipher suite authenticates peers by certificate.
+ *
+ * @param[in]  cipherSuite    negotiated cipher suite
+ *
+ * @return  true for certificate based cipher suites
+ */
+static bool IsCertCipherSuite(int cipherSuite)
+{
+    return MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256 != cipherSuite &&
+           MBEDTLS_TLS_ECDH_ANON_WITH_AES_128_CBC_SHA256 != cipherSuite;
+}
+
+/**
+ * Deletes client session kept for resumption.
+ *
+ * @param[in]  cs    client session
+ */
+static void DeleteClientSession(SslClientSession_t * cs)
+{
+    mbedtls_ssl_session_free(&cs->session);
+    OICFree(cs);
+}
+
+/**
+ * Deletes the least recently used client sessions above the limit.
+ *
+ * @param[in]  maxEntries    number of client sessions to keep
+ */
+static void TrimClientSessions(size_t maxEntries)
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+
+    while (u_arraylist_length(g_caSslContext->clientSessions) > maxEntries)
+    {
+        DeleteClientSession((SslClientSession_t *)
+                            u_arraylist_remove(g_caSslContext->clientSessions, 0));
+    }
+}
+
+/**
+ * Gets index of client session kept for endpoint.
+ *
+ * @param[in]  endpoint    remote address
+ * @param[out]  listIndex    index of session in the client session list
+ *
+ * @return  client session or NULL
+ */
+static SslClientSession_t * GetClientSession(const CAEndpoint_t * endpoint, size_t * listIndex)
+{
+    size_t listLength = u_arraylist_length(g_caSslContext->clientSessions);
+    for (size_t i = 0; i < listLength; i++)
+    {
+        SslClientSession_t * cs =
+            (SslClientSession_t *) u_arraylist_get(g_caSslContext->clientSessions, i);
+        if (cs && IsSamePeer(endpoint, &cs->endpoint))
+        {
+            *listIndex = i;
+            return cs;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Offers the session kept for the endpoint, if any, in the client hello.
+ *
+ * @param[in]  tep    endpoint with new client session
+ */
+static void LoadClientSession(SslEndPoint_t * tep)
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+
+    size_t listIndex = 0;
+    SslClientSession_t * cs = GetClientSession(&tep->sep.endpoint, &listIndex);
+    if (NULL == cs)
+    {
+        return;
+    }
+
+    if (cs->expiryTime <= OICGetCurrentTime(TIME_IN_MS))
+    {
+        u_arraylist_remove(g_caSslContext->clientSessions, listIndex);
+        DeleteClientSession(cs);
+        return;
+    }
+
+    if (0 == mbedtls_ssl_set_session(&tep->ssl, &cs->session))
+    {
+        OIC_LOG_V(DEBUG, NET_SSL_TAG, "Offer session of [%s:%d]",
+                  tep->sep.endpoint.addr, tep->sep.endpoint.port);
+        tep->resumeOffered = true;
+    }
+}
+
+/**
+ * Keeps the session of an established client connection for resumption.
+ *
+ * @param[in]  tep    endpoint with established client session
+ */
+static void SaveClientSession(SslEndPoint_t * tep)
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+
+    if (0 == g_sessionCacheMaxEntries || !IsCertCipherSuite(tep->ssl.session->ciphersuite))
+    {
+        return;
+    }
+
+    size_t listIndex = 0;
+    SslClientSession_t * cs = GetClientSession(&tep->sep.endpoint, &listIndex);
+    if (cs)
+    {
+        u_arraylist_remove(g_caSslContext->clientSessions, listIndex);
+        if (tep->resumed)
+        {
+            // Same session; it keeps its lifetime and becomes the most recently used.
+            if (!u_arraylist_add(g_caSslContext->clientSessions, (void *) cs))
+            {
+                DeleteClientSession(cs);
+            }
+            return;
+        }
+        DeleteClientSession(cs);
+    }
+
+    cs = (SslClientSession_t *) OICCalloc(1, sizeof(SslClientSession_t));
+    if (NULL == cs)
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "Malloc failed!");
+        return;
+    }
+    cs->endpoint = tep->sep.endpoint;
+    cs->expiryTime = OICGetCurrentTime(TIME_IN_MS) + (uint64_t) g_sessionCacheTimeout * MS_PER_SEC;
+    mbedtls_ssl_session_init(&cs->session);
+    if (0 != mbedtls_ssl_get_session(&tep->ssl, &cs->session))
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "Failed to copy session");
+        DeleteClientSession(cs);
+        return;
+    }
+
+    TrimClientSessions(g_sessionCacheMaxEntries - 1);
+    if (!u_arraylist_add(g_caSslContext->clientSessions, (void *) cs))
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "u_arraylist_add failed!");
+        DeleteClientSession(cs);
+    }
+}
+
+/**
+ * Looks up server session for resumption. Called by mbedTLS when a client
+ * offers a session ID.
+ *
+ * @return  0 if the session is resumed
+ */
+static int GetCachedSession(void * cache, mbedtls_ssl_session * session)
+{
+    if (0 == g_sessionCacheMaxEntries)
+    {
+        return -1;
+    }
+
+    int ret = mbedtls_ssl_cache_get(cache, session);
+    if (0 == ret)
+    {
+        g_sessionCacheStats.hits++;
+    }
+    else
+    {
+        g_sessionCacheStats.misses++;
+    }
+    return ret;
+}
+
+/**
+ * Keeps server session for resumption. Called by mbedTLS at the end of a
+ * full handshake.
+ *
+ * @return  0 on success
+ */
+static int SetCachedSession(void * cache, const mbedtls_ssl_session * session)
+{
+    if (0 == g_sessionCacheMaxEntries || !IsCertCipherSuite(session->ciphersuite))
+    {
+        return 0;
+    }
+    return mbedtls_ssl_cache_set(cache, session);
+}
+
+/**
+ * Applies the session resumption settings to the server session cache.
+ */
+static void ConfigureSessionCache()
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+
+    if (0 == g_sessionCacheMaxEntries)
+    {
+        mbedtls_ssl_cache_free(&g_caSslContext->sessionCache);
+        mbedtls_ssl_cache_init(&g_caSslContext->sessionCache);
+    }
+    else
+    {
+        mbedtls_ssl_cache_set_max_entries(&g_caSslContext->sessionCache,
+                                          (int) g_sessionCacheMaxEntries);
+        mbedtls_ssl_cache_set_timeout(&g_caSslContext->sessionCache,
+                                      (int) g_sessionCacheTimeout);
+    }
+    TrimClientSessions(g_sessionCacheMaxEntries);
+}
+
+/**
+ * Drops all server and client sessions kept for resumption. A resumed
+ * handshake skips the certificate and CRL checks, so the sessions must not
+ * outlive the credentials they were verified against.
+ */
+static void FlushSessionCaches()
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+
+    OIC_LOG(DEBUG, NET_SSL_TAG, "Flush sessions kept for resumption");
+    mbedtls_ssl_cache_free(&g_caSslContext->sessionCache);
+    mbedtls_ssl_cache_init(&g_caSslContext->sessionCache);
+    ConfigureSessionCache();
+    TrimClientSessions(0);
+}
+
+/**
+ * Drops the client session kept for endpoint, if any.
+ *
+ * @param[in]  endpoint    remote address
+ */
+static void DeleteKeptClientSession(const CAEndpoint_t * endpoint)
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+
+    size_t listIndex = 0;
+    SslClientSession_t * cs = GetClientSession(endpoint, &listIndex);
+    if (cs)
+    {
+        u_arraylist_remove(g_caSslContext->clientSessions, listIndex);
+        DeleteClientSession(cs);
+    }
+}
+
+CAResult_t CAsetSslSessionCache(size_t maxEntries, uint32_t timeoutSec)
+{
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
+    VERIFY_TRUE_RET((0 < timeoutSec && timeoutSec <= INT_MAX), NET_SSL_TAG,
+                    "invalid timeout", CA_STATUS_INVALID_PARAM);
+
+    if (maxEntries > INT_MAX)
+    {
+        maxEntries = INT_MAX;
+    }
+
+    if (g_sslContextMutex)
+    {
+        oc_mutex_lock(g_sslContextMutex);
+    }
+    g_sessionCacheMaxEntries = maxEntries;
+    g_sessionCacheTimeout = timeoutSec;
+    if (g_caSslContext)
+    {
+        ConfigureSessionCache();
+    }
+    if (g_sslContextMutex)
+    {
+        oc_mutex_unlock(g_sslContextMutex);
+    }
+
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+    return CA_STATUS_OK;
+}
+
+CAResult_t CAgetSslSessionCacheStats(CASslSessionCacheStats_t *stats)
+{
+    VERIFY_NON_NULL_RET(stats, NET_SSL_TAG, "stats is NULL", CA_STATUS_INVALID_PARAM);
+
+    if (g_sslContextMutex)
+    {
+        oc_mutex_lock(g_sslContextMutex);
+    }
+    *stats = g_sessionCacheStats;
+    if (g_sslContextMutex)
+    {
+        oc_mutex_unlock(g_sslContextMutex);
+    }
+    return CA_STATUS_OK;
+}
+
 /**
  * Deletes session list.
  */
@@ -1155,6 +1636,8 @@ static void DeletePeerList()
         DeleteSslEndPoint(tep);
     }
     u_arraylist_free(&g_caSslContext->peerList);
+    oc_hashmap_free(g_caSslContext->peerMap);
+    g_caSslContext->peerMap = NULL;
 }
 
 CAResult_t CAcloseSslConnection(const CAEndpoint_t *endpoint)
@@ -1231,7 +1714,7 @@ void CAcloseSslConnectionAll(CATransportAdapter_t transportType)
         while (MBEDTLS_ERR_SSL_WANT_WRITE == ret);*/
 
         // delete from list
-        u_arraylist_remove(g_caSslContext->peerList, i - 1);
+        RemoveSslPeerAt(i - 1);
         DeleteSslEndPoint(tep);
     }
     oc_mutex_unlock(g_sslContextMutex);
@@ -1367,6 +1850,9 @@ static bool SetupCipher(mbedtls_ssl_config * config, CATransportAdapter_t adapte
 
     g_getCredentialTypesCallback(g_caSslContext->cipherFlag, deviceId);
 
+    unsigned char pkixDigest[PKIX_DIGEST_LEN];
+    memcpy(pkixDigest, g_caSslContext->pkixDigest, sizeof(pkixDigest));
+
     // Retrieve the PSK credential from SRM or use PIN based generation
     if ((SSL_ECDHE_PSK_WITH_AES_128_CBC_SHA256 == g_caSslContext->cipher ||
          true == g_caSslContext->cipherFlag[0]) && 0 != InitPskIdentity(config))
@@ -1385,6 +1871,16 @@ static bool SetupCipher(mbedtls_ssl_config * config, CATransportAdapter_t adapte
             /* Don't return error, the connection may work with another cred type */
         }
     }
+    else
+    {
+        memset(g_caSslContext->pkixDigest, 0, sizeof(g_caSslContext->pkixDigest));
+    }
+
+    // Own certificate, trust anchors or CRL changed since the sessions were kept.
+    if (0 != memcmp(pkixDigest, g_caSslContext->pkixDigest, sizeof(pkixDigest)))
+    {
+        FlushSessionCaches();
+    }
 
     memset(g_cipherSuitesList, 0, sizeof(g_cipherSuitesList));
 
@@ -1472,14 +1968,14 @@ static SslEndPoint_t * InitiateTlsHandshake(const CAEndpoint_t *endpoint)
     }
 
     oc_mutex_lock(g_sslContextMutex);
-    ret = u_arraylist_add(g_caSslContext->peerList, (void *) tep);
-    if (!ret)
+    if (!AddSslPeer(tep))
     {
         oc_mutex_unlock(g_sslContextMutex);
-        OIC_LOG(ERROR, NET_SSL_TAG, "u_arraylist_add failed!");
+        OIC_LOG(ERROR, NET_SSL_TAG, "AddSslPeer failed!");
         DeleteSslEndPoint(tep);
         return NULL;
     }
+    LoadClientSession(tep);
 
     while (MBEDTLS_SSL_HANDSHAKE_OVER > tep->ssl.state)
     {
@@ -1536,6 +2032,9 @@ void CAdeinitSslAdapter()
 
     // Clear all lists
     DeletePeerList();
+    TrimClientSessions(0);
+    u_arraylist_free(&g_caSslContext->clientSessions);
+    mbedtls_ssl_cache_free(&g_caSslContext->sessionCache);
 
     // De-initialize mbedTLS
     mbedtls_x509_crt_free(&g_caSslContext->crt);
@@ -1596,6 +2095,12 @@ static int InitConfig(mbedtls_ssl_config * conf, int transport, int mode)
     }
 #endif // __WITH_DTLS__
 
+    if (MBEDTLS_SSL_IS_SERVER == mode)
+    {
+        mbedtls_ssl_conf_session_cache(conf, &g_caSslContext->sessionCache,
+                                       GetCachedSession, SetCachedSession);
+    }
+
     /* Set TLS 1.2 as the minimum allowed version. */
     mbedtls_ssl_conf_min_version(conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
 
@@ -1697,10 +2202,16 @@ CAResult_t CAinitSslAdapter()
 
     // Create peer list
     g_caSslContext->peerList = u_arraylist_create();
+    g_caSslContext->peerMap = oc_hashmap_new(HashPeer, EqualPeer);
+    g_caSslContext->clientSessions = u_arraylist_create();
 
-    if(NULL == g_caSslContext->peerList)
+    if(NULL == g_caSslContext->peerList || NULL == g_caSslContext->peerMap
+       || NULL == g_caSslContext->clientSessions)
     {
         OIC_LOG(ERROR, NET_SSL_TAG, "peerList initialization failed!");
+        u_arraylist_free(&g_caSslContext->peerList);
+        oc_hashmap_free(g_caSslContext->peerMap);
+        u_arraylist_free(&g_caSslContext->clientSessions);
         OICFree(g_caSslContext);
         g_caSslContext = NULL;
         oc_mutex_unlock(g_sslContextMutex);
@@ -1709,6 +2220,9 @@ CAResult_t CAinitSslAdapter()
         return CA_STATUS_FAILED;
     }
 
+    mbedtls_ssl_cache_init(&g_caSslContext->sessionCache);
+    ConfigureSessionCache();
+
     /* Initialize TLS library
      */
 #if !defined(NDEBUG) || defined(TB_LOG)
@@ -2044,10 +2558,9 @@ CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, size_t dat
             return CA_STATUS_FAILED;
         }
 
-        ret = u_arraylist_add(g_caSslContext->peerList, (void *) peer);
-        if (!ret)
+        if (!AddSslPeer(peer))
         {
-            OIC_LOG(ERROR, NET_SSL_TAG, "u_arraylist_add failed!");
+            OIC_LOG(ERROR, NET_SSL_TAG, "AddSslPeer failed!");
             DeleteSslEndPoint(peer);
             oc_mutex_unlock(g_sslContextMutex);
             return CA_STATUS_FAILED;
@@ -2107,19 +2620,35 @@ CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, size_t dat
         {
             memcpy(peer->random, peer->ssl.handshake->randbytes, sizeof(peer->random));
         }
+        if (peer->ssl.handshake && peer->ssl.handshake->resume)
+        {
+            peer->resumed = true;
+        }
 
         if (MBEDTLS_SSL_HANDSHAKE_OVER == peer->ssl.state)
         {
             SSL_RES(peer, CA_STATUS_OK);
             if (MBEDTLS_SSL_IS_CLIENT == peer->ssl.conf->endpoint)
             {
+                if (peer->resumeOffered)
+                {
+                    if (peer->resumed)
+                    {
+                        g_sessionCacheStats.hits++;
+                    }
+                    else
+                    {
+                        g_sessionCacheStats.misses++;
+                    }
+                }
+                SaveClientSession(peer);
                 SendCacheMessages(peer);
             }
 
             int selectedCipher = peer->ssl.session->ciphersuite;
-            OIC_LOG_V(DEBUG, NET_SSL_TAG, "(D)TLS Session is connected via ciphersuite [0x%x]", selectedCipher);
-            if (MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256 != selectedCipher &&
-                MBEDTLS_TLS_ECDH_ANON_WITH_AES_128_CBC_SHA256 != selectedCipher)
+            OIC_LOG_V(DEBUG, NET_SSL_TAG, "(D)TLS Session is %s via ciphersuite [0x%x]",
+                      peer->resumed ? "resumed" : "connected", selectedCipher);
+            if (IsCertCipherSuite(selectedCipher))
             {
                 const mbedtls_x509_crt * peerCert = mbedtls_ssl_get_peer_cert(&peer->ssl);
                 const mbedtls_x509_name * name = NULL;
@@ -2427,6 +2956,10 @@ CAResult_t CAsetTlsCipherSuite(const uint32_t cipher)
     }
     g_caSslContext->cipher = index;
 
+    // Ownership transfer selects its cipher suite before the handshake that
+    // CAsslGenerateOwnerPsk() derives keys from; that handshake must be a full one.
+    FlushSessionCaches();
+
     oc_mutex_unlock(g_sslContextMutex);
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
     return CA_STATUS_OK;
@@ -2447,6 +2980,11 @@ CAResult_t CAinitiateSslHandshake(const CAEndpoint_t *endpoint)
             OIC_LOG(WARNING, NET_SSL_TAG, "Failed to close secure session");
         }
     }
+    // An explicit handshake is a full one, e.g. for ownership transfer.
+    if (g_caSslContext)
+    {
+        DeleteKeptClientSession(endpoint);
+    }
 
     if (NULL == InitiateTlsHandshake(endpoint))
     {
@@ -2588,6 +3126,13 @@ CAResult_t CAsslGenerateOwnerPsk(const CAEndpoint_t *endpoint,
         oc_mutex_unlock(g_sslContextMutex);
         return CA_STATUS_FAILED;
     }
+    if (tep->resumed)
+    {
+        // mbedTLS clears the random bytes while resuming, before they can be copied.
+        OIC_LOG(ERROR, NET_SSL_TAG, "Owner PSK can't be generated for a resumed session");
+        oc_mutex_unlock(g_sslContextMutex);
+        return CA_STATUS_FAILED;
+    }
 
     // keyBlockLen set up according to OIC 1.1 Security Specification Section 7.3.2
     int macKeyLen = 0;
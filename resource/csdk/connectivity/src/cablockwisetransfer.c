@@ -47,7 +47,6 @@
 
 #define TAG "OIC_CA_BWT"
 
-#define BLOCKWISE_OPTION_BUFFER    (sizeof(unsigned int))
 #define BLOCK_NUMBER_IDX           4
 #define BLOCK_M_BIT_IDX            3
 #define PORT_LENGTH                2
@@ -58,8 +57,83 @@
 static CABlockWiseContext_t g_context = { .sendThreadFunc = NULL,
                                           .receivedThreadFunc = NULL,
                                           .dataList = NULL,
+                                          .dataMap = NULL,
                                           .multicastDataList = NULL };
 
+static uint32_t CABlockIdHash(const void *key)
+{
+    const CABlockDataID_t *blockID = (const CABlockDataID_t *) key;
+    return oc_hashmap_hash_bytes(blockID->id, blockID->idLength, 0);
+}
+
+static bool CABlockIdEqual(const void *key1, const void *key2)
+{
+    const CABlockDataID_t *blockID1 = (const CABlockDataID_t *) key1;
+    const CABlockDataID_t *blockID2 = (const CABlockDataID_t *) key2;
+    return blockID1->idLength == blockID2->idLength
+           && !memcmp(blockID1->id, blockID2->id, blockID1->idLength);
+}
+
+/**
+ * Find the block data of a block ID. blockDataListMutex must be held.
+ * The first data in the list with the block ID is found.
+ */
+static CABlockData_t *CAFindBlockData(const CABlockDataID_t *blockID)
+{
+    if (!blockID->id)
+    {
+        return NULL;
+    }
+    if (g_context.dataMap)
+    {
+        return (CABlockData_t *) oc_hashmap_get(g_context.dataMap, blockID);
+    }
+
+    size_t len = u_arraylist_length(g_context.dataList);
+    for (size_t i = 0; i < len; i++)
+    {
+        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
+        if (CABlockidMatches(currData, blockID))
+        {
+            return currData;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Remove the block data at the index of the list. blockDataListMutex must be held.
+ */
+static CABlockData_t *CARemoveBlockDataAt(size_t index)
+{
+    CABlockData_t *removedData = u_arraylist_remove(g_context.dataList, index);
+    if (!removedData || !g_context.dataMap
+        || removedData != oc_hashmap_get(g_context.dataMap, removedData->blockDataId))
+    {
+        return removedData;
+    }
+
+    oc_hashmap_remove(g_context.dataMap, removedData->blockDataId);
+
+    // a remaining data with the same block ID is found from now on
+    size_t len = u_arraylist_length(g_context.dataList);
+    for (size_t i = 0; i < len; i++)
+    {
+        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
+        if (CABlockidMatches(currData, removedData->blockDataId))
+        {
+            if (!oc_hashmap_put(g_context.dataMap, currData->blockDataId, currData))
+            {
+                OIC_LOG(ERROR, TAG, "failed to index block data, searching the list");
+                oc_hashmap_free(g_context.dataMap);
+                g_context.dataMap = NULL;
+            }
+            break;
+        }
+    }
+    return removedData;
+}
+
 static bool CACheckPayloadLength(const CAData_t *sendData)
 {
     size_t payloadLen = 0;
@@ -98,6 +172,11 @@ CAResult_t CAInitializeBlockWiseTransfer(CASendThreadFunc sendThreadFunc,
         g_context.dataList = u_arraylist_create();
     }
 
+    if (!g_context.dataMap)
+    {
+        g_context.dataMap = oc_hashmap_new(CABlockIdHash, CABlockIdEqual);
+    }
+
     if (!g_context.multicastDataList)
     {
         g_context.multicastDataList = u_arraylist_create();
@@ -108,6 +187,8 @@ CAResult_t CAInitializeBlockWiseTransfer(CASendThreadFunc sendThreadFunc,
     {
         u_arraylist_free(&g_context.dataList);
         g_context.dataList = NULL;
+        oc_hashmap_free(g_context.dataMap);
+        g_context.dataMap = NULL;
         u_arraylist_free(&g_context.multicastDataList);
         g_context.multicastDataList = NULL;
         OIC_LOG(ERROR, TAG, "init has failed");
@@ -126,6 +207,9 @@ CAResult_t CATerminateBlockWiseTransfer()
         u_arraylist_free(&g_context.dataList);
     }
 
+    oc_hashmap_free(g_context.dataMap);
+    g_context.dataMap = NULL;
+
     if (g_context.multicastDataList)
     {
         CARemoveAllBlockMulticastDataFromList();
@@ -821,6 +905,7 @@ CAResult_t CASendErrorMessage(const coap_pdu_t *pdu, uint8_t status,
     {
         OICFree(data->payload);
         data->payload = NULL;
+        data->payloadCapacity = 0;
         data->payloadLength = 0;
         data->receivedPayloadLen = 0;
         data->block1.num = 0;
@@ -1457,7 +1542,7 @@ CAResult_t CAUpdateMessageId(coap_pdu_t *pdu, const CABlockDataID_t *blockID)
 }
 
 CAResult_t CAAddBlockOption(coap_pdu_t **pdu, const CAInfo_t *info,
-                            const CAEndpoint_t *endpoint, coap_list_t **options)
+                            const CAEndpoint_t *endpoint, CAPDUOptions_t *options)
 {
     OIC_LOG(DEBUG, TAG, "IN-AddBlockOption");
     VERIFY_NON_NULL(pdu, TAG, "pdu");
@@ -1521,25 +1606,12 @@ CAResult_t CAAddBlockOption(coap_pdu_t **pdu, const CAInfo_t *info,
         OIC_LOG(DEBUG, TAG, "no BLOCK option");
 
         // in case it is not large data, add option list to pdu.
-        if (*options)
+        res = CAAddOptionToPDU(*pdu, options);
+        if (CA_STATUS_OK != res)
         {
-            for (coap_list_t *opt = *options; opt; opt = opt->next)
-            {
-                OIC_LOG_V(DEBUG, TAG, "[%s] opt will be added.",
-                          COAP_OPTION_DATA(*(coap_option *) opt->data));
-                OIC_LOG_V(DEBUG, TAG, "[%d] pdu length", (*pdu)->length);
-
-                if (0 == coap_add_option(*pdu, COAP_OPTION_KEY(*(coap_option *) opt->data),
-                                         COAP_OPTION_LENGTH(*(coap_option *) opt->data),
-                                         COAP_OPTION_DATA(*(coap_option *) opt->data)))
-                {
-                    OIC_LOG(ERROR, TAG, "coap_add_option has failed");
-                    res = CA_STATUS_FAILED;
-                    goto exit;
-                }
-            }
+            OIC_LOG(ERROR, TAG, "coap_add_option has failed");
+            goto exit;
         }
-        OIC_LOG_V(DEBUG, TAG, "[%d] pdu length after option", (*pdu)->length);
 
         // if response data is so large. it have to send as block transfer
         if (!coap_add_data(*pdu, dataLength, (const unsigned char*)info->payload))
@@ -1578,7 +1650,7 @@ exit:
 }
 
 CAResult_t CAAddBlockOption2(coap_pdu_t **pdu, const CAInfo_t *info, size_t dataLength,
-                             const CABlockDataID_t *blockID, coap_list_t **options)
+                             const CABlockDataID_t *blockID, CAPDUOptions_t *options)
 {
     OIC_LOG(DEBUG, TAG, "IN-AddBlockOption2");
     VERIFY_NON_NULL(pdu, TAG, "pdu");
@@ -1686,7 +1758,7 @@ exit:
 }
 
 CAResult_t CAAddBlockOption1(coap_pdu_t **pdu, const CAInfo_t *info, size_t dataLength,
-                             const CABlockDataID_t *blockID, coap_list_t **options)
+                             const CABlockDataID_t *blockID, CAPDUOptions_t *options)
 {
     OIC_LOG(DEBUG, TAG, "IN-AddBlockOption1");
     VERIFY_NON_NULL(pdu, TAG, "pdu");
@@ -1810,22 +1882,17 @@ exit:
 }
 
 CAResult_t CAAddBlockOptionImpl(coap_block_t *block, uint8_t blockType,
-                                coap_list_t **options)
+                                CAPDUOptions_t *options)
 {
     OIC_LOG(DEBUG, TAG, "IN-AddBlockOptionImpl");
     VERIFY_NON_NULL(block, TAG, "block");
     VERIFY_NON_NULL(options, TAG, "options");
 
-    unsigned char buf[BLOCKWISE_OPTION_BUFFER] = { 0 };
-    unsigned int optionLength = coap_encode_var_bytes(buf,
-                                                      ((block->num << BLOCK_NUMBER_IDX)
-                                                       | (block->m << BLOCK_M_BIT_IDX)
-                                                       | block->szx));
-
-    int ret = coap_insert(options,
-                          CACreateNewOptionNode(blockType, optionLength, (char *) buf),
-                          CAOrderOpts);
-    if (ret <= 0)
+    CAResult_t ret = CAAddPDUUintOption(options, blockType,
+                                        ((block->num << BLOCK_NUMBER_IDX)
+                                         | (block->m << BLOCK_M_BIT_IDX)
+                                         | block->szx));
+    if (CA_STATUS_OK != ret)
     {
         return CA_STATUS_INVALID_PARAM;
     }
@@ -1834,24 +1901,22 @@ CAResult_t CAAddBlockOptionImpl(coap_block_t *block, uint8_t blockType,
     return CA_STATUS_OK;
 }
 
-CAResult_t CAAddOptionToPDU(coap_pdu_t *pdu, coap_list_t **options)
+CAResult_t CAAddOptionToPDU(coap_pdu_t *pdu, const CAPDUOptions_t *options)
 {
+    VERIFY_NON_NULL(pdu, TAG, "pdu");
+    VERIFY_NON_NULL(options, TAG, "options");
+
     // after adding the block option to option list, add option list to pdu.
-    if (*options)
+    for (size_t i = 0; i < options->numOptions; i++)
     {
-        for (coap_list_t *opt = *options; opt; opt = opt->next)
-        {
-            OIC_LOG_V(DEBUG, TAG, "[%s] opt will be added.",
-                      COAP_OPTION_DATA(*(coap_option *) opt->data));
+        const CAPDUOption_t *opt = &options->options[i];
+        OIC_LOG_V(DEBUG, TAG, "[%d] opt will be added.", opt->key);
 
-            OIC_LOG_V(DEBUG, TAG, "[%d] pdu length", pdu->length);
-            size_t ret = coap_add_option(pdu, COAP_OPTION_KEY(*(coap_option *) opt->data),
-                                         COAP_OPTION_LENGTH(*(coap_option *) opt->data),
-                                         COAP_OPTION_DATA(*(coap_option *) opt->data));
-            if (!ret)
-            {
-                return CA_STATUS_FAILED;
-            }
+        OIC_LOG_V(DEBUG, TAG, "[%d] pdu length", pdu->length);
+        size_t ret = coap_add_option(pdu, opt->key, opt->length, opt->data);
+        if (!ret)
+        {
+            return CA_STATUS_FAILED;
         }
     }
 
@@ -1861,7 +1926,7 @@ CAResult_t CAAddOptionToPDU(coap_pdu_t *pdu, coap_list_t **options)
 }
 
 CAResult_t CAAddBlockSizeOption(coap_pdu_t *pdu, uint16_t sizeType, size_t dataLength,
-                                coap_list_t **options)
+                                CAPDUOptions_t *options)
 {
     OIC_LOG(DEBUG, TAG, "IN-CAAddBlockSizeOption");
     VERIFY_NON_NULL(pdu, TAG, "pdu");
@@ -1874,14 +1939,8 @@ CAResult_t CAAddBlockSizeOption(coap_pdu_t *pdu, uint16_t sizeType, size_t dataL
         return CA_STATUS_FAILED;
     }
 
-    unsigned char value[BLOCKWISE_OPTION_BUFFER] = { 0 };
-    unsigned int optionLength = coap_encode_var_bytes(value,
-                                                      (unsigned int)dataLength);
-
-    int ret = coap_insert(options,
-                          CACreateNewOptionNode(sizeType, optionLength, (char *) value),
-                          CAOrderOpts);
-    if (ret <= 0)
+    CAResult_t ret = CAAddPDUUintOption(options, sizeType, (uint32_t)dataLength);
+    if (CA_STATUS_OK != ret)
     {
         return CA_STATUS_INVALID_PARAM;
     }
@@ -2059,46 +2118,36 @@ CAResult_t CAUpdatePayloadData(CABlockData_t *currData, const CAData_t *received
     size_t prePayloadLen = currData->receivedPayloadLen;
     if (blockPayload)
     {
-        if (currData->payloadLength)
+        size_t totalPayloadLen = prePayloadLen + blockPayloadLen;
+        if (totalPayloadLen > currData->payloadCapacity)
         {
-            // in case the block message has the size option
-            // allocate the memory for the total payload
-            if (isSizeOption)
+            // in case the block message has the size option, allocate the memory
+            // for the total payload once. Otherwise grow the buffer geometrically
+            // so that the payload received so far is copied O(1) times per byte.
+            size_t capacity = currData->payloadCapacity * 2;
+            if (isSizeOption && currData->payloadLength >= totalPayloadLen)
             {
-                CAPayload_t prePayload = currData->payload;
-
-                OIC_LOG(DEBUG, TAG, "allocate memory for the total payload");
-                currData->payload = (CAPayload_t) OICCalloc(1, currData->payloadLength);
-                if (NULL == currData->payload)
-                {
-                    OIC_LOG(ERROR, TAG, "out of memory");
-                    return CA_MEMORY_ALLOC_FAILED;
-                }
-                memcpy(currData->payload, prePayload, prePayloadLen);
-                OICFree(prePayload);
+                capacity = currData->payloadLength;
+            }
+            if (capacity < totalPayloadLen)
+            {
+                capacity = totalPayloadLen;
             }
 
-            // update the total payload
-            memcpy(currData->payload + prePayloadLen, blockPayload, blockPayloadLen);
-        }
-        else
-        {
-            OIC_LOG(DEBUG, TAG, "allocate memory for the received block payload");
-
-            size_t totalPayloadLen = prePayloadLen + blockPayloadLen;
-            CAPayload_t newPayload = OICRealloc(currData->payload, totalPayloadLen);
+            OIC_LOG_V(DEBUG, TAG, "allocate %" PRIuPTR " bytes for the payload", capacity);
+            CAPayload_t newPayload = OICRealloc(currData->payload, capacity);
             if (NULL == newPayload)
             {
                 OIC_LOG(ERROR, TAG, "out of memory");
                 return CA_MEMORY_ALLOC_FAILED;
             }
-
-            // update the total payload
-            memset(newPayload + prePayloadLen, 0, blockPayloadLen);
             currData->payload = newPayload;
-            memcpy(currData->payload + prePayloadLen, blockPayload, blockPayloadLen);
+            currData->payloadCapacity = capacity;
         }
 
+        // update the total payload
+        memcpy(currData->payload + prePayloadLen, blockPayload, blockPayloadLen);
+
         // update received payload length
         currData->receivedPayloadLen += blockPayloadLen;
 
@@ -2356,17 +2405,13 @@ CAResult_t CAUpdateBlockOptionType(const CABlockDataID_t *blockID, uint16_t bloc
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    if (currData)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            currData->type = blockType;
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            OIC_LOG(DEBUG, TAG, "OUT-UpdateBlockOptionType");
-            return CA_STATUS_OK;
-        }
+        currData->type = blockType;
+        oc_mutex_unlock(g_context.blockDataListMutex);
+        OIC_LOG(DEBUG, TAG, "OUT-UpdateBlockOptionType");
+        return CA_STATUS_OK;
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
@@ -2381,16 +2426,13 @@ uint16_t CAGetBlockOptionType(const CABlockDataID_t *blockID)
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    if (currData)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            OIC_LOG(DEBUG, TAG, "OUT-GetBlockOptionType");
-            return currData->type;
-        }
+        uint16_t type = currData->type;
+        oc_mutex_unlock(g_context.blockDataListMutex);
+        OIC_LOG(DEBUG, TAG, "OUT-GetBlockOptionType");
+        return type;
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
@@ -2404,15 +2446,11 @@ CAData_t *CAGetDataSetFromBlockDataList(const CABlockDataID_t *blockID)
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    if (currData)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            return currData->sentData;
-        }
+        oc_mutex_unlock(g_context.blockDataListMutex);
+        return currData->sentData;
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
@@ -2427,17 +2465,13 @@ CABlockData_t *CAUpdateDataSetFromBlockDataList(const CABlockDataID_t *blockID,
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    if (currData)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            CADestroyDataSet(currData->sentData);
-            currData->sentData = CACloneCAData(sendData);
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            return currData;
-        }
+        CADestroyDataSet(currData->sentData);
+        currData->sentData = CACloneCAData(sendData);
+        oc_mutex_unlock(g_context.blockDataListMutex);
+        return currData;
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
@@ -2534,19 +2568,10 @@ CABlockData_t *CAGetBlockDataFromBlockDataList(const CABlockDataID_t *blockID)
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
-    {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            return currData;
-        }
-    }
+    CABlockData_t *currData = CAFindBlockData(blockID);
     oc_mutex_unlock(g_context.blockDataListMutex);
 
-    return NULL;
+    return currData;
 }
 
 coap_block_t *CAGetBlockOption(const CABlockDataID_t *blockID, uint16_t blockType)
@@ -2556,23 +2581,20 @@ coap_block_t *CAGetBlockOption(const CABlockDataID_t *blockID, uint16_t blockTyp
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    if (currData)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
+        oc_mutex_unlock(g_context.blockDataListMutex);
+        OIC_LOG(DEBUG, TAG, "OUT-GetBlockOption");
+        if (COAP_OPTION_BLOCK2 == blockType)
         {
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            OIC_LOG(DEBUG, TAG, "OUT-GetBlockOption");
-            if (COAP_OPTION_BLOCK2 == blockType)
-            {
-                return &currData->block2;
-            }
-            else if (COAP_OPTION_BLOCK1 == blockType)
-            {
-                return &currData->block1;
-            }
+            return &currData->block2;
         }
+        else if (COAP_OPTION_BLOCK1 == blockType)
+        {
+            return &currData->block1;
+        }
+        return NULL;
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
@@ -2589,17 +2611,13 @@ CAPayload_t CAGetPayloadFromBlockDataList(const CABlockDataID_t *blockID,
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    if (currData)
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
-        {
-            oc_mutex_unlock(g_context.blockDataListMutex);
-            *fullPayloadLen = currData->receivedPayloadLen;
-            OIC_LOG(DEBUG, TAG, "OUT-GetFullPayload");
-            return currData->payload;
-        }
+        oc_mutex_unlock(g_context.blockDataListMutex);
+        *fullPayloadLen = currData->receivedPayloadLen;
+        OIC_LOG(DEBUG, TAG, "OUT-GetFullPayload");
+        return currData->payload;
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
@@ -2668,6 +2686,12 @@ CABlockData_t *CACreateNewBlockData(const CAData_t *sendData)
     oc_mutex_lock(g_context.blockDataListMutex);
 
     bool res = u_arraylist_add(g_context.dataList, (void *) data);
+    if (res && g_context.dataMap && !oc_hashmap_get(g_context.dataMap, blockDataID)
+        && !oc_hashmap_put(g_context.dataMap, blockDataID, data))
+    {
+        u_arraylist_remove(g_context.dataList, u_arraylist_length(g_context.dataList) - 1);
+        res = false;
+    }
     if (!res)
     {
         OIC_LOG(ERROR, TAG, "add has failed");
@@ -2690,28 +2714,23 @@ CAResult_t CARemoveBlockDataFromList(const CABlockDataID_t *blockID)
 
     oc_mutex_lock(g_context.blockDataListMutex);
 
-    size_t len = u_arraylist_length(g_context.dataList);
-    for (size_t i = 0; i < len; i++)
+    CABlockData_t *currData = CAFindBlockData(blockID);
+    size_t index = 0;
+    if (currData && u_arraylist_get_index(g_context.dataList, currData, &index))
     {
-        CABlockData_t *currData = (CABlockData_t *) u_arraylist_get(g_context.dataList, i);
-        if (CABlockidMatches(currData, blockID))
+        CABlockData_t *removedData = CARemoveBlockDataAt(index);
+        if (!removedData)
         {
-            CABlockData_t *removedData = u_arraylist_remove(g_context.dataList, i);
-            if (!removedData)
-            {
-                OIC_LOG(ERROR, TAG, "data is NULL");
-                oc_mutex_unlock(g_context.blockDataListMutex);
-                return CA_STATUS_FAILED;
-            }
-
-            // destroy memory
-            CADestroyDataSet(removedData->sentData);
-            CADestroyBlockID(removedData->blockDataId);
-            OICFree(removedData->payload);
-            OICFree(removedData);
+            OIC_LOG(ERROR, TAG, "data is NULL");
             oc_mutex_unlock(g_context.blockDataListMutex);
-            return CA_STATUS_OK;
+            return CA_STATUS_FAILED;
         }
+
+        // destroy memory
+        CADestroyDataSet(removedData->sentData);
+        CADestroyBlockID(removedData->blockDataId);
+        OICFree(removedData->payload);
+        OICFree(removedData);
     }
     oc_mutex_unlock(g_context.blockDataListMutex);
 
@@ -2727,7 +2746,7 @@ CAResult_t CARemoveAllBlockDataFromList()
     size_t len = u_arraylist_length(g_context.dataList);
     for (size_t i = len; i > 0; i--)
     {
-        CABlockData_t *removedData = u_arraylist_remove(g_context.dataList, i - 1);
+        CABlockData_t *removedData = CARemoveBlockDataAt(i - 1);
         if (removedData)
         {
             // destroy memory
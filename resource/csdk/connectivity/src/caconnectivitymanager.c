@@ -505,6 +505,15 @@ CAResult_t CAHandleRequestResponse()
     return CA_STATUS_OK;
 }
 
+#ifdef WITH_PROCESS_EVENT
+void CARegisterProcessEvent(oc_event event)
+{
+    OIC_LOG(DEBUG, TAG, "CARegisterProcessEvent");
+
+    CASetProcessEvent(event);
+}
+#endif
+
 CAResult_t CASelectCipherSuite(const uint16_t cipher, CATransportAdapter_t adapter)
 {
     (void)(adapter); // prevent unused-parameter warning when building release variant
@@ -0,0 +1,314 @@
+/* ****************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "cadeduplication.h"
+#include "cacommonutil.h"
+#include "ochashmap.h"
+#include "octhread.h"
+#include "oic_malloc.h"
+#include "oic_string.h"
+#include "oic_time.h"
+#include "logger.h"
+
+#define TAG "OIC_CA_DEDUP"
+
+/** key of a remembered request. **/
+typedef struct
+{
+    CATransportAdapter_t adapter;
+    uint16_t port;
+    uint16_t messageId;
+    char addr[MAX_ADDR_STR_SIZE_CA];
+} CADedupKey_t;
+
+/**
+ * remembered request. All entries have the same lifetime, so the list is
+ * ordered by insertion and expiry alike.
+ */
+typedef struct CADedupEntry
+{
+    CADedupKey_t key;
+    uint64_t expiryTime;
+    void *response;
+    uint32_t responseLength;
+    struct CADedupEntry *prev;
+    struct CADedupEntry *next;
+} CADedupEntry_t;
+
+static oc_mutex g_dedupMutex = NULL;
+static oc_hashmap g_dedupMap = NULL;
+static CADedupEntry_t *g_dedupHead = NULL;
+static CADedupEntry_t *g_dedupTail = NULL;
+static size_t g_maxEntries = CA_DEDUP_DEFAULT_MAX_ENTRIES;
+static size_t g_maxResponseSize = CA_DEDUP_DEFAULT_MAX_RESPONSE_SIZE;
+
+static uint32_t CADedupHashKey(const void *key)
+{
+    const CADedupKey_t *k = (const CADedupKey_t *) key;
+    uint32_t hash = oc_hashmap_hash_bytes(&k->messageId, sizeof(k->messageId), 0);
+    hash = oc_hashmap_hash_bytes(&k->port, sizeof(k->port), hash);
+    return oc_hashmap_hash_bytes(k->addr, strlen(k->addr), hash);
+}
+
+static bool CADedupEqualKey(const void *key1, const void *key2)
+{
+    const CADedupKey_t *k1 = (const CADedupKey_t *) key1;
+    const CADedupKey_t *k2 = (const CADedupKey_t *) key2;
+    return k1->messageId == k2->messageId && k1->port == k2->port
+           && k1->adapter == k2->adapter && 0 == strcmp(k1->addr, k2->addr);
+}
+
+static void CADedupMakeKey(CADedupKey_t *key, const CAEndpoint_t *endpoint, uint16_t messageId)
+{
+    memset(key, 0, sizeof(*key));
+    key->adapter = endpoint->adapter;
+    key->port = endpoint->port;
+    key->messageId = messageId;
+    OICStrcpy(key->addr, sizeof(key->addr), endpoint->addr);
+}
+
+static void CADedupRemoveEntry(CADedupEntry_t *entry)
+{
+    oc_hashmap_remove(g_dedupMap, &entry->key);
+
+    if (entry->prev)
+    {
+        entry->prev->next = entry->next;
+    }
+    else
+    {
+        g_dedupHead = entry->next;
+    }
+    if (entry->next)
+    {
+        entry->next->prev = entry->prev;
+    }
+    else
+    {
+        g_dedupTail = entry->prev;
+    }
+
+    OICFree(entry->response);
+    OICFree(entry);
+}
+
+/* Drops expired entries and the oldest ones above the limit. */
+static void CADedupTrim(uint64_t currentTime, size_t limit)
+{
+    while (g_dedupHead
+           && (g_dedupHead->expiryTime <= currentTime || oc_hashmap_size(g_dedupMap) > limit))
+    {
+        CADedupRemoveEntry(g_dedupHead);
+    }
+}
+
+CAResult_t CADeduplicationInitialize(void)
+{
+    if (g_dedupMap)
+    {
+        return CA_STATUS_OK;
+    }
+
+    g_dedupMutex = oc_mutex_new();
+    g_dedupMap = oc_hashmap_new(CADedupHashKey, CADedupEqualKey);
+    if (!g_dedupMutex || !g_dedupMap)
+    {
+        OIC_LOG(ERROR, TAG, "memory allocation failed");
+        CADeduplicationTerminate();
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+
+    return CA_STATUS_OK;
+}
+
+void CADeduplicationTerminate(void)
+{
+    if (g_dedupMutex)
+    {
+        oc_mutex_lock(g_dedupMutex);
+    }
+
+    if (g_dedupMap)
+    {
+        CADedupTrim(UINT64_MAX, 0);
+        oc_hashmap_free(g_dedupMap);
+        g_dedupMap = NULL;
+    }
+
+    if (g_dedupMutex)
+    {
+        oc_mutex_unlock(g_dedupMutex);
+        oc_mutex_free(g_dedupMutex);
+        g_dedupMutex = NULL;
+    }
+}
+
+CAResult_t CADeduplicationSetCacheSize(size_t maxEntries, size_t maxResponseSize)
+{
+    OIC_LOG_V(DEBUG, TAG, "max entries: %" PRIuPTR ", max response size: %" PRIuPTR,
+              maxEntries, maxResponseSize);
+
+    if (g_dedupMutex)
+    {
+        oc_mutex_lock(g_dedupMutex);
+    }
+
+    g_maxEntries = maxEntries;
+    g_maxResponseSize = maxResponseSize;
+
+    for (CADedupEntry_t *entry = g_dedupHead; entry; entry = entry->next)
+    {
+        if (entry->responseLength > maxResponseSize)
+        {
+            OICFree(entry->response);
+            entry->response = NULL;
+            entry->responseLength = 0;
+        }
+    }
+    if (g_dedupMap)
+    {
+        CADedupTrim(0, maxEntries);
+    }
+
+    if (g_dedupMutex)
+    {
+        oc_mutex_unlock(g_dedupMutex);
+    }
+    return CA_STATUS_OK;
+}
+
+bool CADeduplicationCheckRequest(const CAEndpoint_t *endpoint, uint16_t messageId,
+                                 void **response, uint32_t *responseLength)
+{
+    VERIFY_NON_NULL_RET(endpoint, TAG, "endpoint", false);
+    VERIFY_NON_NULL_RET(response, TAG, "response", false);
+    VERIFY_NON_NULL_RET(responseLength, TAG, "responseLength", false);
+
+    *response = NULL;
+    *responseLength = 0;
+
+    if (!g_dedupMap)
+    {
+        return false;
+    }
+
+    CADedupKey_t key;
+    CADedupMakeKey(&key, endpoint, messageId);
+    uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
+    bool duplicate = false;
+
+    oc_mutex_lock(g_dedupMutex);
+
+    CADedupTrim(currentTime, g_maxEntries);
+
+    CADedupEntry_t *entry = (CADedupEntry_t *) oc_hashmap_get(g_dedupMap, &key);
+    if (entry)
+    {
+        duplicate = true;
+        if (entry->response)
+        {
+            *response = OICMalloc(entry->responseLength);
+            if (*response)
+            {
+                memcpy(*response, entry->response, entry->responseLength);
+                *responseLength = entry->responseLength;
+            }
+        }
+    }
+    else if (0 < g_maxEntries)
+    {
+        if (oc_hashmap_size(g_dedupMap) >= g_maxEntries)
+        {
+            CADedupRemoveEntry(g_dedupHead);
+        }
+
+        entry = (CADedupEntry_t *) OICCalloc(1, sizeof(CADedupEntry_t));
+        if (entry)
+        {
+            entry->key = key;
+            entry->expiryTime = currentTime + (uint64_t) CA_EXCHANGE_LIFETIME_SEC * US_PER_SEC;
+            if (oc_hashmap_put(g_dedupMap, &entry->key, entry))
+            {
+                entry->prev = g_dedupTail;
+                if (g_dedupTail)
+                {
+                    g_dedupTail->next = entry;
+                }
+                else
+                {
+                    g_dedupHead = entry;
+                }
+                g_dedupTail = entry;
+            }
+            else
+            {
+                OIC_LOG(ERROR, TAG, "failed to remember request");
+                OICFree(entry);
+            }
+        }
+        else
+        {
+            OIC_LOG(ERROR, TAG, "memory allocation failed");
+        }
+    }
+
+    oc_mutex_unlock(g_dedupMutex);
+
+    return duplicate;
+}
+
+void CADeduplicationSaveResponse(const CAEndpoint_t *endpoint, uint16_t messageId,
+                                 const void *pdu, uint32_t size)
+{
+    VERIFY_NON_NULL_VOID(endpoint, TAG, "endpoint");
+    VERIFY_NON_NULL_VOID(pdu, TAG, "pdu");
+
+    if (!g_dedupMap)
+    {
+        return;
+    }
+
+    CADedupKey_t key;
+    CADedupMakeKey(&key, endpoint, messageId);
+
+    oc_mutex_lock(g_dedupMutex);
+
+    CADedupEntry_t *entry = (CADedupEntry_t *) oc_hashmap_get(g_dedupMap, &key);
+    if (entry && size <= g_maxResponseSize)
+    {
+        void *response = OICMalloc(size);
+        if (response)
+        {
+            memcpy(response, pdu, size);
+            OICFree(entry->response);
+            entry->response = response;
+            entry->responseLength = size;
+        }
+        else
+        {
+            OIC_LOG(ERROR, TAG, "memory allocation failed");
+        }
+    }
+
+    oc_mutex_unlock(g_dedupMutex);
+}
@@ -37,6 +37,7 @@
 #include "caadapterutils.h"
 #include "cainterfacecontroller.h"
 #include "caretransmission.h"
+#include "cadeduplication.h"
 #include "oic_string.h"
 
 #ifdef WITH_BWT
@@ -61,6 +62,14 @@ static ca_thread_pool_t g_threadPoolHandle = NULL;
 static CAQueueingThread_t g_sendThread;
 static CAQueueingThread_t g_receiveThread;
 
+#ifdef WITH_PROCESS_EVENT
+// event signaled when data is added to g_receiveThread
+static oc_event g_processEvent = NULL;
+
+// guards g_processEvent, which is replaced while the adapter threads signal it
+static oc_mutex g_processEventMutex = NULL;
+#endif
+
 #else
 #define CA_MAX_RT_ARRAY_SIZE    3
 #endif  // SINGLE_THREAD
@@ -91,6 +100,8 @@ static void CAProcessReceivedData(CAData_t *data);
 #endif
 static void CADestroyData(void *data, uint32_t size);
 static void CALogPayloadInfo(CAInfo_t *info);
+static bool CAIsDeduplicationSupported(CATransportAdapter_t adapter);
+static bool CADropDuplicateRequest(const CASecureEndpoint_t *sep, const coap_pdu_t *pdu);
 static bool CADropSecondMessage(CAHistory_t *history, const CAEndpoint_t *endpoint, uint16_t id,
                                 CAToken_t token, uint8_t tokenLength);
 
@@ -109,6 +120,26 @@ void CAAddDataToSendThread(CAData_t *data)
     // add thread
     CAQueueingThreadAddData(&g_sendThread, data, sizeof(CAData_t));
 }
+#endif
+
+#ifndef SINGLE_THREAD
+#ifdef WITH_PROCESS_EVENT
+static void CASignalProcessEvent()
+{
+    if (g_processEventMutex)
+    {
+        oc_mutex_lock(g_processEventMutex);
+    }
+    if (g_processEvent)
+    {
+        oc_event_signal(g_processEvent);
+    }
+    if (g_processEventMutex)
+    {
+        oc_mutex_unlock(g_processEventMutex);
+    }
+}
+#endif
 
 void CAAddDataToReceiveThread(CAData_t *data)
 {
@@ -116,6 +147,10 @@ void CAAddDataToReceiveThread(CAData_t *data)
 
     // add thread
     CAQueueingThreadAddData(&g_receiveThread, data, sizeof(CAData_t));
+
+#ifdef WITH_PROCESS_EVENT
+    CASignalProcessEvent();
+#endif
 }
 #endif
 
@@ -333,7 +368,7 @@ static void CATimeoutCallback(const CAEndpoint_t *endpoint, const void *pdu, uin
 #ifdef SINGLE_THREAD
     CAProcessReceivedData(cadata);
 #else
-    CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+    CAAddDataToReceiveThread(cadata);
 #endif
 }
 
@@ -437,7 +472,7 @@ static CAResult_t CAProcessMulticastData(const CAData_t *data)
 
     coap_pdu_t *pdu = NULL;
     CAInfo_t *info = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;     // about 2.4 KB, see CAPDUOptions_t
     coap_transport_t transport = COAP_UDP;
     CAResult_t res = CA_SEND_FAILED;
 
@@ -467,7 +502,6 @@ static CAResult_t CAProcessMulticastData(const CAData_t *data)
     {
         OIC_LOG(ERROR,TAG,"Failed to generate multicast PDU");
         CASendErrorInfo(data->remoteEndpoint, info, CA_SEND_FAILED);
-        coap_delete_list(options);
         return res;
     }
 
@@ -493,13 +527,11 @@ static CAResult_t CAProcessMulticastData(const CAData_t *data)
         goto exit;
     }
 
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
     return res;
 
 exit:
     CAErrorHandler(data->remoteEndpoint, pdu->transport_hdr, pdu->length, res);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
     return res;
 }
@@ -515,7 +547,7 @@ static CAResult_t CAProcessSendData(const CAData_t *data)
 
     coap_pdu_t *pdu = NULL;
     CAInfo_t *info = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;     // about 2.4 KB, see CAPDUOptions_t
     coap_transport_t transport = COAP_UDP;
 
     if (SEND_TYPE_UNICAST == type)
@@ -572,7 +604,6 @@ static CAResult_t CAProcessSendData(const CAData_t *data)
                     {
                         OIC_LOG(INFO, TAG, "to write block option has failed");
                         CAErrorHandler(data->remoteEndpoint, pdu->transport_hdr, pdu->length, res);
-                        coap_delete_list(options);
                         coap_delete_pdu(pdu);
                         return res;
                     }
@@ -587,11 +618,20 @@ static CAResult_t CAProcessSendData(const CAData_t *data)
             {
                 OIC_LOG_V(ERROR, TAG, "send failed:%d", res);
                 CAErrorHandler(data->remoteEndpoint, pdu->transport_hdr, pdu->length, res);
-                coap_delete_list(options);
                 coap_delete_pdu(pdu);
                 return res;
             }
 
+            // keep a piggybacked response for the duplicates of the request
+            if (NULL != data->responseInfo && CA_MSG_ACKNOWLEDGE == info->type
+                && CAIsDeduplicationSupported(data->remoteEndpoint->adapter))
+            {
+                CADeduplicationSaveResponse(data->remoteEndpoint,
+                                            CAGetMessageIdFromPduBinaryData(pdu->transport_hdr,
+                                                                            pdu->length),
+                                            pdu->transport_hdr, pdu->length);
+            }
+
 #ifdef WITH_TCP
             if (CAIsSupportedCoAPOverTCP(data->remoteEndpoint->adapter))
             {
@@ -612,13 +652,11 @@ static CAResult_t CAProcessSendData(const CAData_t *data)
                 {
                     //when retransmission not supported this will return CA_NOT_SUPPORTED, ignore
                     OIC_LOG_V(INFO, TAG, "retransmission is not enabled due to error, res : %d", res);
-                    coap_delete_list(options);
                     coap_delete_pdu(pdu);
                     return res;
                 }
             }
 
-            coap_delete_list(options);
             coap_delete_pdu(pdu);
         }
         else
@@ -676,6 +714,101 @@ static void CASendThreadProcess(void *threadData)
 }
 #endif
 
+static bool CAIsDeduplicationSupported(CATransportAdapter_t adapter)
+{
+#ifdef WITH_TCP
+    // CoAP over TCP has no message ID
+    if (CAIsSupportedCoAPOverTCP(adapter))
+    {
+        return false;
+    }
+#else
+    OC_UNUSED(adapter);
+#endif
+    return true;
+}
+
+#ifndef SINGLE_THREAD
+typedef struct
+{
+    CAEndpoint_t *endpoint;
+    void *pdu;
+    uint32_t size;
+} CAResendData_t;
+
+static void CAResendResponseThread(void *threadData)
+{
+    CAResendData_t *data = (CAResendData_t *) threadData;
+    CAResult_t res = CASendUnicastData(data->endpoint, data->pdu, data->size, CA_RESPONSE_DATA);
+    if (CA_STATUS_OK != res)
+    {
+        OIC_LOG_V(ERROR, TAG, "resend failed:%d", res);
+    }
+    CAFreeEndpoint(data->endpoint);
+    OICFree(data->pdu);
+    OICFree(data);
+}
+#endif
+
+/*
+ * If a request arrives again from the same endpoint with the same message ID within
+ * EXCHANGE_LIFETIME, drop it.  A confirmable request is answered with the piggybacked
+ * response sent for the first one, if it was kept.
+ */
+static bool CADropDuplicateRequest(const CASecureEndpoint_t *sep, const coap_pdu_t *pdu)
+{
+    if (!CAIsDeduplicationSupported(sep->endpoint.adapter))
+    {
+        return false;
+    }
+
+    uint16_t messageId = CAGetMessageIdFromPduBinaryData(pdu->transport_hdr, pdu->length);
+    void *response = NULL;
+    uint32_t responseLength = 0;
+    if (!CADeduplicationCheckRequest(&sep->endpoint, messageId, &response, &responseLength))
+    {
+        return false;
+    }
+
+    OIC_LOG_V(INFO, TAG, "duplicate request ignored, msgid=%d", messageId);
+    if (!response)
+    {
+        return true;
+    }
+
+    if (CA_MSG_CONFIRM == CAGetMessageTypeFromPduBinaryData(pdu->transport_hdr, pdu->length))
+    {
+#ifdef SINGLE_THREAD
+        // the secure adapters deliver requests from inside the decrypt path
+        if (!(sep->endpoint.flags & CA_SECURE))
+        {
+            CASendUnicastData(&sep->endpoint, response, responseLength, CA_RESPONSE_DATA);
+        }
+#else
+        // sending from the receive callback would re-enter the secure adapters
+        CAResendData_t *data = (CAResendData_t *) OICCalloc(1, sizeof(CAResendData_t));
+        if (data)
+        {
+            data->endpoint = CACloneEndpoint(&sep->endpoint);
+            data->pdu = response;
+            data->size = responseLength;
+            if (data->endpoint
+                && CA_STATUS_OK == ca_thread_pool_add_task(g_threadPoolHandle,
+                                                           CAResendResponseThread, data))
+            {
+                return true;
+            }
+            CAFreeEndpoint(data->endpoint);
+            OICFree(data);
+        }
+        OIC_LOG(ERROR, TAG, "failed to resend response");
+#endif
+    }
+
+    OICFree(response);
+    return true;
+}
+
 /*
  * If a second message arrives with the same message ID, token and the other address
  * family, drop it.  Typically, IPv6 beats IPv4, so the IPv4 message is dropped.
@@ -762,6 +895,12 @@ static void CAReceivedPacketCallback(const CASecureEndpoint_t *sep,
     OIC_LOG_V(DEBUG, TAG, "code = %d", code);
     if (CA_GET == code || CA_POST == code || CA_PUT == code || CA_DELETE == code)
     {
+        if (CADropDuplicateRequest(sep, pdu))
+        {
+            coap_delete_pdu(pdu);
+            goto exit;
+        }
+
         cadata = CAGenerateHandlerData(&(sep->endpoint), &(sep->identity), pdu, CA_REQUEST_DATA);
         if (!cadata)
         {
@@ -827,7 +966,7 @@ static void CAReceivedPacketCallback(const CASecureEndpoint_t *sep,
         if (CA_NOT_SUPPORTED == res || CA_REQUEST_TIMEOUT == res)
         {
             OIC_LOG(DEBUG, TAG, "this message does not have block option");
-            CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+            CAAddDataToReceiveThread(cadata);
         }
         else
         {
@@ -837,7 +976,7 @@ static void CAReceivedPacketCallback(const CASecureEndpoint_t *sep,
     else
 #endif
     {
-        CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+        CAAddDataToReceiveThread(cadata);
     }
 #endif // SINGLE_THREAD
 
@@ -850,6 +989,22 @@ exit:
     OIC_TRACE_END();
 }
 
+#ifdef WITH_PROCESS_EVENT
+void CASetProcessEvent(oc_event event)
+{
+    // Once this returns, no adapter thread signals the previous event any more.
+    if (g_processEventMutex)
+    {
+        oc_mutex_lock(g_processEventMutex);
+    }
+    g_processEvent = event;
+    if (g_processEventMutex)
+    {
+        oc_mutex_unlock(g_processEventMutex);
+    }
+}
+#endif
+
 void CAHandleRequestResponseCallbacks()
 {
 #ifdef SINGLE_THREAD
@@ -865,6 +1020,14 @@ void CAHandleRequestResponseCallbacks()
 
     u_queue_message_t *item = u_queue_get_element(g_receiveThread.dataQueue);
 
+#ifdef WITH_PROCESS_EVENT
+    // Only one item is handled per call; keep the event signaled while more are queued.
+    if (u_queue_get_size(g_receiveThread.dataQueue) > 0)
+    {
+        CASignalProcessEvent();
+    }
+#endif
+
     oc_mutex_unlock(g_receiveThread.threadMutex);
 
     if (NULL == item || NULL == item->msg)
@@ -1024,7 +1187,7 @@ CAResult_t CADetachSendMessage(const CAEndpoint_t *endpoint, const void *sendMsg
     {
         OIC_LOG(DEBUG, TAG,
                 "This is a loopback message. Transfer it to the receive queue directly");
-        CAQueueingThreadAddData(&g_receiveThread, data, sizeof(CAData_t));
+        CAAddDataToReceiveThread(data);
         return CA_STATUS_OK;
     }
 #ifdef WITH_BWT
@@ -1072,7 +1235,25 @@ CAResult_t CAInitializeMessageHandler(CATransportAdapter_t transportType)
     CASetPacketReceivedCallback(CAReceivedPacketCallback);
     CASetErrorHandleCallback(CAErrorHandler);
 
+    if (CA_STATUS_OK != CADeduplicationInitialize())
+    {
+        OIC_LOG(ERROR, TAG, "Failed to Initialize Deduplication.");
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+
 #ifndef SINGLE_THREAD
+#ifdef WITH_PROCESS_EVENT
+    if (!g_processEventMutex)
+    {
+        g_processEventMutex = oc_mutex_new();
+        if (!g_processEventMutex)
+        {
+            OIC_LOG(ERROR, TAG, "Failed to create process event mutex");
+            return CA_MEMORY_ALLOC_FAILED;
+        }
+    }
+#endif
+
     // create thread pool
     CAResult_t res = ca_thread_pool_init(MAX_THREAD_POOL_SIZE, &g_threadPoolHandle);
     if (CA_STATUS_OK != res)
@@ -1211,6 +1392,12 @@ void CATerminateMessageHandler()
 
     // terminate interface adapters by controller
     CATerminateAdapters();
+
+#ifdef WITH_PROCESS_EVENT
+    // No adapter thread is left to signal the process event.
+    oc_mutex_free(g_processEventMutex);
+    g_processEventMutex = NULL;
+#endif
 #else
     // terminate interface adapters by controller
     CATerminateAdapters();
@@ -1219,6 +1406,8 @@ void CATerminateMessageHandler()
     CARetransmissionStop(&g_retransmissionContext);
     CARetransmissionDestroy(&g_retransmissionContext);
 #endif // SINGLE_THREAD
+
+    CADeduplicationTerminate();
 }
 
 static void CALogPayloadInfo(CAInfo_t *info)
@@ -1290,7 +1479,7 @@ void CAErrorHandler(const CAEndpoint_t *endpoint,
 
     cadata->errorInfo->result = result;
 
-    CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+    CAAddDataToReceiveThread(cadata);
     coap_delete_pdu(pdu);
 #else
     (void)result;
@@ -1343,7 +1532,7 @@ static void CASendErrorInfo(const CAEndpoint_t *endpoint, const CAInfo_t *info,
     cadata->errorInfo = errorInfo;
     cadata->dataType = CA_ERROR_DATA;
 
-    CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+    CAAddDataToReceiveThread(cadata);
 #endif
     OIC_LOG(DEBUG, TAG, "CASendErrorInfo OUT");
 }
@@ -99,11 +99,14 @@ CAResult_t CAGetErrorInfoFromPDU(const coap_pdu_t *pdu, const CAEndpoint_t *endp
 }
 
 coap_pdu_t *CAGeneratePDU(uint32_t code, const CAInfo_t *info, const CAEndpoint_t *endpoint,
-                          coap_list_t **optlist, coap_transport_t *transport)
+                          CAPDUOptions_t *options, coap_transport_t *transport)
 {
     VERIFY_NON_NULL_RET(info, TAG, "info", NULL);
     VERIFY_NON_NULL_RET(endpoint, TAG, "endpoint", NULL);
-    VERIFY_NON_NULL_RET(optlist, TAG, "optlist", NULL);
+    VERIFY_NON_NULL_RET(options, TAG, "options", NULL);
+
+    options->numOptions = 0;
+    options->bufferLength = 0;
 
     OIC_LOG_V(DEBUG, TAG, "generate pdu for [%d]adapter, [%d]flags",
               endpoint->adapter, endpoint->flags);
@@ -146,34 +149,25 @@ coap_pdu_t *CAGeneratePDU(uint32_t code, const CAInfo_t *info, const CAEndpoint_
                 return NULL;
             }
 
-            size_t uriLength = length + sizeof(COAP_URI_HEADER);
-            char *coapUri = (char *) OICCalloc(1, uriLength);
-            if (NULL == coapUri)
-            {
-                OIC_LOG(ERROR, TAG, "out of memory");
-                return NULL;
-            }
-            OICStrcat(coapUri, uriLength, COAP_URI_HEADER);
-            OICStrcat(coapUri, uriLength, info->resourceUri);
+            char coapUri[CA_MAX_URI_LENGTH + sizeof(COAP_URI_HEADER)];
+            memcpy(coapUri, COAP_URI_HEADER, sizeof(COAP_URI_HEADER) - 1);
+            memcpy(coapUri + sizeof(COAP_URI_HEADER) - 1, info->resourceUri, length + 1);
 
             // parsing options in URI
-            CAResult_t res = CAParseURI(coapUri, optlist);
+            CAResult_t res = CAParseURI(coapUri, options);
             if (CA_STATUS_OK != res)
             {
-                OICFree(coapUri);
                 return NULL;
             }
-
-            OICFree(coapUri);
         }
         // parsing options in HeadOption
-        CAResult_t ret = CAParseHeadOption(code, info, optlist);
+        CAResult_t ret = CAParseHeadOption(code, info, options);
         if (CA_STATUS_OK != ret)
         {
             return NULL;
         }
 
-        pdu = CAGeneratePDUImpl((code_t) code, info, endpoint, *optlist, transport);
+        pdu = CAGeneratePDUImpl((code_t) code, info, endpoint, options, transport);
         if (NULL == pdu)
         {
             OIC_LOG(ERROR, TAG, "pdu NULL");
@@ -254,7 +248,7 @@ exit:
 }
 
 coap_pdu_t *CAGeneratePDUImpl(code_t code, const CAInfo_t *info,
-                              const CAEndpoint_t *endpoint, coap_list_t *options,
+                              const CAEndpoint_t *endpoint, const CAPDUOptions_t *options,
                               coap_transport_t *transport)
 {
     VERIFY_NON_NULL_RET(info, TAG, "info", NULL);
@@ -271,16 +265,16 @@ coap_pdu_t *CAGeneratePDUImpl(code_t code, const CAInfo_t *info,
         if (options)
         {
             unsigned short prevOptNumber = 0;
-            for (coap_list_t *opt = options; opt; opt = opt->next)
+            for (size_t i = 0; i < options->numOptions; i++)
             {
-                unsigned short curOptNumber = COAP_OPTION_KEY(*(coap_option *) opt->data);
+                unsigned short curOptNumber = options->options[i].key;
                 if (prevOptNumber > curOptNumber)
                 {
                     OIC_LOG(ERROR, TAG, "option list is wrong");
                     return NULL;
                 }
 
-                size_t optValueLen = COAP_OPTION_LENGTH(*(coap_option *) opt->data);
+                size_t optValueLen = options->options[i].length;
                 size_t optLength = coap_get_opt_header_length(curOptNumber - prevOptNumber, optValueLen);
                 if (0 == optLength)
                 {
@@ -380,15 +374,13 @@ coap_pdu_t *CAGeneratePDUImpl(code_t code, const CAInfo_t *info,
 
     if (options)
     {
-        for (coap_list_t *opt = options; opt; opt = opt->next)
+        for (size_t i = 0; i < options->numOptions; i++)
         {
-            OIC_LOG_V(DEBUG, TAG, "[%s] opt will be added.",
-                      COAP_OPTION_DATA(*(coap_option *) opt->data));
+            const CAPDUOption_t *opt = &options->options[i];
+            OIC_LOG_V(DEBUG, TAG, "[%d] opt will be added.", opt->key);
 
             OIC_LOG_V(DEBUG, TAG, "[%d] pdu length", pdu->length);
-            if (0 == coap_add_option2(pdu, COAP_OPTION_KEY(*(coap_option *) opt->data),
-                                      COAP_OPTION_LENGTH(*(coap_option *) opt->data),
-                                      COAP_OPTION_DATA(*(coap_option *) opt->data), *transport))
+            if (0 == coap_add_option2(pdu, opt->key, opt->length, opt->data, *transport))
             {
                 OIC_LOG(ERROR, TAG, "coap_add_option2 has failed");
                 coap_delete_pdu(pdu);
@@ -409,7 +401,7 @@ coap_pdu_t *CAGeneratePDUImpl(code_t code, const CAInfo_t *info,
     return pdu;
 }
 
-CAResult_t CAParseURI(const char *uriInfo, coap_list_t **optlist)
+CAResult_t CAParseURI(const char *uriInfo, CAPDUOptions_t *optlist)
 {
     VERIFY_NON_NULL(uriInfo, TAG, "uriInfo");
     VERIFY_NON_NULL(optlist, TAG, "optlist");
@@ -420,13 +412,8 @@ CAResult_t CAParseURI(const char *uriInfo, coap_list_t **optlist)
 
     if (uri.port != COAP_DEFAULT_PORT)
     {
-        unsigned char portbuf[CA_ENCODE_BUFFER_SIZE] = { 0 };
-        int ret = coap_insert(optlist,
-                              CACreateNewOptionNode(COAP_OPTION_URI_PORT,
-                                                    coap_encode_var_bytes(portbuf, uri.port),
-                                                    (char *)portbuf),
-                              CAOrderOpts);
-        if (ret <= 0)
+        CAResult_t ret = CAAddPDUUintOption(optlist, COAP_OPTION_URI_PORT, uri.port);
+        if (CA_STATUS_OK != ret)
         {
             return CA_STATUS_INVALID_PARAM;
         }
@@ -458,7 +445,7 @@ CAResult_t CAParseURI(const char *uriInfo, coap_list_t **optlist)
 }
 
 CAResult_t CAParseUriPartial(const unsigned char *str, size_t length, uint16_t target,
-                             coap_list_t **optlist)
+                             CAPDUOptions_t *optlist)
 {
     VERIFY_NON_NULL(optlist, TAG, "optlist");
 
@@ -470,30 +457,28 @@ CAResult_t CAParseUriPartial(const unsigned char *str, size_t length, uint16_t t
     }
     else if (str && length)
     {
-        unsigned char uriBuffer[CA_MAX_URI_LENGTH] = { 0 };
-        unsigned char *pBuf = uriBuffer;
-        size_t unusedBufferSize = sizeof(uriBuffer);
+        // the options are split into the options buffer and their values are referenced there
+        unsigned char *pBuf = optlist->buffer + optlist->bufferLength;
+        size_t bufferSize = sizeof(optlist->buffer) - optlist->bufferLength;
+        size_t unusedBufferSize = bufferSize;
         int res = (target == COAP_OPTION_URI_PATH) ? coap_split_path(str, length, pBuf, &unusedBufferSize) :
                                                      coap_split_query(str, length, pBuf, &unusedBufferSize);
 
         if (res > 0)
         {
-            assert(unusedBufferSize < sizeof(uriBuffer));
-            size_t usedBufferSize = sizeof(uriBuffer) - unusedBufferSize;
+            assert(unusedBufferSize < bufferSize);
             size_t prevIdx = 0;
             while (res--)
             {
-                int ret = coap_insert(optlist,
-                                      CACreateNewOptionNode(target, COAP_OPT_LENGTH(pBuf),
-                                                            (char *)COAP_OPT_VALUE(pBuf)),
-                                      CAOrderOpts);
-                if (ret <= 0)
+                CAResult_t ret = CAAddPDUOption(optlist, target, COAP_OPT_LENGTH(pBuf),
+                                                COAP_OPT_VALUE(pBuf));
+                if (CA_STATUS_OK != ret)
                 {
                     return CA_STATUS_INVALID_PARAM;
                 }
 
                 size_t optSize = COAP_OPT_SIZE(pBuf);
-                if (prevIdx + optSize > usedBufferSize)
+                if (prevIdx + optSize > bufferSize)
                 {
                     assert(false);
                     return CA_STATUS_INVALID_PARAM;
@@ -501,6 +486,9 @@ CAResult_t CAParseUriPartial(const unsigned char *str, size_t length, uint16_t t
                 pBuf += optSize;
                 prevIdx += optSize;
             }
+            // coap_split_path and coap_split_query report the buffer size differently,
+            // so keep what the options took.
+            optlist->bufferLength += prevIdx;
         }
         else
         {
@@ -517,7 +505,7 @@ CAResult_t CAParseUriPartial(const unsigned char *str, size_t length, uint16_t t
     return CA_STATUS_OK;
 }
 
-CAResult_t CAParseHeadOption(uint32_t code, const CAInfo_t *info, coap_list_t **optlist)
+CAResult_t CAParseHeadOption(uint32_t code, const CAInfo_t *info, CAPDUOptions_t *optlist)
 {
     (void)code;
     VERIFY_NON_NULL_RET(info, TAG, "info", CA_STATUS_INVALID_PARAM);
@@ -554,11 +542,8 @@ CAResult_t CAParseHeadOption(uint32_t code, const CAInfo_t *info, coap_list_t **
             default:
                 OIC_LOG_V(DEBUG, TAG, "Head opt ID[%d], length[%d]", id,
                     (info->options + i)->optionLength);
-                int ret = coap_insert(optlist,
-                                      CACreateNewOptionNode(id, (info->options + i)->optionLength,
-                                                            (info->options + i)->optionData),
-                                      CAOrderOpts);
-                if (ret <= 0)
+                if (CA_STATUS_OK != CAAddPDUOption(optlist, id, (info->options + i)->optionLength,
+                                                   (const uint8_t *) (info->options + i)->optionData))
                 {
                     return CA_STATUS_INVALID_PARAM;
                 }
@@ -580,38 +565,25 @@ CAResult_t CAParseHeadOption(uint32_t code, const CAInfo_t *info, coap_list_t **
 }
 
 CAResult_t CAParsePayloadFormatHeadOption(uint16_t formatOption, CAPayloadFormat_t format,
-        uint16_t versionOption, uint16_t version, coap_list_t **optlist)
+        uint16_t versionOption, uint16_t version, CAPDUOptions_t *optlist)
 {
-    coap_list_t* encodeNode = NULL;
-    coap_list_t* versionNode = NULL;
-    uint8_t encodeBuf[CA_ENCODE_BUFFER_SIZE] = { 0 };
-    uint8_t versionBuf[CA_ENCODE_BUFFER_SIZE] = { 0 };
+    unsigned short mediaType = 0;
 
     switch (format)
     {
         case CA_FORMAT_APPLICATION_CBOR:
-            encodeNode = CACreateNewOptionNode(formatOption,
-                    coap_encode_var_bytes(encodeBuf,
-                            (unsigned short) COAP_MEDIATYPE_APPLICATION_CBOR), (char *) encodeBuf);
+            mediaType = (unsigned short) COAP_MEDIATYPE_APPLICATION_CBOR;
             break;
         case CA_FORMAT_APPLICATION_VND_OCF_CBOR:
-            encodeNode = CACreateNewOptionNode(formatOption,
-                    coap_encode_var_bytes(encodeBuf,
-                            (unsigned short) COAP_MEDIATYPE_APPLICATION_VND_OCF_CBOR),
-                    (char *) encodeBuf);
+            mediaType = (unsigned short) COAP_MEDIATYPE_APPLICATION_VND_OCF_CBOR;
             break;
         default:
             OIC_LOG_V(ERROR, TAG, "Format option:[%d] not supported", format);
+            OIC_LOG(ERROR, TAG, "Format option not created");
+            return CA_STATUS_INVALID_PARAM;
     }
-    if (!encodeNode)
-    {
-        OIC_LOG(ERROR, TAG, "Format option not created");
-        return CA_STATUS_INVALID_PARAM;
-    }
-    int ret = coap_insert(optlist, encodeNode, CAOrderOpts);
-    if (0 >= ret)
+    if (CA_STATUS_OK != CAAddPDUUintOption(optlist, formatOption, mediaType))
     {
-        coap_delete(encodeNode);
         OIC_LOG(ERROR, TAG, "Format option not inserted in header");
         return CA_STATUS_INVALID_PARAM;
     }
@@ -620,20 +592,8 @@ CAResult_t CAParsePayloadFormatHeadOption(uint16_t formatOption, CAPayloadFormat
          CA_OPTION_CONTENT_VERSION == versionOption) &&
         CA_FORMAT_APPLICATION_VND_OCF_CBOR == format)
     {
-        versionNode = CACreateNewOptionNode(versionOption,
-                coap_encode_var_bytes(versionBuf, version), (char *) versionBuf);
-
-        if (!versionNode)
-        {
-            OIC_LOG(ERROR, TAG, "Version option not created");
-            coap_delete(encodeNode);
-            return CA_STATUS_INVALID_PARAM;
-        }
-        ret = coap_insert(optlist, versionNode, CAOrderOpts);
-        if (0 >= ret)
+        if (CA_STATUS_OK != CAAddPDUUintOption(optlist, versionOption, version))
         {
-            coap_delete(versionNode);
-            coap_delete(encodeNode);
             OIC_LOG(ERROR, TAG, "Content version option not inserted in header");
             return CA_STATUS_INVALID_PARAM;
         }
@@ -641,19 +601,58 @@ CAResult_t CAParsePayloadFormatHeadOption(uint16_t formatOption, CAPayloadFormat
     return CA_STATUS_OK;
 }
 
-coap_list_t *CACreateNewOptionNode(uint16_t key, uint32_t length, const char *data)
+/**
+ * Inserts an option after the options with the same or a lower key. Options are
+ * mostly added in order, so this rarely moves any of them.
+ */
+static CAResult_t CAInsertPDUOption(CAPDUOptions_t *options, uint16_t key, uint16_t length,
+                                    const uint8_t *data)
 {
-    VERIFY_NON_NULL_RET(data, TAG, "data", NULL);
+    if (CA_PDU_MAX_OPTIONS <= options->numOptions)
+    {
+        OIC_LOG_V(ERROR, TAG, "too many options, the limit is %d", CA_PDU_MAX_OPTIONS);
+        return CA_STATUS_FAILED;
+    }
 
-    coap_option *option = coap_malloc(sizeof(coap_option) + length + 1);
-    if (!option)
+    size_t index = options->numOptions;
+    while (index && options->options[index - 1].key > key)
     {
-        OIC_LOG(ERROR, TAG, "Out of memory");
-        return NULL;
+        options->options[index] = options->options[index - 1];
+        index--;
     }
-    memset(option, 0, sizeof(coap_option) + length + 1);
+    options->options[index].key = key;
+    options->options[index].length = length;
+    options->options[index].data = data;
+    options->numOptions++;
+
+    return CA_STATUS_OK;
+}
 
-    COAP_OPTION_KEY(*option) = key;
+CAResult_t CAAddPDUUintOption(CAPDUOptions_t *options, uint16_t key, uint32_t value)
+{
+    VERIFY_NON_NULL(options, TAG, "options");
+
+    if (CA_ENCODE_BUFFER_SIZE > sizeof(options->buffer) - options->bufferLength)
+    {
+        OIC_LOG(ERROR, TAG, "option buffer is full");
+        return CA_STATUS_FAILED;
+    }
+
+    uint8_t *data = options->buffer + options->bufferLength;
+    unsigned int length = coap_encode_var_bytes(data, value);
+    CAResult_t res = CAInsertPDUOption(options, key, (uint16_t) length, data);
+    if (CA_STATUS_OK == res)
+    {
+        options->bufferLength += length;
+    }
+    return res;
+}
+
+CAResult_t CAAddPDUOption(CAPDUOptions_t *options, uint16_t key, uint32_t length,
+                          const uint8_t *data)
+{
+    VERIFY_NON_NULL(options, TAG, "options");
+    VERIFY_NON_NULL(data, TAG, "data");
 
     coap_option_def_t* def = coap_opt_def(key);
     if (NULL != def && coap_is_var_bytes(def))
@@ -669,42 +668,16 @@ coap_list_t *CACreateNewOptionNode(uint16_t key, uint32_t length, const char *da
         }
         // Shrink the encoding length to a minimum size for coap
         // options that support variable length encoding.
-         COAP_OPTION_LENGTH(*option) = coap_encode_var_bytes(
-                COAP_OPTION_DATA(*option),
-                coap_decode_var_bytes((unsigned char *)data, length));
-    }
-    else
-    {
-        COAP_OPTION_LENGTH(*option) = length;
-        memcpy(COAP_OPTION_DATA(*option), data, length);
+        return CAAddPDUUintOption(options, key,
+                                  coap_decode_var_bytes((unsigned char *)data, length));
     }
 
-    /* we can pass NULL here as delete function since option is released automatically  */
-    coap_list_t *node = coap_new_listnode(option, NULL);
-
-    if (!node)
+    if (UINT16_MAX < length)
     {
-        OIC_LOG(ERROR, TAG, "node is NULL");
-        coap_free(option);
-        return NULL;
-    }
-
-    return node;
-}
-
-int CAOrderOpts(void *a, void *b)
-{
-    if (!a || !b)
-    {
-        return a < b ? -1 : 1;
-    }
-
-    if (COAP_OPTION_KEY(*(coap_option *) a) < COAP_OPTION_KEY(*(coap_option * ) b))
-    {
-        return -1;
+        OIC_LOG(ERROR, TAG, "option is too long");
+        return CA_STATUS_INVALID_PARAM;
     }
-
-    return COAP_OPTION_KEY(*(coap_option *) a) == COAP_OPTION_KEY(*(coap_option * ) b);
+    return CAInsertPDUOption(options, key, (uint16_t) length, data);
 }
 
 CAResult_t CAGetOptionCount(coap_opt_iterator_t opt_iter, uint8_t *optionCount)
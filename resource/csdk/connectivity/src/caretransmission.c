@@ -75,21 +75,31 @@
 
 #define TAG "OIC_CA_RETRANS"
 
+typedef struct
+{
+    uint16_t messageId;                 /**< coap PDU message id */
+    CATransportAdapter_t adapter;       /**< transport adapter of the remote endpoint */
+} CARetransmissionKey_t;
+
 typedef struct
 {
     uint64_t timeStamp;                 /**< last sent time. microseconds */
 #ifndef SINGLE_THREAD
     uint64_t timeout;                   /**< timeout value. microseconds */
 #endif
+    uint64_t nextTime;                  /**< next retransmission time. microseconds */
+    size_t heapIndex;                   /**< position in the dataList heap */
     uint8_t triedCount;                 /**< retransmission count */
-    uint16_t messageId;                 /**< coap PDU message id */
+    CARetransmissionKey_t key;          /**< key of the data in dataMap */
     CADataType_t dataType;              /**< data Type (Request/Response) */
     CAEndpoint_t *endpoint;             /**< remote endpoint */
     void *pdu;                          /**< coap PDU */
     uint32_t size;                      /**< coap PDU size */
 } CARetransmissionData_t;
 
+#ifdef SINGLE_THREAD
 static const uint64_t USECS_PER_SEC = 1000000;
+#endif
 static const uint64_t USECS_PER_MSEC = 1000;
 static const uint64_t MSECS_PER_SEC = 1000;
 
@@ -141,36 +151,134 @@ CAResult_t CARetransmissionStart(CARetransmission_t *context)
 #endif
 
 /**
- * @brief   check timeout routine
- * @param   currentTime     [IN]microseconds
+ * @brief   calculate the time of the next retransmission
  * @param   retData         [IN]retransmission data
- * @return  true if the timeout period has elapsed, false otherwise
+ * @return  microseconds
  */
-static bool CACheckTimeout(uint64_t currentTime, CARetransmissionData_t *retData)
+static uint64_t CAGetNextRetransmissionTime(const CARetransmissionData_t *retData)
 {
 #ifndef SINGLE_THREAD
-    // #1. calculate timeout
     uint64_t milliTimeoutValue = retData->timeout / USECS_PER_MSEC;
     uint64_t timeout = (milliTimeoutValue << retData->triedCount) * USECS_PER_MSEC;
+#else
+    uint64_t timeout = (2 << retData->triedCount) * (uint64_t) USECS_PER_SEC;
+#endif
+    return retData->timeStamp + timeout;
+}
+
+static uint32_t CARetransmissionKeyHash(const void *key)
+{
+    const CARetransmissionKey_t *rtKey = (const CARetransmissionKey_t *) key;
+    uint32_t hash = oc_hashmap_hash_bytes(&rtKey->messageId, sizeof(rtKey->messageId), 0);
+    return oc_hashmap_hash_bytes(&rtKey->adapter, sizeof(rtKey->adapter), hash);
+}
+
+static bool CARetransmissionKeyEqual(const void *key1, const void *key2)
+{
+    const CARetransmissionKey_t *rtKey1 = (const CARetransmissionKey_t *) key1;
+    const CARetransmissionKey_t *rtKey2 = (const CARetransmissionKey_t *) key2;
+    return (rtKey1->messageId == rtKey2->messageId) && (rtKey1->adapter == rtKey2->adapter);
+}
 
-    if (currentTime >= retData->timeStamp + timeout)
+/*
+ * dataList is a binary min-heap ordered by nextTime, so the data to retransmit
+ * first is always at index 0. Each data remembers its position for removal.
+ */
+static void CASetHeapData(u_arraylist_t *heap, size_t index, CARetransmissionData_t *retData)
+{
+    u_arraylist_set(heap, index, retData);
+    retData->heapIndex = index;
+}
+
+static void CAHeapSiftUp(u_arraylist_t *heap, size_t index)
+{
+    CARetransmissionData_t *retData = (CARetransmissionData_t *) u_arraylist_get(heap, index);
+    while (index > 0)
     {
-        OIC_LOG_V(DEBUG, TAG, "%" PRIu64 " microseconds time out!!, tried count(%d)",
-                  timeout, retData->triedCount);
-        return true;
+        size_t parent = (index - 1) / 2;
+        CARetransmissionData_t *parentData =
+                (CARetransmissionData_t *) u_arraylist_get(heap, parent);
+        if (parentData->nextTime <= retData->nextTime)
+        {
+            break;
+        }
+        CASetHeapData(heap, index, parentData);
+        index = parent;
     }
-#else
-    // #1. calculate timeout
-    uint64_t timeOut = (2 << retData->triedCount) * (uint64_t) USECS_PER_SEC;
+    CASetHeapData(heap, index, retData);
+}
 
-    if (currentTime >= retData->timeStamp + timeOut)
+static void CAHeapSiftDown(u_arraylist_t *heap, size_t index)
+{
+    size_t len = u_arraylist_length(heap);
+    CARetransmissionData_t *retData = (CARetransmissionData_t *) u_arraylist_get(heap, index);
+    while (true)
     {
-        OIC_LOG_V(DEBUG, TAG, "timeout=%d, tried cnt=%d",
-                  (2 << retData->triedCount), retData->triedCount);
-        return true;
+        size_t child = 2 * index + 1;
+        if (child >= len)
+        {
+            break;
+        }
+        CARetransmissionData_t *childData =
+                (CARetransmissionData_t *) u_arraylist_get(heap, child);
+        if (child + 1 < len)
+        {
+            CARetransmissionData_t *rightData =
+                    (CARetransmissionData_t *) u_arraylist_get(heap, child + 1);
+            if (rightData->nextTime < childData->nextTime)
+            {
+                child++;
+                childData = rightData;
+            }
+        }
+        if (retData->nextTime <= childData->nextTime)
+        {
+            break;
+        }
+        CASetHeapData(heap, index, childData);
+        index = child;
     }
-#endif
-    return false;
+    CASetHeapData(heap, index, retData);
+}
+
+static bool CAAddRetransmissionData(CARetransmission_t *context, CARetransmissionData_t *retData)
+{
+    if (!u_arraylist_add(context->dataList, (void *) retData))
+    {
+        return false;
+    }
+    if (!oc_hashmap_put(context->dataMap, &retData->key, retData))
+    {
+        u_arraylist_remove(context->dataList, u_arraylist_length(context->dataList) - 1);
+        return false;
+    }
+    CAHeapSiftUp(context->dataList, u_arraylist_length(context->dataList) - 1);
+    return true;
+}
+
+static void CARemoveRetransmissionData(CARetransmission_t *context,
+                                       CARetransmissionData_t *retData)
+{
+    u_arraylist_t *heap = context->dataList;
+    size_t index = retData->heapIndex;
+    size_t last = u_arraylist_length(heap) - 1;
+
+    oc_hashmap_remove(context->dataMap, &retData->key);
+
+    CARetransmissionData_t *lastData = (CARetransmissionData_t *) u_arraylist_remove(heap, last);
+    if (index != last)
+    {
+        CASetHeapData(heap, index, lastData);
+        CAHeapSiftUp(heap, index);
+        CAHeapSiftDown(heap, lastData->heapIndex);
+    }
+}
+
+static void CADestroyRetransmissionData(CARetransmissionData_t *retData)
+{
+    CAFreeEndpoint(retData->endpoint);
+    OICFree(retData->pdu);
+    OICFree(retData);
 }
 
 static void CACheckRetransmissionList(CARetransmission_t *context)
@@ -184,64 +292,54 @@ static void CACheckRetransmissionList(CARetransmission_t *context)
     // mutex lock
     oc_mutex_lock(context->threadMutex);
 
-    size_t len = u_arraylist_length(context->dataList);
+    uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
 
-    for (size_t i = 0; i < len; i++)
+    // only the data whose time is up are visited, earliest first.
+    while (u_arraylist_length(context->dataList) > 0)
     {
-        CARetransmissionData_t *retData = u_arraylist_get(context->dataList, i);
-
-        if (NULL == retData)
+        CARetransmissionData_t *retData =
+                (CARetransmissionData_t *) u_arraylist_get(context->dataList, 0);
+        if (retData->nextTime > currentTime)
         {
-            continue;
+            break;
         }
 
-        uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
+        OIC_LOG_V(DEBUG, TAG, "%" PRIu64 " microseconds time out!!, tried count(%d)",
+                  currentTime - retData->timeStamp, retData->triedCount);
 
-        if (CACheckTimeout(currentTime, retData))
+        // #1. if time's up, send the data.
+        if (NULL != context->dataSendMethod)
         {
-            // #2. if time's up, send the data.
-            if (NULL != context->dataSendMethod)
-            {
-                OIC_LOG_V(DEBUG, TAG, "retransmission CON data!!, msgid=%d",
-                          retData->messageId);
-                context->dataSendMethod(retData->endpoint, retData->pdu,
-                                        retData->size, retData->dataType);
-            }
-
-            // #3. increase the retransmission count and update timestamp.
-            retData->timeStamp = currentTime;
-            retData->triedCount++;
+            OIC_LOG_V(DEBUG, TAG, "retransmission CON data!!, msgid=%d",
+                      retData->key.messageId);
+            context->dataSendMethod(retData->endpoint, retData->pdu,
+                                    retData->size, retData->dataType);
         }
 
-        // #4. if tried count is max, remove the retransmission data from list.
+        // #2. increase the retransmission count and update timestamp.
+        retData->timeStamp = currentTime;
+        retData->triedCount++;
+
+        // #3. if tried count is max, remove the retransmission data from list.
         if (retData->triedCount >= context->config.tryingCount)
         {
-            CARetransmissionData_t *removedData = u_arraylist_remove(context->dataList, i);
-            if (NULL == removedData)
-            {
-                OIC_LOG(ERROR, TAG, "Removed data is NULL");
-                // mutex unlock
-                oc_mutex_unlock(context->threadMutex);
-                return;
-            }
+            CARemoveRetransmissionData(context, retData);
             OIC_LOG_V(DEBUG, TAG, "max trying count, remove RTCON data,"
-                      "msgid=%d", removedData->messageId);
+                      "msgid=%d", retData->key.messageId);
 
             // callback for retransmit timeout
             if (NULL != context->timeoutCallback)
             {
-                context->timeoutCallback(removedData->endpoint, removedData->pdu,
-                                         removedData->size);
+                context->timeoutCallback(retData->endpoint, retData->pdu,
+                                         retData->size);
             }
 
-            CAFreeEndpoint(removedData->endpoint);
-            OICFree(removedData->pdu);
-
-            OICFree(removedData);
-
-            // modify loop value.
-            len = u_arraylist_length(context->dataList);
-            --i;
+            CADestroyRetransmissionData(retData);
+        }
+        else
+        {
+            retData->nextTime = CAGetNextRetransmissionTime(retData);
+            CAHeapSiftDown(context->dataList, 0);
         }
     }
 
@@ -288,13 +386,16 @@ void CARetransmissionBaseRoutine(void *threadValue)
         }
         else if (!context->isStop)
         {
-            // check each RETRANSMISSION_CHECK_PERIOD_SEC time.
-            OIC_LOG_V(DEBUG, TAG, "wait..(%" PRIu64 ")microseconds",
-                      RETRANSMISSION_CHECK_PERIOD_SEC * (uint64_t) USECS_PER_SEC);
-
-            // wait
-            uint64_t absTime = RETRANSMISSION_CHECK_PERIOD_SEC * (uint64_t) USECS_PER_SEC;
-            oc_cond_wait_for(context->threadCond, context->threadMutex, absTime );
+            // sleep until the earliest retransmission time; new data wakes the thread up.
+            CARetransmissionData_t *retData =
+                    (CARetransmissionData_t *) u_arraylist_get(context->dataList, 0);
+            uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
+            if (retData->nextTime > currentTime)
+            {
+                uint64_t waitTime = retData->nextTime - currentTime;
+                OIC_LOG_V(DEBUG, TAG, "wait..(%" PRIu64 ")microseconds", waitTime);
+                oc_cond_wait_for(context->threadCond, context->threadMutex, waitTime);
+            }
         }
         else
         {
@@ -344,8 +445,8 @@ CAResult_t CARetransmissionInitialize(CARetransmission_t *context,
 
     memset(context, 0, sizeof(CARetransmission_t));
 
-    CARetransmissionConfig_t cfg = { .supportType = DEFAULT_RETRANSMISSION_TYPE,
-                                     .tryingCount = DEFAULT_RETRANSMISSION_COUNT };
+    CARetransmissionConfig_t cfg = { (CATransportAdapter_t) DEFAULT_RETRANSMISSION_TYPE,
+                                     DEFAULT_RETRANSMISSION_COUNT };
 
     if (config)
     {
@@ -361,6 +462,15 @@ CAResult_t CARetransmissionInitialize(CARetransmission_t *context,
     context->config = cfg;
     context->isStop = false;
     context->dataList = u_arraylist_create();
+    context->dataMap = oc_hashmap_new(CARetransmissionKeyHash, CARetransmissionKeyEqual);
+
+    if (NULL == context->threadMutex || NULL == context->threadCond
+        || NULL == context->dataList || NULL == context->dataMap)
+    {
+        OIC_LOG(ERROR, TAG, "memory error");
+        CARetransmissionDestroy(context);
+        return CA_MEMORY_ALLOC_FAILED;
+    }
 
     return CA_STATUS_OK;
 }
@@ -431,53 +541,49 @@ CAResult_t CARetransmissionSentData(CARetransmission_t *context,
     retData->timeout = CAGetTimeoutValue();
 #endif
     retData->triedCount = 0;
-    retData->messageId = messageId;
+    retData->nextTime = CAGetNextRetransmissionTime(retData);
+    retData->key.messageId = messageId;
+    retData->key.adapter = endpoint->adapter;
     retData->endpoint = remoteEndpoint;
     retData->pdu = pduData;
     retData->size = size;
     retData->dataType = dataType;
-#ifndef SINGLE_THREAD
+
     // mutex lock
     oc_mutex_lock(context->threadMutex);
 
-    size_t len = u_arraylist_length(context->dataList);
-
     // #3. add data into list
-    for (size_t i = 0; i < len; i++)
+    if (oc_hashmap_get(context->dataMap, &retData->key))
     {
-        CARetransmissionData_t *currData = u_arraylist_get(context->dataList, i);
+        OIC_LOG(ERROR, TAG, "Duplicate message ID");
 
-        if (NULL == currData)
-        {
-            continue;
-        }
+        // mutex unlock
+        oc_mutex_unlock(context->threadMutex);
 
-        // found index
-        if (NULL != currData->endpoint && currData->messageId == messageId
-            && (currData->endpoint->adapter == endpoint->adapter))
-        {
-            OIC_LOG(ERROR, TAG, "Duplicate message ID");
+        CADestroyRetransmissionData(retData);
+        return CA_STATUS_FAILED;
+    }
 
-            // mutex unlock
-            oc_mutex_unlock(context->threadMutex);
+    if (!CAAddRetransmissionData(context, retData))
+    {
+        OIC_LOG(ERROR, TAG, "memory error");
 
-            OICFree(retData);
-            OICFree(pduData);
-            OICFree(remoteEndpoint);
-            return CA_STATUS_FAILED;
-        }
-    }
+        // mutex unlock
+        oc_mutex_unlock(context->threadMutex);
 
-    u_arraylist_add(context->dataList, (void *) retData);
+        CADestroyRetransmissionData(retData);
+        return CA_MEMORY_ALLOC_FAILED;
+    }
 
+#ifndef SINGLE_THREAD
     // notify the thread
     oc_cond_signal(context->threadCond);
 
     // mutex unlock
     oc_mutex_unlock(context->threadMutex);
-
 #else
-    u_arraylist_add(context->dataList, (void *) retData);
+    // mutex unlock
+    oc_mutex_unlock(context->threadMutex);
 
     CACheckRetransmissionList(context);
 #endif
@@ -517,75 +623,41 @@ CAResult_t CARetransmissionReceivedData(CARetransmission_t *context,
         return CA_STATUS_OK;
     }
 
+    CARetransmissionKey_t key = { .messageId = messageId, .adapter = endpoint->adapter };
+
     // mutex lock
     oc_mutex_lock(context->threadMutex);
-    size_t len = u_arraylist_length(context->dataList);
 
-    for (size_t i = 0; i < len; i++)
+    CARetransmissionData_t *retData =
+            (CARetransmissionData_t *) oc_hashmap_get(context->dataMap, &key);
+    if (NULL != retData)
     {
-        CARetransmissionData_t *retData = (CARetransmissionData_t *) u_arraylist_get(
-                context->dataList, i);
-
-        if (NULL == retData)
+        // get pdu data for getting token when CA_EMPTY(RST/ACK) is received from remote device
+        // if retransmission was finish..token will be unavailable.
+        if (CA_EMPTY == code)
         {
-            continue;
-        }
+            OIC_LOG(DEBUG, TAG, "code is CA_EMPTY");
 
-        // found index
-        if (NULL != retData->endpoint && retData->messageId == messageId
-            && (retData->endpoint->adapter == endpoint->adapter))
-        {
-            // get pdu data for getting token when CA_EMPTY(RST/ACK) is received from remote device
-            // if retransmission was finish..token will be unavailable.
-            if (CA_EMPTY == CAGetCodeFromPduBinaryData(pdu, size))
-            {
-                OIC_LOG(DEBUG, TAG, "code is CA_EMPTY");
-
-                if (NULL == retData->pdu)
-                {
-                    OIC_LOG(ERROR, TAG, "retData->pdu is null");
-                    OICFree(retData);
-                    // mutex unlock
-                    oc_mutex_unlock(context->threadMutex);
-
-                    return CA_STATUS_FAILED;
-                }
-
-                // copy PDU data
-                (*retransmissionPdu) = (void *) OICCalloc(1, retData->size);
-                if ((*retransmissionPdu) == NULL)
-                {
-                    OICFree(retData);
-                    OIC_LOG(ERROR, TAG, "memory error");
-
-                    // mutex unlock
-                    oc_mutex_unlock(context->threadMutex);
-
-                    return CA_MEMORY_ALLOC_FAILED;
-                }
-                memcpy((*retransmissionPdu), retData->pdu, retData->size);
-            }
-
-            // #2. remove data from list
-            CARetransmissionData_t *removedData = u_arraylist_remove(context->dataList, i);
-            if (NULL == removedData)
+            // copy PDU data
+            (*retransmissionPdu) = (void *) OICCalloc(1, retData->size);
+            if ((*retransmissionPdu) == NULL)
             {
-                OIC_LOG(ERROR, TAG, "Removed data is NULL");
+                OIC_LOG(ERROR, TAG, "memory error");
 
                 // mutex unlock
                 oc_mutex_unlock(context->threadMutex);
 
-                return CA_STATUS_FAILED;
+                return CA_MEMORY_ALLOC_FAILED;
             }
+            memcpy((*retransmissionPdu), retData->pdu, retData->size);
+        }
 
-            OIC_LOG_V(DEBUG, TAG, "remove RTCON data!!, msgid=%d", messageId);
+        // #2. remove data from list
+        CARemoveRetransmissionData(context, retData);
 
-            CAFreeEndpoint(removedData->endpoint);
-            OICFree(removedData->pdu);
-            OICFree(removedData);
+        OIC_LOG_V(DEBUG, TAG, "remove RTCON data!!, msgid=%d", messageId);
 
-            break;
-        }
+        CADestroyRetransmissionData(retData);
     }
 
     // mutex unlock
@@ -636,20 +708,22 @@ CAResult_t CARetransmissionDestroy(CARetransmission_t *context)
     size_t len = u_arraylist_length(context->dataList);
     for (size_t i = 0; i < len; i++)
     {
-        CARetransmissionData_t *data = u_arraylist_get(context->dataList, i);
+        CARetransmissionData_t *data =
+                (CARetransmissionData_t *) u_arraylist_get(context->dataList, i);
         if (NULL == data)
         {
             continue;
         }
-        CAFreeEndpoint(data->endpoint);
-        OICFree(data->pdu);
-        OICFree(data);
+        CADestroyRetransmissionData(data);
     }
+    oc_hashmap_free(context->dataMap);
+    context->dataMap = NULL;
     oc_mutex_unlock(context->threadMutex);
 
     oc_mutex_free(context->threadMutex);
     context->threadMutex = NULL;
     oc_cond_free(context->threadCond);
+    context->threadCond = NULL;
     u_arraylist_free(&context->dataList);
 
     return CA_STATUS_OK;
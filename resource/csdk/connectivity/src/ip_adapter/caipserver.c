@@ -61,6 +61,12 @@
 #include <linux/rtnetlink.h>
 #endif
 
+#if defined(WITH_EPOLL) && defined(__linux__)
+#define CA_IP_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
 #include <coap/pdu.h>
 #include "caipinterface.h"
 #include "caipnwmonitor.h"
@@ -89,6 +95,16 @@
 
 #define SELECT_TIMEOUT 1     // select() seconds (and termination latency)
 
+#ifdef CA_IP_EPOLL
+#define EPOLL_MAX_EVENTS 10  // 8 sockets, netlink and wakeup
+#define RECV_BATCH_SIZE 8    // datagrams read per recvmmsg() call
+#endif
+
+#if defined(__linux__) && defined(__GLIBC__)
+#define CA_IP_SENDMMSG
+#define SEND_BATCH_SIZE 16   // multicast copies sent per sendmmsg() call
+#endif
+
 #define IPv4_MULTICAST     "224.0.1.187"
 static struct in_addr IPv4MulticastAddress = { 0 };
 
@@ -147,6 +163,38 @@ static CAIPErrorHandleCallback g_ipErrorHandler = NULL;
 
 static CAIPPacketReceivedCallback g_packetReceivedCallback = NULL;
 
+/**
+ * Interface list used for multicast sends. Where netlink reports interface
+ * changes the list is kept until the next change, otherwise it is fetched
+ * again for every send.
+ */
+static u_arraylist_t *g_multicastIfList = NULL;
+
+/**
+ * Mutex to synchronize access to g_multicastIfList.
+ */
+static oc_mutex g_multicastIfListMutex = NULL;
+
+static void CAInvalidateMulticastInterfaceList()
+{
+    oc_mutex_lock(g_multicastIfListMutex);
+    u_arraylist_destroy(g_multicastIfList);
+    g_multicastIfList = NULL;
+    oc_mutex_unlock(g_multicastIfListMutex);
+}
+
+#ifdef CA_IP_EPOLL
+/**
+ * epoll instance of the receive thread; -1 when select() is used.
+ */
+static int g_epollFd = -1;
+
+/**
+ * eventfd used to wake up the receive thread for shutdown or changes.
+ */
+static int g_wakeupFd = -1;
+#endif
+
 static void CAFindReadyMessage();
 #if !defined(WSA_WAIT_EVENT_0)
 static void CASelectReturned(fd_set *readFds, int ret);
@@ -155,6 +203,10 @@ static void CAEventReturned(CASocketFd_t socket);
 #endif
 
 static CAResult_t CAReceiveMessage(CASocketFd_t fd, CATransportFlags_t flags);
+static CAResult_t CAHandleReceivedData(CATransportFlags_t flags,
+                                       struct sockaddr_storage *srcAddr, int namelen,
+                                       unsigned char *pktinfo,
+                                       char *recvBuffer, size_t recvLen);
 
 static void CAReceiveHandler(void *data)
 {
@@ -185,12 +237,264 @@ static void CAReceiveHandler(void *data)
     if (caglobals.ip.TYPE.fd != OC_INVALID_SOCKET && FD_ISSET(caglobals.ip.TYPE.fd, FDS)) \
     { \
         fd = caglobals.ip.TYPE.fd; \
-        flags = FLAGS; \
+        flags = (CATransportFlags_t)(FLAGS); \
     }
 
 
+#ifndef _WIN32
+static void CAHandleNetlinkEvent()
+{
+#if NETWORK_INTERFACE_CHANGED_LOGGING
+    OIC_LOG_V(DEBUG, TAG, "Netlink event detacted");
+#endif
+    CAInvalidateMulticastInterfaceList();
+
+    u_arraylist_t *iflist = CAFindInterfaceChange();
+    if (iflist)
+    {
+        size_t listLength = u_arraylist_length(iflist);
+        for (size_t i = 0; i < listLength; i++)
+        {
+            CAInterface_t *ifitem = (CAInterface_t *)u_arraylist_get(iflist, i);
+            if (ifitem)
+            {
+                CAProcessNewInterface(ifitem);
+            }
+        }
+        u_arraylist_destroy(iflist);
+    }
+}
+#endif
+
+#ifdef CA_IP_EPOLL
+/*
+ * The epoll user data of a socket holds its fd in the upper and its transport
+ * flags in the lower 32 bits, so a ready socket needs no lookup.
+ */
+#define EPOLL_DATA(FD, FLAGS) (((uint64_t)(uint32_t)(FD) << 32) | (uint32_t)(FLAGS))
+#define EPOLL_DATA_FD(DATA) ((int)(uint32_t)((DATA) >> 32))
+#define EPOLL_DATA_FLAGS(DATA) ((CATransportFlags_t)(uint32_t)(DATA))
+
+#define EPOLL_ADD(TYPE, FLAGS) \
+    if (caglobals.ip.TYPE.fd != OC_INVALID_SOCKET) \
+    { \
+        CAEpollAdd(caglobals.ip.TYPE.fd, (CATransportFlags_t)(FLAGS)); \
+    }
+
+static void CAEpollAdd(int fd, CATransportFlags_t flags)
+{
+    struct epoll_event event = { .events = EPOLLIN, .data = { .u64 = EPOLL_DATA(fd, flags) } };
+    if (-1 == epoll_ctl(g_epollFd, EPOLL_CTL_ADD, fd, &event))
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_ctl(%d) failed: %s", fd, strerror(errno));
+    }
+}
+
+static void CACloseEpoll()
+{
+    if (-1 != g_epollFd)
+    {
+        close(g_epollFd);
+        g_epollFd = -1;
+    }
+    if (-1 != g_wakeupFd)
+    {
+        close(g_wakeupFd);
+        g_wakeupFd = -1;
+    }
+}
+
+/**
+ * Creates the epoll instance and the wakeup eventfd.
+ * On failure the receive thread falls back to select().
+ */
+static bool CAInitializeEpoll()
+{
+    CACloseEpoll();
+
+    g_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (-1 == g_epollFd)
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_create1 failed: %s", strerror(errno));
+        return false;
+    }
+
+    g_wakeupFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (-1 == g_wakeupFd)
+    {
+        OIC_LOG_V(ERROR, TAG, "eventfd failed: %s", strerror(errno));
+        CACloseEpoll();
+        return false;
+    }
+
+    struct epoll_event event = { .events = EPOLLIN,
+                                 .data = { .u64 = EPOLL_DATA(g_wakeupFd, 0) } };
+    if (-1 == epoll_ctl(g_epollFd, EPOLL_CTL_ADD, g_wakeupFd, &event))
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_ctl failed: %s", strerror(errno));
+        CACloseEpoll();
+        return false;
+    }
+
+    caglobals.ip.shutdownFds[0] = -1;
+    caglobals.ip.shutdownFds[1] = -1;
+    return true;
+}
+
+/**
+ * Adds the sockets and the netlink fd to the epoll instance.
+ */
+static void CAEpollRegisterSockets()
+{
+    EPOLL_ADD(u6,  CA_IPV6)
+    EPOLL_ADD(u6s, CA_IPV6 | CA_SECURE)
+    EPOLL_ADD(u4,  CA_IPV4)
+    EPOLL_ADD(u4s, CA_IPV4 | CA_SECURE)
+    EPOLL_ADD(m6,  CA_MULTICAST | CA_IPV6)
+    EPOLL_ADD(m6s, CA_MULTICAST | CA_IPV6 | CA_SECURE)
+    EPOLL_ADD(m4,  CA_MULTICAST | CA_IPV4)
+    EPOLL_ADD(m4s, CA_MULTICAST | CA_IPV4 | CA_SECURE)
+
+    if (caglobals.ip.netlinkFd != OC_INVALID_SOCKET)
+    {
+        CAEpollAdd(caglobals.ip.netlinkFd, CA_DEFAULT_FLAGS);
+    }
+}
+
+static void CAWakeUpEpoll()
+{
+    uint64_t value = 1;
+    ssize_t len = 0;
+    do
+    {
+        len = write(g_wakeupFd, &value, sizeof (value));
+    } while ((len == -1) && (errno == EINTR));
+    if ((len == -1) && (errno != EAGAIN))
+    {
+        OIC_LOG_V(DEBUG, TAG, "write failed: %s", strerror(errno));
+    }
+}
+
+/**
+ * Reads all pending datagrams of a socket, up to RECV_BATCH_SIZE per syscall.
+ */
+static void CAReceiveMessages(CASocketFd_t fd, CATransportFlags_t flags)
+{
+    union control
+    {
+        struct cmsghdr cmsg;
+        unsigned char data[CMSG_SPACE(sizeof (struct in6_pktinfo))];
+    };
+
+    char recvBuffers[RECV_BATCH_SIZE][COAP_MAX_PDU_SIZE];
+    struct sockaddr_storage srcAddrs[RECV_BATCH_SIZE];
+    union control cmsgs[RECV_BATCH_SIZE];
+    struct iovec iovs[RECV_BATCH_SIZE];
+    struct mmsghdr msgs[RECV_BATCH_SIZE];
+
+    int namelen = (flags & CA_IPV6) ? sizeof (struct sockaddr_in6) : sizeof (struct sockaddr_in);
+    int level = (flags & CA_IPV6) ? IPPROTO_IPV6 : IPPROTO_IP;
+    int type = (flags & CA_IPV6) ? IPV6_PKTINFO : IP_PKTINFO;
+
+    while (!caglobals.ip.terminate)
+    {
+        memset(msgs, 0, sizeof (msgs));
+        for (size_t i = 0; i < RECV_BATCH_SIZE; i++)
+        {
+            iovs[i].iov_base = recvBuffers[i];
+            iovs[i].iov_len = sizeof (recvBuffers[i]);
+            msgs[i].msg_hdr.msg_name = &srcAddrs[i];
+            msgs[i].msg_hdr.msg_namelen = namelen;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_control = &cmsgs[i];
+            msgs[i].msg_hdr.msg_controllen = CMSG_SPACE(sizeof (struct in6_pktinfo));
+        }
+
+        int count = recvmmsg(fd, msgs, RECV_BATCH_SIZE, MSG_DONTWAIT, NULL);
+        if (-1 == count)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                OIC_LOG_V(ERROR, TAG, "recvmmsg failed %s", strerror(errno));
+            }
+            return;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            unsigned char *pktinfo = NULL;
+            for (struct cmsghdr *cmp = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmp != NULL;
+                 cmp = CMSG_NXTHDR(&msgs[i].msg_hdr, cmp))
+            {
+                if (cmp->cmsg_level == level && cmp->cmsg_type == type)
+                {
+                    pktinfo = CMSG_DATA(cmp);
+                }
+            }
+            (void)CAHandleReceivedData(flags, &srcAddrs[i], namelen, pktinfo,
+                                       recvBuffers[i], msgs[i].msg_len);
+        }
+
+        if (count < RECV_BATCH_SIZE)
+        {
+            return;
+        }
+    }
+}
+
+static void CAFindReadyMessageEpoll()
+{
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+    int timeout = caglobals.ip.selectTimeout == -1 ? -1 : caglobals.ip.selectTimeout * 1000;
+
+    int ret = epoll_wait(g_epollFd, events, EPOLL_MAX_EVENTS, timeout);
+
+    if (caglobals.ip.terminate)
+    {
+        OIC_LOG_V(DEBUG, TAG, "Packet receiver Stop request received.");
+        return;
+    }
+
+    if (0 > ret)
+    {
+        if (EINTR != errno)
+        {
+            OIC_LOG_V(FATAL, TAG, "epoll_wait error %s", strerror(errno));
+        }
+        return;
+    }
+
+    for (int i = 0; i < ret && !caglobals.ip.terminate; i++)
+    {
+        int fd = EPOLL_DATA_FD(events[i].data.u64);
+        if (fd == g_wakeupFd)
+        {
+            uint64_t value = 0;
+            (void)read(g_wakeupFd, &value, sizeof (value));
+        }
+        else if (fd == caglobals.ip.netlinkFd)
+        {
+            CAHandleNetlinkEvent();
+        }
+        else
+        {
+            CAReceiveMessages(fd, EPOLL_DATA_FLAGS(events[i].data.u64));
+        }
+    }
+}
+#endif // CA_IP_EPOLL
+
 static void CAFindReadyMessage()
 {
+#ifdef CA_IP_EPOLL
+    if (-1 != g_epollFd)
+    {
+        CAFindReadyMessageEpoll();
+        return;
+    }
+#endif
+
     fd_set readFds;
     struct timeval timeout;
 
@@ -258,23 +562,7 @@ static void CASelectReturned(fd_set *readFds, int ret)
         else ISSET(m4s, readFds, CA_MULTICAST | CA_IPV4 | CA_SECURE)
         else if ((caglobals.ip.netlinkFd != OC_INVALID_SOCKET) && FD_ISSET(caglobals.ip.netlinkFd, readFds))
         {
-#if NETWORK_INTERFACE_CHANGED_LOGGING
-            OIC_LOG_V(DEBUG, TAG, "Netlink event detacted");
-#endif
-            u_arraylist_t *iflist = CAFindInterfaceChange();
-            if (iflist)
-            {
-                size_t listLength = u_arraylist_length(iflist);
-                for (size_t i = 0; i < listLength; i++)
-                {
-                    CAInterface_t *ifitem = (CAInterface_t *)u_arraylist_get(iflist, i);
-                    if (ifitem)
-                    {
-                        CAProcessNewInterface(ifitem);
-                    }
-                }
-                u_arraylist_destroy(iflist);
-            }
+            CAHandleNetlinkEvent();
             break;
         }
         else if (FD_ISSET(caglobals.ip.shutdownFds[0], readFds))
@@ -538,6 +826,14 @@ void CADeInitializeIPGlobals()
     CLOSE_SOCKET(m4s);
 
     CAUnregisterForAddressChanges();
+
+#ifdef CA_IP_EPOLL
+    CACloseEpoll();
+#endif
+
+    CAInvalidateMulticastInterfaceList();
+    oc_mutex_free(g_multicastIfListMutex);
+    g_multicastIfListMutex = NULL;
 }
 
 static CAResult_t CAReceiveMessage(CASocketFd_t fd, CATransportFlags_t flags)
@@ -642,6 +938,14 @@ static CAResult_t CAReceiveMessage(CASocketFd_t fd, CATransportFlags_t flags)
         }
     }
 #endif // !defined(WSA_CMSG_DATA)
+    return CAHandleReceivedData(flags, &srcAddr, namelen, pktinfo, recvBuffer, recvLen);
+}
+
+static CAResult_t CAHandleReceivedData(CATransportFlags_t flags,
+                                       struct sockaddr_storage *srcAddr, int namelen,
+                                       unsigned char *pktinfo,
+                                       char *recvBuffer, size_t recvLen)
+{
     if (!pktinfo)
     {
         OIC_LOG(ERROR, TAG, "pktinfo is null");
@@ -660,7 +964,7 @@ static CAResult_t CAReceiveMessage(CASocketFd_t fd, CATransportFlags_t flags)
             unsigned char topbits = ((unsigned char *)addr)[0];
             if (topbits != 0xff)
             {
-                sep.endpoint.flags &= ~CA_MULTICAST;
+                sep.endpoint.flags = (CATransportFlags_t)(sep.endpoint.flags & ~CA_MULTICAST);
             }
         }
     }
@@ -675,12 +979,12 @@ static CAResult_t CAReceiveMessage(CASocketFd_t fd, CATransportFlags_t flags)
             unsigned char topbits = ((unsigned char *)&host)[3];
             if (topbits < 224 || topbits > 239)
             {
-                sep.endpoint.flags &= ~CA_MULTICAST;
+                sep.endpoint.flags = (CATransportFlags_t)(sep.endpoint.flags & ~CA_MULTICAST);
             }
         }
     }
 
-    CAConvertAddrToName(&srcAddr, namelen, sep.endpoint.addr, &sep.endpoint.port);
+    CAConvertAddrToName(srcAddr, namelen, sep.endpoint.addr, &sep.endpoint.port);
 
     if (flags & CA_SECURE)
     {
@@ -872,6 +1176,13 @@ static void CAInitializeFastShutdownMechanism()
     OIC_LOG_V(DEBUG, TAG, "IN %s", __func__);
     caglobals.ip.selectTimeout = -1; // don't poll for shutdown
     int ret = -1;
+#ifdef CA_IP_EPOLL
+    if (CAInitializeEpoll())
+    {
+        OIC_LOG_V(DEBUG, TAG, "OUT %s", __func__);
+        return;
+    }
+#endif
 #if defined(WSA_WAIT_EVENT_0)
     caglobals.ip.shutdownEvent = WSACreateEvent();
     if (WSA_INVALID_EVENT != caglobals.ip.shutdownEvent)
@@ -982,12 +1293,29 @@ CAResult_t CAIPStartServer(const ca_thread_pool_t threadPool)
         return CA_STATUS_FAILED;
     }
 #endif
+    if (!g_multicastIfListMutex)
+    {
+        g_multicastIfListMutex = oc_mutex_new();
+        if (!g_multicastIfListMutex)
+        {
+            OIC_LOG(ERROR, TAG, "Failed to create mutex!");
+            return CA_STATUS_FAILED;
+        }
+    }
+
     // set up appropriate FD mechanism for fast shutdown
     CAInitializeFastShutdownMechanism();
 
     // create source of network address change notifications
     CARegisterForAddressChanges();
 
+#ifdef CA_IP_EPOLL
+    if (-1 != g_epollFd)
+    {
+        CAEpollRegisterSockets();
+    }
+#endif
+
     caglobals.ip.selectTimeout = CAGetPollingInterval(caglobals.ip.selectTimeout);
 
     res = CAIPStartListenServer();
@@ -1015,6 +1343,14 @@ void CAIPStopServer()
     caglobals.ip.started = false;
     caglobals.ip.terminate = true;
 
+#ifdef CA_IP_EPOLL
+    if (-1 != g_wakeupFd)
+    {
+        CAWakeUpEpoll();
+        // receive thread will stop immediately
+        return;
+    }
+#endif
 #if !defined(WSA_WAIT_EVENT_0)
     if (caglobals.ip.shutdownFds[1] != -1)
     {
@@ -1036,6 +1372,13 @@ void CAIPStopServer()
 
 void CAWakeUpForChange()
 {
+#ifdef CA_IP_EPOLL
+    if (-1 != g_wakeupFd)
+    {
+        CAWakeUpEpoll();
+        return;
+    }
+#endif
 #if !defined(WSA_WAIT_EVENT_0)
     if (caglobals.ip.shutdownFds[1] != -1)
     {
@@ -1066,7 +1409,7 @@ static void applyMulticastToInterface4(uint32_t ifindex)
 
 #if defined(USE_IP_MREQN)
     struct ip_mreqn mreq = { .imr_multiaddr = IPv4MulticastAddress,
-                             .imr_address.s_addr = htonl(INADDR_ANY),
+                             .imr_address = { htonl(INADDR_ANY) },
                              .imr_ifindex = ifindex };
 #else
     struct ip_mreq mreq  = { .imr_multiaddr.s_addr = IPv4MulticastAddress.s_addr,
@@ -1264,6 +1607,8 @@ void CAProcessNewInterface(CAInterface_t *ifitem)
         return;
     }
 
+    CAInvalidateMulticastInterfaceList();
+
     if (ifitem->family == AF_INET6)
     {
         OIC_LOG_V(DEBUG, TAG, "Adding a new IPv6 interface(%i) to multicast group", ifitem->index);
@@ -1377,6 +1722,130 @@ static void sendData(CASocketFd_t fd, const CAEndpoint_t *endpoint,
 #endif
 }
 
+#ifdef CA_IP_SENDMMSG
+static void sendMulticastMessages(CASocketFd_t fd, struct mmsghdr *msgs, size_t count,
+                                  const CAEndpoint_t *endpoint,
+                                  const void *data, size_t dlen, const char *fam)
+{
+    (void)fam;  // eliminates release warning
+#ifdef TB_LOG
+    const char *secure = (endpoint->flags & CA_SECURE) ? "secure " : "";
+#endif
+
+    size_t sent = 0;
+    while (sent < count)
+    {
+        int ret = sendmmsg(fd, &msgs[sent], count - sent, 0);
+        if (OC_SOCKET_ERROR == ret)
+        {
+            if (g_ipErrorHandler)
+            {
+                g_ipErrorHandler(endpoint, data, dlen, CA_SEND_FAILED);
+            }
+            OIC_LOG_V(ERROR, TAG, "%smulticast %s sendmmsg failed: %s",
+                      secure, fam, strerror(errno));
+            CALogSendStateInfo(endpoint->adapter, endpoint->addr, endpoint->port,
+                               -1, false, strerror(errno));
+            // skip the datagram that failed
+            sent++;
+            continue;
+        }
+
+        for (int i = 0; i < ret; i++)
+        {
+            CALogSendStateInfo(endpoint->adapter, endpoint->addr, endpoint->port,
+                               msgs[sent + i].msg_len, true, NULL);
+        }
+        OIC_LOG_V(INFO, TAG, "%smulticast %s sendmmsg is successful: %d datagrams",
+                  secure, fam, ret);
+        sent += ret;
+    }
+}
+
+/**
+ * Sends one copy of a multicast datagram per interface of the given family,
+ * with as few sendmmsg() calls as possible. The outgoing interface of each
+ * copy is selected with an IP_PKTINFO / IPV6_PKTINFO control message instead
+ * of setting IP_MULTICAST_IF before each send.
+ */
+static void sendMulticastBatch(CASocketFd_t fd, const u_arraylist_t *iflist, int family,
+                               const CAEndpoint_t *endpoint,
+                               const void *data, size_t dlen, const char *fam)
+{
+    union control
+    {
+        struct cmsghdr cmsg;
+        unsigned char data[CMSG_SPACE(sizeof (struct in6_pktinfo))];
+    };
+
+    struct sockaddr_storage sock = { .ss_family = 0 };
+    CAConvertNameToAddr(endpoint->addr, endpoint->port, &sock);
+    socklen_t socklen = (AF_INET6 == family) ? sizeof (struct sockaddr_in6)
+                                             : sizeof (struct sockaddr_in);
+
+    struct iovec iov = { .iov_base = (void *)data, .iov_len = dlen };
+    struct mmsghdr msgs[SEND_BATCH_SIZE];
+    union control cmsgs[SEND_BATCH_SIZE];
+    size_t count = 0;
+
+    size_t len = u_arraylist_length(iflist);
+    for (size_t i = 0; i < len; i++)
+    {
+        CAInterface_t *ifitem = (CAInterface_t *)u_arraylist_get(iflist, i);
+        if (!ifitem)
+        {
+            continue;
+        }
+        if ((ifitem->flags & IFF_UP_RUNNING_FLAGS) != IFF_UP_RUNNING_FLAGS)
+        {
+            continue;
+        }
+        if (ifitem->family != family)
+        {
+            continue;
+        }
+
+        memset(&msgs[count], 0, sizeof (msgs[count]));
+        memset(&cmsgs[count], 0, sizeof (cmsgs[count]));
+        struct msghdr *msg = &msgs[count].msg_hdr;
+        msg->msg_name = &sock;
+        msg->msg_namelen = socklen;
+        msg->msg_iov = &iov;
+        msg->msg_iovlen = 1;
+        msg->msg_control = &cmsgs[count];
+
+        struct cmsghdr *cmsg = &cmsgs[count].cmsg;
+        if (AF_INET6 == family)
+        {
+            msg->msg_controllen = CMSG_SPACE(sizeof (struct in6_pktinfo));
+            cmsg->cmsg_level = IPPROTO_IPV6;
+            cmsg->cmsg_type = IPV6_PKTINFO;
+            cmsg->cmsg_len = CMSG_LEN(sizeof (struct in6_pktinfo));
+            ((struct in6_pktinfo *)CMSG_DATA(cmsg))->ipi6_ifindex = ifitem->index;
+        }
+        else
+        {
+            msg->msg_controllen = CMSG_SPACE(sizeof (struct in_pktinfo));
+            cmsg->cmsg_level = IPPROTO_IP;
+            cmsg->cmsg_type = IP_PKTINFO;
+            cmsg->cmsg_len = CMSG_LEN(sizeof (struct in_pktinfo));
+            ((struct in_pktinfo *)CMSG_DATA(cmsg))->ipi_ifindex = ifitem->index;
+        }
+
+        if (++count == SEND_BATCH_SIZE)
+        {
+            sendMulticastMessages(fd, msgs, count, endpoint, data, dlen, fam);
+            count = 0;
+        }
+    }
+
+    if (count)
+    {
+        sendMulticastMessages(fd, msgs, count, endpoint, data, dlen, fam);
+    }
+}
+#endif // CA_IP_SENDMMSG
+
 static void sendMulticastData6(const u_arraylist_t *iflist,
                                CAEndpoint_t *endpoint,
                                const void *data, size_t datalen)
@@ -1397,6 +1866,9 @@ static void sendMulticastData6(const u_arraylist_t *iflist,
     OICStrcpy(endpoint->addr, sizeof(endpoint->addr), ipv6mcname);
     CASocketFd_t fd = caglobals.ip.u6.fd;
 
+#ifdef CA_IP_SENDMMSG
+    sendMulticastBatch(fd, iflist, AF_INET6, endpoint, data, datalen, "ipv6");
+#else
     size_t len = u_arraylist_length(iflist);
     for (size_t i = 0; i < len; i++)
     {
@@ -1422,6 +1894,7 @@ static void sendMulticastData6(const u_arraylist_t *iflist,
         }
         sendData(fd, endpoint, data, datalen, "multicast", "ipv6");
     }
+#endif
 }
 
 static void sendMulticastData4(const u_arraylist_t *iflist,
@@ -1430,6 +1903,10 @@ static void sendMulticastData4(const u_arraylist_t *iflist,
 {
     VERIFY_NON_NULL_VOID(endpoint, TAG, "endpoint is NULL");
 
+#ifdef CA_IP_SENDMMSG
+    OICStrcpy(endpoint->addr, sizeof(endpoint->addr), IPv4_MULTICAST);
+    sendMulticastBatch(caglobals.ip.u4.fd, iflist, AF_INET, endpoint, data, datalen, "ipv4");
+#else
 #if defined(USE_IP_MREQN)
     struct ip_mreqn mreq = { .imr_multiaddr = IPv4MulticastAddress,
                              .imr_address.s_addr = htonl(INADDR_ANY),
@@ -1470,6 +1947,28 @@ static void sendMulticastData4(const u_arraylist_t *iflist,
         }
         sendData(fd, endpoint, data, datalen, "multicast", "ipv4");
     }
+#endif // CA_IP_SENDMMSG
+}
+
+/**
+ * Gets the interface list for a multicast send. Must be called with
+ * g_multicastIfListMutex held; the list stays owned by this module.
+ */
+static u_arraylist_t *CAGetMulticastInterfaceList()
+{
+#ifdef __linux__
+    bool changesNotified = (caglobals.ip.netlinkFd != OC_INVALID_SOCKET);
+#else
+    bool changesNotified = false;
+#endif
+    if (g_multicastIfList && changesNotified)
+    {
+        return g_multicastIfList;
+    }
+
+    u_arraylist_destroy(g_multicastIfList);
+    g_multicastIfList = CAIPGetInterfaceInformation(0);
+    return g_multicastIfList;
 }
 
 void CAIPSendData(CAEndpoint_t *endpoint, const void *data, size_t datalen,
@@ -1484,9 +1983,11 @@ void CAIPSendData(CAEndpoint_t *endpoint, const void *data, size_t datalen,
     {
         endpoint->port = isSecure ? CA_SECURE_COAP : CA_COAP;
 
-        u_arraylist_t *iflist = CAIPGetInterfaceInformation(0);
+        oc_mutex_lock(g_multicastIfListMutex);
+        u_arraylist_t *iflist = CAGetMulticastInterfaceList();
         if (!iflist)
         {
+            oc_mutex_unlock(g_multicastIfListMutex);
             OIC_LOG_V(ERROR, TAG, "get interface info failed: %s", strerror(errno));
             return;
         }
@@ -1500,7 +2001,7 @@ void CAIPSendData(CAEndpoint_t *endpoint, const void *data, size_t datalen,
             sendMulticastData4(iflist, endpoint, data, datalen);
         }
 
-        u_arraylist_destroy(iflist);
+        oc_mutex_unlock(g_multicastIfListMutex);
     }
     else
     {
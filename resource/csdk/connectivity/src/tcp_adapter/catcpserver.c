@@ -57,12 +57,22 @@
 #include <netdb.h>
 #endif
 
+#if defined(WITH_EPOLL) && defined(__linux__)
+#define CA_TCP_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#endif
+
 #include "catcpinterface.h"
 #include "caipnwmonitor.h"
 #include "caadapterutils.h"
 #include "octhread.h"
 #include "oic_malloc.h"
 #include "oic_string.h"
+#ifdef CA_TCP_EPOLL
+#include "ochashmap.h"
+#endif
 
 #include <coap/pdu.h>
 #include <coap/utlist.h>
@@ -87,6 +97,12 @@
  */
 #define TLS_HEADER_SIZE 5
 
+#ifdef CA_TCP_EPOLL
+#define EPOLL_MAX_EVENTS 64            // events handled per epoll_wait() call
+#define WRITEV_MAX_FRAMES 16           // queued frames written per sendmsg() call
+#define MAX_PENDING_LEN (256 * 1024)   // queued bytes per session before sends fail
+#endif
+
 /**
  * Mutex to synchronize device object list.
  */
@@ -117,6 +133,49 @@ static CATCPConnectionHandleCallback g_connectionCallback = NULL;
  */
 static CATCPSessionInfo_t *g_sessionList = NULL;
 
+#ifdef CA_TCP_EPOLL
+/**
+ * Outbound data of a session that could not be written without blocking.
+ */
+typedef struct CATCPPendingData_t
+{
+    struct CATCPPendingData_t *next;
+    size_t len;                         /**< length of data */
+    size_t offset;                      /**< bytes of data already written */
+    unsigned char data[];
+} CATCPPendingData_t;
+
+/**
+ * Outbound queue of a disconnected session, waiting to be reported to the error handler.
+ */
+typedef struct CATCPDiscardedData_t
+{
+    struct CATCPDiscardedData_t *next;
+    CAEndpoint_t endpoint;              /**< endpoint of the disconnected session */
+    CATCPPendingData_t *pendingHead;    /**< unsent data, oldest first */
+} CATCPDiscardedData_t;
+
+/**
+ * Queues of disconnected sessions; protected by g_mutexObjectList.
+ */
+static CATCPDiscardedData_t *g_discardedData = NULL;
+
+/**
+ * epoll instance of the receive thread; -1 when select() is used.
+ */
+static int g_epollFd = -1;
+
+/**
+ * eventfd used to wake up the receive thread for shutdown.
+ */
+static int g_wakeupFd = -1;
+
+/**
+ * Connected sessions by socket fd; protected by g_mutexObjectList.
+ */
+static oc_hashmap g_sessionsByFd = NULL;
+#endif
+
 static CAResult_t CATCPCreateMutex();
 static void CATCPDestroyMutex();
 static CAResult_t CATCPCreateCond();
@@ -223,10 +282,471 @@ static void CAReceiveHandler(void *data)
     OIC_LOG(DEBUG, TAG, "OUT - CAReceiveHandler");
 }
 
+#ifdef CA_TCP_EPOLL
+#define EPOLL_ADD(TYPE) \
+    if (caglobals.tcp.TYPE.fd != OC_INVALID_SOCKET) \
+    { \
+        CAEpollControl(EPOLL_CTL_ADD, caglobals.tcp.TYPE.fd, EPOLLIN); \
+    }
+
+static uint32_t CAHashSocketFd(const void *key)
+{
+    return oc_hashmap_hash_bytes(key, sizeof (CASocketFd_t), 0);
+}
+
+static bool CAEqualSocketFd(const void *key1, const void *key2)
+{
+    return *(const CASocketFd_t *)key1 == *(const CASocketFd_t *)key2;
+}
+
+static void CAEpollControl(int op, CASocketFd_t fd, uint32_t events)
+{
+    struct epoll_event event = { .events = events, .data = { .fd = fd } };
+    if (-1 == epoll_ctl(g_epollFd, op, fd, &event))
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_ctl(%d) failed: %s", fd, strerror(errno));
+    }
+}
+
+static void CACloseEpoll()
+{
+    if (-1 != g_epollFd)
+    {
+        close(g_epollFd);
+        g_epollFd = -1;
+    }
+    if (-1 != g_wakeupFd)
+    {
+        close(g_wakeupFd);
+        g_wakeupFd = -1;
+    }
+    oc_hashmap_free(g_sessionsByFd);
+    g_sessionsByFd = NULL;
+}
+
+/**
+ * Creates the epoll instance, the wakeup eventfd and the session map.
+ * On failure the receive thread falls back to select().
+ */
+static bool CAInitializeEpoll()
+{
+    CACloseEpoll();
+
+    g_sessionsByFd = oc_hashmap_new(CAHashSocketFd, CAEqualSocketFd);
+    if (!g_sessionsByFd)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to create session map");
+        return false;
+    }
+
+    g_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (-1 == g_epollFd)
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_create1 failed: %s", strerror(errno));
+        CACloseEpoll();
+        return false;
+    }
+
+    g_wakeupFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (-1 == g_wakeupFd)
+    {
+        OIC_LOG_V(ERROR, TAG, "eventfd failed: %s", strerror(errno));
+        CACloseEpoll();
+        return false;
+    }
+
+    struct epoll_event event = { .events = EPOLLIN, .data = { .fd = g_wakeupFd } };
+    if (-1 == epoll_ctl(g_epollFd, EPOLL_CTL_ADD, g_wakeupFd, &event))
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_ctl failed: %s", strerror(errno));
+        CACloseEpoll();
+        return false;
+    }
+
+    caglobals.tcp.shutdownFds[0] = -1;
+    caglobals.tcp.shutdownFds[1] = -1;
+    caglobals.tcp.connectionFds[0] = -1;
+    caglobals.tcp.connectionFds[1] = -1;
+    return true;
+}
+
+static void CAWakeUpEpoll()
+{
+    uint64_t value = 1;
+    ssize_t len = 0;
+    do
+    {
+        len = write(g_wakeupFd, &value, sizeof (value));
+    } while ((len == -1) && (errno == EINTR));
+    if ((len == -1) && (errno != EAGAIN))
+    {
+        OIC_LOG_V(DEBUG, TAG, "write failed: %s", strerror(errno));
+    }
+}
+
+/**
+ * Makes the socket of a connected session non-blocking and adds it to the
+ * session map and the epoll instance. Does nothing when select() is used.
+ * Must be called with g_mutexObjectList held.
+ */
+static bool CARegisterTCPSession(CATCPSessionInfo_t *session)
+{
+    if (-1 == g_epollFd)
+    {
+        return true;
+    }
+
+    int flags = fcntl(session->fd, F_GETFL);
+    if ((-1 == flags) || (-1 == fcntl(session->fd, F_SETFL, flags | O_NONBLOCK)))
+    {
+        OIC_LOG_V(ERROR, TAG, "fcntl failed: %s", strerror(errno));
+        return false;
+    }
+
+    if (!oc_hashmap_put(g_sessionsByFd, &session->fd, session))
+    {
+        OIC_LOG(ERROR, TAG, "Failed to add session to map");
+        return false;
+    }
+
+    CAEpollControl(EPOLL_CTL_ADD, session->fd, EPOLLIN);
+    return true;
+}
+
+/**
+ * Removes a session from the session map and the epoll instance.
+ * Must be called with g_mutexObjectList held, before the socket is closed.
+ */
+static void CAUnregisterTCPSession(CATCPSessionInfo_t *session)
+{
+    if (session == oc_hashmap_get(g_sessionsByFd, &session->fd))
+    {
+        oc_hashmap_remove(g_sessionsByFd, &session->fd);
+        (void)epoll_ctl(g_epollFd, EPOLL_CTL_DEL, session->fd, NULL);
+    }
+}
+
+/**
+ * Takes the outbound queue of a session that is being disconnected. Its frames
+ * are reported by CAReportDiscardedData, since the error handler must not be
+ * called with g_mutexObjectList held.
+ * Must be called with g_mutexObjectList held.
+ */
+static void CADiscardPendingData(CATCPSessionInfo_t *session)
+{
+    if (!session->pendingHead)
+    {
+        return;
+    }
+
+    CATCPDiscardedData_t *discarded = (CATCPDiscardedData_t *)OICMalloc(sizeof (*discarded));
+    if (discarded)
+    {
+        discarded->endpoint = session->sep.endpoint;
+        discarded->pendingHead = session->pendingHead;
+        LL_APPEND(g_discardedData, discarded);
+    }
+    else
+    {
+        OIC_LOG(ERROR, TAG, "Out of memory, unsent data is not reported");
+        while (session->pendingHead)
+        {
+            CATCPPendingData_t *next = session->pendingHead->next;
+            OICFree(session->pendingHead);
+            session->pendingHead = next;
+        }
+    }
+    session->pendingHead = NULL;
+    session->pendingTail = NULL;
+    session->pendingLen = 0;
+}
+
+/**
+ * Reports every frame discarded by CADiscardPendingData to the error handler.
+ * Must be called without g_mutexObjectList held.
+ */
+static void CAReportDiscardedData()
+{
+    oc_mutex_lock(g_mutexObjectList);
+    CATCPDiscardedData_t *discarded = g_discardedData;
+    g_discardedData = NULL;
+    oc_mutex_unlock(g_mutexObjectList);
+
+    while (discarded)
+    {
+        CATCPDiscardedData_t *next = discarded->next;
+        CATCPPendingData_t *pending = discarded->pendingHead;
+        while (pending)
+        {
+            CATCPPendingData_t *nextPending = pending->next;
+            if (g_tcpErrorHandler)
+            {
+                g_tcpErrorHandler(&discarded->endpoint, pending->data, pending->len,
+                                  CA_SEND_FAILED);
+            }
+            OICFree(pending);
+            pending = nextPending;
+        }
+        OICFree(discarded);
+        discarded = next;
+    }
+}
+
+/**
+ * Writes as much of the outbound queue of a session as the socket accepts,
+ * up to WRITEV_MAX_FRAMES frames per sendmsg() call. Stops watching the socket
+ * for writability once the queue is empty.
+ * Must be called with g_mutexObjectList held.
+ */
+static CAResult_t CAFlushPendingData(CATCPSessionInfo_t *session)
+{
+    while (session->pendingHead)
+    {
+        struct iovec iov[WRITEV_MAX_FRAMES];
+        size_t count = 0;
+        for (CATCPPendingData_t *pending = session->pendingHead;
+             pending && (count < WRITEV_MAX_FRAMES); pending = pending->next)
+        {
+            iov[count].iov_base = pending->data + pending->offset;
+            iov[count].iov_len = pending->len - pending->offset;
+            count++;
+        }
+
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = count };
+        ssize_t len = sendmsg(session->fd, &msg, MSG_NOSIGNAL);
+        if (-1 == len)
+        {
+            if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
+            {
+                return CA_STATUS_OK;
+            }
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            OIC_LOG_V(ERROR, TAG, "sendmsg failed: %s", strerror(errno));
+            CALogSendStateInfo(session->sep.endpoint.adapter, session->sep.endpoint.addr,
+                               session->sep.endpoint.port, len, false, strerror(errno));
+            return CA_SEND_FAILED;
+        }
+
+        session->pendingLen -= (size_t)len;
+        while (len > 0)
+        {
+            CATCPPendingData_t *pending = session->pendingHead;
+            size_t remaining = pending->len - pending->offset;
+            if ((size_t)len < remaining)
+            {
+                pending->offset += (size_t)len;
+                break;
+            }
+            len -= remaining;
+            session->pendingHead = pending->next;
+            OICFree(pending);
+        }
+    }
+
+    session->pendingTail = NULL;
+    CAEpollControl(EPOLL_CTL_MOD, session->fd, EPOLLIN);
+    return CA_STATUS_OK;
+}
+
+/**
+ * Sends data on a session socket without blocking. Whatever the socket does not
+ * accept right away is queued and written by the receive thread when the socket
+ * becomes writable. Fails when the queue of the session would exceed
+ * MAX_PENDING_LEN, i.e. when the peer stopped reading.
+ */
+static ssize_t CASendOrQueueData(CASocketFd_t sockFd, const CAEndpoint_t *endpoint,
+                                 const void *data, size_t dlen, const char *fam)
+{
+    oc_mutex_lock(g_mutexObjectList);
+    CATCPSessionInfo_t *session = (CATCPSessionInfo_t *)oc_hashmap_get(g_sessionsByFd, &sockFd);
+    if (!session)
+    {
+        oc_mutex_unlock(g_mutexObjectList);
+        OIC_LOG(ERROR, TAG, "Session not found");
+        return -1;
+    }
+
+    if (session->pendingLen + dlen > MAX_PENDING_LEN)
+    {
+        OIC_LOG_V(ERROR, TAG, "send queue is full: %" PRIuPTR " bytes pending",
+                  session->pendingLen);
+        oc_mutex_unlock(g_mutexObjectList);
+        CALogSendStateInfo(endpoint->adapter, endpoint->addr, endpoint->port,
+                           -1, false, "send queue is full");
+        return -1;
+    }
+
+    // Write directly unless older data is still queued.
+    size_t sent = 0;
+    if (!session->pendingHead)
+    {
+        ssize_t len = 0;
+        do
+        {
+            len = send(sockFd, data, dlen, MSG_NOSIGNAL);
+        } while ((-1 == len) && (EINTR == errno));
+
+        if (-1 == len)
+        {
+            if ((EAGAIN != errno) && (EWOULDBLOCK != errno))
+            {
+                oc_mutex_unlock(g_mutexObjectList);
+                OIC_LOG_V(ERROR, TAG, "unicast %stcp send failed: %s", fam, strerror(errno));
+                CALogSendStateInfo(endpoint->adapter, endpoint->addr, endpoint->port,
+                                   len, false, strerror(errno));
+                return -1;
+            }
+            len = 0;
+        }
+        sent = (size_t)len;
+    }
+
+    if (sent < dlen)
+    {
+        size_t remaining = dlen - sent;
+        CATCPPendingData_t *pending =
+                (CATCPPendingData_t *)OICMalloc(sizeof (*pending) + remaining);
+        if (!pending)
+        {
+            oc_mutex_unlock(g_mutexObjectList);
+            OIC_LOG(ERROR, TAG, "Out of memory");
+            return -1;
+        }
+        pending->next = NULL;
+        pending->len = remaining;
+        pending->offset = 0;
+        memcpy(pending->data, (const unsigned char *)data + sent, remaining);
+
+        if (session->pendingTail)
+        {
+            session->pendingTail->next = pending;
+        }
+        else
+        {
+            session->pendingHead = pending;
+            CAEpollControl(EPOLL_CTL_MOD, sockFd, EPOLLIN | EPOLLOUT);
+        }
+        session->pendingTail = pending;
+        session->pendingLen += remaining;
+        OIC_LOG_V(DEBUG, TAG, "%" PRIuPTR " bytes queued, %" PRIuPTR " bytes pending",
+                  remaining, session->pendingLen);
+    }
+    oc_mutex_unlock(g_mutexObjectList);
+
+#ifndef TB_LOG
+    (void)fam;
+#endif
+    OIC_LOG_V(INFO, TAG, "unicast %stcp sendTo is successful: %" PRIuPTR " bytes", fam, dlen);
+    CALogSendStateInfo(endpoint->adapter, endpoint->addr, endpoint->port,
+                       dlen, true, NULL);
+    return dlen;
+}
+
+/**
+ * Handles readiness of a session socket.
+ */
+static void CAHandleSessionEvent(CASocketFd_t fd, uint32_t events)
+{
+    oc_mutex_lock(g_mutexObjectList);
+    CATCPSessionInfo_t *session = (CATCPSessionInfo_t *)oc_hashmap_get(g_sessionsByFd, &fd);
+    if (session)
+    {
+        CAResult_t res = CA_STATUS_OK;
+        if (events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+        {
+            res = CAReceiveMessage(session);
+        }
+        if ((CA_STATUS_OK == res) && (events & EPOLLOUT))
+        {
+            res = CAFlushPendingData(session);
+        }
+
+        //disconnect session and clean-up data if any error occurs
+        if (CA_STATUS_OK != res)
+        {
+#ifdef __WITH_TLS__
+            if (CA_STATUS_OK != CAcloseSslConnection(&session->sep.endpoint))
+            {
+                OIC_LOG(ERROR, TAG, "Failed to close TLS session");
+            }
+#endif
+            LL_DELETE(g_sessionList, session);
+            CADisconnectTCPSession(session);
+        }
+    }
+    oc_mutex_unlock(g_mutexObjectList);
+
+    CAReportDiscardedData();
+}
+
+static void CAFindReadyMessageEpoll()
+{
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+
+    int ret = epoll_wait(g_epollFd, events, EPOLL_MAX_EVENTS, caglobals.tcp.selectTimeout * 1000);
+
+    if (caglobals.tcp.terminate)
+    {
+        OIC_LOG_V(DEBUG, TAG, "Packet receiver Stop request received.");
+        return;
+    }
+
+    if (0 > ret)
+    {
+        if (EINTR != errno)
+        {
+            OIC_LOG_V(FATAL, TAG, "epoll_wait error %s", strerror(errno));
+        }
+        return;
+    }
+
+    for (int i = 0; i < ret && !caglobals.tcp.terminate; i++)
+    {
+        CASocketFd_t fd = events[i].data.fd;
+        if (fd == g_wakeupFd)
+        {
+            uint64_t value = 0;
+            (void)read(g_wakeupFd, &value, sizeof (value));
+        }
+        else if (fd == caglobals.tcp.ipv4.fd)
+        {
+            CAAcceptConnection(CA_IPV4, &caglobals.tcp.ipv4);
+        }
+        else if (fd == caglobals.tcp.ipv4s.fd)
+        {
+            CAAcceptConnection(CA_IPV4 | CA_SECURE, &caglobals.tcp.ipv4s);
+        }
+        else if (fd == caglobals.tcp.ipv6.fd)
+        {
+            CAAcceptConnection(CA_IPV6, &caglobals.tcp.ipv6);
+        }
+        else if (fd == caglobals.tcp.ipv6s.fd)
+        {
+            CAAcceptConnection(CA_IPV6 | CA_SECURE, &caglobals.tcp.ipv6s);
+        }
+        else
+        {
+            CAHandleSessionEvent(fd, events[i].events);
+        }
+    }
+}
+#endif // CA_TCP_EPOLL
+
 #if !defined(WSA_WAIT_EVENT_0)
 
 static void CAFindReadyMessage()
 {
+#ifdef CA_TCP_EPOLL
+    if (-1 != g_epollFd)
+    {
+        CAFindReadyMessageEpoll();
+        return;
+    }
+#endif
+
     fd_set readFds;
     struct timeval timeout = { .tv_sec = caglobals.tcp.selectTimeout };
 
@@ -595,6 +1115,15 @@ static void CAAcceptConnection(CATransportFlags_t flag, CASocket_t *sock)
                             svritem->sep.endpoint.addr, &svritem->sep.endpoint.port);
 
         oc_mutex_lock(g_mutexObjectList);
+#ifdef CA_TCP_EPOLL
+        if (!CARegisterTCPSession(svritem))
+        {
+            oc_mutex_unlock(g_mutexObjectList);
+            OC_CLOSE_SOCKET(sockfd);
+            OICFree(svritem);
+            return;
+        }
+#endif
         LL_APPEND(g_sessionList, svritem);
         oc_mutex_unlock(g_mutexObjectList);
 
@@ -782,7 +1311,11 @@ static CAResult_t CAReceiveMessage(CATCPSessionInfo_t *svritem)
         }
 
         len = recv(svritem->fd, (char*)svritem->tlsdata + svritem->tlsLen, (int)nbRead, 0);
-        if (len < 0)
+        if (len < 0 && (EAGAIN == errno || EWOULDBLOCK == errno))
+        {
+            OIC_LOG(DEBUG, TAG, "no data to read yet");
+        }
+        else if (len < 0)
         {
             OIC_LOG_V(ERROR, TAG, "recv failed %s", strerror(errno));
             res = CA_RECEIVE_FAILED;
@@ -814,7 +1347,11 @@ static CAResult_t CAReceiveMessage(CATCPSessionInfo_t *svritem)
 
         // svritem->tlsdata can also be used as receiving buffer in case of raw tcp
         len = recv(svritem->fd, (char*)svritem->tlsdata, sizeof(svritem->tlsdata), 0);
-        if (len < 0)
+        if (len < 0 && (EAGAIN == errno || EWOULDBLOCK == errno))
+        {
+            OIC_LOG(DEBUG, TAG, "no data to read yet");
+        }
+        else if (len < 0)
         {
             OIC_LOG_V(ERROR, TAG, "recv failed %s", strerror(errno));
             res = CA_RECEIVE_FAILED;
@@ -918,6 +1455,16 @@ static CAResult_t CATCPCreateSocket(int family, CATCPSessionInfo_t *svritem)
 
     OIC_LOG(DEBUG, TAG, "connect socket success");
     svritem->state = CONNECTED;
+#ifdef CA_TCP_EPOLL
+    if (-1 != g_epollFd)
+    {
+        // the receive thread picks up the socket without a wakeup.
+        oc_mutex_lock(g_mutexObjectList);
+        bool registered = CARegisterTCPSession(svritem);
+        oc_mutex_unlock(g_mutexObjectList);
+        return registered ? CA_STATUS_OK : CA_SOCKET_OPERATION_FAILED;
+    }
+#endif
     CHECKFD(svritem->fd);
 #if !defined(WSA_WAIT_EVENT_0)
     ssize_t len = CAWakeUpForReadFdsUpdate(svritem->sep.endpoint.addr);
@@ -1110,15 +1657,25 @@ CAResult_t CATCPStartServer(const ca_thread_pool_t threadPool)
         return res;
     }
 #else
-    CAInitializePipe(caglobals.tcp.shutdownFds);
-    CHECKFD(caglobals.tcp.shutdownFds[0]);
-    CHECKFD(caglobals.tcp.shutdownFds[1]);
+#ifdef CA_TCP_EPOLL
+    if (CAInitializeEpoll())
+    {
+        EPOLL_ADD(ipv4)
+        EPOLL_ADD(ipv4s)
+        EPOLL_ADD(ipv6)
+        EPOLL_ADD(ipv6s)
+    }
+    else
 #endif
+    {
+        CAInitializePipe(caglobals.tcp.shutdownFds);
+        CHECKFD(caglobals.tcp.shutdownFds[0]);
+        CHECKFD(caglobals.tcp.shutdownFds[1]);
 
-#ifndef WSA_WAIT_EVENT_0
-    CAInitializePipe(caglobals.tcp.connectionFds);
-    CHECKFD(caglobals.tcp.connectionFds[0]);
-    CHECKFD(caglobals.tcp.connectionFds[1]);
+        CAInitializePipe(caglobals.tcp.connectionFds);
+        CHECKFD(caglobals.tcp.connectionFds[0]);
+        CHECKFD(caglobals.tcp.connectionFds[1]);
+    }
 #endif
 
     caglobals.tcp.terminate = false;
@@ -1149,6 +1706,12 @@ void CATCPStopServer()
     caglobals.tcp.terminate = true;
 
 #if !defined(WSA_WAIT_EVENT_0)
+#ifdef CA_TCP_EPOLL
+    if (-1 != g_wakeupFd)
+    {
+        CAWakeUpEpoll();
+    }
+#endif
     if (caglobals.tcp.shutdownFds[1] != OC_INVALID_SOCKET)
     {
         close(caglobals.tcp.shutdownFds[1]);
@@ -1194,6 +1757,9 @@ void CATCPStopServer()
     oc_mutex_unlock(g_mutexObjectList);
 
     CATCPDisconnectAll();
+#ifdef CA_TCP_EPOLL
+    CACloseEpoll();
+#endif
     CATCPDestroyMutex();
     CATCPDestroyCond();
 
@@ -1267,6 +1833,12 @@ static ssize_t sendData(const CAEndpoint_t *endpoint, const void *data,
     }
 
     // #2. send data to remote device.
+#ifdef CA_TCP_EPOLL
+    if (-1 != g_epollFd)
+    {
+        return CASendOrQueueData(sockFd, endpoint, data, dlen, fam);
+    }
+#endif
     ssize_t remainLen = dlen;
     do
     {
@@ -1472,6 +2044,9 @@ CAResult_t CADisconnectTCPSession(CATCPSessionInfo_t *removedData)
     // close the socket and remove session info in list.
     if (removedData->fd != OC_INVALID_SOCKET)
     {
+#ifdef CA_TCP_EPOLL
+        CAUnregisterTCPSession(removedData);
+#endif
         shutdown(removedData->fd, SHUT_RDWR);
         OC_CLOSE_SOCKET(removedData->fd);
         removedData->fd = OC_INVALID_SOCKET;
@@ -1485,6 +2060,9 @@ CAResult_t CADisconnectTCPSession(CATCPSessionInfo_t *removedData)
             g_connectionCallback(&(removedData->sep.endpoint), false, removedData->isClient);
         }
     }
+#ifdef CA_TCP_EPOLL
+    CADiscardPendingData(removedData);
+#endif
     OICFree(removedData->data);
     removedData->data = NULL;
 
@@ -1513,6 +2091,10 @@ void CATCPDisconnectAll()
     g_sessionList = NULL;
     oc_mutex_unlock(g_mutexObjectList);
 
+#ifdef CA_TCP_EPOLL
+    CAReportDiscardedData();
+#endif
+
 #ifdef __WITH_TLS__
     CAcloseSslConnectionAll(CA_ADAPTER_TCP);
 #endif
@@ -1592,6 +2174,9 @@ CAResult_t CASearchAndDeleteTCPSession(const CAEndpoint_t *endpoint)
             LL_DELETE(g_sessionList, session);
             CADisconnectTCPSession(session);
             oc_mutex_unlock(g_mutexObjectList);
+#ifdef CA_TCP_EPOLL
+            CAReportDiscardedData();
+#endif
             return CA_STATUS_OK;
         }
     }
@@ -50,7 +50,7 @@ TEST_F(CABlockTransferTests, CACreateNewDataSetTest)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -89,7 +89,6 @@ TEST_F(CABlockTransferTests, CACreateNewDataSetTest)
     }
 
     CADestroyDataSet(cadata);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -103,7 +102,7 @@ TEST_F(CABlockTransferTests, CARemoveBlockDataFromListWithSeed)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -142,7 +141,6 @@ TEST_F(CABlockTransferTests, CARemoveBlockDataFromListWithSeed)
     }
 
     CADestroyDataSet(cadata);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -156,7 +154,7 @@ TEST_F(CABlockTransferTests, CAGetBlockDataFromBlockDataListTest)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -185,7 +183,6 @@ TEST_F(CABlockTransferTests, CAGetBlockDataFromBlockDataListTest)
     }
 
     CADestroyDataSet(cadata);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -199,7 +196,7 @@ TEST_F(CABlockTransferTests, CAGetPayloadFromBlockDataListTest)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -232,7 +229,6 @@ TEST_F(CABlockTransferTests, CAGetPayloadFromBlockDataListTest)
     }
 
     CADestroyDataSet(cadata);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -240,6 +236,89 @@ TEST_F(CABlockTransferTests, CAGetPayloadFromBlockDataListTest)
     free(requestData.payload);
 }
 
+TEST_F(CABlockTransferTests, CAManyBlockDataTest)
+{
+    const size_t count = 100;
+    CAEndpoint_t* tempRep = NULL;
+    CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
+
+    CAInfo_t responseData;
+    memset(&responseData, 0, sizeof(CAInfo_t));
+    responseData.type = CA_MSG_NONCONFIRM;
+
+    CAResponseInfo_t responseInfo;
+    memset(&responseInfo, 0, sizeof(CAResponseInfo_t));
+    responseInfo.result = CA_CONTENT;
+
+    CAData_t cadata;
+    memset(&cadata, 0, sizeof(CAData_t));
+    cadata.type = SEND_TYPE_UNICAST;
+    cadata.remoteEndpoint = tempRep;
+    cadata.responseInfo = &responseInfo;
+    cadata.dataType = CA_RESPONSE_DATA;
+
+    CAToken_t tokens[count];
+    CABlockData_t *blockData[count];
+    for (size_t i = 0; i < count; i++)
+    {
+        CAGenerateToken(&tokens[i], CA_MAX_TOKEN_LEN);
+        responseInfo.info = responseData;
+        responseInfo.info.token = tokens[i];
+        responseInfo.info.tokenLength = CA_MAX_TOKEN_LEN;
+        blockData[i] = CACreateNewBlockData(&cadata);
+        ASSERT_TRUE(blockData[i] != NULL);
+    }
+
+    // every transfer is found by its own block ID
+    for (size_t i = 0; i < count; i++)
+    {
+        EXPECT_EQ(blockData[i], CAGetBlockDataFromBlockDataList(blockData[i]->blockDataId));
+    }
+
+    // the payload of a transfer is the concatenation of its blocks
+    char block[16];
+    responseInfo.info.payload = (CAPayload_t) block;
+    responseInfo.info.payloadSize = sizeof(block);
+    for (size_t n = 0; n < 64; n++)
+    {
+        memset(block, 'a' + (n % 26), sizeof(block));
+        EXPECT_EQ(CA_STATUS_OK, CAUpdatePayloadData(blockData[0], &cadata, CA_BLOCK_UNKNOWN,
+                                                    false, COAP_OPTION_BLOCK2));
+    }
+    size_t fullPayloadLen = 0;
+    CAPayload_t fullPayload = CAGetPayloadFromBlockDataList(blockData[0]->blockDataId,
+                                                            &fullPayloadLen);
+    ASSERT_EQ(64 * sizeof(block), fullPayloadLen);
+    for (size_t n = 0; n < 64; n++)
+    {
+        EXPECT_EQ('a' + (n % 26), fullPayload[n * sizeof(block)]);
+        EXPECT_EQ('a' + (n % 26), fullPayload[(n + 1) * sizeof(block) - 1]);
+    }
+    responseInfo.info.payload = NULL;
+    responseInfo.info.payloadSize = 0;
+
+    for (size_t i = 0; i < count; i += 2)
+    {
+        EXPECT_EQ(CA_STATUS_OK, CARemoveBlockDataFromList(blockData[i]->blockDataId));
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        CABlockDataID_t *blockDataID = CACreateBlockDatablockId(tokens[i], CA_MAX_TOKEN_LEN,
+                                                                tempRep->addr, tempRep->port);
+        ASSERT_TRUE(blockDataID != NULL);
+        CABlockData_t *data = CAGetBlockDataFromBlockDataList(blockDataID);
+        CADestroyBlockID(blockDataID);
+        EXPECT_EQ((i % 2) ? blockData[i] : NULL, data);
+        if (data)
+        {
+            EXPECT_EQ(CA_STATUS_OK, CARemoveBlockDataFromList(data->blockDataId));
+        }
+        CADestroyToken(tokens[i]);
+    }
+
+    CADestroyEndpoint(tempRep);
+}
+
 // request and block option1
 TEST_F(CABlockTransferTests, CAAddBlockOptionTest)
 {
@@ -247,7 +326,7 @@ TEST_F(CABlockTransferTests, CAAddBlockOptionTest)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -272,7 +351,6 @@ TEST_F(CABlockTransferTests, CAAddBlockOptionTest)
 
     EXPECT_EQ(CA_STATUS_OK, CAAddBlockOption(&pdu, &requestData, tempRep, &options));
 
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -287,7 +365,7 @@ TEST_F(CABlockTransferTests, CAAddBlockOption1InRequest)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -327,7 +405,6 @@ TEST_F(CABlockTransferTests, CAAddBlockOption1InRequest)
     }
 
     CADestroyDataSet(cadata);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -342,7 +419,7 @@ TEST_F(CABlockTransferTests, CAAddBlockOption1InResponse)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -383,7 +460,6 @@ TEST_F(CABlockTransferTests, CAAddBlockOption1InResponse)
     }
 
     CADestroyDataSet(cadata);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -398,7 +474,7 @@ TEST_F(CABlockTransferTests, CAAddBlockOption2InResponse)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -439,7 +515,6 @@ TEST_F(CABlockTransferTests, CAAddBlockOption2InResponse)
     }
 
     CADestroyDataSet(cadata);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -454,7 +529,7 @@ TEST_F(CABlockTransferTests, CAAddBlockOption2InRequest)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -494,7 +569,6 @@ TEST_F(CABlockTransferTests, CAAddBlockOption2InRequest)
     }
 
     CADestroyDataSet(cadata);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -508,7 +582,7 @@ TEST_F(CABlockTransferTests, CAGetBlockSizeOptionFromPduTest)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -526,7 +600,6 @@ TEST_F(CABlockTransferTests, CAGetBlockSizeOptionFromPduTest)
     EXPECT_FALSE(CAIsPayloadLengthInPduWithBlockSizeOption(pdu, COAP_OPTION_SIZE1,
                                                            &totalPayloadLen));
 
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -540,7 +613,7 @@ TEST_F(CABlockTransferTests, CASetNextBlockOption1WithRequest)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -564,7 +637,6 @@ TEST_F(CABlockTransferTests, CASetNextBlockOption1WithRequest)
     EXPECT_EQ(CA_STATUS_OK, CASetNextBlockOption1(pdu, tempRep, cadata, block, pdu->length));
 
     CADestroyDataSet(cadata);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -578,7 +650,7 @@ TEST_F(CABlockTransferTests, CASetNextBlockOption1WithResponse)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -603,7 +675,6 @@ TEST_F(CABlockTransferTests, CASetNextBlockOption1WithResponse)
     EXPECT_EQ(CA_STATUS_OK, CASetNextBlockOption1(pdu, tempRep, cadata, block, pdu->length));
 
     CADestroyDataSet(cadata);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -617,7 +688,7 @@ TEST_F(CABlockTransferTests, CASetNextBlockOption2WithRequest)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -641,7 +712,6 @@ TEST_F(CABlockTransferTests, CASetNextBlockOption2WithRequest)
     EXPECT_EQ(CA_STATUS_OK, CASetNextBlockOption2(pdu, tempRep, cadata, block, pdu->length));
 
     CADestroyDataSet(cadata);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
@@ -655,7 +725,7 @@ TEST_F(CABlockTransferTests, CASetNextBlockOption2WithResponse)
     CACreateEndpoint(CA_DEFAULT_FLAGS, CA_ADAPTER_IP, "127.0.0.1", 5683, &tempRep);
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAToken_t tempToken = NULL;
@@ -680,7 +750,6 @@ TEST_F(CABlockTransferTests, CASetNextBlockOption2WithResponse)
     EXPECT_EQ(CA_STATUS_OK, CASetNextBlockOption2(pdu, tempRep, cadata, block, pdu->length));
 
     CADestroyDataSet(cadata);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 
     CADestroyToken(tempToken);
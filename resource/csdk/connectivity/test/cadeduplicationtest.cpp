@@ -0,0 +1,111 @@
+/* ****************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include "cacommon.h"
+#include "cadeduplication.h"
+#include "oic_malloc.h"
+#include "oic_string.h"
+
+class CADeduplicationTests : public testing::Test {
+    protected:
+    virtual void SetUp()
+    {
+        CADeduplicationSetCacheSize(CA_DEDUP_DEFAULT_MAX_ENTRIES,
+                                    CA_DEDUP_DEFAULT_MAX_RESPONSE_SIZE);
+        CADeduplicationInitialize();
+
+        memset(&m_first, 0, sizeof(m_first));
+        m_first.adapter = CA_ADAPTER_IP;
+        m_first.port = 5683;
+        OICStrcpy(m_first.addr, sizeof(m_first.addr), "192.168.0.1");
+        m_second = m_first;
+        OICStrcpy(m_second.addr, sizeof(m_second.addr), "192.168.0.2");
+    }
+
+    virtual void TearDown()
+    {
+        CADeduplicationTerminate();
+        CADeduplicationSetCacheSize(CA_DEDUP_DEFAULT_MAX_ENTRIES,
+                                    CA_DEDUP_DEFAULT_MAX_RESPONSE_SIZE);
+    }
+
+    bool IsDuplicate(const CAEndpoint_t *endpoint, uint16_t messageId)
+    {
+        void *response = NULL;
+        uint32_t responseLength = 0;
+        bool duplicate = CADeduplicationCheckRequest(endpoint, messageId,
+                                                     &response, &responseLength);
+        OICFree(response);
+        return duplicate;
+    }
+
+    CAEndpoint_t m_first;
+    CAEndpoint_t m_second;
+};
+
+TEST_F(CADeduplicationTests, DuplicateIsPerEndpointAndMessageId)
+{
+    EXPECT_FALSE(IsDuplicate(&m_first, 1));
+    EXPECT_FALSE(IsDuplicate(&m_second, 1));
+    EXPECT_FALSE(IsDuplicate(&m_first, 2));
+    EXPECT_TRUE(IsDuplicate(&m_first, 1));
+    EXPECT_TRUE(IsDuplicate(&m_second, 1));
+}
+
+TEST_F(CADeduplicationTests, ResponseIsReturnedForDuplicate)
+{
+    void *response = NULL;
+    uint32_t responseLength = 0;
+    EXPECT_FALSE(CADeduplicationCheckRequest(&m_first, 1, &response, &responseLength));
+    EXPECT_EQ(NULL, response);
+
+    CADeduplicationSaveResponse(&m_first, 1, "response", 8);
+    CADeduplicationSaveResponse(&m_second, 1, "unknown", 7);
+
+    EXPECT_TRUE(CADeduplicationCheckRequest(&m_first, 1, &response, &responseLength));
+    ASSERT_NE((void *)NULL, response);
+    EXPECT_EQ(8u, responseLength);
+    EXPECT_EQ(0, memcmp(response, "response", 8));
+    OICFree(response);
+
+    EXPECT_FALSE(IsDuplicate(&m_second, 1));
+}
+
+TEST_F(CADeduplicationTests, CacheSizeIsBounded)
+{
+    CADeduplicationSetCacheSize(2, 4);
+
+    void *response = NULL;
+    uint32_t responseLength = 0;
+    EXPECT_FALSE(IsDuplicate(&m_first, 1));
+    CADeduplicationSaveResponse(&m_first, 1, "response", 8);
+    EXPECT_TRUE(CADeduplicationCheckRequest(&m_first, 1, &response, &responseLength));
+    EXPECT_EQ(NULL, response);
+
+    EXPECT_FALSE(IsDuplicate(&m_first, 2));
+    EXPECT_FALSE(IsDuplicate(&m_first, 3));
+    EXPECT_FALSE(IsDuplicate(&m_first, 1));
+
+    CADeduplicationSetCacheSize(0, 0);
+    EXPECT_FALSE(IsDuplicate(&m_first, 4));
+    EXPECT_FALSE(IsDuplicate(&m_first, 4));
+}
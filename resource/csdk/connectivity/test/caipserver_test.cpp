@@ -0,0 +1,344 @@
+//******************************************************************
+//
+// Copyright 2017 Open Connectivity Foundation All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "iotivity_config.h"
+#include <gtest/gtest.h>
+
+#ifdef __linux__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// Test function hooks
+#define CAUnregisterForAddressChanges CAUnregisterForAddressChangesTest
+#define CADeInitializeIPGlobals CADeInitializeIPGlobalsTest
+#define CAIPPullData CAIPPullDataTest
+#define CAIPStartServer CAIPStartServerTest
+#define CAIPStopServer CAIPStopServerTest
+#define CAWakeUpForChange CAWakeUpForChangeTest
+#define CAIPStartListenServer CAIPStartListenServerTest
+#define CAIPStopListenServer CAIPStopListenServerTest
+#define CAProcessNewInterface CAProcessNewInterfaceTest
+#define CAIPSetPacketReceiveCallback CAIPSetPacketReceiveCallbackTest
+#define CAIPSendData CAIPSendDataTest
+#define CAGetIPInterfaceInformation CAGetIPInterfaceInformationTest
+#define CAIPSetErrorHandler CAIPSetErrorHandlerTest
+#define CAGetLinkLocalZoneId CAGetLinkLocalZoneIdTest
+#define CAIPGetInterfaceInformation CAIPGetInterfaceInformationTest
+
+#include "../src/ip_adapter/caipserver.c"
+
+#define PEER_COUNT (3 * RECV_BATCH_SIZE + 1)
+#define WAIT_TIME_US (5 * 1000 * 1000)
+#define MULTICAST_INTERFACE_COUNT (2 * SEND_BATCH_SIZE + 3)
+
+// The fake reports g_interfaceCount usable loopback entries, plus one entry
+// that is down and one of the other family, which multicast sends skip.
+static size_t g_interfaceCount = 1;
+static size_t g_interfaceQueries = 0;
+
+static bool AddInterface(u_arraylist_t *iflist, uint32_t flags, uint16_t family)
+{
+    CAInterface_t *ifitem = (CAInterface_t *)OICCalloc(1, sizeof(*ifitem));
+    if (!ifitem)
+    {
+        return false;
+    }
+    OICStrcpy(ifitem->name, sizeof(ifitem->name), "lo");
+    ifitem->index = if_nametoindex("lo");
+    ifitem->flags = flags;
+    ifitem->family = family;
+    OICStrcpy(ifitem->addr, sizeof(ifitem->addr), "127.0.0.1");
+    if (!u_arraylist_add(iflist, ifitem))
+    {
+        OICFree(ifitem);
+        return false;
+    }
+    return true;
+}
+
+u_arraylist_t *CAIPGetInterfaceInformationTest(int desiredIndex)
+{
+    (void)desiredIndex;
+    g_interfaceQueries++;
+    u_arraylist_t *iflist = u_arraylist_create();
+    if (!iflist)
+    {
+        return NULL;
+    }
+    AddInterface(iflist, IFF_UP, AF_INET);
+    AddInterface(iflist, IFF_UP | IFF_RUNNING, AF_INET6);
+    for (size_t i = 0; i < g_interfaceCount; i++)
+    {
+        AddInterface(iflist, IFF_UP | IFF_RUNNING, AF_INET);
+    }
+    return iflist;
+}
+
+typedef struct
+{
+    CAEndpoint_t endpoint;
+    char payload[16];
+} ReceivedDatagram_t;
+
+static oc_mutex g_receivedMutex = NULL;
+static oc_cond g_receivedCond = NULL;
+static ReceivedDatagram_t g_received[MULTICAST_INTERFACE_COUNT + PEER_COUNT + 1];
+static size_t g_receivedCount = 0;
+static bool g_holdReceiver = false;
+
+// Keeps the receive thread busy on the first datagram while the test queues more.
+static void RecordDatagram(const CASecureEndpoint_t *sep, const void *data, size_t dataLength)
+{
+    oc_mutex_lock(g_receivedMutex);
+    if (g_receivedCount < sizeof(g_received) / sizeof(g_received[0]))
+    {
+        ReceivedDatagram_t *datagram = &g_received[g_receivedCount];
+        datagram->endpoint = sep->endpoint;
+        size_t len = (dataLength < sizeof(datagram->payload)) ? dataLength
+                                                               : sizeof(datagram->payload) - 1;
+        memcpy(datagram->payload, data, len);
+        datagram->payload[len] = '\0';
+    }
+    g_receivedCount++;
+    oc_cond_broadcast(g_receivedCond);
+    while (g_holdReceiver)
+    {
+        oc_cond_wait(g_receivedCond, g_receivedMutex);
+    }
+    oc_mutex_unlock(g_receivedMutex);
+}
+
+class CAIPServerTest : public testing::Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            g_interfaceCount = 1;
+            g_interfaceQueries = 0;
+            g_receivedCount = 0;
+            g_holdReceiver = false;
+            g_receivedMutex = oc_mutex_new();
+            g_receivedCond = oc_cond_new();
+
+            caglobals.ip.u6.fd = OC_INVALID_SOCKET;
+            caglobals.ip.u6s.fd = OC_INVALID_SOCKET;
+            caglobals.ip.u4.fd = OC_INVALID_SOCKET;
+            caglobals.ip.u4s.fd = OC_INVALID_SOCKET;
+            caglobals.ip.m6.fd = OC_INVALID_SOCKET;
+            caglobals.ip.m6s.fd = OC_INVALID_SOCKET;
+            caglobals.ip.m4.fd = OC_INVALID_SOCKET;
+            caglobals.ip.m4s.fd = OC_INVALID_SOCKET;
+            caglobals.ip.u4.port = 0;
+            caglobals.ip.u4s.port = 0;
+            caglobals.ip.m4.port = CA_COAP;
+            caglobals.ip.m4s.port = CA_SECURE_COAP;
+            caglobals.ip.ipv4enabled = true;
+            caglobals.ip.ipv6enabled = false;
+            caglobals.ip.started = false;
+
+            ASSERT_EQ(CA_STATUS_OK, ca_thread_pool_init(1, &m_threadPool));
+            CAIPSetPacketReceiveCallback(RecordDatagram);
+            ASSERT_EQ(CA_STATUS_OK, CAIPStartServer(m_threadPool));
+        }
+
+        virtual void TearDown()
+        {
+            oc_mutex_lock(g_receivedMutex);
+            g_holdReceiver = false;
+            oc_cond_broadcast(g_receivedCond);
+            oc_mutex_unlock(g_receivedMutex);
+
+            CAIPStopServer();
+            ca_thread_pool_free(m_threadPool);
+            CADeInitializeIPGlobals();
+            CAIPSetPacketReceiveCallback(NULL);
+            oc_cond_free(g_receivedCond);
+            oc_mutex_free(g_receivedMutex);
+        }
+
+        // Waits until at least count datagrams have been delivered.
+        bool WaitForDatagrams(size_t count)
+        {
+            oc_mutex_lock(g_receivedMutex);
+            while (g_receivedCount < count)
+            {
+                if (OC_WAIT_SUCCESS != oc_cond_wait_for(g_receivedCond, g_receivedMutex,
+                                                        WAIT_TIME_US))
+                {
+                    break;
+                }
+            }
+            bool received = (g_receivedCount >= count);
+            oc_mutex_unlock(g_receivedMutex);
+            return received;
+        }
+
+        // Sends the local port of a new socket, from that socket, to the unicast socket.
+        uint16_t SendFromNewPeer(int *peerFd)
+        {
+            *peerFd = socket(AF_INET, SOCK_DGRAM, 0);
+            EXPECT_NE(-1, *peerFd);
+            struct sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t addrLen = sizeof(addr);
+            EXPECT_EQ(0, bind(*peerFd, (struct sockaddr *)&addr, sizeof(addr)));
+            EXPECT_EQ(0, getsockname(*peerFd, (struct sockaddr *)&addr, &addrLen));
+            uint16_t port = ntohs(addr.sin_port);
+
+            char payload[16];
+            int len = snprintf(payload, sizeof(payload), "%u", port);
+            addr.sin_port = htons(caglobals.ip.u4.port);
+            EXPECT_EQ(len, sendto(*peerFd, payload, len, 0,
+                                  (struct sockaddr *)&addr, sizeof(addr)));
+            return port;
+        }
+
+        // Sends a multicast datagram the way the IP adapter does.
+        void SendMulticast(const char *payload)
+        {
+            CAEndpoint_t endpoint;
+            memset(&endpoint, 0, sizeof(endpoint));
+            endpoint.adapter = CA_ADAPTER_IP;
+            endpoint.flags = CA_IPV4;
+            CAIPSendData(&endpoint, payload, strlen(payload), true);
+        }
+
+        // Reports the loopback interface as newly added, as a netlink event would.
+        void NotifyNewInterface()
+        {
+            CAInterface_t ifitem;
+            memset(&ifitem, 0, sizeof(ifitem));
+            ifitem.index = if_nametoindex("lo");
+            ifitem.flags = IFF_UP | IFF_RUNNING;
+            ifitem.family = AF_INET;
+            CAProcessNewInterface(&ifitem);
+        }
+
+        ca_thread_pool_t m_threadPool;
+};
+
+TEST_F(CAIPServerTest, BatchedReceiveKeepsEachSource)
+{
+    int peerFds[PEER_COUNT + 1];
+    uint16_t ports[PEER_COUNT + 1];
+
+    // Hold the receive thread in the callback so the next datagrams queue up
+    // on the socket and are read back in full batches.
+    g_holdReceiver = true;
+    ports[0] = SendFromNewPeer(&peerFds[0]);
+    ASSERT_TRUE(WaitForDatagrams(1));
+
+    for (int i = 1; i <= PEER_COUNT; i++)
+    {
+        ports[i] = SendFromNewPeer(&peerFds[i]);
+    }
+
+    oc_mutex_lock(g_receivedMutex);
+    g_holdReceiver = false;
+    oc_cond_broadcast(g_receivedCond);
+    oc_mutex_unlock(g_receivedMutex);
+    ASSERT_TRUE(WaitForDatagrams(PEER_COUNT + 1));
+
+    // Each datagram arrives once, with the address and port it was sent from.
+    EXPECT_EQ((size_t)PEER_COUNT + 1, g_receivedCount);
+    bool seen[PEER_COUNT + 1] = { false };
+    for (int i = 0; i <= PEER_COUNT; i++)
+    {
+        const ReceivedDatagram_t *datagram = &g_received[i];
+        EXPECT_EQ(CA_ADAPTER_IP, datagram->endpoint.adapter);
+        EXPECT_TRUE(0 != (datagram->endpoint.flags & CA_IPV4));
+        EXPECT_FALSE(0 != (datagram->endpoint.flags & CA_MULTICAST));
+        EXPECT_STREQ("127.0.0.1", datagram->endpoint.addr);
+        EXPECT_EQ(datagram->endpoint.port, (uint16_t)atoi(datagram->payload));
+
+        for (int j = 0; j <= PEER_COUNT; j++)
+        {
+            if (ports[j] == datagram->endpoint.port)
+            {
+                EXPECT_FALSE(seen[j]);
+                seen[j] = true;
+            }
+        }
+    }
+    for (int i = 0; i <= PEER_COUNT; i++)
+    {
+        EXPECT_TRUE(seen[i]);
+        close(peerFds[i]);
+    }
+}
+
+TEST_F(CAIPServerTest, MulticastInterfacesCachedUntilChange)
+{
+    size_t queries = g_interfaceQueries;
+    SendMulticast("1");
+    EXPECT_EQ(queries + 1, g_interfaceQueries);
+
+    // Without interface change notifications the list is fetched for every send.
+    bool changesNotified = (caglobals.ip.netlinkFd != OC_INVALID_SOCKET);
+    SendMulticast("2");
+    EXPECT_EQ(queries + (changesNotified ? 1 : 2), g_interfaceQueries);
+    EXPECT_TRUE(NULL != g_multicastIfList);
+
+    // A new interface drops the cached list, and the next send fetches it again.
+    queries = g_interfaceQueries;
+    NotifyNewInterface();
+    EXPECT_TRUE(NULL == g_multicastIfList);
+    EXPECT_EQ(queries, g_interfaceQueries);
+
+    SendMulticast("3");
+    EXPECT_EQ(queries + 1, g_interfaceQueries);
+    EXPECT_TRUE(NULL != g_multicastIfList);
+    EXPECT_TRUE(WaitForDatagrams(3));
+}
+
+TEST_F(CAIPServerTest, MulticastReachesEveryInterface)
+{
+    // Enough interfaces for several sendmmsg() batches.
+    g_interfaceCount = MULTICAST_INTERFACE_COUNT;
+    NotifyNewInterface();
+    SendMulticast("fan-out");
+
+    // The server's multicast socket has joined the group on the loopback
+    // interface, so it receives the copy sent on each listed interface.
+    ASSERT_TRUE(WaitForDatagrams(MULTICAST_INTERFACE_COUNT));
+    usleep(100 * 1000);
+    oc_mutex_lock(g_receivedMutex);
+    EXPECT_EQ((size_t)MULTICAST_INTERFACE_COUNT, g_receivedCount);
+    for (size_t i = 0; i < g_receivedCount; i++)
+    {
+        const ReceivedDatagram_t *datagram = &g_received[i];
+        EXPECT_TRUE(0 != (datagram->endpoint.flags & CA_MULTICAST));
+        EXPECT_EQ(if_nametoindex("lo"), datagram->endpoint.ifindex);
+        EXPECT_EQ(caglobals.ip.u4.port, datagram->endpoint.port);
+        EXPECT_STREQ("fan-out", datagram->payload);
+    }
+    oc_mutex_unlock(g_receivedMutex);
+}
+
+#endif
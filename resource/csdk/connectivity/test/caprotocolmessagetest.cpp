@@ -49,19 +49,19 @@ public:
  */
 void verifyParsedOptions(CoAPOptionCase const *cases,
 			 size_t numCases,
-			 coap_list_t *optlist)
+			 const CAPDUOptions_t *optlist)
 {
     size_t index = 0;
-    for (coap_list_t *opt = optlist; opt; opt = opt->next)
+    for (size_t i = 0; i < optlist->numOptions; i++)
     {
-        coap_option *option = (coap_option *) opt->data;
-        EXPECT_TRUE(option != NULL);
+        const CAPDUOption_t *option = &optlist->options[i];
+        EXPECT_TRUE(option->data != NULL);
         EXPECT_LT(index, numCases);
-        if (option && (index < numCases))
+        if (option->data && (index < numCases))
         {
-            unsigned short key = COAP_OPTION_KEY(*option);
-            unsigned int length = COAP_OPTION_LENGTH(*option);
-            std::string dataStr((const char*)COAP_OPTION_DATA(*option), length);
+            unsigned short key = option->key;
+            unsigned int length = option->length;
+            std::string dataStr((const char*)option->data, length);
             // First validate the test case:
             EXPECT_EQ(cases[index].length, cases[index].dataStr.length());
 
@@ -91,12 +91,11 @@ TEST(CAProtocolMessage, CAParseURIBase)
     size_t numCases = sizeof(cases) / sizeof(cases[0]);
 
 
-    coap_list_t *optlist = NULL;
+    CAPDUOptions_t optlist = CAPDUOptions_t();
     CAParseURI(sampleURI, &optlist);
 
 
-    verifyParsedOptions(cases, numCases, optlist);
-    coap_delete_list(optlist);
+    verifyParsedOptions(cases, numCases, &optlist);
 }
 
 // Try for multiple URI path components that still total less than 128
@@ -124,12 +123,11 @@ TEST(CAProtocolMessage, CAParseURIManyPath)
     size_t numCases = sizeof(cases) / sizeof(cases[0]);
 
 
-    coap_list_t *optlist = NULL;
+    CAPDUOptions_t optlist = CAPDUOptions_t();
     CAParseURI(sampleURI, &optlist);
 
 
-    verifyParsedOptions(cases, numCases, optlist);
-    coap_delete_list(optlist);
+    verifyParsedOptions(cases, numCases, &optlist);
 }
 
 // Try for multiple URI parameters that still total less than 128
@@ -156,12 +154,11 @@ TEST(CAProtocolMessage, CAParseURIManyParams)
     size_t numCases = sizeof(cases) / sizeof(cases[0]);
 
 
-    coap_list_t *optlist = NULL;
+    CAPDUOptions_t optlist = CAPDUOptions_t();
     CAParseURI(sampleURI, &optlist);
 
 
-    verifyParsedOptions(cases, numCases, optlist);
-    coap_delete_list(optlist);
+    verifyParsedOptions(cases, numCases, &optlist);
 }
 
 // Test that an initial long path component won't hide latter ones.
@@ -183,12 +180,47 @@ TEST(CAProtocolMessage, CAParseURILongPath)
     size_t numCases = sizeof(cases) / sizeof(cases[0]);
 
 
-    coap_list_t *optlist = NULL;
+    CAPDUOptions_t optlist = CAPDUOptions_t();
     CAParseURI(sampleURI, &optlist);
 
 
-    verifyParsedOptions(cases, numCases, optlist);
-    coap_delete_list(optlist);
+    verifyParsedOptions(cases, numCases, &optlist);
+}
+
+// Header options are kept in option number order, integer options re-encoded.
+TEST(CAProtocolMessage, CAParseHeadOptionOrder)
+{
+    CAHeaderOption_t headerOptions[3];
+    memset(headerOptions, 0, sizeof(headerOptions));
+    headerOptions[0].optionID = 2048;
+    headerOptions[0].optionLength = 1;
+    headerOptions[0].optionData[0] = 'v';
+    headerOptions[1].optionID = COAP_OPTION_MAXAGE;
+    headerOptions[1].optionLength = 4;
+    headerOptions[1].optionData[3] = '<';
+    headerOptions[2].optionID = COAP_OPTION_IF_MATCH;
+    headerOptions[2].optionLength = 2;
+    headerOptions[2].optionData[0] = 'a';
+    headerOptions[2].optionData[1] = 'b';
+
+    CAInfo_t inData;
+    memset(&inData, 0, sizeof(CAInfo_t));
+    inData.options = headerOptions;
+    inData.numOptions = 3;
+    inData.payloadFormat = CA_FORMAT_APPLICATION_CBOR;
+
+    CoAPOptionCase cases[] = {
+        {COAP_OPTION_IF_MATCH, 2, "ab"},
+        {COAP_OPTION_CONTENT_FORMAT, 1, "<"},
+        {COAP_OPTION_MAXAGE, 1, "<"},
+        {2048, 1, "v"},
+    };
+    size_t numCases = sizeof(cases) / sizeof(cases[0]);
+
+    CAPDUOptions_t optlist = CAPDUOptions_t();
+    EXPECT_EQ(CA_STATUS_OK, CAParseHeadOption(CA_GET, &inData, &optlist));
+
+    verifyParsedOptions(cases, numCases, &optlist);
 }
 
 TEST(CAProtocolMessage, CAGetTokenFromPDU)
@@ -200,7 +232,7 @@ TEST(CAProtocolMessage, CAGetTokenFromPDU)
     tempRep.port = 5683;
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAInfo_t inData;
@@ -221,7 +253,6 @@ TEST(CAProtocolMessage, CAGetTokenFromPDU)
     EXPECT_EQ(CA_STATUS_OK, CAGetTokenFromPDU(pdu->transport_hdr, &outData, &tempRep));
 
     OICFree(outData.token);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 }
 
@@ -234,7 +265,7 @@ TEST(CAProtocolMessage, CAGetInfoFromPDU)
     tempRep.port = 5683;
 
     coap_pdu_t *pdu = NULL;
-    coap_list_t *options = NULL;
+    CAPDUOptions_t options;
     coap_transport_t transport = COAP_UDP;
 
     CAInfo_t inData;
@@ -258,6 +289,5 @@ TEST(CAProtocolMessage, CAGetInfoFromPDU)
     EXPECT_EQ(CA_STATUS_OK, CAGetInfoFromPDU(pdu, &tempRep, &code, &outData));
 
     OICFree(outData.token);
-    coap_delete_list(options);
     coap_delete_pdu(pdu);
 }
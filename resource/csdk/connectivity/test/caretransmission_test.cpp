@@ -0,0 +1,195 @@
+//******************************************************************
+//
+// Copyright 2017 Open Connectivity Foundation All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "iotivity_config.h"
+#include <gtest/gtest.h>
+
+// Test function hooks
+#define CARetransmissionStart CARetransmissionStartTest
+#define CARetransmissionBaseRoutine CARetransmissionBaseRoutineTest
+#define CARetransmissionInitialize CARetransmissionInitializeTest
+#define CARetransmissionSentData CARetransmissionSentDataTest
+#define CARetransmissionReceivedData CARetransmissionReceivedDataTest
+#define CARetransmissionStop CARetransmissionStopTest
+#define CARetransmissionDestroy CARetransmissionDestroyTest
+
+#include "../src/caretransmission.c"
+
+#define PENDING_COUNT 64
+#define TEST_PDU_SIZE 4
+
+// CoAP header: version 1, type, token length 0, code, message id.
+static void MakePdu(uint8_t *pdu, CAMessageType_t type, uint8_t code, uint16_t messageId)
+{
+    pdu[0] = (uint8_t)(0x40 | (type << 4));
+    pdu[1] = code;
+    pdu[2] = (uint8_t)(messageId >> 8);
+    pdu[3] = (uint8_t)(messageId & 0xFF);
+}
+
+class CARetransmissionTest : public testing::Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            memset(&m_endpoint, 0, sizeof(m_endpoint));
+            m_endpoint.adapter = CA_ADAPTER_IP;
+            m_endpoint.flags = CA_IPV4;
+            m_endpoint.port = 5683;
+
+            // The retransmission thread is not started, so nothing leaves the heap on its own.
+            ASSERT_EQ(CA_STATUS_OK, ca_thread_pool_init(1, &m_threadPool));
+            ASSERT_EQ(CA_STATUS_OK, CARetransmissionInitialize(&m_context, m_threadPool,
+                                                               NULL, NULL, NULL));
+        }
+
+        virtual void TearDown()
+        {
+            CARetransmissionDestroy(&m_context);
+            ca_thread_pool_free(m_threadPool);
+        }
+
+        CAResult_t Send(uint16_t messageId)
+        {
+            uint8_t pdu[TEST_PDU_SIZE];
+            MakePdu(pdu, CA_MSG_CONFIRM, CA_GET, messageId);
+            return CARetransmissionSentData(&m_context, &m_endpoint, CA_REQUEST_DATA,
+                                            pdu, sizeof(pdu));
+        }
+
+        CAResult_t Receive(const CAEndpoint_t *endpoint, CAMessageType_t type, uint8_t code,
+                           uint16_t messageId, void **retransmissionPdu)
+        {
+            uint8_t pdu[TEST_PDU_SIZE];
+            MakePdu(pdu, type, code, messageId);
+            return CARetransmissionReceivedData(&m_context, endpoint, pdu, sizeof(pdu),
+                                                retransmissionPdu);
+        }
+
+        void ExpectHeap()
+        {
+            size_t len = u_arraylist_length(m_context.dataList);
+            for (size_t i = 0; i < len; i++)
+            {
+                CARetransmissionData_t *data =
+                        (CARetransmissionData_t *) u_arraylist_get(m_context.dataList, i);
+                EXPECT_EQ(i, data->heapIndex);
+                EXPECT_EQ(data, oc_hashmap_get(m_context.dataMap, &data->key));
+                if (0 < i)
+                {
+                    CARetransmissionData_t *parent = (CARetransmissionData_t *)
+                            u_arraylist_get(m_context.dataList, (i - 1) / 2);
+                    EXPECT_LE(parent->nextTime, data->nextTime);
+                }
+            }
+        }
+
+        ca_thread_pool_t m_threadPool;
+        CARetransmission_t m_context;
+        CAEndpoint_t m_endpoint;
+};
+
+TEST_F(CARetransmissionTest, HeapOrdersByNextTime)
+{
+    for (uint16_t id = 1; id <= PENDING_COUNT; id++)
+    {
+        ASSERT_EQ(CA_STATUS_OK, Send(id));
+    }
+    ASSERT_EQ((size_t)PENDING_COUNT, u_arraylist_length(m_context.dataList));
+    ExpectHeap();
+
+    // Taking the top repeatedly yields the data in order of their next retransmission.
+    uint64_t lastTime = 0;
+    oc_mutex_lock(m_context.threadMutex);
+    while (0 < u_arraylist_length(m_context.dataList))
+    {
+        CARetransmissionData_t *data =
+                (CARetransmissionData_t *) u_arraylist_get(m_context.dataList, 0);
+        EXPECT_LE(lastTime, data->nextTime);
+        lastTime = data->nextTime;
+        CARemoveRetransmissionData(&m_context, data);
+        CADestroyRetransmissionData(data);
+        ExpectHeap();
+    }
+    oc_mutex_unlock(m_context.threadMutex);
+}
+
+TEST_F(CARetransmissionTest, DuplicateMessageIdIsRejected)
+{
+    ASSERT_EQ(CA_STATUS_OK, Send(7));
+    EXPECT_EQ(CA_STATUS_FAILED, Send(7));
+    EXPECT_EQ(1u, u_arraylist_length(m_context.dataList));
+}
+
+TEST_F(CARetransmissionTest, AckRemovesMatchingData)
+{
+    for (uint16_t id = 1; id <= PENDING_COUNT; id++)
+    {
+        ASSERT_EQ(CA_STATUS_OK, Send(id));
+    }
+
+    // Same message id on another transport adapter does not match.
+    CAEndpoint_t other = m_endpoint;
+    other.adapter = CA_ADAPTER_GATT_BTLE;
+    void *retransmissionPdu = NULL;
+    EXPECT_EQ(CA_STATUS_OK, Receive(&other, CA_MSG_ACKNOWLEDGE, CA_EMPTY, 5,
+                                    &retransmissionPdu));
+    EXPECT_EQ(NULL, retransmissionPdu);
+    EXPECT_EQ((size_t)PENDING_COUNT, u_arraylist_length(m_context.dataList));
+
+    // A reset carrying a response code is not a rejection of the message.
+    EXPECT_EQ(CA_STATUS_OK, Receive(&m_endpoint, CA_MSG_RESET, CA_GET, 5,
+                                    &retransmissionPdu));
+    EXPECT_EQ((size_t)PENDING_COUNT, u_arraylist_length(m_context.dataList));
+
+    // An empty ACK removes the data and hands back the sent PDU.
+    EXPECT_EQ(CA_STATUS_OK, Receive(&m_endpoint, CA_MSG_ACKNOWLEDGE, CA_EMPTY, 5,
+                                    &retransmissionPdu));
+    ASSERT_TRUE(NULL != retransmissionPdu);
+    uint8_t sent[TEST_PDU_SIZE];
+    MakePdu(sent, CA_MSG_CONFIRM, CA_GET, 5);
+    EXPECT_EQ(0, memcmp(sent, retransmissionPdu, sizeof(sent)));
+    OICFree(retransmissionPdu);
+    EXPECT_EQ((size_t)PENDING_COUNT - 1, u_arraylist_length(m_context.dataList));
+
+    // A piggybacked response and an empty RST remove data too.
+    retransmissionPdu = NULL;
+    EXPECT_EQ(CA_STATUS_OK, Receive(&m_endpoint, CA_MSG_ACKNOWLEDGE, 0x45, 1,
+                                    &retransmissionPdu));
+    EXPECT_EQ(NULL, retransmissionPdu);
+    EXPECT_EQ(CA_STATUS_OK, Receive(&m_endpoint, CA_MSG_RESET, CA_EMPTY, PENDING_COUNT,
+                                    &retransmissionPdu));
+    OICFree(retransmissionPdu);
+    EXPECT_EQ((size_t)PENDING_COUNT - 3, u_arraylist_length(m_context.dataList));
+
+    CARetransmissionKey_t key = { 0, CA_ADAPTER_IP };
+    uint8_t removed[] = { 1, 5, PENDING_COUNT };
+    for (size_t i = 0; i < sizeof(removed); i++)
+    {
+        MakePdu(sent, CA_MSG_CONFIRM, CA_GET, removed[i]);
+        key.messageId = CAGetMessageIdFromPduBinaryData(sent, sizeof(sent));
+        EXPECT_EQ(NULL, oc_hashmap_get(m_context.dataMap, &key));
+    }
+    ExpectHeap();
+
+    // The removed message id can be used again.
+    EXPECT_EQ(CA_STATUS_OK, Send(5));
+    ExpectHeap();
+}
@@ -0,0 +1,145 @@
+//******************************************************************
+//
+// Copyright 2017 Open Connectivity Foundation All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "iotivity_config.h"
+#include <gtest/gtest.h>
+
+// The outbound queue of TCP sessions is only used with epoll.
+#if defined(TCP_ADAPTER) && defined(WITH_EPOLL) && defined(__linux__)
+
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "catcpinterface.h"
+#include "cathreadpool.h"
+
+#define FRAME_SIZE 1000
+
+static int g_failedFrames = 0;
+static size_t g_failedBytes = 0;
+
+static void RecordFailedFrame(const CAEndpoint_t *endpoint, const void *data, size_t dlen,
+                              CAResult_t result)
+{
+    (void)data;
+    EXPECT_EQ(CA_SEND_FAILED, result);
+    // The session list is unlocked by now, so the error handler may look sessions up.
+    EXPECT_EQ(OC_INVALID_SOCKET, CAGetSocketFDFromEndpoint(endpoint));
+    g_failedFrames++;
+    g_failedBytes += dlen;
+}
+
+class CATCPWriteQueueTest : public testing::Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            g_failedFrames = 0;
+            g_failedBytes = 0;
+
+            caglobals.tcp.ipv4.fd = OC_INVALID_SOCKET;
+            caglobals.tcp.ipv4s.fd = OC_INVALID_SOCKET;
+            caglobals.tcp.ipv6.fd = OC_INVALID_SOCKET;
+            caglobals.tcp.ipv6s.fd = OC_INVALID_SOCKET;
+            caglobals.tcp.selectTimeout = 1;
+            caglobals.tcp.listenBacklog = 3;
+            ASSERT_EQ(CA_STATUS_OK, ca_thread_pool_init(2, &m_threadPool));
+            CATCPSetErrorHandler(RecordFailedFrame);
+            ASSERT_EQ(CA_STATUS_OK, CATCPStartServer(m_threadPool));
+
+            // A peer that accepts the connection but never reads from it.
+            m_peerFd = socket(AF_INET, SOCK_STREAM, 0);
+            ASSERT_NE(-1, m_peerFd);
+            int size = 4096;
+            setsockopt(m_peerFd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+            struct sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t addrLen = sizeof(addr);
+            ASSERT_EQ(0, bind(m_peerFd, (struct sockaddr *)&addr, sizeof(addr)));
+            ASSERT_EQ(0, listen(m_peerFd, 1));
+            ASSERT_EQ(0, getsockname(m_peerFd, (struct sockaddr *)&addr, &addrLen));
+
+            memset(&m_endpoint, 0, sizeof(m_endpoint));
+            m_endpoint.adapter = CA_ADAPTER_TCP;
+            m_endpoint.flags = CA_IPV4;
+            m_endpoint.port = ntohs(addr.sin_port);
+            strcpy(m_endpoint.addr, "127.0.0.1");
+
+            for (size_t i = 0; i < sizeof(m_frame); i++)
+            {
+                m_frame[i] = (unsigned char)i;
+            }
+        }
+
+        virtual void TearDown()
+        {
+            CATCPStopServer();
+            CATCPSetErrorHandler(NULL);
+            close(m_peerFd);
+            ca_thread_pool_free(m_threadPool);
+        }
+
+        ca_thread_pool_t m_threadPool;
+        int m_peerFd;
+        CAEndpoint_t m_endpoint;
+        unsigned char m_frame[FRAME_SIZE];
+};
+
+TEST_F(CATCPWriteQueueTest, DisconnectReportsQueuedData)
+{
+    // Send until the socket stops accepting data, i.e. a write was partial or
+    // failed with EAGAIN and the rest of the frame was queued.
+    CATCPSessionInfo_t *session = NULL;
+    size_t sent = 0;
+    for (int i = 0; i < 10000; i++)
+    {
+        ASSERT_EQ(FRAME_SIZE, CATCPSendData(&m_endpoint, m_frame, sizeof(m_frame)));
+        sent += FRAME_SIZE;
+        session = CAGetTCPSessionInfoFromEndpoint(&m_endpoint);
+        ASSERT_TRUE(NULL != session);
+        if (session->pendingHead)
+        {
+            break;
+        }
+    }
+    ASSERT_TRUE(NULL != session->pendingHead);
+
+    // Later frames are queued behind it instead of being written.
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_EQ(FRAME_SIZE, CATCPSendData(&m_endpoint, m_frame, sizeof(m_frame)));
+        sent += FRAME_SIZE;
+    }
+    size_t pendingLen = session->pendingLen;
+    EXPECT_LE(3u * FRAME_SIZE, pendingLen);
+    EXPECT_GT(sent, pendingLen);
+    EXPECT_EQ(0, g_failedFrames);
+
+    // Disconnecting drops the queue and reports every unsent frame.
+    EXPECT_EQ(CA_STATUS_OK, CASearchAndDeleteTCPSession(&m_endpoint));
+    EXPECT_EQ(4, g_failedFrames);
+    EXPECT_EQ(pendingLen, g_failedBytes);
+}
+
+#endif
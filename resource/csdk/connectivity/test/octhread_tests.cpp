@@ -542,3 +542,47 @@ TEST(ConditionTests, TC_07_WAITDURATION)
 
     oc_cond_free(sharedCond);
 }
+
+typedef struct _tagFunc3
+{
+    oc_mutex mutex;
+    int count;
+} _func3_struct;
+
+void countFunc(void *context)
+{
+    _func3_struct* pData = (_func3_struct*) context;
+
+    oc_mutex_lock(pData->mutex);
+    pData->count++;
+    oc_mutex_unlock(pData->mutex);
+}
+
+TEST(ThreadPoolTests, TC_01_BOUNDED_WORKERS)
+{
+    const int NUM_TASKS = 200;
+    ca_thread_pool_t mythreadpool;
+
+    EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_init(3, &mythreadpool));
+
+    _func3_struct pData = { oc_mutex_new(), 0 };
+    EXPECT_TRUE(pData.mutex != NULL);
+
+    for (int i = 0; i < NUM_TASKS; i++)
+    {
+        EXPECT_EQ(CA_STATUS_OK,
+                  ca_thread_pool_add_task(mythreadpool, countFunc, &pData));
+    }
+
+    ca_thread_pool_stats_t stats;
+    EXPECT_EQ(CA_STATUS_OK, ca_thread_pool_get_stats(mythreadpool, &stats));
+    EXPECT_GE(3u, stats.numThreads);
+    EXPECT_LT(0u, stats.maxQueueDepth);
+
+    // Queued tasks are drained before the workers are joined.
+    ca_thread_pool_free(mythreadpool);
+
+    EXPECT_EQ(NUM_TASKS, pData.count);
+
+    oc_mutex_free(pData.mutex);
+}
@@ -48,6 +48,8 @@
 #define GetCASecureEndpointData GetCASecureEndpointDataTest
 #define SetCASecureEndpointAttribute SetCASecureEndpointAttributeTest
 #define GetCASecureEndpointAttributes GetCASecureEndpointAttributesTest
+#define CAsetSslSessionCache CAsetSslSessionCacheTest
+#define CAgetSslSessionCacheStats CAgetSslSessionCacheStatsTest
 
 #include "../src/adapter_util/ca_adapter_net_ssl.c"
 
@@ -3042,3 +3044,389 @@ TEST(TLSAdapter, TestCertsValid)
     EXPECT_EQ(0, ret) << "Failed to parse CA cert";
     mbedtls_x509_crt_free(&cert);
 }
+
+TEST(TLSAdapter, SetSslSessionCache)
+{
+    CASslSessionCacheStats_t stats;
+    EXPECT_EQ(CA_STATUS_INVALID_PARAM, CAsetSslSessionCache(10, 0));
+    EXPECT_EQ(CA_STATUS_INVALID_PARAM, CAgetSslSessionCacheStats(NULL));
+
+    EXPECT_EQ(CA_STATUS_OK, CAsetSslSessionCache(10, 60));
+    EXPECT_EQ(CA_STATUS_OK, CAgetSslSessionCacheStats(&stats));
+
+    EXPECT_EQ(CA_STATUS_OK, CAsetSslSessionCache(0, SESSION_CACHE_DEFAULT_TIMEOUT));
+}
+
+TEST(TLSAdapter, PkixDigestTracksTrustChanges)
+{
+    uint8_t ca[] = "ca";
+    uint8_t crl[] = "crl";
+    uint8_t revoked[] = "crl2";
+    PkiInfo_t inf = {
+        BYTE_ARRAY_INITIALIZER,
+        BYTE_ARRAY_INITIALIZER,
+        { ca, sizeof(ca) },
+        { crl, sizeof(crl) }
+    };
+    unsigned char first[PKIX_DIGEST_LEN];
+    unsigned char second[PKIX_DIGEST_LEN];
+
+    ASSERT_TRUE(DigestPkixInfo(&inf, first));
+    ASSERT_TRUE(DigestPkixInfo(&inf, second));
+    EXPECT_EQ(0, memcmp(first, second, sizeof(first)));
+
+    inf.crl.data = revoked;
+    inf.crl.len = sizeof(revoked);
+    ASSERT_TRUE(DigestPkixInfo(&inf, second));
+    EXPECT_NE(0, memcmp(first, second, sizeof(first)));
+}
+
+TEST(TLSAdapter, CipherSelectionFlushesKeptSessions)
+{
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+    EXPECT_EQ(CA_STATUS_OK, CAsetSslSessionCache(10, 60));
+
+    SslClientSession_t * cs = (SslClientSession_t *) OICCalloc(1, sizeof(SslClientSession_t));
+    ASSERT_TRUE(NULL != cs);
+    mbedtls_ssl_session_init(&cs->session);
+    oc_mutex_lock(g_sslContextMutex);
+    bool added = u_arraylist_add(g_caSslContext->clientSessions, (void *) cs);
+    oc_mutex_unlock(g_sslContextMutex);
+    ASSERT_TRUE(added);
+
+    EXPECT_EQ(CA_STATUS_OK, CAsetTlsCipherSuite(MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256));
+    EXPECT_EQ(0u, u_arraylist_length(g_caSslContext->clientSessions));
+
+    EXPECT_EQ(CA_STATUS_OK, CAsetSslSessionCache(0, SESSION_CACHE_DEFAULT_TIMEOUT));
+    CAdeinitSslAdapter();
+}
+
+static SslEndPoint_t * NewTestPeer(CATransportAdapter_t adapter, const char *addr, uint16_t port)
+{
+    SslEndPoint_t * tep = (SslEndPoint_t *) OICCalloc(1, sizeof(SslEndPoint_t));
+    if (NULL != tep)
+    {
+        mbedtls_ssl_init(&tep->ssl);
+        tep->sep.endpoint.adapter = adapter;
+        strncpy(tep->sep.endpoint.addr, addr, sizeof(tep->sep.endpoint.addr) - 1);
+        tep->sep.endpoint.port = port;
+    }
+    return tep;
+}
+
+TEST(TLSAdapter, PeerIndexMatchesPeerList)
+{
+    const size_t peerCount = 300;
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+    oc_mutex_lock(g_sslContextMutex);
+    ASSERT_TRUE(NULL != g_caSslContext->peerMap);
+
+    char addr[MAX_ADDR_STR_SIZE_CA];
+    for (size_t i = 0; i < peerCount; i++)
+    {
+        snprintf(addr, sizeof(addr), "10.0.%u.%u", (unsigned)(i / 100), (unsigned)(i % 100));
+        SslEndPoint_t * tep = NewTestPeer(CA_ADAPTER_TCP, addr, (uint16_t)(5000 + i % 3));
+        ASSERT_TRUE(NULL != tep);
+        ASSERT_TRUE(AddSslPeer(tep));
+    }
+    SslEndPoint_t * ble = NewTestPeer(CA_ADAPTER_GATT_BTLE, "00:11:22:33:44:55", 0);
+    ASSERT_TRUE(NULL != ble);
+    ASSERT_TRUE(AddSslPeer(ble));
+
+    // Every session is found by its address, and a different port doesn't match.
+    for (size_t i = 0; i < peerCount; i++)
+    {
+        SslEndPoint_t * tep = (SslEndPoint_t *) u_arraylist_get(g_caSslContext->peerList, i);
+        CAEndpoint_t endpoint = tep->sep.endpoint;
+        EXPECT_EQ(tep, GetSslPeer(&endpoint));
+        endpoint.port++;
+        EXPECT_TRUE(NULL == GetSslPeer(&endpoint));
+        endpoint.port--;
+        endpoint.adapter = CA_ADAPTER_IP;
+        EXPECT_TRUE(NULL == GetSslPeer(&endpoint));
+    }
+
+    // The port of a BLE address is not compared.
+    CAEndpoint_t endpoint = ble->sep.endpoint;
+    endpoint.port = 1234;
+    EXPECT_EQ(ble, GetSslPeer(&endpoint));
+
+    // As with the list, the first of two sessions with the same address is found,
+    // and the second one once the first is removed.
+    SslEndPoint_t * first = (SslEndPoint_t *) u_arraylist_get(g_caSslContext->peerList, 7);
+    SslEndPoint_t * second = NewTestPeer(CA_ADAPTER_TCP, first->sep.endpoint.addr,
+                                         first->sep.endpoint.port);
+    ASSERT_TRUE(NULL != second);
+    ASSERT_TRUE(AddSslPeer(second));
+    EXPECT_EQ(first, GetSslPeer(&first->sep.endpoint));
+    RemoveSslPeerAt(7);
+    EXPECT_EQ(second, GetSslPeer(&first->sep.endpoint));
+    DeleteSslEndPoint(first);
+
+    // Lookups without the index search the list and agree with it.
+    size_t listLength = u_arraylist_length(g_caSslContext->peerList);
+    for (size_t i = 0; i < listLength; i++)
+    {
+        SslEndPoint_t * tep = (SslEndPoint_t *) u_arraylist_get(g_caSslContext->peerList, i);
+        oc_hashmap peerMap = g_caSslContext->peerMap;
+        g_caSslContext->peerMap = NULL;
+        SslEndPoint_t * scanned = GetSslPeer(&tep->sep.endpoint);
+        g_caSslContext->peerMap = peerMap;
+        EXPECT_EQ(scanned, GetSslPeer(&tep->sep.endpoint));
+    }
+
+    oc_mutex_unlock(g_sslContextMutex);
+    CAdeinitSslAdapter();
+}
+
+/* **************************
+ *
+ * Session resumption tests
+ *
+ * The adapter is the TLS server. A mbedTLS client talks to it through
+ * in-memory buffers, so both sides run on the test thread.
+ *
+ * *************************/
+
+#define RESUMPTION_BUF_SIZE (16 * 1024)
+#define TLS_RECORD_HEADER_LEN (5)
+
+typedef struct
+{
+    unsigned char data[RESUMPTION_BUF_SIZE];
+    size_t len;
+} ResumptionPipe_t;
+
+static ResumptionPipe_t g_toAdapter;
+static ResumptionPipe_t g_toClient;
+
+static bool PipeWrite(ResumptionPipe_t * pipe, const void * buf, size_t len)
+{
+    if (len > sizeof(pipe->data) - pipe->len)
+    {
+        return false;
+    }
+    memcpy(pipe->data + pipe->len, buf, len);
+    pipe->len += len;
+    return true;
+}
+
+static ssize_t ResumptionAdapterSendCB(CAEndpoint_t *, const void *buf, size_t buflen)
+{
+    return PipeWrite(&g_toClient, buf, buflen) ? (ssize_t)buflen : -1;
+}
+
+static void ResumptionAdapterRecvCB(const CASecureEndpoint_t *, const void *, size_t)
+{
+}
+
+static int ResumptionClientSend(void *, const unsigned char *buf, size_t len)
+{
+    return PipeWrite(&g_toAdapter, buf, len) ? (int)len : MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+}
+
+static int ResumptionClientRecv(void *, unsigned char *buf, size_t len)
+{
+    if (0 == g_toClient.len)
+    {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    size_t n = (len < g_toClient.len) ? len : g_toClient.len;
+    memcpy(buf, g_toClient.data, n);
+    memmove(g_toClient.data, g_toClient.data + n, g_toClient.len - n);
+    g_toClient.len -= n;
+    return (int)n;
+}
+
+// Same credentials as infoCallback_that_loads_x509, plus a CRL.
+static void infoCallback_that_loads_x509_and_crl(PkiInfo_t * inf)
+{
+    static const uint8_t crl[] = { 0x30, 0x00 };
+
+    infoCallback_that_loads_x509(inf);
+    inf->crl.len = sizeof(crl);
+    inf->crl.data = (uint8_t*)OICMalloc(inf->crl.len);
+    ASSERT_TRUE(inf->crl.data != NULL);
+    memcpy(inf->crl.data, crl, inf->crl.len);
+}
+
+class TLSResumptionTest : public testing::Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            memset(&m_sep, 0, sizeof(m_sep));
+            m_sep.endpoint.adapter = CA_ADAPTER_TCP;
+            m_sep.endpoint.flags = CA_SECURE;
+            m_sep.endpoint.port = 4434;
+            memcpy(m_sep.endpoint.addr, "127.0.0.1", sizeof("127.0.0.1"));
+            g_toAdapter.len = 0;
+            g_toClient.len = 0;
+
+            mbedtls_entropy_init(&m_entropy);
+            mbedtls_ctr_drbg_init(&m_ctrDrbg);
+            mbedtls_ssl_config_init(&m_conf);
+            mbedtls_x509_crt_init(&m_caCert);
+            mbedtls_x509_crt_init(&m_ownCert);
+            mbedtls_pk_init(&m_pkey);
+
+            ASSERT_EQ(0, mbedtls_ctr_drbg_seed(&m_ctrDrbg, mbedtls_entropy_func, &m_entropy,
+                                               (const unsigned char *) SEED, strlen(SEED)));
+            ASSERT_LE(0, mbedtls_x509_crt_parse(&m_caCert, caCert, caCertLen));
+            ASSERT_LE(0, mbedtls_x509_crt_parse(&m_ownCert, serverCert, serverCertLen));
+            ASSERT_EQ(0, mbedtls_pk_parse_key(&m_pkey, serverPrivateKey, serverPrivateKeyLen,
+                                              NULL, 0));
+            ASSERT_EQ(0, mbedtls_ssl_config_defaults(&m_conf, MBEDTLS_SSL_IS_CLIENT,
+                                                     MBEDTLS_SSL_TRANSPORT_STREAM,
+                                                     MBEDTLS_SSL_PRESET_DEFAULT));
+            mbedtls_ssl_conf_authmode(&m_conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
+            mbedtls_ssl_conf_ca_chain(&m_conf, &m_caCert, NULL);
+            ASSERT_EQ(0, mbedtls_ssl_conf_own_cert(&m_conf, &m_ownCert, &m_pkey));
+            mbedtls_ssl_conf_rng(&m_conf, mbedtls_ctr_drbg_random, &m_ctrDrbg);
+
+            ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+            CAsetSslAdapterCallbacks(ResumptionAdapterRecvCB, ResumptionAdapterSendCB,
+                                     CA_ADAPTER_TCP);
+            CAsetPkixInfoCallback(infoCallback_that_loads_x509);
+            CAsetCredentialTypesCallback(clutch);
+            CAsetPskCredentialsCallback(GetDtlsPskCredentials);
+            ASSERT_EQ(CA_STATUS_OK, CAsetTlsCipherSuite(MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CCM));
+            ASSERT_EQ(CA_STATUS_OK, CAsetSslSessionCache(10, 60));
+        }
+
+        virtual void TearDown()
+        {
+            EXPECT_EQ(CA_STATUS_OK, CAsetSslSessionCache(0, SESSION_CACHE_DEFAULT_TIMEOUT));
+            CAdeinitSslAdapter();
+
+            mbedtls_pk_free(&m_pkey);
+            mbedtls_x509_crt_free(&m_ownCert);
+            mbedtls_x509_crt_free(&m_caCert);
+            mbedtls_ssl_config_free(&m_conf);
+            mbedtls_ctr_drbg_free(&m_ctrDrbg);
+            mbedtls_entropy_free(&m_entropy);
+        }
+
+        // Passes the records written by the client to the adapter, one at a time.
+        bool FeedAdapter()
+        {
+            size_t offset = 0;
+            while (offset + TLS_RECORD_HEADER_LEN <= g_toAdapter.len)
+            {
+                size_t recordLen = TLS_RECORD_HEADER_LEN +
+                                   g_toAdapter.data[offset + 3] * 0x100 +
+                                   g_toAdapter.data[offset + 4];
+                if (offset + recordLen > g_toAdapter.len ||
+                    CA_STATUS_OK != CAdecryptSsl(&m_sep, g_toAdapter.data + offset, recordLen))
+                {
+                    return false;
+                }
+                offset += recordLen;
+            }
+            bool consumed = (offset == g_toAdapter.len);
+            g_toAdapter.len = 0;
+            return consumed;
+        }
+
+        // Runs a handshake with the adapter, optionally offering a session,
+        // and closes the connection again.
+        bool Connect(const mbedtls_ssl_session * offer, mbedtls_ssl_session * established)
+        {
+            mbedtls_ssl_context ssl;
+            mbedtls_ssl_init(&ssl);
+            bool ok = (0 == mbedtls_ssl_setup(&ssl, &m_conf));
+            if (ok && offer)
+            {
+                ok = (0 == mbedtls_ssl_set_session(&ssl, offer));
+            }
+            mbedtls_ssl_set_bio(&ssl, NULL, ResumptionClientSend, ResumptionClientRecv, NULL);
+
+            int ret = MBEDTLS_ERR_SSL_WANT_READ;
+            for (int flight = 0; ok && MBEDTLS_ERR_SSL_WANT_READ == ret && flight < 10; flight++)
+            {
+                ret = mbedtls_ssl_handshake(&ssl);
+                ok = FeedAdapter();
+            }
+            ok = ok && (0 == ret);
+            if (ok && established)
+            {
+                ok = (0 == mbedtls_ssl_get_session(&ssl, established));
+            }
+
+            mbedtls_ssl_free(&ssl);
+            CAcloseSslConnection(&m_sep.endpoint);
+            g_toAdapter.len = 0;
+            g_toClient.len = 0;
+            return ok;
+        }
+
+        CASecureEndpoint_t m_sep;
+        mbedtls_entropy_context m_entropy;
+        mbedtls_ctr_drbg_context m_ctrDrbg;
+        mbedtls_ssl_config m_conf;
+        mbedtls_x509_crt m_caCert;
+        mbedtls_x509_crt m_ownCert;
+        mbedtls_pk_context m_pkey;
+};
+
+TEST_F(TLSResumptionTest, ResumesKeptSession)
+{
+    mbedtls_ssl_session first;
+    mbedtls_ssl_session second;
+    mbedtls_ssl_session_init(&first);
+    mbedtls_ssl_session_init(&second);
+    CASslSessionCacheStats_t before;
+    CASslSessionCacheStats_t after;
+
+    ASSERT_TRUE(Connect(NULL, &first));
+    ASSERT_EQ(CA_STATUS_OK, CAgetSslSessionCacheStats(&before));
+    ASSERT_TRUE(Connect(&first, &second));
+    ASSERT_EQ(CA_STATUS_OK, CAgetSslSessionCacheStats(&after));
+
+    EXPECT_EQ(before.hits + 1, after.hits);
+    EXPECT_EQ(before.misses, after.misses);
+    ASSERT_EQ(first.id_len, second.id_len);
+    EXPECT_EQ(0, memcmp(first.id, second.id, first.id_len));
+
+    mbedtls_ssl_session_free(&second);
+    mbedtls_ssl_session_free(&first);
+}
+
+TEST_F(TLSResumptionTest, CredentialChangeFlushesKeptSessions)
+{
+    mbedtls_ssl_session first;
+    mbedtls_ssl_session_init(&first);
+    CASslSessionCacheStats_t before;
+    CASslSessionCacheStats_t after;
+
+    ASSERT_TRUE(Connect(NULL, &first));
+    // A new CRL changes the PKIX digest; the kept session must be verified again.
+    CAsetPkixInfoCallback(infoCallback_that_loads_x509_and_crl);
+    ASSERT_EQ(CA_STATUS_OK, CAgetSslSessionCacheStats(&before));
+    ASSERT_TRUE(Connect(&first, NULL));
+    ASSERT_EQ(CA_STATUS_OK, CAgetSslSessionCacheStats(&after));
+
+    EXPECT_EQ(before.hits, after.hits);
+    EXPECT_EQ(before.misses + 1, after.misses);
+
+    mbedtls_ssl_session_free(&first);
+}
+
+TEST_F(TLSResumptionTest, CipherSelectionPreventsResumption)
+{
+    mbedtls_ssl_session first;
+    mbedtls_ssl_session_init(&first);
+    CASslSessionCacheStats_t before;
+    CASslSessionCacheStats_t after;
+
+    ASSERT_TRUE(Connect(NULL, &first));
+    ASSERT_EQ(CA_STATUS_OK, CAsetTlsCipherSuite(MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CCM));
+    ASSERT_EQ(CA_STATUS_OK, CAgetSslSessionCacheStats(&before));
+    ASSERT_TRUE(Connect(&first, NULL));
+    ASSERT_EQ(CA_STATUS_OK, CAgetSslSessionCacheStats(&after));
+
+    EXPECT_EQ(before.hits, after.hits);
+    EXPECT_EQ(before.misses + 1, after.misses);
+
+    mbedtls_ssl_session_free(&first);
+}
@@ -184,6 +184,23 @@ TEST_F(UArrayListF, Get)
     }
 }
 
+TEST_F(UArrayListF, Set)
+{
+    int dummy[3] = {0};
+
+    EXPECT_FALSE(u_arraylist_set(list, 0, &dummy[0]));
+    ASSERT_TRUE(u_arraylist_add(list, &dummy[0]));
+    ASSERT_TRUE(u_arraylist_add(list, &dummy[1]));
+
+    EXPECT_TRUE(u_arraylist_set(list, 1, &dummy[2]));
+    EXPECT_EQ(&dummy[0], u_arraylist_get(list, 0));
+    EXPECT_EQ(&dummy[2], u_arraylist_get(list, 1));
+    EXPECT_EQ(static_cast<size_t>(2), u_arraylist_length(list));
+
+    EXPECT_FALSE(u_arraylist_set(list, 2, &dummy[1]));
+    EXPECT_FALSE(u_arraylist_set(NULL, 0, &dummy[1]));
+}
+
 TEST_F(UArrayListF, Remove)
 {
     ASSERT_EQ(static_cast<size_t>(0), u_arraylist_length(list));
@@ -24,6 +24,7 @@
 #include "cautilinterface.h"
 #include "cainterfacecontroller.h"
 #include "cacommon.h"
+#include "cadeduplication.h"
 #include "logger.h"
 
 #if defined(TCP_ADAPTER) && defined(WITH_CLOUD)
@@ -436,3 +437,10 @@ void CAUtilSetLogLevel(CAUtilLogLevel_t level, bool hidePrivateLogEntries)
 
     OCSetLogLevel(logLevel, hidePrivateLogEntries);
 }
+
+CAResult_t CAUtilSetDeduplicationCacheSize(size_t maxEntries, size_t maxResponseSize)
+{
+    OIC_LOG(DEBUG, TAG, "CAUtilSetDeduplicationCacheSize");
+
+    return CADeduplicationSetCacheSize(maxEntries, maxResponseSize);
+}
@@ -1192,6 +1192,15 @@ typedef enum
  * Persistent storage open handler points to default file path.
  * It should check file path and whether the file is symbolic link or no.
  * Application can point to appropriate SVR database path for it's IoTivity Server.
+ *
+ * The open handler is called with the modes "rb", "wb" and "ab". A database opened with
+ * "ab" must be appended to, not truncated, since updates of a single resource are appended
+ * to the database instead of rewriting it.
+ *
+ * The rename handler is optional. If it is set, a database is rewritten by writing it to
+ * the database path with ".tmp" appended and renaming that file over the database, so an
+ * interrupted rewrite leaves the old database intact. The open handler must then map the
+ * temporary path to a file of its own. If it is NULL, a database is rewritten in place.
  */
 typedef struct {
     /** Persistent storage file path.*/
@@ -1208,6 +1217,9 @@ typedef struct {
 
     /** Persistent storage unlink handler.*/
     int (* unlink)(const char *path);
+
+    /** Persistent storage rename handler; optional, replaces newpath if it exists.*/
+    int (* rename)(const char *oldpath, const char *newpath);
 } OCPersistentStorage;
 
 /**
@@ -1527,6 +1539,8 @@ typedef struct OCRepPayload
     OCStringLL* interfaces;
     OCRepPayloadValue* values;
     struct OCRepPayload* next;
+    /** Index of values by name; maintained by the OCRepPayload APIs.*/
+    struct OCRepPayloadIndex* index;
 } OCRepPayload;
 
 // used inside a resource payload
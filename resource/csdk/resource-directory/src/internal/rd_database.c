@@ -86,6 +86,111 @@ static sqlite3 *gRDDB = NULL;
     "FOREIGN KEY("XSTR(LINK_ID)") REFERENCES RD_DEVICE_LINK_LIST("XSTR(OC_RSRVD_INS)") " \
     "ON DELETE CASCADE);"
 
+/* Indexes of the lookups by device, link, resource type and interface */
+#define RD_LL_INDEX \
+    "create index if not exists RD_DEVICE_LINK_LIST_DEVICE_ID on " \
+    "RD_DEVICE_LINK_LIST(DEVICE_ID, " XSTR(OC_RSRVD_HREF) ");"
+
+#define RD_RT_INDEX \
+    "create index if not exists RD_LINK_RT_LINK_ID on " \
+    "RD_LINK_RT(LINK_ID, " XSTR(OC_RSRVD_RESOURCE_TYPE) ");" \
+    "create index if not exists RD_LINK_RT_RT on " \
+    "RD_LINK_RT(" XSTR(OC_RSRVD_RESOURCE_TYPE) ", LINK_ID);"
+
+#define RD_IF_INDEX \
+    "create index if not exists RD_LINK_IF_LINK_ID on " \
+    "RD_LINK_IF(LINK_ID, " XSTR(OC_RSRVD_INTERFACE) ");" \
+    "create index if not exists RD_LINK_IF_IF on " \
+    "RD_LINK_IF(" XSTR(OC_RSRVD_INTERFACE) ", LINK_ID);"
+
+#define RD_EP_INDEX \
+    "create index if not exists RD_LINK_EP_LINK_ID on RD_LINK_EP(LINK_ID);"
+
+/* Statements of the publish and delete requests, prepared once for the connection. */
+typedef enum
+{
+    RD_INSERT_DEVICE_STMT = 0,
+    RD_UPDATE_DEVICE_STMT,
+    RD_SELECT_DEVICE_STMT,
+    RD_DELETE_DEVICE_STMT,
+    RD_INSERT_LINK_STMT,
+    RD_UPDATE_LINK_STMT,
+    RD_SELECT_LINK_STMT,
+    RD_DELETE_RT_STMT,
+    RD_INSERT_RT_STMT,
+    RD_DELETE_IF_STMT,
+    RD_INSERT_IF_STMT,
+    RD_DELETE_EP_STMT,
+    RD_INSERT_EP_STMT,
+    RD_STMT_COUNT
+} RDStatement;
+
+static const char *gRDStatementSql[RD_STMT_COUNT] =
+{
+    /* INSERT OR IGNORE then UPDATE to update or insert the row without triggering the cascading deletes */
+    "INSERT OR IGNORE INTO RD_DEVICE_LIST (ID, di, ttl) "
+        "VALUES ((SELECT ID FROM RD_DEVICE_LIST WHERE di=@deviceId), @deviceId, @ttl)",
+    "UPDATE RD_DEVICE_LIST SET ttl=@ttl WHERE di=@deviceId",
+    "SELECT ID FROM RD_DEVICE_LIST WHERE di=@deviceId",
+    "DELETE FROM RD_DEVICE_LIST WHERE di=@deviceId",
+    "INSERT OR IGNORE INTO RD_DEVICE_LINK_LIST (ins, href, DEVICE_ID) "
+        "VALUES((SELECT ins FROM RD_DEVICE_LINK_LIST WHERE DEVICE_ID=@id AND href=@uri),@uri,@id)",
+    "UPDATE RD_DEVICE_LINK_LIST SET anchor=@anchor,bm=@bm "
+        "WHERE DEVICE_ID=@id AND href=@uri",
+    "SELECT ins FROM RD_DEVICE_LINK_LIST WHERE DEVICE_ID=@id AND href=@uri",
+    "DELETE FROM RD_LINK_RT WHERE LINK_ID=@id",
+    "INSERT INTO RD_LINK_RT VALUES(@resourceType, @id)",
+    "DELETE FROM RD_LINK_IF WHERE LINK_ID=@id",
+    "INSERT INTO RD_LINK_IF VALUES(@interfaceType, @id)",
+    "DELETE FROM RD_LINK_EP WHERE LINK_ID=@id",
+    "INSERT INTO RD_LINK_EP VALUES(@ep, @pri, @id)"
+};
+
+static sqlite3_stmt *gRDStatements[RD_STMT_COUNT] = { NULL };
+
+/* Returns the prepared statement, it must be reset with resetStatement after use. */
+static int getStatement(RDStatement id, sqlite3_stmt **stmt)
+{
+    int res = SQLITE_OK;
+    if (!gRDStatements[id])
+    {
+        res = sqlite3_prepare_v2(gRDDB, gRDStatementSql[id], -1, &gRDStatements[id], NULL);
+    }
+    *stmt = gRDStatements[id];
+    return res;
+}
+
+static int resetStatement(sqlite3_stmt *stmt)
+{
+    if (!stmt)
+    {
+        return SQLITE_OK;
+    }
+    int res = sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return res;
+}
+
+/*
+ * Closes the connection and the one of the discovery queries, which is opened again by the
+ * next query. The WAL file is only removed when the last connection is closed.
+ */
+static int closeDatabase()
+{
+    OCRDDatabaseDiscoveryClose();
+    for (size_t i = 0; i < RD_STMT_COUNT; i++)
+    {
+        sqlite3_finalize(gRDStatements[i]);
+        gRDStatements[i] = NULL;
+    }
+    int res = sqlite3_close(gRDDB);
+    if (SQLITE_OK == res)
+    {
+        gRDDB = NULL;
+    }
+    return res;
+}
+
 static void errorCallback(void *arg, int errCode, const char *errMsg)
 {
     OC_UNUSED(arg);
@@ -112,6 +217,10 @@ static bool stringArgumentsWithinBounds(const char** arguments, size_t count)
     return true;
 }
 
+/*
+ * The store functions are called within the transaction of storeResources, which is
+ * rolled back as a whole if any of them fails.
+ */
 static int storeResourceTypes(char **resourceTypes, size_t size, sqlite3_int64 rowid)
 {
     int res = 1;
@@ -120,28 +229,21 @@ static int storeResourceTypes(char **resourceTypes, size_t size, sqlite3_int64 r
         return res;
     }
 
-    VERIFY_SQLITE(sqlite3_exec(gRDDB, "SAVEPOINT storeResourceTypes", NULL, NULL, NULL));
-
-    static const char deleteRT[] = "DELETE FROM RD_LINK_RT WHERE LINK_ID=@id";
-    static const char insertRT[] = "INSERT INTO RD_LINK_RT VALUES(@resourceType, @id)";
-    int deleteRTSize = (int)sizeof(deleteRT);
-    int insertRTSize = (int)sizeof(insertRT);
-
     sqlite3_stmt *stmt = NULL;
 
-    VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, deleteRT, deleteRTSize, &stmt, NULL));
+    VERIFY_SQLITE(getStatement(RD_DELETE_RT_STMT, &stmt));
     VERIFY_SQLITE(sqlite3_bind_int64(stmt, sqlite3_bind_parameter_index(stmt, "@id"), rowid));
     res = sqlite3_step(stmt);
     if (SQLITE_DONE != res)
     {
         goto exit;
     }
-    VERIFY_SQLITE(sqlite3_finalize(stmt));
+    VERIFY_SQLITE(resetStatement(stmt));
     stmt = NULL;
 
+    VERIFY_SQLITE(getStatement(RD_INSERT_RT_STMT, &stmt));
     for (size_t i = 0; i < size; i++)
     {
-        VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, insertRT, insertRTSize, &stmt, NULL));
         if (resourceTypes[i])
         {
             VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@resourceType"),
@@ -153,19 +255,14 @@ static int storeResourceTypes(char **resourceTypes, size_t size, sqlite3_int64 r
         {
             goto exit;
         }
-        VERIFY_SQLITE(sqlite3_finalize(stmt));
-        stmt = NULL;
+        VERIFY_SQLITE(resetStatement(stmt));
     }
+    stmt = NULL;
 
-    VERIFY_SQLITE(sqlite3_exec(gRDDB, "RELEASE storeResourceTypes", NULL, NULL, NULL));
     res = SQLITE_OK;
 
 exit:
-    sqlite3_finalize(stmt);
-    if (SQLITE_OK != res)
-    {
-        sqlite3_exec(gRDDB, "ROLLBACK TO storeResourceTypes", NULL, NULL, NULL);
-    }
+    resetStatement(stmt);
     return res;
 }
 
@@ -178,26 +275,19 @@ static int storeInterfaces(char **interfaces, size_t size, sqlite3_int64 rowid)
         return res;
     }
 
-    VERIFY_SQLITE(sqlite3_exec(gRDDB, "SAVEPOINT storeInterfaces", NULL, NULL, NULL));
-
-    static const char deleteIF[] = "DELETE FROM RD_LINK_IF WHERE LINK_ID=@id";
-    static const char insertIF[] = "INSERT INTO RD_LINK_IF VALUES(@interfaceType, @id)";
-    int deleteIFLength = (int)sizeof(deleteIF);
-    int insertIFLength = (int)sizeof(insertIF);
-
-    VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, deleteIF, deleteIFLength, &stmt, NULL));
+    VERIFY_SQLITE(getStatement(RD_DELETE_IF_STMT, &stmt));
     VERIFY_SQLITE(sqlite3_bind_int64(stmt, sqlite3_bind_parameter_index(stmt, "@id"), rowid));
     res = sqlite3_step(stmt);
     if (SQLITE_DONE != res)
     {
         goto exit;
     }
-    VERIFY_SQLITE(sqlite3_finalize(stmt));
+    VERIFY_SQLITE(resetStatement(stmt));
     stmt = NULL;
 
+    VERIFY_SQLITE(getStatement(RD_INSERT_IF_STMT, &stmt));
     for (size_t i = 0; i < size; i++)
     {
-        VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, insertIF, insertIFLength, &stmt, NULL));
         if (interfaces[i])
         {
             VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@interfaceType"),
@@ -209,19 +299,14 @@ static int storeInterfaces(char **interfaces, size_t size, sqlite3_int64 rowid)
         {
             goto exit;
         }
-        VERIFY_SQLITE(sqlite3_finalize(stmt));
-        stmt = NULL;
+        VERIFY_SQLITE(resetStatement(stmt));
     }
+    stmt = NULL;
 
-    VERIFY_SQLITE(sqlite3_exec(gRDDB, "RELEASE storeInterfaces", NULL, NULL, NULL));
     res = SQLITE_OK;
 
 exit:
-    sqlite3_finalize(stmt);
-    if (SQLITE_OK != res)
-    {
-        sqlite3_exec(gRDDB, "ROLLBACK TO storeInterfaces", NULL, NULL, NULL);
-    }
+    resetStatement(stmt);
     return res;
 }
 
@@ -229,28 +314,21 @@ static int storeEndpoints(OCRepPayload **eps, size_t size, sqlite3_int64 rowid)
 {
     int res;
     char *ep = NULL;
-
-    VERIFY_SQLITE(sqlite3_exec(gRDDB, "SAVEPOINT storeEndpoints", NULL, NULL, NULL));
-    static const char deleteEp[] = "DELETE FROM RD_LINK_EP WHERE LINK_ID=@id";
-    static const char insertEp[] = "INSERT INTO RD_LINK_EP VALUES(@ep, @pri, @id)";
-    int deleteEpLength = (int)sizeof(deleteEp);
-    int insertEpLength = (int)sizeof(insertEp);
-
     sqlite3_stmt *stmt = NULL;
 
-    VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, deleteEp, deleteEpLength, &stmt, NULL));
+    VERIFY_SQLITE(getStatement(RD_DELETE_EP_STMT, &stmt));
     VERIFY_SQLITE(sqlite3_bind_int64(stmt, sqlite3_bind_parameter_index(stmt, "@id"), rowid));
     res = sqlite3_step(stmt);
     if (SQLITE_DONE != res)
     {
         goto exit;
     }
-    VERIFY_SQLITE(sqlite3_finalize(stmt));
+    VERIFY_SQLITE(resetStatement(stmt));
     stmt = NULL;
 
+    VERIFY_SQLITE(getStatement(RD_INSERT_EP_STMT, &stmt));
     for (size_t i = 0; i < size; i++)
     {
-        VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, insertEp, insertEpLength, &stmt, NULL));
         if (OCRepPayloadGetPropString(eps[i], OC_RSRVD_ENDPOINT, &ep))
         {
             if (!stringArgumentWithinBounds(ep))
@@ -271,22 +349,17 @@ static int storeEndpoints(OCRepPayload **eps, size_t size, sqlite3_int64 rowid)
         {
             goto exit;
         }
-        VERIFY_SQLITE(sqlite3_finalize(stmt));
-        stmt = NULL;
+        VERIFY_SQLITE(resetStatement(stmt));
         OICFree(ep);
         ep = NULL;
     }
+    stmt = NULL;
 
-    VERIFY_SQLITE(sqlite3_exec(gRDDB, "RELEASE storeEndpoints", NULL, NULL, NULL));
     res = SQLITE_OK;
 
 exit:
     OICFree(ep);
-    sqlite3_finalize(stmt);
-    if (SQLITE_OK != res)
-    {
-        sqlite3_exec(gRDDB, "ROLLBACK TO storeInterfaces", NULL, NULL, NULL);
-    }
+    resetStatement(stmt);
     return res;
 }
 
@@ -323,19 +396,9 @@ static int storeLinkPayload(OCRepPayload *rdPayload, sqlite3_int64 rowid)
         OCRepPayload** eps = NULL;
         size_t epsDim[MAX_REP_ARRAY_DEPTH] = {0};
 
-        static const char insertDeviceLLList[] = "INSERT OR IGNORE INTO RD_DEVICE_LINK_LIST (ins, href, DEVICE_ID) "
-            "VALUES((SELECT ins FROM RD_DEVICE_LINK_LIST WHERE DEVICE_ID=@id AND href=@uri),@uri,@id)";
-        static const char updateDeviceLLList[] = "UPDATE RD_DEVICE_LINK_LIST SET anchor=@anchor,bm=@bm "
-            "WHERE DEVICE_ID=@id AND href=@uri";
-        int insertDeviceLLListSize = (int)sizeof(insertDeviceLLList);
-        int updateDeviceLLListSize = (int)sizeof(updateDeviceLLList);
-
         for (size_t i = 0; (SQLITE_OK == res) && (i < links->arr.dimensions[0]); i++)
         {
-            VERIFY_SQLITE(sqlite3_exec(gRDDB, "SAVEPOINT storeLinkPayload", NULL, NULL, NULL));
-
-            VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, insertDeviceLLList,
-                            insertDeviceLLListSize, &stmt, NULL));
+            VERIFY_SQLITE(getStatement(RD_INSERT_LINK_STMT, &stmt));
 
             OCRepPayload *link = links->arr.objArray[i];
             VERIFY_SQLITE(sqlite3_bind_int64(stmt, sqlite3_bind_parameter_index(stmt, "@id"), rowid));
@@ -353,11 +416,10 @@ static int storeLinkPayload(OCRepPayload *rdPayload, sqlite3_int64 rowid)
             {
                 goto exit;
             }
-            VERIFY_SQLITE(sqlite3_finalize(stmt));
+            VERIFY_SQLITE(resetStatement(stmt));
             stmt = NULL;
 
-            VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, updateDeviceLLList,
-                            updateDeviceLLListSize, &stmt, NULL));
+            VERIFY_SQLITE(getStatement(RD_UPDATE_LINK_STMT, &stmt));
             VERIFY_SQLITE(sqlite3_bind_int64(stmt, sqlite3_bind_parameter_index(stmt, "@id"), rowid));
             if (uri)
             {
@@ -386,13 +448,10 @@ static int storeLinkPayload(OCRepPayload *rdPayload, sqlite3_int64 rowid)
             {
                 goto exit;
             }
-            VERIFY_SQLITE(sqlite3_finalize(stmt));
+            VERIFY_SQLITE(resetStatement(stmt));
             stmt = NULL;
 
-            static const char input[] = "SELECT ins FROM RD_DEVICE_LINK_LIST WHERE DEVICE_ID=@id AND href=@uri";
-            int inputSize = (int)sizeof(input);
-
-            VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, input, inputSize, &stmt, NULL));
+            VERIFY_SQLITE(getStatement(RD_SELECT_LINK_STMT, &stmt));
             VERIFY_SQLITE(sqlite3_bind_int64(stmt, sqlite3_bind_parameter_index(stmt, "@id"), rowid));
             if (uri)
             {
@@ -403,7 +462,7 @@ static int storeLinkPayload(OCRepPayload *rdPayload, sqlite3_int64 rowid)
             if (res == SQLITE_ROW || res == SQLITE_DONE)
             {
                 sqlite3_int64 ins = sqlite3_column_int64(stmt, 0);
-                VERIFY_SQLITE(sqlite3_finalize(stmt));
+                VERIFY_SQLITE(resetStatement(stmt));
                 stmt = NULL;
                 if (!OCRepPayloadSetPropInt(link, OC_RSRVD_INS, ins))
                 {
@@ -419,11 +478,10 @@ static int storeLinkPayload(OCRepPayload *rdPayload, sqlite3_int64 rowid)
             }
             else
             {
-                VERIFY_SQLITE(sqlite3_finalize(stmt));
+                VERIFY_SQLITE(resetStatement(stmt));
                 stmt = NULL;
             }
 
-            VERIFY_SQLITE(sqlite3_exec(gRDDB, "RELEASE storeLinkPayload", NULL, NULL, NULL));
             res = SQLITE_OK;
 
         exit:
@@ -460,12 +518,8 @@ static int storeLinkPayload(OCRepPayload *rdPayload, sqlite3_int64 rowid)
             anchor = NULL;
             OICFree(uri);
             uri = NULL;
-            sqlite3_finalize(stmt);
+            resetStatement(stmt);
             stmt = NULL;
-            if (SQLITE_OK != res)
-            {
-                sqlite3_exec(gRDDB, "ROLLBACK TO storeLinkPayload", NULL, NULL, NULL);
-            }
         }
     }
 
@@ -487,13 +541,8 @@ static int storeResources(OCRepPayload *payload)
     int res;
     VERIFY_SQLITE(sqlite3_exec(gRDDB, "BEGIN TRANSACTION", NULL, NULL, NULL));
 
-    /* INSERT OR IGNORE then UPDATE to update or insert the row without triggering the cascading deletes */
     sqlite3_stmt *stmt = NULL;
-    static const char insertDeviceList[] = "INSERT OR IGNORE INTO RD_DEVICE_LIST (ID, di, ttl) "
-        "VALUES ((SELECT ID FROM RD_DEVICE_LIST WHERE di=@deviceId), @deviceId, @ttl)";
-    int insertDeviceListSize = (int)sizeof(insertDeviceList);
-    VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, insertDeviceList, insertDeviceListSize,
-                    &stmt, NULL));
+    VERIFY_SQLITE(getStatement(RD_INSERT_DEVICE_STMT, &stmt));
     if (deviceId)
     {
         VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@deviceId"),
@@ -508,13 +557,10 @@ static int storeResources(OCRepPayload *payload)
     {
         goto exit;
     }
-    VERIFY_SQLITE(sqlite3_finalize(stmt));
+    VERIFY_SQLITE(resetStatement(stmt));
     stmt = NULL;
 
-    static const char updateDeviceList[] = "UPDATE RD_DEVICE_LIST SET ttl=@ttl WHERE di=@deviceId";
-    int updateDeviceListSize = (int)sizeof(updateDeviceList);
-    VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, updateDeviceList, updateDeviceListSize,
-                    &stmt, NULL));
+    VERIFY_SQLITE(getStatement(RD_UPDATE_DEVICE_STMT, &stmt));
     if (deviceId)
     {
         VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@deviceId"),
@@ -529,14 +575,11 @@ static int storeResources(OCRepPayload *payload)
     {
         goto exit;
     }
-    VERIFY_SQLITE(sqlite3_finalize(stmt));
+    VERIFY_SQLITE(resetStatement(stmt));
     stmt = NULL;
 
     /* Store the rest of the payload */
-    static const char input[] = "SELECT ID FROM RD_DEVICE_LIST WHERE di=@deviceId";
-    int inputSize = (int)sizeof(input);
-
-    VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, input, inputSize, &stmt, NULL));
+    VERIFY_SQLITE(getStatement(RD_SELECT_DEVICE_STMT, &stmt));
     if (deviceId)
     {
         VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@deviceId"),
@@ -546,13 +589,13 @@ static int storeResources(OCRepPayload *payload)
     if (res == SQLITE_ROW || res == SQLITE_DONE)
     {
         sqlite3_int64 rowid = sqlite3_column_int64(stmt, 0);
-        VERIFY_SQLITE(sqlite3_finalize(stmt));
+        VERIFY_SQLITE(resetStatement(stmt));
         stmt = NULL;
         VERIFY_SQLITE(storeLinkPayload(payload, rowid));
     }
     else
     {
-        VERIFY_SQLITE(sqlite3_finalize(stmt));
+        VERIFY_SQLITE(resetStatement(stmt));
         stmt = NULL;
     }
 
@@ -560,7 +603,7 @@ static int storeResources(OCRepPayload *payload)
     res = SQLITE_OK;
 
 exit:
-    sqlite3_finalize(stmt);
+    resetStatement(stmt);
     OICFree(deviceId);
     if (SQLITE_OK != res)
     {
@@ -584,10 +627,7 @@ static int deleteResources(const char *deviceId, const uint8_t *instanceIds, uin
     sqlite3_stmt *stmt = NULL;
     if (!instanceIds || !nInstanceIds)
     {
-        static const char delDevice[] = "DELETE FROM RD_DEVICE_LIST WHERE di=@deviceId";
-        int delDeviceSize = (int)sizeof(delDevice);
-
-        VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, delDevice, delDeviceSize, &stmt, NULL));
+        VERIFY_SQLITE(getStatement(RD_DELETE_DEVICE_STMT, &stmt));
         VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@deviceId"),
                                         deviceId, (int)strlen(deviceId), SQLITE_STATIC));
     }
@@ -630,15 +670,23 @@ static int deleteResources(const char *deviceId, const uint8_t *instanceIds, uin
     {
         goto exit;
     }
-    VERIFY_SQLITE(sqlite3_finalize(stmt));
+    /* The statement deleting instances depends on their number, so it is not cached */
+    VERIFY_SQLITE(delResource ? sqlite3_finalize(stmt) : resetStatement(stmt));
     stmt = NULL;
 
     VERIFY_SQLITE(sqlite3_exec(gRDDB, "COMMIT", NULL, NULL, NULL));
     res = SQLITE_OK;
 
 exit:
+    if (delResource)
+    {
+        sqlite3_finalize(stmt);
+    }
+    else
+    {
+        resetStatement(stmt);
+    }
     OICFree(delResource);
-    sqlite3_finalize(stmt);
     if (SQLITE_OK != res)
     {
         sqlite3_exec(gRDDB, "ROLLBACK", NULL, NULL, NULL);
@@ -648,6 +696,19 @@ exit:
 
 OCStackResult OC_CALL OCRDDatabaseInit()
 {
+    if (gRDDB)
+    {
+        /* The database is kept open, unless its file has been removed or replaced since */
+        int moved = 0;
+        if (SQLITE_OK == sqlite3_file_control(gRDDB, "main", SQLITE_FCNTL_HAS_MOVED, &moved)
+            && !moved)
+        {
+            return OC_STACK_OK;
+        }
+        closeDatabase();
+        gRDDB = NULL;
+    }
+
     if (SQLITE_OK == sqlite3_config(SQLITE_CONFIG_LOG, errorCallback))
     {
         OIC_LOG_V(INFO, TAG, "SQLite debugging log initialized.");
@@ -660,6 +721,8 @@ OCStackResult OC_CALL OCRDDatabaseInit()
     {
         OIC_LOG(DEBUG, TAG, "RD database file did not open, as no table exists.");
         OIC_LOG(DEBUG, TAG, "RD creating new table.");
+        sqlite3_close(gRDDB);
+        gRDDB = NULL;
         VERIFY_SQLITE(sqlite3_open_v2(OCRDDatabaseGetStorageFilename(), &gRDDB,
                         SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL));
 
@@ -691,6 +754,12 @@ OCStackResult OC_CALL OCRDDatabaseInit()
         }
         VERIFY_SQLITE(sqlite3_finalize(stmt));
         stmt = NULL;
+
+        /* Readers do not block the writer and the writer does not block readers */
+        VERIFY_SQLITE(sqlite3_exec(gRDDB, "PRAGMA journal_mode = WAL;", NULL, NULL, NULL));
+
+        VERIFY_SQLITE(sqlite3_exec(gRDDB, RD_LL_INDEX RD_RT_INDEX RD_IF_INDEX RD_EP_INDEX,
+                        NULL, NULL, NULL));
     }
 
 exit:
@@ -701,7 +770,7 @@ exit:
     }
     else
     {
-        sqlite3_close(gRDDB);
+        closeDatabase();
         gRDDB = NULL;
         return OC_STACK_ERROR;
     }
@@ -711,8 +780,7 @@ OCStackResult OC_CALL OCRDDatabaseClose()
 {
     CHECK_DATABASE_INIT;
     int res;
-    VERIFY_SQLITE(sqlite3_close(gRDDB));
-    gRDDB = NULL;
+    VERIFY_SQLITE(closeDatabase());
 exit:
     return (SQLITE_OK == res) ? OC_STACK_OK : OC_STACK_ERROR;
 }
@@ -239,6 +239,51 @@ TEST_F(RDDatabaseTests, StoreResources)
     OCPayloadDestroy((OCPayload *)repPayload);
 }
 
+TEST_F(RDDatabaseTests, ResourceTypeMatchesExactly)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    const char *deviceId = "7a960f46-a52e-4837-bd83-460b1a6dd56b";
+    OCRepPayload *repPayload = CreateResources(deviceId);
+    ASSERT_TRUE(NULL != repPayload) << "CreateResources failed!";
+
+    EXPECT_EQ(OC_STACK_OK, OCRDDatabaseStoreResources(repPayload));
+
+    OCDiscoveryPayload *discPayload = NULL;
+    EXPECT_EQ(OC_STACK_NO_RESOURCE, OCRDDatabaseDiscoveryPayloadCreate(NULL, "core.LIGHT", &discPayload));
+    EXPECT_TRUE(discPayload == NULL);
+    EXPECT_EQ(OC_STACK_NO_RESOURCE, OCRDDatabaseDiscoveryPayloadCreate(NULL, "core.ligh_", &discPayload));
+    EXPECT_TRUE(discPayload == NULL);
+
+    OCPayloadDestroy((OCPayload *)repPayload);
+}
+
+TEST_F(RDDatabaseTests, ReplaceDatabase)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    const char *deviceId = "7a960f46-a52e-4837-bd83-460b1a6dd56b";
+    OCRepPayload *repPayload = CreateResources(deviceId);
+    ASSERT_TRUE(NULL != repPayload) << "CreateResources failed!";
+
+    EXPECT_EQ(OC_STACK_OK, OCRDDatabaseStoreResources(repPayload));
+
+    OCDiscoveryPayload *discPayload = NULL;
+    EXPECT_EQ(OC_STACK_OK, OCRDDatabaseDiscoveryPayloadCreate(NULL, "core.light", &discPayload));
+    OCDiscoveryPayloadDestroy(discPayload);
+    discPayload = NULL;
+
+    // the open connections must not keep using the removed file
+    remove("RD.db");
+    EXPECT_EQ(OC_STACK_OK, OCRDDatabaseInit());
+    EXPECT_EQ(OC_STACK_NO_RESOURCE, OCRDDatabaseDiscoveryPayloadCreate(NULL, "core.light", &discPayload));
+    EXPECT_TRUE(discPayload == NULL);
+
+    EXPECT_EQ(OC_STACK_OK, OCRDDatabaseStoreResources(repPayload));
+    EXPECT_EQ(OC_STACK_OK, OCRDDatabaseDiscoveryPayloadCreate(NULL, "core.light", &discPayload));
+    OCDiscoveryPayloadDestroy(discPayload);
+
+    OCPayloadDestroy((OCPayload *)repPayload);
+}
+
 TEST_F(RDDatabaseTests, AddResources)
 {
     itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
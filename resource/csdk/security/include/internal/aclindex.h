@@ -0,0 +1,147 @@
+//******************************************************************
+//
+// Copyright 2017 Open Connectivity Foundation
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/**
+ * @file
+ *
+ * This file contains the APIs of the ACL index. The index groups the ACEs of
+ * the ACL by subject UUID, role and conntype, keeping ACL order within each
+ * group, and compiles the resources of each ACE into a sorted href table.
+ * It is built lazily from the ACL passed to ::InvalidateACLIndex, which also
+ * drops the cached access decisions derived from the ACL.
+ */
+
+#ifndef IOTVT_SRM_ACL_INDEX_H
+#define IOTVT_SRM_ACL_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "securevirtualresourcetypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * ACE of the ACL index.
+ */
+typedef struct OicSecIndexedAce
+{
+    const OicSecAce_t *ace;     /**< the indexed ACE */
+    size_t position;            /**< position of the ACE in the ACL */
+    uint8_t wildcards;          /**< resource wildcards of the ACE */
+    const char **hrefs;         /**< sorted hrefs of the ACE resources */
+    size_t hrefCount;           /**< number of entries in hrefs */
+} OicSecIndexedAce_t;
+
+/**
+ * Key of a cached access decision.
+ */
+typedef struct OicSecAclDecisionKey
+{
+    OicUuid_t subjectUuid;              /**< subject of the request */
+    const char *resourceUri;            /**< URI of the requested resource */
+    uint16_t permission;                /**< requested permission */
+    bool secureChannel;                 /**< whether the request was received over a secure channel */
+    OicSecDiscoverable_t discoverable;  /**< discoverability of the requested resource */
+} OicSecAclDecisionKey_t;
+
+/**
+ * Drops the ACL index and the cached access decisions. Must be called whenever the ACL or any of its ACEs
+ * changes, before the index is used again.
+ *
+ * @param acl  current ACL; NULL if there is none.
+ */
+void InvalidateACLIndex(const OicSecAcl_t *acl);
+
+/**
+ * Gets the ACEs with a subject UUID, in ACL order.
+ *
+ * @param subjectId  subject UUID.
+ * @param aces       out param; set to an array owned by the index, valid until
+ *                   the next call to ::InvalidateACLIndex.
+ *
+ * @return number of entries in aces.
+ */
+size_t GetIndexedACEsBySubject(const OicUuid_t *subjectId, OicSecIndexedAce_t * const **aces);
+
+/**
+ * Gets the ACEs with a conntype subject, in ACL order.
+ *
+ * @param conntype  conntype subject.
+ * @param aces      out param; see ::GetIndexedACEsBySubject.
+ *
+ * @return number of entries in aces.
+ */
+size_t GetIndexedACEsByConntype(OicSecConntype_t conntype, OicSecIndexedAce_t * const **aces);
+
+/**
+ * Gets the ACEs with any of a set of role subjects, in ACL order.
+ *
+ * @note Caller of this method MUST use OICFree() method to release memory
+ *       referenced by the aces argument.
+ *
+ * @param roles      array of roles.
+ * @param roleCount  number of entries in roles.
+ * @param aces       out param; set to an allocated array of entries owned by
+ *                   the index, valid until the next call to ::InvalidateACLIndex.
+ *
+ * @return number of entries in aces.
+ */
+size_t GetIndexedACEsByRoles(const OicSecRole_t *roles, size_t roleCount,
+                             OicSecIndexedAce_t ***aces);
+
+/**
+ * Checks whether an ACE applies to a resource.
+ *
+ * @param ace           indexed ACE.
+ * @param uri           URI of the resource.
+ * @param discoverable  discoverability of the resource.
+ *
+ * @return true if the ACE applies to the resource.
+ */
+bool IsResourceInIndexedACE(const OicSecIndexedAce_t *ace, const char *uri,
+                            OicSecDiscoverable_t discoverable);
+
+/**
+ * Gets a cached access decision.
+ *
+ * @param key          key of the decision.
+ * @param responseVal  out param; set to the cached decision.
+ *
+ * @return true if a decision was cached for the key.
+ */
+bool GetCachedACLDecision(const OicSecAclDecisionKey_t *key, SRMAccessResponse_t *responseVal);
+
+/**
+ * Caches an access decision. The cache is bounded; the decision may replace
+ * an older one.
+ *
+ * @param key          key of the decision.
+ * @param responseVal  the decision.
+ */
+void CacheACLDecision(const OicSecAclDecisionKey_t *key, SRMAccessResponse_t responseVal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTVT_SRM_ACL_INDEX_H
@@ -21,6 +21,24 @@
 #ifndef IOTVT_SRM_PSI_H
 #define IOTVT_SRM_PSI_H
 
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Write statistics of the persistent storage interface. The write amplification
+ * of resource updates is writtenBytes / payloadBytes.
+ */
+typedef struct PSWriteStats
+{
+    uint64_t updates;       /**< number of resource updates */
+    uint64_t payloadBytes;  /**< CBOR payload bytes of the updated resources */
+    uint64_t writtenBytes;  /**< bytes written to persistent storage */
+    uint64_t fullWrites;    /**< number of times a whole database was written */
+} PSWriteStats;
+
 /**
  * Reads the database from PS
  *
@@ -103,4 +121,26 @@ OCStackResult ResetSecureResourceInPS(void);
  */
 OCStackResult CreateResetProfile(void);
 
+/**
+ * Forgets the layout of all databases, so that the next update of each rewrites it.
+ * Called when the persistent storage handler changes.
+ */
+void ResetPSDatabaseStates(void);
+
+/**
+ * Gets the write statistics of the persistent storage interface.
+ *
+ * @param stats  receives the statistics.
+ */
+void GetPSWriteStats(PSWriteStats *stats);
+
+/**
+ * Resets the write statistics of the persistent storage interface.
+ */
+void ResetPSWriteStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif //IOTVT_SRM_PSI_H
@@ -0,0 +1,503 @@
+//******************************************************************
+//
+// Copyright 2017 Open Connectivity Foundation
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "utlist.h"
+#include "ochashmap.h"
+#include "oic_malloc.h"
+#include "oic_string.h"
+#include "logger.h"
+#include "srmresourcestrings.h"
+#include "aclindex.h"
+
+#define TAG "OIC_SRM_ACL_INDEX"
+
+/** Initial capacity of an ACE list. */
+#define ACE_LIST_INITIAL_CAPACITY (4)
+
+/** Number of cached access decisions; must be a power of two. */
+#define ACL_DECISION_CACHE_SIZE (32)
+
+/** The ACE applies to all resources. */
+#define ACE_WILDCARD_ALL              (0x1)
+/** The ACE applies to all discoverable resources. */
+#define ACE_WILDCARD_DISCOVERABLE     (0x2)
+/** The ACE applies to all non-discoverable resources. */
+#define ACE_WILDCARD_NON_DISCOVERABLE (0x4)
+
+/**
+ * ACEs of one subject, in ACL order.
+ */
+typedef struct
+{
+    OicSecIndexedAce_t **aces;
+    size_t count;
+    size_t capacity;
+} AceList;
+
+/**
+ * Cached access decision.
+ */
+typedef struct
+{
+    char *resourceUri;                  /* NULL for an unused entry */
+    OicUuid_t subjectUuid;
+    uint16_t permission;
+    bool secureChannel;
+    OicSecDiscoverable_t discoverable;
+    SRMAccessResponse_t responseVal;
+} AclDecision;
+
+/** ACL the index is built from. */
+static const OicSecAcl_t *g_indexedAcl = NULL;
+
+/** Whether the index reflects g_indexedAcl. */
+static bool g_indexValid = false;
+
+/** One entry per ACE of the ACL, in ACL order. */
+static OicSecIndexedAce_t *g_indexedAces = NULL;
+
+static size_t g_indexedAceCount = 0;
+
+/** OicUuid_t -> AceList. Keys point into the ACEs. */
+static oc_hashmap g_acesBySubject = NULL;
+
+/** OicSecRole_t -> AceList. Keys point into the ACEs. */
+static oc_hashmap g_acesByRole = NULL;
+
+static AceList g_authCryptAces = { NULL, 0, 0 };
+
+static AceList g_anonClearAces = { NULL, 0, 0 };
+
+/** Direct mapped cache of access decisions. */
+static AclDecision g_aclDecisions[ACL_DECISION_CACHE_SIZE];
+
+static uint32_t HashUuid(const void *key)
+{
+    return oc_hashmap_hash_bytes(key, sizeof(OicUuid_t), 0);
+}
+
+static bool EqualUuid(const void *key1, const void *key2)
+{
+    return (0 == memcmp(key1, key2, sizeof(OicUuid_t)));
+}
+
+static uint32_t HashRole(const void *key)
+{
+    const OicSecRole_t *role = (const OicSecRole_t *)key;
+    uint32_t hash = oc_hashmap_hash_bytes(role->id, strlen(role->id), 0);
+    return oc_hashmap_hash_bytes(role->authority, strlen(role->authority), hash);
+}
+
+static bool EqualRole(const void *key1, const void *key2)
+{
+    const OicSecRole_t *role1 = (const OicSecRole_t *)key1;
+    const OicSecRole_t *role2 = (const OicSecRole_t *)key2;
+    return (0 == strcmp(role1->id, role2->id)) && (0 == strcmp(role1->authority, role2->authority));
+}
+
+static int CompareHref(const void *href1, const void *href2)
+{
+    return strcmp(*(const char * const *)href1, *(const char * const *)href2);
+}
+
+static int CompareAcePosition(const void *ace1, const void *ace2)
+{
+    size_t position1 = (*(const OicSecIndexedAce_t * const *)ace1)->position;
+    size_t position2 = (*(const OicSecIndexedAce_t * const *)ace2)->position;
+    return (position1 < position2) ? -1 : ((position1 > position2) ? 1 : 0);
+}
+
+static bool AppendToAceList(AceList *list, OicSecIndexedAce_t *ace)
+{
+    if (list->count == list->capacity)
+    {
+        size_t capacity = list->capacity ? list->capacity * 2 : ACE_LIST_INITIAL_CAPACITY;
+        OicSecIndexedAce_t **aces = (OicSecIndexedAce_t **)OICRealloc(list->aces,
+                                        capacity * sizeof(OicSecIndexedAce_t *));
+        if (!aces)
+        {
+            return false;
+        }
+        list->aces = aces;
+        list->capacity = capacity;
+    }
+    list->aces[list->count++] = ace;
+    return true;
+}
+
+static bool AppendToAceMap(oc_hashmap map, const void *key, OicSecIndexedAce_t *ace)
+{
+    AceList *list = (AceList *)oc_hashmap_get(map, key);
+    if (!list)
+    {
+        list = (AceList *)OICCalloc(1, sizeof(AceList));
+        if (!list || !oc_hashmap_put(map, key, list))
+        {
+            OICFree(list);
+            return false;
+        }
+    }
+    return AppendToAceList(list, ace);
+}
+
+static bool FreeAceListVisitor(const void *key, void *value, void *context)
+{
+    OC_UNUSED(key);
+    OC_UNUSED(context);
+    AceList *list = (AceList *)value;
+    OICFree(list->aces);
+    OICFree(list);
+    return true;
+}
+
+static void FreeACLIndex(void)
+{
+    oc_hashmap_foreach(g_acesBySubject, FreeAceListVisitor, NULL);
+    oc_hashmap_foreach(g_acesByRole, FreeAceListVisitor, NULL);
+    oc_hashmap_free(g_acesBySubject);
+    oc_hashmap_free(g_acesByRole);
+    g_acesBySubject = NULL;
+    g_acesByRole = NULL;
+
+    for (size_t i = 0; i < g_indexedAceCount; i++)
+    {
+        OICFree(g_indexedAces[i].hrefs);
+    }
+    OICFree(g_indexedAces);
+    g_indexedAces = NULL;
+    g_indexedAceCount = 0;
+
+    OICFree(g_authCryptAces.aces);
+    OICFree(g_anonClearAces.aces);
+    memset(&g_authCryptAces, 0, sizeof(g_authCryptAces));
+    memset(&g_anonClearAces, 0, sizeof(g_anonClearAces));
+
+    for (size_t i = 0; i < ACL_DECISION_CACHE_SIZE; i++)
+    {
+        OICFree(g_aclDecisions[i].resourceUri);
+    }
+    memset(g_aclDecisions, 0, sizeof(g_aclDecisions));
+}
+
+/**
+ * Compiles the resources of an ACE into wildcard flags and a sorted href table.
+ */
+static bool CompileACEResources(OicSecIndexedAce_t *indexedAce)
+{
+    const OicSecRsrc_t *rsrc = NULL;
+    size_t hrefCount = 0;
+    LL_FOREACH(indexedAce->ace->resources, rsrc)
+    {
+        if (NULL != rsrc->href)
+        {
+            hrefCount++;
+        }
+    }
+
+    if (hrefCount)
+    {
+        indexedAce->hrefs = (const char **)OICCalloc(hrefCount, sizeof(const char *));
+        if (!indexedAce->hrefs)
+        {
+            return false;
+        }
+    }
+
+    LL_FOREACH(indexedAce->ace->resources, rsrc)
+    {
+        if (NULL != rsrc->href)
+        {
+            if (0 == strcmp(WILDCARD_RESOURCE_URI, rsrc->href))
+            {
+                indexedAce->wildcards |= ACE_WILDCARD_ALL;
+            }
+            indexedAce->hrefs[indexedAce->hrefCount++] = rsrc->href;
+        }
+        else if (ALL_RESOURCES == rsrc->wildcard)
+        {
+            indexedAce->wildcards |= ACE_WILDCARD_ALL;
+        }
+        else if (ALL_DISCOVERABLE == rsrc->wildcard)
+        {
+            indexedAce->wildcards |= ACE_WILDCARD_DISCOVERABLE;
+        }
+        else if (ALL_NON_DISCOVERABLE == rsrc->wildcard)
+        {
+            indexedAce->wildcards |= ACE_WILDCARD_NON_DISCOVERABLE;
+        }
+    }
+
+    if (indexedAce->hrefCount)
+    {
+        qsort(indexedAce->hrefs, indexedAce->hrefCount, sizeof(const char *), CompareHref);
+    }
+    return true;
+}
+
+static bool BuildACLIndex(void)
+{
+    const OicSecAce_t *ace = NULL;
+    size_t aceCount = 0;
+
+    if (g_indexedAcl)
+    {
+        LL_FOREACH(g_indexedAcl->aces, ace)
+        {
+            aceCount++;
+        }
+    }
+
+    g_acesBySubject = oc_hashmap_new(HashUuid, EqualUuid);
+    g_acesByRole = oc_hashmap_new(HashRole, EqualRole);
+    if (aceCount)
+    {
+        g_indexedAces = (OicSecIndexedAce_t *)OICCalloc(aceCount, sizeof(OicSecIndexedAce_t));
+    }
+    if (!g_acesBySubject || !g_acesByRole || (aceCount && !g_indexedAces))
+    {
+        goto error;
+    }
+
+    for (ace = g_indexedAcl ? g_indexedAcl->aces : NULL; ace; ace = ace->next)
+    {
+        OicSecIndexedAce_t *indexedAce = &g_indexedAces[g_indexedAceCount];
+        indexedAce->ace = ace;
+        indexedAce->position = g_indexedAceCount++;
+        if (!CompileACEResources(indexedAce))
+        {
+            goto error;
+        }
+
+        bool added = true;
+        switch (ace->subjectType)
+        {
+            case OicSecAceUuidSubject:
+                added = AppendToAceMap(g_acesBySubject, &ace->subjectuuid, indexedAce);
+                break;
+            case OicSecAceRoleSubject:
+                added = AppendToAceMap(g_acesByRole, &ace->subjectRole, indexedAce);
+                break;
+            case OicSecAceConntypeSubject:
+                if (AUTH_CRYPT == ace->subjectConn)
+                {
+                    added = AppendToAceList(&g_authCryptAces, indexedAce);
+                }
+                else if (ANON_CLEAR == ace->subjectConn)
+                {
+                    added = AppendToAceList(&g_anonClearAces, indexedAce);
+                }
+                break;
+            default:
+                break;
+        }
+        if (!added)
+        {
+            goto error;
+        }
+    }
+
+    OIC_LOG_V(DEBUG, TAG, "Indexed %" PRIuPTR " ACEs", g_indexedAceCount);
+    g_indexValid = true;
+    return true;
+
+error:
+    OIC_LOG(ERROR, TAG, "Failed to build ACL index");
+    FreeACLIndex();
+    return false;
+}
+
+static bool EnsureACLIndex(void)
+{
+    return g_indexValid || BuildACLIndex();
+}
+
+void InvalidateACLIndex(const OicSecAcl_t *acl)
+{
+    FreeACLIndex();
+    g_indexedAcl = acl;
+    g_indexValid = false;
+}
+
+static size_t GetAceList(const AceList *list, OicSecIndexedAce_t * const **aces)
+{
+    *aces = list ? list->aces : NULL;
+    return list ? list->count : 0;
+}
+
+size_t GetIndexedACEsBySubject(const OicUuid_t *subjectId, OicSecIndexedAce_t * const **aces)
+{
+    if (!subjectId || !aces || !EnsureACLIndex())
+    {
+        return 0;
+    }
+    return GetAceList((const AceList *)oc_hashmap_get(g_acesBySubject, subjectId), aces);
+}
+
+size_t GetIndexedACEsByConntype(OicSecConntype_t conntype, OicSecIndexedAce_t * const **aces)
+{
+    if (!aces || !EnsureACLIndex())
+    {
+        return 0;
+    }
+    if (AUTH_CRYPT == conntype)
+    {
+        return GetAceList(&g_authCryptAces, aces);
+    }
+    if (ANON_CLEAR == conntype)
+    {
+        return GetAceList(&g_anonClearAces, aces);
+    }
+    return GetAceList(NULL, aces);
+}
+
+size_t GetIndexedACEsByRoles(const OicSecRole_t *roles, size_t roleCount,
+                             OicSecIndexedAce_t ***aces)
+{
+    if (!aces)
+    {
+        return 0;
+    }
+    *aces = NULL;
+    if (!roles || (0 == roleCount) || !EnsureACLIndex())
+    {
+        return 0;
+    }
+
+    const AceList **lists = (const AceList **)OICCalloc(roleCount, sizeof(const AceList *));
+    if (!lists)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to allocate role lists");
+        return 0;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < roleCount; i++)
+    {
+        lists[i] = (const AceList *)oc_hashmap_get(g_acesByRole, &roles[i]);
+        // The same role may be asserted twice; use its ACEs once.
+        for (size_t j = 0; lists[i] && (j < i); j++)
+        {
+            if (lists[j] == lists[i])
+            {
+                lists[i] = NULL;
+            }
+        }
+        count += lists[i] ? lists[i]->count : 0;
+    }
+
+    if (count)
+    {
+        *aces = (OicSecIndexedAce_t **)OICMalloc(count * sizeof(OicSecIndexedAce_t *));
+    }
+    if (!*aces)
+    {
+        OICFree(lists);
+        return 0;
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < roleCount; i++)
+    {
+        if (lists[i])
+        {
+            memcpy(*aces + offset, lists[i]->aces, lists[i]->count * sizeof(OicSecIndexedAce_t *));
+            offset += lists[i]->count;
+        }
+    }
+    OICFree(lists);
+    qsort(*aces, count, sizeof(OicSecIndexedAce_t *), CompareAcePosition);
+    return count;
+}
+
+bool IsResourceInIndexedACE(const OicSecIndexedAce_t *ace, const char *uri,
+                            OicSecDiscoverable_t discoverable)
+{
+    if (!ace || !uri)
+    {
+        return false;
+    }
+
+    if ((ace->wildcards & ACE_WILDCARD_ALL) ||
+        ((ace->wildcards & ACE_WILDCARD_DISCOVERABLE) && (DISCOVERABLE_TRUE == discoverable)) ||
+        ((ace->wildcards & ACE_WILDCARD_NON_DISCOVERABLE) && (DISCOVERABLE_FALSE == discoverable)))
+    {
+        OIC_LOG_V(DEBUG, TAG, "%s: found wildcard matching resource.", __func__);
+        return true;
+    }
+
+    if (ace->hrefCount &&
+        bsearch(&uri, ace->hrefs, ace->hrefCount, sizeof(const char *), CompareHref))
+    {
+        OIC_LOG_V(DEBUG, TAG, "%s: found href %s matching resource.", __func__, uri);
+        return true;
+    }
+    return false;
+}
+
+static AclDecision *GetACLDecisionSlot(const OicSecAclDecisionKey_t *key)
+{
+    uint32_t hash = oc_hashmap_hash_bytes(key->resourceUri, strlen(key->resourceUri), 0);
+    hash = oc_hashmap_hash_bytes(&key->subjectUuid, sizeof(key->subjectUuid), hash);
+    hash = oc_hashmap_hash_bytes(&key->permission, sizeof(key->permission), hash);
+    hash ^= (key->secureChannel ? 1 : 0) | ((uint32_t)key->discoverable << 1);
+    return &g_aclDecisions[hash & (ACL_DECISION_CACHE_SIZE - 1)];
+}
+
+bool GetCachedACLDecision(const OicSecAclDecisionKey_t *key, SRMAccessResponse_t *responseVal)
+{
+    if (!key || !key->resourceUri || !responseVal)
+    {
+        return false;
+    }
+
+    const AclDecision *decision = GetACLDecisionSlot(key);
+    if (decision->resourceUri &&
+        (decision->permission == key->permission) &&
+        (decision->secureChannel == key->secureChannel) &&
+        (decision->discoverable == key->discoverable) &&
+        (0 == memcmp(&decision->subjectUuid, &key->subjectUuid, sizeof(OicUuid_t))) &&
+        (0 == strcmp(decision->resourceUri, key->resourceUri)))
+    {
+        *responseVal = decision->responseVal;
+        return true;
+    }
+    return false;
+}
+
+void CacheACLDecision(const OicSecAclDecisionKey_t *key, SRMAccessResponse_t responseVal)
+{
+    if (!key || !key->resourceUri)
+    {
+        return;
+    }
+
+    AclDecision *decision = GetACLDecisionSlot(key);
+    OICFree(decision->resourceUri);
+    decision->resourceUri = OICStrdup(key->resourceUri);
+    memcpy(&decision->subjectUuid, &key->subjectUuid, sizeof(OicUuid_t));
+    decision->permission = key->permission;
+    decision->secureChannel = key->secureChannel;
+    decision->discoverable = key->discoverable;
+    decision->responseVal = responseVal;
+}
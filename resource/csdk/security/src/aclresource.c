@@ -39,6 +39,7 @@
 #include "payload_logging.h"
 #include "srmresourcestrings.h"
 #include "aclresource.h"
+#include "aclindex.h"
 #include "doxmresource.h"
 #include "rolesresource.h"
 #include "resourcemanager.h"
@@ -2141,6 +2142,8 @@ OCStackResult RemoveACE(const OicUuid_t *subject, const char *resource)
 
     if (deleteFlag)
     {
+        InvalidateACLIndex(gAcl);
+
         // In case of unit test do not update persistant storage.
         if (memcmp(subject->id, &WILDCARD_SUBJECT_B64_ID, sizeof(subject->id)) == 0)
         {
@@ -2498,6 +2501,7 @@ static OCStackResult RemoveAllAce(void)
             LL_DELETE(gAcl->aces, aceItem);
             FreeACE(aceItem);
         }
+        InvalidateACLIndex(gAcl);
 
         //Generate empty ACL payload
         ret = AclToCBORPayload(gAcl, OIC_SEC_ACL_V2, &payload, &size);
@@ -2524,6 +2528,7 @@ static OCStackResult RemoveAllAce(void)
                 {
                     DeleteACLList(gAcl);
                     gAcl = originAcl;
+                    InvalidateACLIndex(gAcl);
                 }
                 else
                 {
@@ -2723,6 +2728,7 @@ static OCEntityHandlerResult HandleACLPostRequest(const OCEntityHandlerRequest *
                         OIC_LOG(DEBUG, TAG, "Prepending new ACE:");
                         OIC_LOG_ACE(DEBUG, insertAce);
                         LL_PREPEND(gAcl->aces, insertAce);
+                        InvalidateACLIndex(gAcl);
                     }
                     else
                     {
@@ -2921,6 +2927,7 @@ static OCStackResult CreateACLResource()
 OCStackResult SetDefaultACL(OicSecAcl_t *acl)
 {
     gAcl = acl;
+    InvalidateACLIndex(gAcl);
     return OC_STACK_OK;
 }
 
@@ -3136,6 +3143,7 @@ OCStackResult InitACLResource()
         // TODO Needs to update persistent storage
     }
     VERIFY_NOT_NULL(TAG, gAcl, FATAL);
+    InvalidateACLIndex(gAcl);
 
     // Instantiate 'oic.sec.acl'
     ret = CreateACLResource();
@@ -3160,132 +3168,92 @@ OCStackResult DeInitACLResource()
         DeleteACLList(gAcl);
         gAcl = NULL;
     }
+    InvalidateACLIndex(NULL);
     return (OC_STACK_OK != ret) ? ret : ret2;
 }
 
-const OicSecAce_t* GetACLResourceData(const OicUuid_t* subjectId, OicSecAce_t **savePtr)
+/**
+ * Gets the ACE following the one pointed to by savePtr in a list of indexed ACEs.
+ *
+ * @param aces     indexed ACEs, in ACL order.
+ * @param count    number of entries in aces.
+ * @param savePtr  NULL on the first call, otherwise the ACE returned by the previous call.
+ *
+ * @return reference to @ref OicSecAce_t if ACE is found, else NULL.
+ */
+static const OicSecAce_t* GetNextIndexedACE(OicSecIndexedAce_t * const *aces, size_t count,
+                                            OicSecAce_t **savePtr)
 {
-    OicSecAce_t *ace = NULL;
-    OicSecAce_t *begin = NULL;
-
-    if (NULL == subjectId || NULL == savePtr || NULL == gAcl)
-    {
-        return NULL;
-    }
-
-    OIC_LOG(DEBUG, TAG, "GetACLResourceData: searching for ACE matching subject:");
-    OIC_LOG_BUFFER(DEBUG, TAG, subjectId->id, sizeof(subjectId->id));
+    size_t begin = 0;
 
     /*
-     * savePtr MUST point to NULL if this is the 'first' call to retrieve ACL for
-     * subjectID.
+     * If this is a 'successive' call, search for location pointed by
+     * savePtr and start from the next ACE after it.
      */
-    if (NULL == *savePtr)
-    {
-        begin = gAcl->aces;
-    }
-    else
+    if (NULL != *savePtr)
     {
-        /*
-         * If this is a 'successive' call, search for location pointed by
-         * savePtr and assign 'begin' to the next ACL after it in the linked
-         * list and start searching from there.
-         */
-        LL_FOREACH(gAcl->aces, ace)
+        while ((begin < count) && (aces[begin]->ace != *savePtr))
         {
-            if (ace == *savePtr)
-            {
-                begin = ace->next;
-            }
+            begin++;
         }
+        begin++;
     }
 
-    // Find the next ACL corresponding to the 'subjectID' and return it.
-    LL_FOREACH(begin, ace)
+    if (begin < count)
     {
-        if ((OicSecAceUuidSubject == ace->subjectType) &&
-            (0 == memcmp(&(ace->subjectuuid), subjectId, sizeof(OicUuid_t))))
-        {
-            OIC_LOG(DEBUG, TAG, "GetACLResourceData: found matching ACE:");
-            OIC_LOG_ACE(DEBUG, ace);
-            *savePtr = ace;
-            return ace;
-        }
+        *savePtr = (OicSecAce_t *)aces[begin]->ace;
+        return aces[begin]->ace;
     }
 
-    // Cleanup in case no ACL is found
+    // Cleanup in case no ACE is found
     *savePtr = NULL;
     return NULL;
 }
 
-const OicSecAce_t* GetACLResourceDataByRoles(const OicSecRole_t *roles, size_t roleCount, OicSecAce_t **savePtr)
+const OicSecAce_t* GetACLResourceData(const OicUuid_t* subjectId, OicSecAce_t **savePtr)
 {
-    OicSecAce_t *ace = NULL;
-    OicSecAce_t *begin = NULL;
-
-    if ((NULL == savePtr) || (NULL == gAcl))
+    if (NULL == subjectId || NULL == savePtr || NULL == gAcl)
     {
-        OIC_LOG(ERROR, TAG, "Invalid parameters to GetACLResourceDataByRoles");
         return NULL;
     }
 
-    if ((NULL == roles) || (0 == roleCount))
-    {
-        /* Not an error; just nothing to do. */
-        return NULL;
-    }
+    OIC_LOG(DEBUG, TAG, "GetACLResourceData: searching for ACE matching subject:");
+    OIC_LOG_BUFFER(DEBUG, TAG, subjectId->id, sizeof(subjectId->id));
 
-    /*
-     * savePtr MUST point to NULL if this is the 'first' call to retrieve ACL for
-     * subjectID.
-     */
-    if (NULL == *savePtr)
+    OicSecIndexedAce_t * const *aces = NULL;
+    size_t count = GetIndexedACEsBySubject(subjectId, &aces);
+    const OicSecAce_t *ace = GetNextIndexedACE(aces, count, savePtr);
+    if (ace)
     {
-        begin = gAcl->aces;
+        OIC_LOG(DEBUG, TAG, "GetACLResourceData: found matching ACE:");
+        OIC_LOG_ACE(DEBUG, ace);
     }
-    else
+    return ace;
+}
+
+const OicSecAce_t* GetACLResourceDataByRoles(const OicSecRole_t *roles, size_t roleCount, OicSecAce_t **savePtr)
+{
+    if ((NULL == savePtr) || (NULL == gAcl))
     {
-        /*
-         * If this is a 'successive' call, search for location pointed by
-         * savePtr and assign 'begin' to the next ACL after it in the linked
-         * list and start searching from there.
-         */
-        LL_FOREACH(gAcl->aces, ace)
-        {
-            if (ace == *savePtr)
-            {
-                begin = ace->next;
-            }
-        }
+        OIC_LOG(ERROR, TAG, "Invalid parameters to GetACLResourceDataByRoles");
+        return NULL;
     }
 
-    // Find the next ACL corresponding to the 'roleID' and return it.
-    LL_FOREACH(begin, ace)
+    if ((NULL == roles) || (0 == roleCount))
     {
-        if (OicSecAceRoleSubject == ace->subjectType)
-        {
-            for (size_t i = 0; i < roleCount; i++)
-            {
-                if ((0 == strcmp(ace->subjectRole.id, roles[i].id) &&
-                    (0 == strcmp(ace->subjectRole.authority, roles[i].authority))))
-                {
-                    *savePtr = ace;
-                    return ace;
-                }
-            }
-        }
+        /* Not an error; just nothing to do. */
+        return NULL;
     }
 
-    // Cleanup in case no ACL is found
-    *savePtr = NULL;
-    return NULL;
+    OicSecIndexedAce_t **aces = NULL;
+    size_t count = GetIndexedACEsByRoles(roles, roleCount, &aces);
+    const OicSecAce_t *ace = GetNextIndexedACE(aces, count, savePtr);
+    OICFree(aces);
+    return ace;
 }
 
 const OicSecAce_t* GetACLResourceDataByConntype(const OicSecConntype_t conntype, OicSecAce_t **savePtr)
 {
-    OicSecAce_t *ace = NULL;
-    OicSecAce_t *begin = NULL;
-
     OIC_LOG_V(DEBUG, TAG, "IN: %s(%d)", __func__, conntype);
 
     if ((NULL == savePtr) || (NULL == gAcl))
@@ -3294,44 +3262,13 @@ const OicSecAce_t* GetACLResourceDataByConntype(const OicSecConntype_t conntype,
         return NULL;
     }
 
-    // savePtr MUST point to NULL if this is the 'first' call to retrieve ACL.
-    if (NULL == *savePtr)
-    {
-        begin = gAcl->aces;
-    }
-    else
-    {
-        // If this is a 'successive' call, search for location pointed by
-        // savePtr and assign 'begin' to the next ACE after it in the linked
-        // list and start searching from there.
-        LL_FOREACH(gAcl->aces, ace)
-        {
-            if (ace == *savePtr)
-            {
-                begin = ace->next;
-            }
-        }
-    }
-
-    // Find the next ACE corresponding to the conntype, and return it.
-    LL_FOREACH(begin, ace)
-    {
-        if (OicSecAceConntypeSubject == ace->subjectType)
-        {
-            if (conntype == ace->subjectConn)
-            {
-                *savePtr = ace;
-                return ace;
-            }
-        }
-    }
-
-    // Cleanup in case no ACE is found
-    *savePtr = NULL;
+    OicSecIndexedAce_t * const *aces = NULL;
+    size_t count = GetIndexedACEsByConntype(conntype, &aces);
+    const OicSecAce_t *ace = GetNextIndexedACE(aces, count, savePtr);
 
     OIC_LOG_V(DEBUG, TAG, "OUT: %s(%d)", __func__, conntype);
 
-    return NULL;
+    return ace;
 }
 
 OCStackResult AppendACLObject(const OicSecAcl_t* acl)
@@ -3358,6 +3295,7 @@ OCStackResult AppendACLObject(const OicSecAcl_t* acl)
     {
         gAcl->aces = acl->aces;
     }
+    InvalidateACLIndex(gAcl);
 
     OIC_LOG_ACL(INFO, gAcl);
 
@@ -3600,6 +3538,7 @@ OCStackResult UpdateDefaultSecProvACE()
                 {
                     LL_DELETE(gAcl->aces, ace);
                     FreeACE(ace);
+                    InvalidateACLIndex(gAcl);
                     isRemoved = true;
                 }
             }
@@ -3617,6 +3556,7 @@ OCStackResult UpdateDefaultSecProvACE()
             if (secDefaultAce)
             {
                 LL_APPEND(gAcl->aces, secDefaultAce);
+                InvalidateACLIndex(gAcl);
 
                 size_t size = 0;
                 uint8_t *payload = NULL;
@@ -19,6 +19,7 @@
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 #include <string.h>
 #include <assert.h>
+#include <inttypes.h>
 
 #include "utlist.h"
 #include "oic_malloc.h"
@@ -28,6 +29,7 @@
 #include "srmresourcestrings.h"
 #include "logger.h"
 #include "aclresource.h"
+#include "aclindex.h"
 #include "srmutility.h"
 #include "doxmresource.h"
 #include "iotvticalendar.h"
@@ -356,53 +358,8 @@ static bool IsAccessWithinValidTime(const OicSecAce_t *ace)
 #endif
 }
 
-/**
- * Check whether 'resource' is in the passed ACE.
- *
- * @param[in] context Context->resourceUri contains the Resource being checked,
- *                    as well as the discoverability of the Resource.
- * @param[in] ace The ACE to check.
- *
- * @return true if match found, otherwise false.
- */
-static bool IsResourceInAce(SRMRequestContext_t *context, const OicSecAce_t *ace)
-{
-    if (NULL == context || NULL == ace)
-    {
-        return false;
-    }
-
-    OicSecRsrc_t* rsrc = NULL;
-    LL_FOREACH(ace->resources, rsrc)
-    {
-        if (NULL == rsrc->href)
-        {
-            if (NO_WILDCARD != rsrc->wildcard)
-            {
-                if ((ALL_RESOURCES == rsrc->wildcard) ||
-                    (ALL_DISCOVERABLE == rsrc->wildcard &&
-                        DISCOVERABLE_TRUE == context->discoverable) ||
-                    (ALL_NON_DISCOVERABLE == rsrc->wildcard &&
-                        DISCOVERABLE_FALSE == context->discoverable))
-                {
-                    OIC_LOG_V(DEBUG, TAG, "%s: found wc type %d matching resource.",
-                        __func__, rsrc->wildcard);
-                    return true;
-                }
-            }
-        }
-        else if (0 == strcmp(context->resourceUri, rsrc->href) ||
-                 0 == strcmp(WILDCARD_RESOURCE_URI, rsrc->href))
-        {
-            OIC_LOG_V(DEBUG, TAG, "%s: found href %s matching resource.",
-                        __func__, rsrc->href);
-            return true;
-        }
-    }
-    return false;
-}
-
-static void ProcessMatchingACE(SRMRequestContext_t *context, const OicSecAce_t *currentAce)
+static void ProcessMatchingACE(SRMRequestContext_t *context, const OicSecIndexedAce_t *currentAce,
+                               bool *isTimeBound)
 {
     // Found the subject, so how about resource?
     OIC_LOG_V(DEBUG, TAG, "%s: found ACE matching subject.", __func__);
@@ -410,16 +367,20 @@ static void ProcessMatchingACE(SRMRequestContext_t *context, const OicSecAce_t *
     // Subject was found, so err changes to Rsrc not found for now.
     context->responseVal = ACCESS_DENIED_RESOURCE_NOT_FOUND;
     OIC_LOG_V(DEBUG, TAG, "%s: Searching for resource...", __func__);
-    if (IsResourceInAce(context, currentAce))
+    if (IsResourceInIndexedACE(currentAce, context->resourceUri, context->discoverable))
     {
         OIC_LOG_V(INFO, TAG, "%s: found matching resource in ACE.", __func__);
 
         // Found the resource, so it's down to valid period & permission.
         context->responseVal = ACCESS_DENIED_INVALID_PERIOD;
-        if (IsAccessWithinValidTime(currentAce))
+        if (NULL != currentAce->ace->validities)
+        {
+            *isTimeBound = true;
+        }
+        if (IsAccessWithinValidTime(currentAce->ace))
         {
             context->responseVal = ACCESS_DENIED_INSUFFICIENT_PERMISSION;
-            if (IsPermissionAllowingRequest(currentAce->permission,
+            if (IsPermissionAllowingRequest(currentAce->ace->permission,
                 context->requestedPermission))
             {
                 context->responseVal = ACCESS_GRANTED;
@@ -428,10 +389,30 @@ static void ProcessMatchingACE(SRMRequestContext_t *context, const OicSecAce_t *
     }
 }
 
+/**
+ * Check the ACEs matching the subject of a request, in ACL order, until one grants permission.
+ *
+ * @param[in] context      Context of the request.
+ * @param[in] aces         ACEs matching the subject of the request.
+ * @param[in] count        Number of entries in aces.
+ * @param[out] isTimeBound Set to true if the outcome depends on the validity period of an ACE.
+ */
+static void ProcessMatchingACEs(SRMRequestContext_t *context, OicSecIndexedAce_t * const *aces,
+                                size_t count, bool *isTimeBound)
+{
+    for (size_t i = 0; (i < count) && !IsAccessGranted(context->responseVal); i++)
+    {
+        ProcessMatchingACE(context, aces[i], isTimeBound);
+    }
+}
+
 /**
  * Search for an ACE that matches the Resource URI, by conntype, subjectuuid, or roles.
  * For each matching ACE, check whether it grants permission.
  * If any ACE grants permission, set responseVal to ACCESS_GRANTED.
+ *
+ * The outcome of the conntype and subject checks only depends on the ACL and
+ * the request, so it is cached unless an ACE with a validity period was involved.
  */
 static void ProcessAccessRequest(SRMRequestContext_t *context)
 {
@@ -443,66 +424,51 @@ static void ProcessAccessRequest(SRMRequestContext_t *context)
 
     OIC_LOG_V(DEBUG, TAG, "Entering %s(%s)", __func__, context->resourceUri);
 
-    const OicSecAce_t *currentAce = NULL;
-    OicSecAce_t *aceSavePtr = NULL;
+    OicSecIndexedAce_t * const *aces = NULL;
+    size_t count = 0;
+    bool isTimeBound = false;
 
-    // Start out assuming subject not found.
-    context->responseVal = ACCESS_DENIED_SUBJECT_NOT_FOUND;
+    OicSecAclDecisionKey_t key;
+    memcpy(&key.subjectUuid, &context->subjectUuid, sizeof(OicUuid_t));
+    key.resourceUri = context->resourceUri;
+    key.permission = context->requestedPermission;
+    key.secureChannel = context->secureChannel;
+    key.discoverable = context->discoverable;
 
-    // First, check for a conntype ACE that matches.
-    OicSecConntype_t conntype;
-    if (context->secureChannel)
+    if (GetCachedACLDecision(&key, &context->responseVal))
     {
-        conntype = AUTH_CRYPT;
+        OIC_LOG_V(DEBUG, TAG, "%s: using cached decision for %s", __func__, context->resourceUri);
     }
     else
     {
-        conntype = ANON_CLEAR;
-    }
-    do
-    {
-        currentAce = GetACLResourceDataByConntype(conntype, &aceSavePtr);
+        // Start out assuming subject not found.
+        context->responseVal = ACCESS_DENIED_SUBJECT_NOT_FOUND;
 
-        if (NULL != currentAce)
-        {
-            OIC_LOG_V(DEBUG, TAG, "%s: found conntype %s match; processing for access.",
-                __func__, (AUTH_CRYPT == conntype?"auth-crypt":"anon-clear"));
-            ProcessMatchingACE(context, currentAce);
-        }
-        else
+        // First, check for a conntype ACE that matches.
+        OicSecConntype_t conntype = context->secureChannel ? AUTH_CRYPT : ANON_CLEAR;
+        count = GetIndexedACEsByConntype(conntype, &aces);
+        OIC_LOG_V(DEBUG, TAG, "%s: found %" PRIuPTR " ACEs matching conntype %s", __func__,
+            count, (AUTH_CRYPT == conntype ? "auth-crypt" : "anon-clear"));
+        ProcessMatchingACEs(context, aces, count, &isTimeBound);
+
+        // If not granted via conntype, try Subject-based match.
+        if (!IsAccessGranted(context->responseVal))
         {
-            OIC_LOG_V(INFO, TAG, "%s:no ACL found matching conntype %s for resource %s",
-                __func__, (AUTH_CRYPT == conntype?"auth-crypt":"anon-clear"), context->resourceUri);
+            count = GetIndexedACEsBySubject(&context->subjectUuid, &aces);
+            OIC_LOG_V(DEBUG, TAG, "%s: found %" PRIuPTR " ACEs matching subject", __func__, count);
+            ProcessMatchingACEs(context, aces, count, &isTimeBound);
         }
-    } while ((NULL != currentAce) && !IsAccessGranted(context->responseVal));
 
-    // If not granted via conntype, try Subject-based match.
-    if (!IsAccessGranted(context->responseVal))
-    {
-        currentAce = NULL;
-        aceSavePtr = NULL;
-        do
+        if (!isTimeBound)
         {
-            currentAce = GetACLResourceData(&context->subjectUuid, &aceSavePtr);
-
-            if (NULL != currentAce)
-            {
-                ProcessMatchingACE(context, currentAce);
-            }
-            else
-            {
-                OIC_LOG_V(INFO, TAG, "%s:no ACL found matching subject for resource %s",
-                    __func__, context->resourceUri);
-            }
-        } while ((NULL != currentAce) && !IsAccessGranted(context->responseVal));
+            CacheACLDecision(&key, context->responseVal);
+        }
     }
 
 #if defined(__WITH_DTLS__) || defined(__WITH_TLS__)
     // If no subject ACE granted access, try role ACEs.
     if (!IsAccessGranted(context->responseVal))
     {
-        currentAce = NULL;
-        aceSavePtr = NULL;
         OicSecRole_t *roles = NULL;
         size_t roleCount = 0;
         OCStackResult res = GetEndpointRoles(context->endPoint, &roles, &roleCount);
@@ -513,20 +479,11 @@ static void ProcessAccessRequest(SRMRequestContext_t *context)
         else
         {
             OIC_LOG_V(DEBUG, TAG, "Found %u asserted roles for endpoint", (unsigned int) roleCount);
-            do
-            {
-                currentAce = GetACLResourceDataByRoles(roles, roleCount, &aceSavePtr);
-                if (NULL != currentAce)
-                {
-                    ProcessMatchingACE(context, currentAce);
-                }
-                else
-                {
-                    OIC_LOG_V(INFO, TAG, "%s:no ACL found matching roles for resource %s",
-                        __func__, context->resourceUri);
-                }
-            } while ((NULL != currentAce) && !IsAccessGranted(context->responseVal));
-
+            OicSecIndexedAce_t **roleAces = NULL;
+            count = GetIndexedACEsByRoles(roles, roleCount, &roleAces);
+            OIC_LOG_V(DEBUG, TAG, "%s: found %" PRIuPTR " ACEs matching roles", __func__, count);
+            ProcessMatchingACEs(context, roleAces, count, &isTimeBound);
+            OICFree(roleAces);
             OICFree(roles);
         }
     }
@@ -32,23 +32,67 @@
 #include "ocpayloadcbor.h"
 #include "ocstack.h"
 #include "oic_malloc.h"
+#include "oic_string.h"
 #include "payload_logging.h"
 #include "resourcemanager.h"
 #include "secureresourcemanager.h"
 #include "srmresourcestrings.h"
 #include "srmutility.h"
+#include "psinterface.h"
 #include "pstatresource.h"
 #include "doxmresource.h"
 #include "ocresourcehandler.h"
 
 #define TAG  "OIC_SRM_PSI"
 
+/*
+ * Layout of a database:
+ *
+ * A database starts with a CBOR map of resource name to the CBOR encoded resource,
+ * stored as a byte string. An update of a single resource appends a record to the
+ * database instead of rewriting it. A record is a one entry map with the same layout;
+ * a null value removes the resource. Entries of later maps override earlier ones.
+ *
+ * Each record is written with a single write, so an interrupted update leaves at most
+ * one incomplete record at the end of the database. The parser detects and ignores it,
+ * and the next update rewrites the database. Only this interface applies the records;
+ * anything else parsing the file sees the leading map, i.e. the resources as of the last
+ * rewrite, so the database must be read through ::ReadDatabaseFromPS.
+ *
+ * Removals and updates of credentials or ACLs are appended like any other update, so
+ * replaced secrets stay in the database until it is compacted. Once the records outgrow
+ * the leading map, the database is compacted, i.e. rewritten as a single map. If the
+ * persistent storage handler can rename files, a rewrite goes to a temporary file that
+ * then replaces the database, see ::OCPersistentStorage.
+ */
+
 /**
  * Helps cover adding the name of the resource, map addition, and ending while
  * performing CBOR encoding.
  */
 #define CBOR_ENCODING_SIZE_ADDITION 255
 
+/**
+ * Maximum size of the CBOR header of a text or byte string.
+ */
+#define CBOR_STRING_HEADER_SIZE 9
+
+/**
+ * Size the appended records may reach before a database is compacted, unless
+ * the leading map is larger.
+ */
+#define DB_COMPACTION_MIN_SIZE 4096
+
+/**
+ * Suffix of the temporary file a database is rewritten to.
+ */
+#define DB_TEMP_SUFFIX ".tmp"
+
+/**
+ * Number of databases for which the layout is remembered.
+ */
+#define DB_MAX_STATES 4
+
 /**
  * Virtual database buffer block size
  */
@@ -58,15 +102,353 @@
 const size_t DB_FILE_SIZE_BLOCK = 1023;
 #endif
 
-typedef enum _PSDatabase
+/**
+ * Layout of a database as last read or written through a persistent storage handler.
+ */
+typedef struct PSDatabaseState
+{
+    char name[64];                  /**< database name; empty for an unused slot */
+    OCPersistentStorage ps;         /**< handler the layout was observed through */
+    size_t baseSize;                /**< size of the leading map */
+    size_t journalSize;             /**< size of the records appended after the leading map */
+    bool appendable;                /**< false if the database ends with an incomplete record */
+} PSDatabaseState;
+
+/**
+ * Resource of a database, see ::ParseDatabase.
+ */
+typedef struct PSEntry
+{
+    char *name;
+    uint8_t *data;
+    size_t size;
+    struct PSEntry *next;
+} PSEntry;
+
+static PSDatabaseState g_databaseStates[DB_MAX_STATES];
+
+static size_t g_nextDatabaseState = 0;
+
+static PSWriteStats g_writeStats;
+
+static PSDatabaseState *GetDatabaseState(const OCPersistentStorage *ps, const char *databaseName)
+{
+    for (size_t i = 0; i < DB_MAX_STATES; i++)
+    {
+        PSDatabaseState *state = &g_databaseStates[i];
+        if ((0 == strcmp(state->name, databaseName)) &&
+            (0 == memcmp(&state->ps, ps, sizeof(OCPersistentStorage))))
+        {
+            return state;
+        }
+    }
+    return NULL;
+}
+
+static void SetDatabaseState(const OCPersistentStorage *ps, const char *databaseName,
+                             size_t baseSize, size_t journalSize, bool appendable)
+{
+    PSDatabaseState *state = NULL;
+    for (size_t i = 0; (i < DB_MAX_STATES) && !state; i++)
+    {
+        if (0 == strcmp(g_databaseStates[i].name, databaseName))
+        {
+            state = &g_databaseStates[i];
+        }
+    }
+    if (!state)
+    {
+        if (strlen(databaseName) >= sizeof(state->name))
+        {
+            // Not remembered; every update of this database rewrites it.
+            return;
+        }
+        state = &g_databaseStates[g_nextDatabaseState];
+        g_nextDatabaseState = (g_nextDatabaseState + 1) % DB_MAX_STATES;
+        OICStrcpy(state->name, sizeof(state->name), databaseName);
+    }
+    state->ps = *ps;
+    state->baseSize = baseSize;
+    state->journalSize = journalSize;
+    state->appendable = appendable;
+}
+
+static void FreeEntries(PSEntry *entries)
+{
+    while (entries)
+    {
+        PSEntry *next = entries->next;
+        OICFree(entries->name);
+        OICFree(entries->data);
+        OICFree(entries);
+        entries = next;
+    }
+}
+
+/**
+ * Sets or, if data is NULL, removes a resource. Takes ownership of name and data.
+ */
+static bool SetEntry(PSEntry **entries, char *name, uint8_t *data, size_t size)
+{
+    PSEntry **link = entries;
+    while (*link && strcmp((*link)->name, name))
+    {
+        link = &(*link)->next;
+    }
+
+    PSEntry *entry = *link;
+    if (!data)
+    {
+        if (entry)
+        {
+            *link = entry->next;
+            entry->next = NULL;
+            FreeEntries(entry);
+        }
+        OICFree(name);
+        return true;
+    }
+
+    if (entry)
+    {
+        OICFree(name);
+        OICFree(entry->data);
+    }
+    else
+    {
+        entry = (PSEntry *)OICCalloc(1, sizeof(PSEntry));
+        if (!entry)
+        {
+            OICFree(name);
+            OICFree(data);
+            return false;
+        }
+        entry->name = name;
+        *link = entry;
+    }
+    entry->data = data;
+    entry->size = size;
+    return true;
+}
+
+/**
+ * Applies the entries of one map of a database.
+ *
+ * @param map           map to apply; must be well formed.
+ * @param resourceName  if not NULL, only this resource is applied.
+ * @param entries       resources of the database.
+ */
+static CborError ApplyDatabaseMap(const CborValue *map, const char *resourceName, PSEntry **entries)
+{
+    CborValue entry;
+    CborError cborResult = cbor_value_enter_container(map, &entry);
+    while ((CborNoError == cborResult) && !cbor_value_at_end(&entry))
+    {
+        char *name = NULL;
+        size_t nameLen = 0;
+        if (!cbor_value_is_text_string(&entry))
+        {
+            // Not a resource name; skip the entry.
+            cborResult = cbor_value_advance(&entry);
+            if (CborNoError == cborResult)
+            {
+                cborResult = cbor_value_advance(&entry);
+            }
+            continue;
+        }
+        cborResult = cbor_value_dup_text_string(&entry, &name, &nameLen, &entry);
+        if (CborNoError != cborResult)
+        {
+            break;
+        }
+
+        if (resourceName && strcmp(resourceName, name))
+        {
+            OICFree(name);
+            cborResult = cbor_value_advance(&entry);
+        }
+        else if (cbor_value_is_byte_string(&entry))
+        {
+            uint8_t *data = NULL;
+            size_t size = 0;
+            cborResult = cbor_value_dup_byte_string(&entry, &data, &size, &entry);
+            if (CborNoError != cborResult)
+            {
+                OICFree(name);
+            }
+            else if (!SetEntry(entries, name, data, size))
+            {
+                cborResult = CborErrorOutOfMemory;
+            }
+        }
+        else if (cbor_value_is_null(&entry))
+        {
+            SetEntry(entries, name, NULL, 0);
+            cborResult = cbor_value_advance(&entry);
+        }
+        else
+        {
+            OICFree(name);
+            cborResult = cbor_value_advance(&entry);
+        }
+    }
+    return cborResult;
+}
+
+/**
+ * Parses a database, applying its leading map and its records in order.
+ *
+ * @param data          contents of the database.
+ * @param size          size of the contents.
+ * @param resourceName  if not NULL, only this resource is collected.
+ * @param entries       receives the resources of the database; free with ::FreeEntries.
+ * @param baseSize      receives the size of the leading map.
+ * @param validSize     receives the size of the well formed part of the database. Anything
+ *                      after it is an incomplete record.
+ *
+ * @return ::OC_STACK_OK for Success, otherwise some error value
+ */
+static OCStackResult ParseDatabase(const uint8_t *data, size_t size, const char *resourceName,
+                                   PSEntry **entries, size_t *baseSize, size_t *validSize)
 {
-    PS_DATABASE_SECURITY = 0,
-    PS_DATABASE_DEVICEPROPERTIES
-} PSDatabase;
+    size_t offset = 0;
+    *baseSize = 0;
+
+    while (offset < size)
+    {
+        CborParser parser;  // will be initialized in |cbor_parser_init|
+        CborValue cbor;     // will be initialized in |cbor_parser_init|
+        CborError cborResult = cbor_parser_init(data + offset, size - offset, 0, &parser, &cbor);
+        if ((CborNoError != cborResult) || !cbor_value_is_map(&cbor))
+        {
+            break;
+        }
+
+        // Only apply a map once it is known to be complete.
+        CborValue next = cbor;
+        if (CborNoError != cbor_value_advance(&next))
+        {
+            break;
+        }
+
+        cborResult = ApplyDatabaseMap(&cbor, resourceName, entries);
+        if (CborNoError != cborResult)
+        {
+            OIC_LOG_V(ERROR, TAG, "Failed to parse database: %s", cbor_error_string(cborResult));
+            FreeEntries(*entries);
+            *entries = NULL;
+            return OC_STACK_ERROR;
+        }
+
+        size_t mapSize = (size_t)(cbor_value_get_next_byte(&next) - (data + offset));
+        if (0 == offset)
+        {
+            *baseSize = mapSize;
+        }
+        offset += mapSize;
+    }
+
+    if (offset < size)
+    {
+        OIC_LOG_V(WARNING, TAG, "Ignoring %" PRIuPTR " bytes of incomplete data", size - offset);
+    }
+    *validSize = offset;
+    return OC_STACK_OK;
+}
+
+/**
+ * Encodes resources as a single map.
+ */
+static OCStackResult EncodeDatabase(const PSEntry *entries, uint8_t **payload, size_t *size)
+{
+    OCStackResult ret = OC_STACK_ERROR;
+    int64_t cborEncoderResult = CborNoError;
+    size_t allocSize = CBOR_ENCODING_SIZE_ADDITION;
+    for (const PSEntry *entry = entries; entry; entry = entry->next)
+    {
+        allocSize += strlen(entry->name) + entry->size + 2 * CBOR_STRING_HEADER_SIZE;
+    }
+
+    uint8_t *outPayload = (uint8_t *)OICCalloc(1, allocSize);
+    VERIFY_NOT_NULL(TAG, outPayload, ERROR);
+    CborEncoder encoder;  // will be initialized in |cbor_parser_init|
+    cbor_encoder_init(&encoder, outPayload, allocSize, 0);
+    CborEncoder resource;  // will be initialized in |cbor_encoder_create_map|
+    cborEncoderResult |= cbor_encoder_create_map(&encoder, &resource, CborIndefiniteLength);
+    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding PS Map.");
+
+    for (const PSEntry *entry = entries; entry; entry = entry->next)
+    {
+        cborEncoderResult |= cbor_encode_text_string(&resource, entry->name, strlen(entry->name));
+        VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Value Tag");
+        cborEncoderResult |= cbor_encode_byte_string(&resource, entry->data, entry->size);
+        VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Value.");
+    }
+
+    cborEncoderResult |= cbor_encoder_close_container(&encoder, &resource);
+    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Closing Map.");
+    VERIFY_SUCCESS(TAG, CborNoError == cborEncoderResult, ERROR);
+
+    *size = cbor_encoder_get_buffer_size(&encoder, outPayload);
+    *payload = outPayload;
+    outPayload = NULL;
+    ret = OC_STACK_OK;
+
+exit:
+    OICFree(outPayload);
+    return ret;
+}
+
+/**
+ * Encodes the record of a resource update; a NULL payload removes the resource.
+ */
+static OCStackResult EncodeRecord(const char *resourceName, const uint8_t *payload,
+                                  size_t size, uint8_t **record, size_t *recordSize)
+{
+    OCStackResult ret = OC_STACK_ERROR;
+    int64_t cborEncoderResult = CborNoError;
+    size_t allocSize = strlen(resourceName) + size + CBOR_ENCODING_SIZE_ADDITION;
+
+    uint8_t *outPayload = (uint8_t *)OICCalloc(1, allocSize);
+    VERIFY_NOT_NULL(TAG, outPayload, ERROR);
+    CborEncoder encoder;  // will be initialized in |cbor_parser_init|
+    cbor_encoder_init(&encoder, outPayload, allocSize, 0);
+    CborEncoder resource;  // will be initialized in |cbor_encoder_create_map|
+    cborEncoderResult |= cbor_encoder_create_map(&encoder, &resource, 1);
+    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Record Map.");
+
+    cborEncoderResult |= cbor_encode_text_string(&resource, resourceName, strlen(resourceName));
+    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Value Tag");
+    if (payload && size)
+    {
+        cborEncoderResult |= cbor_encode_byte_string(&resource, payload, size);
+    }
+    else
+    {
+        cborEncoderResult |= cbor_encode_null(&resource);
+    }
+    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Value.");
+
+    cborEncoderResult |= cbor_encoder_close_container(&encoder, &resource);
+    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Closing Map.");
+    VERIFY_SUCCESS(TAG, CborNoError == cborEncoderResult, ERROR);
+
+    *recordSize = cbor_encoder_get_buffer_size(&encoder, outPayload);
+    *record = outPayload;
+    outPayload = NULL;
+    ret = OC_STACK_OK;
+
+exit:
+    OICFree(outPayload);
+    return ret;
+}
 
 /**
  * Writes CBOR payload to the specified database in persistent storage.
  *
+ * If the persistent storage handler can rename files, the payload is written to a
+ * temporary file that then replaces the database; otherwise the database is overwritten.
+ *
  * @param databaseName is the name of the database to access through persistent storage.
  * @param payload      is the CBOR payload to write to the database in persistent storage.
  * @param size         is the size of payload.
@@ -87,30 +469,119 @@ static OCStackResult WritePayloadToPS(const char *databaseName, uint8_t *payload
     OCPersistentStorage* ps = OCGetPersistentStorageHandler();
     if (ps)
     {
-        FILE *fp = ps->open(databaseName, "wb");
+        char *tempName = NULL;
+        const char *fileName = databaseName;
+        if (ps->rename)
+        {
+            size_t tempNameSize = strlen(databaseName) + sizeof(DB_TEMP_SUFFIX);
+            tempName = (char *)OICMalloc(tempNameSize);
+            if (!tempName)
+            {
+                OIC_LOG(ERROR, TAG, "Memory allocation failed.");
+                return OC_STACK_NO_MEMORY;
+            }
+            OICStrcpy(tempName, tempNameSize, databaseName);
+            OICStrcat(tempName, tempNameSize, DB_TEMP_SUFFIX);
+            fileName = tempName;
+        }
+
+        FILE *fp = ps->open(fileName, "wb");
         if (fp)
         {
             size_t numberItems = ps->write(payload, 1, size, fp);
-            if (size == numberItems)
+            g_writeStats.writtenBytes += numberItems;
+            g_writeStats.fullWrites++;
+            if ((0 == ps->close(fp)) && (size == numberItems))
             {
-                OIC_LOG_V(DEBUG, TAG, "Written %" PRIuPTR " bytes into %s", size, databaseName);
+                OIC_LOG_V(DEBUG, TAG, "Written %" PRIuPTR " bytes into %s", size, fileName);
                 result = OC_STACK_OK;
             }
             else
             {
-                OIC_LOG_V(ERROR, TAG, "Failed writing %" PRIuPTR " in %s", numberItems, databaseName);
+                OIC_LOG_V(ERROR, TAG, "Failed writing %" PRIuPTR " in %s", numberItems, fileName);
             }
-            ps->close(fp);
+
+            if (tempName && (OC_STACK_OK == result) && (0 != ps->rename(tempName, databaseName)))
+            {
+                OIC_LOG_V(ERROR, TAG, "Failed renaming %s to %s", tempName, databaseName);
+                result = OC_STACK_ERROR;
+            }
+            if (tempName && (OC_STACK_OK != result))
+            {
+                // The database itself is unchanged.
+                ps->unlink(tempName);
+            }
+            SetDatabaseState(ps, databaseName, size, 0, (OC_STACK_OK == result));
         }
         else
         {
             OIC_LOG(ERROR, TAG, "File open failed.");
         }
+        OICFree(tempName);
     }
 
     return result;
 }
 
+/**
+ * Appends the record of a resource update to a database.
+ *
+ * @param ps            persistent storage handler.
+ * @param state         layout of the database, updated on success.
+ * @param resourceName  is the name of the resource that will be updated.
+ * @param payload       is the new CBOR payload of the resource, NULL to remove it.
+ * @param size          is the size of the CBOR payload.
+ *
+ * @return ::OC_STACK_OK for Success, otherwise some error value
+ */
+static OCStackResult AppendRecordToPS(OCPersistentStorage *ps, PSDatabaseState *state,
+                                      const char *resourceName, const uint8_t *payload,
+                                      size_t size)
+{
+    uint8_t *record = NULL;
+    size_t recordSize = 0;
+    OCStackResult ret = EncodeRecord(resourceName, payload, size, &record, &recordSize);
+    if (OC_STACK_OK != ret)
+    {
+        return ret;
+    }
+
+    size_t limit = (state->baseSize > DB_COMPACTION_MIN_SIZE) ?
+                   state->baseSize : DB_COMPACTION_MIN_SIZE;
+    if (state->journalSize + recordSize > limit)
+    {
+        OIC_LOG_V(DEBUG, TAG, "Compacting %s", state->name);
+        OICFree(record);
+        return OC_STACK_ERROR;
+    }
+
+    ret = OC_STACK_ERROR;
+    FILE *fp = ps->open(state->name, "ab");
+    if (fp)
+    {
+        size_t numberItems = ps->write(record, 1, recordSize, fp);
+        g_writeStats.writtenBytes += numberItems;
+        if ((0 == ps->close(fp)) && (recordSize == numberItems))
+        {
+            OIC_LOG_V(DEBUG, TAG, "Appended %" PRIuPTR " bytes to %s", recordSize, state->name);
+            state->journalSize += recordSize;
+            ret = OC_STACK_OK;
+        }
+        else
+        {
+            OIC_LOG_V(ERROR, TAG, "Failed appending %" PRIuPTR " bytes to %s", recordSize, state->name);
+            state->appendable = false;
+        }
+    }
+    else
+    {
+        OIC_LOG(ERROR, TAG, "File open failed.");
+    }
+
+    OICFree(record);
+    return ret;
+}
+
 /**
  * Gets the database size
  *
@@ -142,9 +613,74 @@ static size_t GetDatabaseSize(const OCPersistentStorage *ps, const char *databas
     return size;
 }
 
+/**
+ * Reads the resources of a database and records its layout.
+ *
+ * @param ps            persistent storage handler.
+ * @param databaseName  is the name of the database to access through persistent storage.
+ * @param resourceName  if not NULL, only this resource is read.
+ * @param entries       receives the resources; free with ::FreeEntries.
+ * @param fsData        if not NULL, receives the raw contents of the database.
+ * @param fsSize        if not NULL, receives the size of the raw contents.
+ * @param compact       if not NULL, set to true if the raw contents are a single map.
+ *
+ * @return ::OC_STACK_OK for Success, also when the database is empty or missing,
+ *         otherwise some error value
+ */
+static OCStackResult ReadEntriesFromPS(OCPersistentStorage *ps, const char *databaseName,
+                                       const char *resourceName, PSEntry **entries,
+                                       uint8_t **fsData, size_t *fsSize, bool *compact)
+{
+    FILE *fp = NULL;
+    uint8_t *data = NULL;
+    size_t baseSize = 0;
+    size_t validSize = 0;
+    OCStackResult ret = OC_STACK_ERROR;
+
+    size_t fileSize = GetDatabaseSize(ps, databaseName);
+    OIC_LOG_V(DEBUG, TAG, "File Read Size: %" PRIuPTR, fileSize);
+    if (fileSize)
+    {
+        data = (uint8_t *) OICCalloc(1, fileSize);
+        VERIFY_NOT_NULL(TAG, data, ERROR);
+
+        fp = ps->open(databaseName, "rb");
+        VERIFY_NOT_NULL(TAG, fp, ERROR);
+        VERIFY_SUCCESS(TAG, ps->read(data, 1, fileSize, fp) == fileSize, ERROR);
+
+        ret = ParseDatabase(data, fileSize, resourceName, entries, &baseSize, &validSize);
+        VERIFY_SUCCESS(TAG, OC_STACK_OK == ret, ERROR);
+    }
+    SetDatabaseState(ps, databaseName, baseSize, validSize - baseSize,
+                     (validSize == fileSize));
+
+    if (compact)
+    {
+        *compact = (validSize == baseSize);
+    }
+    if (fsData)
+    {
+        *fsData = data;
+        data = NULL;
+    }
+    if (fsSize)
+    {
+        *fsSize = fileSize;
+    }
+    ret = OC_STACK_OK;
+
+exit:
+    if (fp)
+    {
+        ps->close(fp);
+    }
+    OICFree(data);
+    return ret;
+}
+
 /**
  * Reads the database from PS
- * 
+ *
  * @note Caller of this method MUST use OICFree() method to release memory
  *       referenced by the data argument.
  *
@@ -165,58 +701,49 @@ OCStackResult ReadDatabaseFromPS(const char *databaseName, const char *resourceN
         return OC_STACK_INVALID_PARAM;
     }
 
-    FILE *fp = NULL;
     uint8_t *fsData = NULL;
     size_t fileSize = 0;
+    bool compact = true;
+    PSEntry *entries = NULL;
     OCStackResult ret = OC_STACK_ERROR;
 
     OCPersistentStorage *ps = OCGetPersistentStorageHandler();
     VERIFY_NOT_NULL(TAG, ps, ERROR);
 
-    fileSize = GetDatabaseSize(ps, databaseName);
-    OIC_LOG_V(DEBUG, TAG, "File Read Size: %" PRIuPTR, fileSize);
+    ret = ReadEntriesFromPS(ps, databaseName, resourceName, &entries, &fsData, &fileSize, &compact);
+    VERIFY_SUCCESS(TAG, OC_STACK_OK == ret, ERROR);
+    ret = OC_STACK_ERROR;
+
     if (fileSize)
     {
-        fsData = (uint8_t *) OICCalloc(1, fileSize);
-        VERIFY_NOT_NULL(TAG, fsData, ERROR);
-
-        fp = ps->open(databaseName, "rb");
-        VERIFY_NOT_NULL(TAG, fp, ERROR);
-        if (ps->read(fsData, 1, fileSize, fp) == fileSize)
+        if (resourceName)
         {
-            if (resourceName)
+            // in case of |else (...)|, svr_data not found
+            if (entries)
             {
-                CborParser parser;  // will be initialized in |cbor_parser_init|
-                CborValue cbor;     // will be initialized in |cbor_parser_init|
-                cbor_parser_init(fsData, fileSize, 0, &parser, &cbor);
-                CborValue cborValue = {0};
-                CborError cborFindResult = cbor_value_map_find_value(&cbor, resourceName, &cborValue);
-                if (CborNoError == cborFindResult && cbor_value_is_byte_string(&cborValue))
-                {
-                    cborFindResult = cbor_value_dup_byte_string(&cborValue, data, size, NULL);
-                    VERIFY_SUCCESS(TAG, CborNoError == cborFindResult, ERROR);
-                    ret = OC_STACK_OK;
-                }
-                // in case of |else (...)|, svr_data not found
-            }
-            // return everything in case resourceName is NULL
-            else
-            {
-                *size = fileSize;
-                *data = (uint8_t *) OICCalloc(1, fileSize);
-                VERIFY_NOT_NULL(TAG, *data, ERROR);
-                memcpy(*data, fsData, fileSize);
+                *data = entries->data;
+                *size = entries->size;
+                entries->data = NULL;
                 ret = OC_STACK_OK;
             }
         }
+        // return everything in case resourceName is NULL
+        else if (compact)
+        {
+            *size = fileSize;
+            *data = fsData;
+            fsData = NULL;
+            ret = OC_STACK_OK;
+        }
+        else
+        {
+            ret = EncodeDatabase(entries, data, size);
+        }
     }
     OIC_LOG(DEBUG, TAG, "ReadDatabaseFromPS OUT");
 
 exit:
-    if (fp)
-    {
-        ps->close(fp);
-    }
+    FreeEntries(entries);
     OICFree(fsData);
     return ret;
 }
@@ -241,256 +768,57 @@ OCStackResult UpdateResourceInPS(const char *databaseName, const char *resourceN
 
     size_t dbSize = 0;
     size_t outSize = 0;
-    uint8_t *dbData = NULL;
     uint8_t *outPayload = NULL;
+    char *name = NULL;
+    uint8_t *data = NULL;
+    PSEntry *entries = NULL;
+    OCStackResult ret = OC_STACK_ERROR;
 
-    uint8_t *aclCbor = NULL;
-    uint8_t *pstatCbor = NULL;
-    uint8_t *doxmCbor = NULL;
-    uint8_t *amaclCbor = NULL;
-    uint8_t *credCbor = NULL;
-    uint8_t *pconfCbor = NULL;
-    uint8_t *resetPfCbor = NULL;
-    uint8_t *crlCbor = NULL;
-    uint8_t *dpCbor = NULL;
-
-    int64_t cborEncoderResult = CborNoError;
-    OCStackResult ret = ReadDatabaseFromPS(databaseName, NULL, &dbData, &dbSize);
-    if (dbData && dbSize)
-    {
-        PSDatabase database = PS_DATABASE_SECURITY;
-        size_t allocSize = 0;
-        size_t aclCborLen = 0;
-        size_t pstatCborLen = 0;
-        size_t doxmCborLen = 0;
-        size_t amaclCborLen = 0;
-        size_t credCborLen = 0;
-        size_t pconfCborLen = 0;
-        size_t resetPfCborLen = 0;
-        size_t crlCborLen = 0;
-        size_t dpCborLen = 0;
-
-        // Determine which database we are working with so we can scope our operations
-        if (0 == strcmp(OC_DEVICE_PROPS_FILE_NAME, databaseName))
-        {
-            database = PS_DATABASE_DEVICEPROPERTIES;
-        }
-
-        // Gets each secure virtual resource from persistent storage
-        // this local scoping intended, for destroying large cbor instances after use
-        {
-            CborParser parser;  // will be initialized in |cbor_parser_init|
-            CborValue cbor;     // will be initialized in |cbor_parser_init|
-            cbor_parser_init(dbData, dbSize, 0, &parser, &cbor);
-            CborValue curVal = {0};
-            CborError cborFindResult = CborNoError;
+    OCPersistentStorage *ps = OCGetPersistentStorageHandler();
+    VERIFY_NOT_NULL(TAG, ps, ERROR);
 
-            // Only search for and copy resources owned by the target database
-            if (PS_DATABASE_SECURITY == database)
-            {
-                // Security database
-                cborFindResult = cbor_value_map_find_value(&cbor, OIC_JSON_ACL_NAME, &curVal);
-                if ((CborNoError == cborFindResult) && cbor_value_is_byte_string(&curVal))
-                {
-                    cborFindResult = cbor_value_dup_byte_string(&curVal, &aclCbor, &aclCborLen, NULL);
-                    VERIFY_CBOR_SUCCESS(TAG, cborFindResult, "Failed Finding ACL Name Value.");
-                }
-                cborFindResult = cbor_value_map_find_value(&cbor, OIC_JSON_PSTAT_NAME, &curVal);
-                if ((CborNoError == cborFindResult) && cbor_value_is_byte_string(&curVal))
-                {
-                    cborFindResult = cbor_value_dup_byte_string(&curVal, &pstatCbor, &pstatCborLen, NULL);
-                    VERIFY_CBOR_SUCCESS(TAG, cborFindResult, "Failed Finding PSTAT Name Value.");
-                }
-                cborFindResult = cbor_value_map_find_value(&cbor, OIC_JSON_DOXM_NAME, &curVal);
-                if ((CborNoError == cborFindResult) && cbor_value_is_byte_string(&curVal))
-                {
-                    cborFindResult = cbor_value_dup_byte_string(&curVal, &doxmCbor, &doxmCborLen, NULL);
-                    VERIFY_CBOR_SUCCESS(TAG, cborFindResult, "Failed Finding DOXM Name Value.");
-                }
-                cborFindResult = cbor_value_map_find_value(&cbor, OIC_JSON_AMACL_NAME, &curVal);
-                if ((CborNoError == cborFindResult) && cbor_value_is_byte_string(&curVal))
-                {
-                    cborFindResult = cbor_value_dup_byte_string(&curVal, &amaclCbor, &amaclCborLen, NULL);
-                    VERIFY_CBOR_SUCCESS(TAG, cborFindResult, "Failed Finding AMACL Name Value.");
-                }
-                cborFindResult = cbor_value_map_find_value(&cbor, OIC_JSON_CRED_NAME, &curVal);
-                if ((CborNoError == cborFindResult) && cbor_value_is_byte_string(&curVal))
-                {
-                    cborFindResult = cbor_value_dup_byte_string(&curVal, &credCbor, &credCborLen, NULL);
-                    VERIFY_CBOR_SUCCESS(TAG, cborFindResult, "Failed Finding CRED Name Value.");
-                }
-                cborFindResult = cbor_value_map_find_value(&cbor, OIC_JSON_PCONF_NAME, &curVal);
-                if ((CborNoError == cborFindResult) && cbor_value_is_byte_string(&curVal))
-                {
-                    cborFindResult = cbor_value_dup_byte_string(&curVal, &pconfCbor, &pconfCborLen, NULL);
-                    VERIFY_CBOR_SUCCESS(TAG, cborFindResult, "Failed Finding PCONF Name Value.");
-                }
-                cborFindResult = cbor_value_map_find_value(&cbor, OIC_JSON_RESET_PF_NAME, &curVal);
-                if ((CborNoError == cborFindResult) && cbor_value_is_byte_string(&curVal))
-                {
-                    cborFindResult = cbor_value_dup_byte_string(&curVal, &resetPfCbor, &resetPfCborLen, NULL);
-                    VERIFY_CBOR_SUCCESS(TAG, cborFindResult, "Failed Finding Reset Profile Name Value.");
-                }
-                int64_t cborFindCrlResult = cbor_value_map_find_value(&cbor, OIC_JSON_CRL_NAME, &curVal);
-                if ((CborNoError == cborFindCrlResult) && cbor_value_is_byte_string(&curVal))
-                {
-                    cborFindCrlResult = cbor_value_dup_byte_string(&curVal, &crlCbor, &crlCborLen, NULL);
-                    if ((CborNoError != cborFindCrlResult) && (CborErrorOutOfMemory != cborFindCrlResult))
-                    {
-                        OIC_LOG(ERROR, TAG, "Failed Finding optional CRL Name Value.");
-                    }
-                    else
-                    {
-                        OIC_LOG(INFO, TAG, "Successfully Finding optional CRL Name Value.");
-                    }
-                }
-            }
-            else
-            {
-                // Device Properties database
-                cborFindResult = cbor_value_map_find_value(&cbor, OC_JSON_DEVICE_PROPS_NAME, &curVal);
-                if ((CborNoError == cborFindResult) && cbor_value_is_byte_string(&curVal))
-                {
-                    cborFindResult = cbor_value_dup_byte_string(&curVal, &dpCbor, &dpCborLen, NULL);
-                    VERIFY_CBOR_SUCCESS(TAG, cborFindResult, "Failed Finding Device Properties Name Value.");
-                }
-            }
-        }
+    g_writeStats.updates++;
+    g_writeStats.payloadBytes += payload ? size : 0;
 
-        // Updates the added |payload| with the existing secure virtual resource(s)
-        // this local scoping intended, for destroying large cbor instances after use
+    // Append a record, or a null record for a removal, unless the database layout is
+    // unknown, the database ends with an incomplete record or is due for compaction.
+    PSDatabaseState *state = GetDatabaseState(ps, databaseName);
+    if (state && state->appendable && state->baseSize)
+    {
+        ret = AppendRecordToPS(ps, state, resourceName, payload, size);
+        if (OC_STACK_OK == ret)
         {
-            if (PS_DATABASE_SECURITY == database)
-            {
-                allocSize = aclCborLen + pstatCborLen + doxmCborLen + amaclCborLen
-                          + credCborLen + pconfCborLen + resetPfCborLen + crlCborLen
-                          + size + CBOR_ENCODING_SIZE_ADDITION;
-            }
-            else
-            {
-                allocSize = dpCborLen + size + CBOR_ENCODING_SIZE_ADDITION;
-            }
-
-
-            outPayload = (uint8_t *)OICCalloc(1, allocSize);
-            VERIFY_NOT_NULL(TAG, outPayload, ERROR);
-            CborEncoder encoder;  // will be initialized in |cbor_parser_init|
-            cbor_encoder_init(&encoder, outPayload, allocSize, 0);
-            CborEncoder resource;  // will be initialized in |cbor_encoder_create_map|
-            cborEncoderResult |= cbor_encoder_create_map(&encoder, &resource, CborIndefiniteLength);
-            VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding PS Map.");
-
-            // Encode the updated payload and add it to our map so it will be stored in the database.
-            if (payload && size)
-            {
-                cborEncoderResult |= cbor_encode_text_string(&resource, resourceName, strlen(resourceName));
-                VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Value Tag");
-                cborEncoderResult |= cbor_encode_byte_string(&resource, payload, size);
-                VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Value.");
-            }
-
-            // Check all of the resources from a particular database to see if we need to encode them. If the resource
-            // currently exists in the database and has not been updated then we need to encode it and add it to the
-            // map. If the resource has been updated then it was encoded and added to the map above so we skip it to
-            // avoid having duplicate entries for the resource in the database.
-            if (PS_DATABASE_SECURITY == database)
-            {
-                // Security database
-                if (strcmp(OIC_JSON_ACL_NAME, resourceName) && aclCborLen)
-                {
-                    cborEncoderResult |= cbor_encode_text_string(&resource, OIC_JSON_ACL_NAME, strlen(OIC_JSON_ACL_NAME));
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding ACL Name.");
-                    cborEncoderResult |= cbor_encode_byte_string(&resource, aclCbor, aclCborLen);
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding ACL Value.");
-                }
-                if (strcmp(OIC_JSON_PSTAT_NAME, resourceName) && pstatCborLen)
-                {
-                    cborEncoderResult |= cbor_encode_text_string(&resource, OIC_JSON_PSTAT_NAME, strlen(OIC_JSON_PSTAT_NAME));
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding PSTAT Name.");
-                    cborEncoderResult |= cbor_encode_byte_string(&resource, pstatCbor, pstatCborLen);
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding PSTAT Value.");
-                }
-                if (strcmp(OIC_JSON_DOXM_NAME, resourceName) && doxmCborLen)
-                {
-                    cborEncoderResult |= cbor_encode_text_string(&resource, OIC_JSON_DOXM_NAME, strlen(OIC_JSON_DOXM_NAME));
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Doxm Name.");
-                    cborEncoderResult |= cbor_encode_byte_string(&resource, doxmCbor, doxmCborLen);
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Doxm Value.");
-                }
-                if (strcmp(OIC_JSON_AMACL_NAME, resourceName) && amaclCborLen)
-                {
-                    cborEncoderResult |= cbor_encode_text_string(&resource, OIC_JSON_AMACL_NAME, strlen(OIC_JSON_AMACL_NAME));
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Amacl Name.");
-                    cborEncoderResult |= cbor_encode_byte_string(&resource, amaclCbor, amaclCborLen);
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Amacl Value.");
-                }
-                if (strcmp(OIC_JSON_CRED_NAME, resourceName) && credCborLen)
-                {
-                    cborEncoderResult |= cbor_encode_text_string(&resource, OIC_JSON_CRED_NAME, strlen(OIC_JSON_CRED_NAME));
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Cred Name.");
-                    cborEncoderResult |= cbor_encode_byte_string(&resource, credCbor, credCborLen);
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Cred Value.");
-                }
-                if (strcmp(OIC_JSON_PCONF_NAME, resourceName) && pconfCborLen)
-                {
-                    cborEncoderResult |= cbor_encode_text_string(&resource, OIC_JSON_PCONF_NAME, strlen(OIC_JSON_PCONF_NAME));
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Pconf Name.");
-                    cborEncoderResult |= cbor_encode_byte_string(&resource, pconfCbor, pconfCborLen);
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Pconf Value.");
-                }
-                if (strcmp(OIC_JSON_RESET_PF_NAME, resourceName) && resetPfCborLen)
-                {
-                    cborEncoderResult |= cbor_encode_text_string(&resource, OIC_JSON_RESET_PF_NAME, strlen(OIC_JSON_RESET_PF_NAME));
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Reset Profile Name.");
-                    cborEncoderResult |= cbor_encode_byte_string(&resource, resetPfCbor, resetPfCborLen);
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Reset Profile Value.");
-                }
-                if (strcmp(OIC_JSON_CRL_NAME, resourceName) && crlCborLen)
-                {
-                    cborEncoderResult |= cbor_encode_text_string(&resource, OIC_JSON_CRL_NAME, strlen(OIC_JSON_CRL_NAME));
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Crl Name.");
-                    cborEncoderResult |= cbor_encode_byte_string(&resource, crlCbor, crlCborLen);
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Crl Value.");
-                }
-            }
-            else
-            {
-                // Device Properties database
-                if (strcmp(OC_JSON_DEVICE_PROPS_NAME, resourceName) && dpCborLen)
-                {
-                    cborEncoderResult |= cbor_encode_text_string(&resource, OC_JSON_DEVICE_PROPS_NAME, strlen(OC_JSON_DEVICE_PROPS_NAME));
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Device Properties Name.");
-                    cborEncoderResult |= cbor_encode_byte_string(&resource, dpCbor, dpCborLen);
-                    VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Device Properties Value.");
-                }
-            }
-
-            cborEncoderResult |= cbor_encoder_close_container(&encoder, &resource);
-            VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Closing Array.");
-            outSize = cbor_encoder_get_buffer_size(&encoder, outPayload);
+            OIC_LOG(DEBUG, TAG, "UpdateResourceInPS OUT");
+            return ret;
         }
     }
-    else if (payload && size)
-    {
-        size_t allocSize = size + CBOR_ENCODING_SIZE_ADDITION;
 
-        outPayload = (uint8_t *)OICCalloc(1, allocSize);
-        VERIFY_NOT_NULL(TAG, outPayload, ERROR);
-        CborEncoder encoder;  // will be initialized in |cbor_parser_init|
-        cbor_encoder_init(&encoder, outPayload, allocSize, 0);
-        CborEncoder resource;  // will be initialized in |cbor_encoder_create_map|
-        cborEncoderResult |= cbor_encoder_create_map(&encoder, &resource, CborIndefiniteLength);
-        VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding PS Map.");
+    // Rewrite the database as a single map.
+    ret = ReadEntriesFromPS(ps, databaseName, NULL, &entries, NULL, &dbSize, NULL);
+    VERIFY_SUCCESS(TAG, OC_STACK_OK == ret, ERROR);
+    ret = OC_STACK_ERROR;
 
-        cborEncoderResult |= cbor_encode_text_string(&resource, resourceName, strlen(resourceName));
-        VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Value Tag");
-        cborEncoderResult |= cbor_encode_byte_string(&resource, payload, size);
-        VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Adding Value.");
+    if (!dbSize && !(payload && size))
+    {
+        ret = OC_STACK_INVALID_PARAM;
+        goto exit;
+    }
 
-        cborEncoderResult |= cbor_encoder_close_container(&encoder, &resource);
-        VERIFY_CBOR_SUCCESS(TAG, cborEncoderResult, "Failed Closing Array.");
-        outSize = cbor_encoder_get_buffer_size(&encoder, outPayload);
+    name = OICStrdup(resourceName);
+    VERIFY_NOT_NULL(TAG, name, ERROR);
+    if (payload && size)
+    {
+        data = (uint8_t *)OICMalloc(size);
+        VERIFY_NOT_NULL(TAG, data, ERROR);
+        memcpy(data, payload, size);
     }
+    bool entrySet = SetEntry(&entries, name, data, size);
+    name = NULL;
+    data = NULL;
+    VERIFY_SUCCESS(TAG, entrySet, ERROR);
+
+    ret = EncodeDatabase(entries, &outPayload, &outSize);
+    VERIFY_SUCCESS(TAG, (OC_STACK_OK == ret), ERROR);
 
     ret = WritePayloadToPS(databaseName, outPayload, outSize);
     VERIFY_SUCCESS(TAG, (OC_STACK_OK == ret), ERROR);
@@ -498,20 +826,42 @@ OCStackResult UpdateResourceInPS(const char *databaseName, const char *resourceN
     OIC_LOG(DEBUG, TAG, "UpdateResourceInPS OUT");
 
 exit:
-    OICFree(dbData);
+    OICFree(name);
+    OICFree(data);
     OICFree(outPayload);
-    OICFree(aclCbor);
-    OICFree(pstatCbor);
-    OICFree(doxmCbor);
-    OICFree(amaclCbor);
-    OICFree(credCbor);
-    OICFree(pconfCbor);
-    OICFree(resetPfCbor);
-    OICFree(crlCbor);
-    OICFree(dpCbor);
+    FreeEntries(entries);
     return ret;
 }
 
+/**
+ * Forgets the layout of all databases.
+ */
+void ResetPSDatabaseStates(void)
+{
+    memset(g_databaseStates, 0, sizeof(g_databaseStates));
+    g_nextDatabaseState = 0;
+}
+
+/**
+ * Gets the write statistics of the persistent storage interface.
+ *
+ * @param stats  receives the statistics.
+ */
+void GetPSWriteStats(PSWriteStats *stats)
+{
+    if (stats)
+    {
+        *stats = g_writeStats;
+    }
+}
+
+/**
+ * Resets the write statistics of the persistent storage interface.
+ */
+void ResetPSWriteStats(void)
+{
+    memset(&g_writeStats, 0, sizeof(g_writeStats));
+}
 /**
  * Reads the Secure Virtual Database from PS
  *
@@ -0,0 +1,177 @@
+//******************************************************************
+//
+// Copyright 2017 Open Connectivity Foundation
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include "ocstack.h"
+#include "oic_malloc.h"
+#include "oic_string.h"
+#include "securevirtualresourcetypes.h"
+#include "aclindex.h"
+
+class ACLIndexTest : public testing::Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            memset(&m_acl, 0, sizeof(m_acl));
+            m_last = NULL;
+        }
+
+        virtual void TearDown()
+        {
+            InvalidateACLIndex(NULL);
+            OicSecAce_t *ace = m_acl.aces;
+            while (ace)
+            {
+                OicSecAce_t *next = ace->next;
+                OicSecRsrc_t *rsrc = ace->resources;
+                while (rsrc)
+                {
+                    OicSecRsrc_t *nextRsrc = rsrc->next;
+                    OICFree(rsrc->href);
+                    OICFree(rsrc);
+                    rsrc = nextRsrc;
+                }
+                OICFree(ace);
+                ace = next;
+            }
+        }
+
+        OicSecAce_t *AddAce(OicSecAceSubjectType subjectType)
+        {
+            OicSecAce_t *ace = (OicSecAce_t *)OICCalloc(1, sizeof(OicSecAce_t));
+            ace->subjectType = subjectType;
+            ace->permission = PERMISSION_READ;
+            if (m_last)
+            {
+                m_last->next = ace;
+            }
+            else
+            {
+                m_acl.aces = ace;
+            }
+            m_last = ace;
+            return ace;
+        }
+
+        void AddResource(OicSecAce_t *ace, const char *href,
+                         OicSecAceResourceWildcard_t wildcard = NO_WILDCARD)
+        {
+            OicSecRsrc_t *rsrc = (OicSecRsrc_t *)OICCalloc(1, sizeof(OicSecRsrc_t));
+            rsrc->href = href ? OICStrdup(href) : NULL;
+            rsrc->wildcard = wildcard;
+            rsrc->next = ace->resources;
+            ace->resources = rsrc;
+        }
+
+        OicSecAcl_t m_acl;
+        OicSecAce_t *m_last;
+};
+
+TEST_F(ACLIndexTest, GroupsACEsBySubjectInACLOrder)
+{
+    OicUuid_t subjectA = {"SubjectA"};
+    OicUuid_t subjectB = {"SubjectB"};
+    OicSecAce_t *ace1 = AddAce(OicSecAceUuidSubject);
+    ace1->subjectuuid = subjectA;
+    OicSecAce_t *ace2 = AddAce(OicSecAceUuidSubject);
+    ace2->subjectuuid = subjectB;
+    OicSecAce_t *ace3 = AddAce(OicSecAceConntypeSubject);
+    ace3->subjectConn = ANON_CLEAR;
+    OicSecAce_t *ace4 = AddAce(OicSecAceUuidSubject);
+    ace4->subjectuuid = subjectA;
+    InvalidateACLIndex(&m_acl);
+
+    OicSecIndexedAce_t * const *aces = NULL;
+    ASSERT_EQ(2u, GetIndexedACEsBySubject(&subjectA, &aces));
+    EXPECT_EQ(ace1, aces[0]->ace);
+    EXPECT_EQ(ace4, aces[1]->ace);
+    ASSERT_EQ(1u, GetIndexedACEsByConntype(ANON_CLEAR, &aces));
+    EXPECT_EQ(ace3, aces[0]->ace);
+    EXPECT_EQ(0u, GetIndexedACEsByConntype(AUTH_CRYPT, &aces));
+
+    OicUuid_t subjectC = {"SubjectC"};
+    EXPECT_EQ(0u, GetIndexedACEsBySubject(&subjectC, &aces));
+}
+
+TEST_F(ACLIndexTest, MergesRoleACEsInACLOrder)
+{
+    OicSecRole_t roles[2];
+    memset(roles, 0, sizeof(roles));
+    OICStrcpy(roles[0].id, sizeof(roles[0].id), "admin");
+    OICStrcpy(roles[1].id, sizeof(roles[1].id), "user");
+
+    OicSecAce_t *ace1 = AddAce(OicSecAceRoleSubject);
+    ace1->subjectRole = roles[1];
+    OicSecAce_t *ace2 = AddAce(OicSecAceRoleSubject);
+    ace2->subjectRole = roles[0];
+    InvalidateACLIndex(&m_acl);
+
+    OicSecIndexedAce_t **aces = NULL;
+    ASSERT_EQ(2u, GetIndexedACEsByRoles(roles, 2, &aces));
+    EXPECT_EQ(ace1, aces[0]->ace);
+    EXPECT_EQ(ace2, aces[1]->ace);
+    OICFree(aces);
+}
+
+TEST_F(ACLIndexTest, MatchesResources)
+{
+    OicSecAce_t *ace = AddAce(OicSecAceConntypeSubject);
+    AddResource(ace, "/a/light");
+    AddResource(ace, "/a/fan");
+    AddResource(ace, NULL, ALL_DISCOVERABLE);
+    InvalidateACLIndex(&m_acl);
+
+    OicSecIndexedAce_t * const *aces = NULL;
+    ASSERT_EQ(1u, GetIndexedACEsByConntype(AUTH_CRYPT, &aces));
+    EXPECT_TRUE(IsResourceInIndexedACE(aces[0], "/a/fan", DISCOVERABLE_FALSE));
+    EXPECT_TRUE(IsResourceInIndexedACE(aces[0], "/a/light", DISCOVERABLE_FALSE));
+    EXPECT_FALSE(IsResourceInIndexedACE(aces[0], "/a/door", DISCOVERABLE_FALSE));
+    EXPECT_TRUE(IsResourceInIndexedACE(aces[0], "/a/door", DISCOVERABLE_TRUE));
+
+    AddResource(ace, "*");
+    InvalidateACLIndex(&m_acl);
+    ASSERT_EQ(1u, GetIndexedACEsByConntype(AUTH_CRYPT, &aces));
+    EXPECT_TRUE(IsResourceInIndexedACE(aces[0], "/a/door", DISCOVERABLE_FALSE));
+}
+
+TEST_F(ACLIndexTest, ACLChangeDropsCachedDecisions)
+{
+    OicSecAclDecisionKey_t key;
+    memset(&key, 0, sizeof(key));
+    key.resourceUri = "/a/light";
+    key.permission = PERMISSION_READ;
+    key.secureChannel = true;
+    InvalidateACLIndex(&m_acl);
+
+    SRMAccessResponse_t responseVal = ACCESS_DENIED_POLICY_ENGINE_ERROR;
+    EXPECT_FALSE(GetCachedACLDecision(&key, &responseVal));
+    CacheACLDecision(&key, ACCESS_GRANTED);
+    EXPECT_TRUE(GetCachedACLDecision(&key, &responseVal));
+    EXPECT_EQ((SRMAccessResponse_t)ACCESS_GRANTED, responseVal);
+
+    key.permission = PERMISSION_WRITE;
+    EXPECT_FALSE(GetCachedACLDecision(&key, &responseVal));
+    key.permission = PERMISSION_READ;
+
+    InvalidateACLIndex(&m_acl);
+    EXPECT_FALSE(GetCachedACLDecision(&key, &responseVal));
+}
@@ -0,0 +1,329 @@
+/* *****************************************************************
+ *
+ * Copyright 2017 Open Connectivity Foundation
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string>
+#include "ocstack.h"
+#include "oic_malloc.h"
+#include "cbor.h"
+#include "psinterface.h"
+#include "srmtestcommon.h"
+
+#define PS_TEST_DB_FILE_NAME "psinterfacetest.dat"
+#define PS_TEST_DB_TEMP_FILE_NAME "psinterfacetest.dat.tmp"
+
+static bool g_failWrites = false;
+
+static size_t FailingWrite(const void *ptr, size_t size, size_t nmemb, FILE *stream)
+{
+    // Simulates a power loss after half of the data was written.
+    return fwrite(ptr, size, g_failWrites ? nmemb / 2 : nmemb, stream);
+}
+
+class PSInterfaceTest : public testing::Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            remove(PS_TEST_DB_FILE_NAME);
+            remove(PS_TEST_DB_TEMP_FILE_NAME);
+            g_failWrites = false;
+            // Registering the handler makes the interface forget the old database layout.
+            SetPersistentHandler(&m_ps, true);
+            ResetPSWriteStats();
+        }
+
+        virtual void TearDown()
+        {
+            remove(PS_TEST_DB_FILE_NAME);
+            remove(PS_TEST_DB_TEMP_FILE_NAME);
+        }
+
+        OCStackResult Update(const char *resourceName, const std::string &value)
+        {
+            return UpdateResourceInPS(PS_TEST_DB_FILE_NAME, resourceName,
+                                      (const uint8_t *)value.data(), value.size());
+        }
+
+        std::string Read(const char *resourceName)
+        {
+            uint8_t *data = NULL;
+            size_t size = 0;
+            std::string value;
+            if (OC_STACK_OK == ReadDatabaseFromPS(PS_TEST_DB_FILE_NAME, resourceName, &data, &size))
+            {
+                value.assign((const char *)data, size);
+            }
+            OICFree(data);
+            return value;
+        }
+
+        std::string FileContents()
+        {
+            std::string contents;
+            FILE *fp = fopen(PS_TEST_DB_FILE_NAME, "rb");
+            if (fp)
+            {
+                char buffer[256];
+                size_t size = 0;
+                while (0 < (size = fread(buffer, 1, sizeof(buffer), fp)))
+                {
+                    contents.append(buffer, size);
+                }
+                fclose(fp);
+            }
+            return contents;
+        }
+
+        long FileSize(const char *fileName = PS_TEST_DB_FILE_NAME)
+        {
+            long size = -1;
+            FILE *fp = fopen(fileName, "rb");
+            if (fp)
+            {
+                fseek(fp, 0, SEEK_END);
+                size = ftell(fp);
+                fclose(fp);
+            }
+            return size;
+        }
+
+        OCPersistentStorage m_ps;
+};
+
+TEST_F(PSInterfaceTest, UpdateWithoutDatabaseOrPayload)
+{
+    EXPECT_EQ(OC_STACK_INVALID_PARAM, UpdateResourceInPS(PS_TEST_DB_FILE_NAME, "acl", NULL, 0));
+    EXPECT_EQ(OC_STACK_INVALID_PARAM, UpdateResourceInPS(NULL, "acl", NULL, 0));
+}
+
+TEST_F(PSInterfaceTest, UpdatesAreAppended)
+{
+    ASSERT_EQ(OC_STACK_OK, Update("pstat", "pstat-1"));
+    ASSERT_EQ(OC_STACK_OK, Update("doxm", "doxm-1"));
+    long size = FileSize();
+    ASSERT_EQ(OC_STACK_OK, Update("pstat", "pstat-2"));
+    EXPECT_LT(size, FileSize());
+
+    EXPECT_EQ("pstat-2", Read("pstat"));
+    EXPECT_EQ("doxm-1", Read("doxm"));
+
+    PSWriteStats stats;
+    GetPSWriteStats(&stats);
+    EXPECT_EQ(3u, stats.updates);
+    EXPECT_EQ(1u, stats.fullWrites);
+    EXPECT_EQ((uint64_t)FileSize(), stats.writtenBytes);
+}
+
+TEST_F(PSInterfaceTest, RemoveResource)
+{
+    ASSERT_EQ(OC_STACK_OK, Update("doxm", "doxm-1"));
+    ASSERT_EQ(OC_STACK_OK, Update("pstat", "pstat-1"));
+    EXPECT_EQ("pstat-1", Read("pstat"));
+
+    // A removal appends a null record.
+    ResetPSWriteStats();
+    long size = FileSize();
+    ASSERT_EQ(OC_STACK_OK, UpdateResourceInPS(PS_TEST_DB_FILE_NAME, "pstat", NULL, 0));
+    EXPECT_LT(size, FileSize());
+    uint8_t *data = NULL;
+    size_t dataSize = 0;
+    EXPECT_NE(OC_STACK_OK, ReadDatabaseFromPS(PS_TEST_DB_FILE_NAME, "pstat", &data, &dataSize));
+    EXPECT_TRUE(NULL == data);
+    EXPECT_EQ("doxm-1", Read("doxm"));
+
+    PSWriteStats stats;
+    GetPSWriteStats(&stats);
+    EXPECT_EQ(0u, stats.fullWrites);
+
+    // The removal survives a rewrite of the database.
+    ResetPSDatabaseStates();
+    ASSERT_EQ(OC_STACK_OK, Update("doxm", "doxm-2"));
+    EXPECT_EQ(std::string::npos, FileContents().find("pstat-1"));
+    EXPECT_EQ("", Read("pstat"));
+    EXPECT_EQ("doxm-2", Read("doxm"));
+}
+
+TEST_F(PSInterfaceTest, SensitiveUpdatesAreAppended)
+{
+    ASSERT_EQ(OC_STACK_OK, Update("doxm", "doxm-1"));
+    ASSERT_EQ(OC_STACK_OK, Update("cred", "cred-secret-1"));
+    ASSERT_EQ(OC_STACK_OK, Update("acl", "acl-secret-1"));
+    ASSERT_EQ(OC_STACK_OK, Update("amacl", "amacl-secret-1"));
+    ASSERT_EQ(OC_STACK_OK, Update("cred", "cred-secret-2"));
+    ASSERT_EQ(OC_STACK_OK, Update("acl", "acl-secret-2"));
+    ASSERT_EQ(OC_STACK_OK, UpdateResourceInPS(PS_TEST_DB_FILE_NAME, "amacl", NULL, 0));
+
+    EXPECT_EQ("cred-secret-2", Read("cred"));
+    EXPECT_EQ("acl-secret-2", Read("acl"));
+    EXPECT_EQ("", Read("amacl"));
+    EXPECT_EQ("doxm-1", Read("doxm"));
+
+    PSWriteStats stats;
+    GetPSWriteStats(&stats);
+    EXPECT_EQ(1u, stats.fullWrites);
+}
+
+TEST_F(PSInterfaceTest, CompactionDropsReplacedSecrets)
+{
+    ASSERT_EQ(OC_STACK_OK, Update("doxm", "doxm-1"));
+    ASSERT_EQ(OC_STACK_OK, Update("cred", "cred-secret-1"));
+    ResetPSWriteStats();
+
+    std::string cred(100, 'c');
+    PSWriteStats stats;
+    for (int i = 0; (i < 100) && (0 == stats.fullWrites); i++)
+    {
+        ASSERT_EQ(OC_STACK_OK, Update("cred", cred));
+        GetPSWriteStats(&stats);
+    }
+    ASSERT_EQ(1u, stats.fullWrites);
+
+    std::string contents = FileContents();
+    EXPECT_EQ(std::string::npos, contents.find("cred-secret-1"));
+    EXPECT_EQ(contents.find(cred), contents.rfind(cred));
+    EXPECT_EQ(cred, Read("cred"));
+    EXPECT_EQ("doxm-1", Read("doxm"));
+    EXPECT_EQ(-1, FileSize(PS_TEST_DB_TEMP_FILE_NAME));
+}
+
+TEST_F(PSInterfaceTest, InterruptedRewriteKeepsDatabase)
+{
+    ASSERT_EQ(OC_STACK_OK, Update("doxm", "doxm-1"));
+    ASSERT_EQ(OC_STACK_OK, Update("pstat", "pstat-1"));
+    std::string contents = FileContents();
+
+    // The new handler forgets the layout, so the next update rewrites the database.
+    OCPersistentStorage ps;
+    SetPersistentHandler(&ps, true);
+    ps.write = FailingWrite;
+    ASSERT_EQ(OC_STACK_OK, OCRegisterPersistentStorageHandler(&ps));
+    g_failWrites = true;
+    EXPECT_NE(OC_STACK_OK, Update("pstat", "pstat-2"));
+    g_failWrites = false;
+
+    EXPECT_EQ(contents, FileContents());
+    EXPECT_EQ(-1, FileSize(PS_TEST_DB_TEMP_FILE_NAME));
+    EXPECT_EQ("pstat-1", Read("pstat"));
+    ASSERT_EQ(OC_STACK_OK, Update("pstat", "pstat-2"));
+    EXPECT_EQ("pstat-2", Read("pstat"));
+    EXPECT_EQ("doxm-1", Read("doxm"));
+    SetPersistentHandler(&m_ps, true);
+}
+
+TEST_F(PSInterfaceTest, HandlerChangeForgetsLayout)
+{
+    ASSERT_EQ(OC_STACK_OK, Update("doxm", "doxm-1"));
+    ASSERT_EQ(OC_STACK_OK, Update("pstat", "pstat-1"));
+
+    // The database may differ behind the new handler, so the next update rewrites it,
+    // in place since the handler cannot rename files.
+    OCPersistentStorage ps;
+    SetPersistentHandler(&ps, true);
+    ps.rename = NULL;
+    ASSERT_EQ(OC_STACK_OK, OCRegisterPersistentStorageHandler(&ps));
+    ResetPSWriteStats();
+    ASSERT_EQ(OC_STACK_OK, Update("pstat", "pstat-2"));
+    EXPECT_EQ("pstat-2", Read("pstat"));
+    EXPECT_EQ("doxm-1", Read("doxm"));
+
+    PSWriteStats stats;
+    GetPSWriteStats(&stats);
+    EXPECT_EQ(1u, stats.fullWrites);
+    SetPersistentHandler(&m_ps, true);
+}
+
+TEST_F(PSInterfaceTest, ReadWholeDatabaseIsSingleMap)
+{
+    ASSERT_EQ(OC_STACK_OK, Update("doxm", "doxm-1"));
+    ASSERT_EQ(OC_STACK_OK, Update("pstat", "pstat-1"));
+    ASSERT_EQ(OC_STACK_OK, Update("doxm", "doxm-2"));
+
+    uint8_t *data = NULL;
+    size_t size = 0;
+    ASSERT_EQ(OC_STACK_OK, ReadDatabaseFromPS(PS_TEST_DB_FILE_NAME, NULL, &data, &size));
+
+    CborParser parser;
+    CborValue cbor;
+    CborValue value;
+    ASSERT_EQ(CborNoError, cbor_parser_init(data, size, 0, &parser, &cbor));
+    ASSERT_EQ(CborNoError, cbor_value_map_find_value(&cbor, "doxm", &value));
+    ASSERT_TRUE(cbor_value_is_byte_string(&value));
+    uint8_t *doxm = NULL;
+    size_t doxmSize = 0;
+    ASSERT_EQ(CborNoError, cbor_value_dup_byte_string(&value, &doxm, &doxmSize, NULL));
+    EXPECT_EQ("doxm-2", std::string((const char *)doxm, doxmSize));
+
+    CborValue next = cbor;
+    ASSERT_EQ(CborNoError, cbor_value_advance(&next));
+    EXPECT_EQ(data + size, cbor_value_get_next_byte(&next));
+
+    OICFree(doxm);
+    OICFree(data);
+}
+
+TEST_F(PSInterfaceTest, IncompleteUpdateIsIgnored)
+{
+    ASSERT_EQ(OC_STACK_OK, Update("pstat", "pstat-1"));
+    ASSERT_EQ(OC_STACK_OK, Update("pstat", "pstat-2"));
+    long size = FileSize();
+
+    // Simulate a power loss while the last update was written.
+    FILE *fp = fopen(PS_TEST_DB_FILE_NAME, "ab");
+    ASSERT_TRUE(NULL != fp);
+    const uint8_t tornRecord[] = { 0xa1, 0x65, 'p', 's', 't', 'a', 't', 0x47, 'p' };
+    ASSERT_EQ(sizeof(tornRecord), fwrite(tornRecord, 1, sizeof(tornRecord), fp));
+    fclose(fp);
+
+    EXPECT_EQ("pstat-2", Read("pstat"));
+
+    // The next update rewrites the database without the incomplete record.
+    ResetPSWriteStats();
+    ASSERT_EQ(OC_STACK_OK, Update("doxm", "doxm-1"));
+    PSWriteStats stats;
+    GetPSWriteStats(&stats);
+    EXPECT_EQ(1u, stats.fullWrites);
+    EXPECT_GE(size + (long)sizeof(tornRecord), FileSize());
+    EXPECT_EQ("pstat-2", Read("pstat"));
+    EXPECT_EQ("doxm-1", Read("doxm"));
+}
+
+TEST_F(PSInterfaceTest, DatabaseIsCompacted)
+{
+    ASSERT_EQ(OC_STACK_OK, Update("cred", std::string(2000, 'c')));
+    ResetPSWriteStats();
+
+    std::string pstat(100, 'p');
+    for (int i = 0; i < 100; i++)
+    {
+        pstat[0] = (char)('a' + i % 26);
+        ASSERT_EQ(OC_STACK_OK, Update("pstat", pstat));
+    }
+    EXPECT_EQ(pstat, Read("pstat"));
+    EXPECT_EQ(std::string(2000, 'c'), Read("cred"));
+
+    PSWriteStats stats;
+    GetPSWriteStats(&stats);
+    EXPECT_EQ(100u, stats.updates);
+    EXPECT_LT(0u, stats.fullWrites);
+    EXPECT_GT(10u, stats.fullWrites);
+    // Rewriting the whole database on every update would write over 20 times the payload.
+    EXPECT_GT(3 * stats.payloadBytes, stats.writtenBytes);
+}
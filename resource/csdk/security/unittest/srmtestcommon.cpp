@@ -164,6 +164,7 @@ void SetPersistentHandler(OCPersistentStorage *ps, bool set)
         ps->write = fwrite;
         ps->close = fclose;
         ps->unlink = remove;
+        ps->rename = rename;
     }
     else
     {
@@ -128,6 +128,13 @@ typedef struct ClientCB {
      * can be explicitly cancelled.*/
     uint32_t TTL;
 
+    /** Neighbours in the list of callbacks ordered by TTL. Only used when TTL is not 0.*/
+    struct ClientCB    *ttlPrev;
+    struct ClientCB    *ttlNext;
+
+    /** previous node in this list.*/
+    struct ClientCB    *prev;
+
     /** next node in this list.*/
     struct ClientCB    *next;
 } ClientCB;
@@ -135,7 +142,7 @@ typedef struct ClientCB {
 //TODO: Now ocstack is directly accessing the clientCB list to process presence.
 //      It should be avoided after we make a presence feature separately.
 /**
- * Linked list of ClientCB node.
+ * Doubly linked list of ClientCB node.
  */
 extern struct ClientCB *g_cbList;
 
@@ -194,6 +201,15 @@ void DeleteClientCB(ClientCB *cbNode);
  */
 void DeleteClientCBList();
 
+/**
+ * This method is used to change the TTL of a cb node. The TTL must not be changed directly
+ * since the cb nodes are kept ordered by TTL.
+ *
+ * @param[in]  cbNode               Address to client callback node.
+ * @param[in]  ttl                  time to live in coap_ticks for the callback.
+ */
+void SetClientCBTTL(ClientCB *cbNode, uint32_t ttl);
+
 /**
  * This method is used to search and retrieve a cb node in cbList using token.
  *
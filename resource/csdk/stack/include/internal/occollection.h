@@ -24,11 +24,20 @@
 #include "ocstack.h"
 #include "ocresourcehandler.h"
 
-uint8_t GetNumOfResourcesInCollection(const OCResource *resource);
+size_t GetNumOfResourcesInCollection(const OCResource *resource);
 
 OCStackResult DefaultCollectionEntityHandler (OCEntityHandlerFlag flag,
                                               OCEntityHandlerRequest *entityHandlerRequest);
 
+/**
+ * Passes a batch request on to the child resources that did not get it yet, as far as the
+ * batch concurrency limit of the collection allows. Called from ProcessBatchContinuations
+ * after a child resource responded.
+ *
+ * @param request   Batch request to a collection.
+ */
+void ContinueBatchRequest(OCServerRequest *request);
+
 OCStackResult BuildCollectionLinksPayloadValue(const char* resourceUri,
                            OCRepPayloadValue** linksRepPayloadValue, OCDevAddr* devAddr);
 
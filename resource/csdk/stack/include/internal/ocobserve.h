@@ -92,6 +92,9 @@ typedef struct ResourceObserver
     /** next node in this list.*/
     struct ResourceObserver *next;
 
+    /** next observer of the same resource.*/
+    struct ResourceObserver *resourceNext;
+
     /** requested payload encoding format. */
     OCPayloadFormat acceptFormat;
 
@@ -102,7 +105,9 @@ typedef struct ResourceObserver
 
 #ifdef WITH_PRESENCE
 /**
- * Create an observe response and send to all observers in the observe list.
+ * Create an observe response and send to all observers of the resource.
+ * The entity handler is called once for each group of observers that share the same query,
+ * accept format and accept version; its encoded response is reused for the rest of the group.
  *
  * @param method          RESTful method.
  * @param resPtr          Observed resource.
@@ -116,7 +121,9 @@ OCStackResult SendAllObserverNotification (OCMethod method, OCResource *resPtr,
         OCPresenceTrigger trigger, OCResourceType *resourceType, OCQualityOfService qos);
 #else
 /**
- * Create an observe response and send to all observers in the observe list.
+ * Create an observe response and send to all observers of the resource.
+ * The entity handler is called once for each group of observers that share the same query,
+ * accept format and accept version; its encoded response is reused for the rest of the group.
  *
  * @param method RESTful method.
  * @param resPtr Observed resource.
@@ -208,6 +215,16 @@ OCStackResult AddObserver (const char         *resUri,
   */
 OCStackResult DeleteObserverUsingDevAddr(const OCDevAddr *devAddr);
 
+/**
+ * Delete all observers of a resource that is about to be deleted.
+ * Free memory that was allocated for the observers in the list.
+ *
+ * @param resource Observed resource.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult DeleteObserverUsingResource(OCResource *resource);
+
 /**
  * Search the list of observers for the specified token.
  *
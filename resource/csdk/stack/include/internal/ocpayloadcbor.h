@@ -22,18 +22,50 @@
 #define OC_PAYLOAD_CBOR_H
 
 #include "octypes.h"
+#include "cacommon.h"
 #include <cbor.h>
 
+/**
+ * Size of an encode buffer. A payload that fits into a single CoAP PDU fits into it;
+ * larger ones are sent blockwise and are encoded into an allocation.
+ */
+#define OC_ENCODE_BUFFER_SIZE (COAP_MAX_PDU_SIZE)
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
+/**
+ * Parses a received payload into a new payload tree.
+ *
+ * Every name, value and nested payload of the tree is a separate allocation that
+ * doesn't refer to the received buffer. Applications replace values through
+ * OCRepPayloadSet*, free parts with OICFree and keep parts after the buffer is gone.
+ * The tree is freed with OCPayloadDestroy.
+ */
 OCStackResult OCParsePayload(OCPayload** outPayload, OCPayloadFormat format, OCPayloadType type,
         const uint8_t* payload, size_t payloadSize);
 
 OCStackResult OCConvertPayload(OCPayload* payload, OCPayloadFormat format,
         uint8_t** outPayload, size_t* size);
 
+/**
+ * Encodes a payload into a caller-provided buffer if it fits, otherwise into an
+ * allocation of the exact encoded size.
+ *
+ * @param payload     payload to encode.
+ * @param format      encoding format.
+ * @param buffer      buffer to encode into; may be NULL.
+ * @param bufferSize  size of buffer.
+ * @param outPayload  out param; set to buffer or to allocated memory, which the caller
+ *                    must release with OICFree() when it is not buffer.
+ * @param size        out param; set to the encoded size.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult OCConvertPayloadToBuffer(OCPayload *payload, OCPayloadFormat format,
+        uint8_t *buffer, size_t bufferSize, uint8_t **outPayload, size_t *size);
+
 #ifdef __cplusplus
 }
 #endif
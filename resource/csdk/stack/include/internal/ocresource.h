@@ -66,6 +66,8 @@ typedef struct PRESENCERESOURCE{
 
 struct rsrc_t;
 
+struct ResourceObserver;
+
 /**
  * following structure will be created in occollection.
  */
@@ -210,6 +212,9 @@ typedef struct OCResource {
     /** Child resource(s); linked list.*/
     OCChildResource *rsrcChildResourcesHead;
 
+    /** Max number of child resources handling a batch request at a time; 0 for no limit.*/
+    uint16_t batchConcurrency;
+
     /** Pointer to function that handles the entity bound to the resource.
      *  This handler has to be explicitly defined by the programmer.*/
     OCEntityHandler entityHandler;
@@ -247,6 +252,12 @@ typedef struct OCResource {
 
     /** Resource endpoint type(s). */
     OCTpsSchemeFlags endpointType;
+
+    /** Position in registration order; assigned by the resource index.*/
+    uint64_t indexOrder;
+
+    /** Observers of this resource; linked list through ResourceObserver::resourceNext.*/
+    struct ResourceObserver *observersHead;
 } OCResource;
 
 
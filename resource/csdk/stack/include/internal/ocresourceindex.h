@@ -0,0 +1,147 @@
+//******************************************************************
+//
+// Copyright 2017 Open Connectivity Foundation
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/**
+ * @file
+ *
+ * This file contains the APIs of the resource index. The index mirrors the
+ * headResource list and provides constant time lookup of a resource by URI
+ * or handle, plus per resource type and per interface lists kept in
+ * registration order for discovery filtering.
+ */
+
+#ifndef OC_RESOURCE_INDEX_H_
+#define OC_RESOURCE_INDEX_H_
+
+#include "ocresource.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Adds a resource to the index. The resource URI must already be set.
+ *
+ * @param resource  Resource to add.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult AddResourceToIndex(OCResource *resource);
+
+/**
+ * Removes a resource and all its resource type and interface bindings from the index.
+ * Does nothing if the resource is not indexed.
+ *
+ * @param resource  Resource to remove.
+ */
+void RemoveResourceFromIndex(OCResource *resource);
+
+/**
+ * Records that a resource type was bound to an indexed resource.
+ *
+ * @param resource          Indexed resource.
+ * @param resourceTypeName  Name of the bound resource type.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult AddResourceTypeToIndex(OCResource *resource, const char *resourceTypeName);
+
+/**
+ * Records that an interface was bound to an indexed resource.
+ *
+ * @param resource       Indexed resource.
+ * @param interfaceName  Name of the bound interface.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult AddResourceInterfaceToIndex(OCResource *resource, const char *interfaceName);
+
+/**
+ * Releases all memory held by the index.
+ */
+void TerminateResourceIndex();
+
+/**
+ * Finds an indexed resource by URI.
+ *
+ * @param uri  URI of the resource.
+ *
+ * @return Pointer to the resource, NULL if not found.
+ */
+OCResource *FindIndexedResourceByUri(const char *uri);
+
+/**
+ * Checks whether a handle refers to an indexed resource, without dereferencing it.
+ *
+ * @param resource  Handle to check.
+ *
+ * @return true if @p resource is indexed.
+ */
+bool IsResourceIndexed(const OCResource *resource);
+
+/**
+ * Number of indexed resources.
+ */
+size_t GetIndexedResourceCount();
+
+/**
+ * Gets the resource at a given position in registration order.
+ *
+ * @param index  Position of the resource.
+ *
+ * @return Pointer to the resource, NULL if @p index is out of range.
+ */
+OCResource *GetIndexedResourceAt(size_t index);
+
+/**
+ * Gets all indexed resources in registration order.
+ *
+ * @param resources  Out param; set to an array owned by the index, valid until the
+ *                   next resource registration change.
+ *
+ * @return Number of entries in @p resources.
+ */
+size_t GetIndexedResources(OCResource * const **resources);
+
+/**
+ * Gets the resources bound to a resource type in registration order.
+ *
+ * @param resourceTypeName  Resource type to look for.
+ * @param resources         Out param; see ::GetIndexedResources.
+ *
+ * @return Number of entries in @p resources, 0 if none.
+ */
+size_t GetIndexedResourcesByType(const char *resourceTypeName, OCResource * const **resources);
+
+/**
+ * Gets the resources bound to an interface in registration order.
+ *
+ * @param interfaceName  Interface to look for.
+ * @param resources      Out param; see ::GetIndexedResources.
+ *
+ * @return Number of entries in @p resources, 0 if none.
+ */
+size_t GetIndexedResourcesByInterface(const char *interfaceName, OCResource * const **resources);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OC_RESOURCE_INDEX_H_
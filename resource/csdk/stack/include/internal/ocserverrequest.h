@@ -46,6 +46,37 @@ extern "C"
  */
 typedef OCStackResult (* OCEHResponseHandler)(OCEntityHandlerResponse * ehResponse);
 
+/**
+ * Encoded response of an entity handler, shared by the notifications sent to all observers
+ * of a resource that use the same query, accept format and accept version.
+ */
+typedef struct OCEncodedNotification
+{
+    /** Set once a response has been captured.*/
+    bool captured;
+
+    /** Entity handler response, without its payload.*/
+    OCEntityHandlerResponse ehResponse;
+
+    /** Response code of the captured response.*/
+    CAResponseResult_t result;
+
+    /** Encoded payload; owned by this structure.*/
+    CAPayload_t payload;
+
+    /** Size of the encoded payload.*/
+    size_t payloadSize;
+
+    /** Format of the encoded payload.*/
+    CAPayloadFormat_t payloadFormat;
+
+    /** Version of the encoded payload format.*/
+    uint16_t payloadVersion;
+
+    /** Whether the response is sent as multicast.*/
+    bool isMulticast;
+} OCEncodedNotification;
+
 /**
  * following structure will be created in occoap and passed up the stack on the server side.
  */
@@ -77,7 +108,7 @@ typedef struct OCServerRequest
     OCStackResult observeResult;
 
     /** number of Responses.*/
-    uint8_t numResponses;
+    uint32_t numResponses;
 
     /** Response Entity Handler .*/
     OCEHResponseHandler ehResponseHandler;
@@ -118,6 +149,25 @@ typedef struct OCServerRequest
     /** Flag indicating notification.*/
     uint8_t notificationFlag;
 
+    /** When set, the encoded response is stored here for reuse by other observers.*/
+    OCEncodedNotification *encodedNotification;
+
+    /** Collection whose child resources a batch request is passed on to.*/
+    struct OCResource *batchCollection;
+
+    /** Index of the next child resource to pass a batch request on to.*/
+    uint32_t batchNext;
+
+    /** Number of child resources that did not get a batch request yet.*/
+    uint32_t batchPending;
+
+    /** Flag indicating a batch request is being passed on to child resources.*/
+    uint8_t batchDispatching;
+
+    /** Flag indicating a batch request waits for the stack thread to pass it on to more
+     *  child resources. Set by the thread responding, so only changed atomically.*/
+    volatile int32_t batchContinue;
+
     /** Payload format retrieved from the received request PDU. */
     OCPayloadFormat payloadFormat;
 
@@ -144,6 +194,9 @@ typedef struct OCServerResponse
     /** this is the pointer to server payload data to be transferred.*/
     OCPayload* payload;
 
+    /** Last aggregated payload, the next response fragment is appended to it.*/
+    OCRepPayload* lastPayload;
+
     /** Remaining size of the payload data to be transferred.*/
     uint16_t remainingPayloadSize;
 
@@ -236,6 +289,26 @@ void DeleteServerRequest(OCServerRequest * serverRequest);
  */
 OCStackResult HandleSingleResponse(OCEntityHandlerResponse * ehResponse);
 
+/**
+ * Send a notification reusing a response that was captured and encoded for another
+ * observer of the same representation. The entity handler is not called.
+ *
+ * @param[in]  request        Notification request of the observer.
+ * @param[in]  notification   Captured response.
+ *
+ * @return
+ *     ::OCStackResult
+ */
+OCStackResult SendEncodedNotification(OCServerRequest *request,
+                                      const OCEncodedNotification *notification);
+
+/**
+ * Release the payload held by a captured notification and reset it.
+ *
+ * @param[in]  notification   Notification to clear.
+ */
+void ClearEncodedNotification(OCEncodedNotification *notification);
+
 /**
  * Handler function for sending a response from multiple resources, such as a collection.
  * Aggregates responses from multiple resource until all responses are received then sends the
@@ -250,6 +323,20 @@ OCStackResult HandleSingleResponse(OCEntityHandlerResponse * ehResponse);
  */
 OCStackResult HandleAggregateResponse(OCEntityHandlerResponse * ehResponse);
 
+/**
+ * Pass the batch requests whose child resources responded with ::OCDoResponse on to the
+ * child resources that did not get them yet. Called from OCProcess, so that the entity
+ * handlers of the children run on the stack thread and not on the thread responding.
+ */
+void ProcessBatchContinuations();
+
+/**
+ * Check if batch requests wait for ProcessBatchContinuations.
+ *
+ * @return true if batch requests wait, otherwise false.
+ */
+bool HasBatchContinuations();
+
 /**
  * Form the OCEntityHandlerRequest struct that is passed to a resource's entity handler
  *
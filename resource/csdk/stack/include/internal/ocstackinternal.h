@@ -95,7 +95,7 @@ typedef struct
     /** resource query send by client.*/
     char query[MAX_QUERY_LENGTH];
 
-    /** reqJSON is retrieved from the payload of the received request PDU.*/
+    /** Payload of the received request PDU; borrowed from the CA request info.*/
     uint8_t *payload;
 
     /** qos is indicating if the request is CON or NON.*/
@@ -110,7 +110,7 @@ typedef struct
     /** Remote end-point address **/
     OCDevAddr devAddr;
 
-    /** Token for the observe request.*/
+    /** Token for the observe request; borrowed from the CA request info.*/
     CAToken_t requestToken;
 
     /** token length.*/
@@ -178,6 +178,14 @@ OCStackResult OCStackFeedBack(CAToken_t token, uint8_t tokenLength, uint8_t stat
  */
 OCStackResult HandleStackRequests(OCServerProtocolRequest * protocolRequest);
 
+/**
+ * Handler function for a request received from CA.
+ *
+ * @param endPoint       Endpoint the request was received from.
+ * @param requestInfo    Request received from CA.
+ */
+void OCHandleRequests(const CAEndpoint_t* endPoint, const CARequestInfo_t* requestInfo);
+
 OCStackResult SendDirectStackResponse(const CAEndpoint_t* endPoint, const uint16_t coapID,
         const CAResponseResult_t responseResult, const CAMessageType_t type,
         const uint8_t numOptions, const CAHeaderOption_t *options,
@@ -324,6 +332,14 @@ OCStackResult OCUpdateResourceInsWithResponse(const char *requestUri,
                                               const OCClientResponse *response);
 #endif
 
+#ifdef RD_SERVER
+/**
+ * Closes the RD database connection used to answer discovery requests. It is opened
+ * again by the next discovery request.
+ */
+void OCRDDatabaseDiscoveryClose();
+#endif
+
 /**
  * Delete all of the dynamically allocated elements that were created for the resource attributes.
  *
@@ -68,8 +68,19 @@ OCStackResult TerminateKeepAlive(OCMode mode);
 
 /**
  * Process the KeepAlive timer to send ping message to OIC Server.
+ * @param[in,out]   nextEventTime   Lowered to the milliseconds until the next KeepAlive
+ *                                  timer is due; NULL if not needed.
  */
-void ProcessKeepAlive();
+void ProcessKeepAlive(uint32_t *nextEventTime);
+
+/**
+ * Process the KeepAlive timers that are due at the given time.
+ * ProcessKeepAlive calls it with the current time.
+ * @param[in]       currentTime     Time to process the timers at. in microseconds.
+ * @param[in,out]   nextEventTime   Lowered to the milliseconds until the next KeepAlive
+ *                                  timer is due; NULL if not needed.
+ */
+void ProcessKeepAliveTimers(uint64_t currentTime, uint32_t *nextEventTime);
 
 /**
  * This API will be called from RI layer whenever there is a request for KeepAlive.
@@ -33,6 +33,9 @@
 #include "octypes.h"
 
 #include "platform_features.h"
+#ifdef WITH_PROCESS_EVENT
+#include "ocevent.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -130,6 +133,32 @@ OCStackResult OC_CALL OCStopMulticastServer();
  */
 OCStackResult OC_CALL OCProcess();
 
+#ifdef WITH_PROCESS_EVENT
+/**
+ * Event driven variant of ::OCProcess. Does the same processing and reports when it has
+ * to be called again; the event registered with ::OCRegisterProcessEvent is signaled if
+ * that is needed sooner, e.g. when a message is received.
+ *
+ * @param nextEventTime  Set to the number of milliseconds until the next timer of the stack
+ *                       is due, UINT32_MAX if there is none.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult OC_CALL OCProcessEvent(uint32_t *nextEventTime);
+
+/**
+ * Register an event to be signaled whenever ::OCProcessEvent has to be called.
+ * Typically the thread calling ::OCProcessEvent waits on the event for at most the
+ * returned nextEventTime.
+ *
+ * Once this returns, no thread signals the previously registered event any more, so it
+ * can be freed.
+ *
+ * @param event  Event to signal, NULL to unregister.
+ */
+void OC_CALL OCRegisterProcessEvent(oc_event event);
+#endif // WITH_PROCESS_EVENT
+
 /**
  * This function discovers or Perform requests on a specified resource
  * (specified by that Resource's respective URI).
@@ -240,7 +269,9 @@ OCStackResult OC_CALL OCCancel(OCDoHandle handle,
 
 /**
  * Register Persistent storage callback.
- * @param   persistentStorageHandler  Pointers to open, read, write, close & unlink handlers.
+ * @param   persistentStorageHandler  Pointers to open, read, write, close & unlink handlers,
+ *                                    and optionally a rename handler. See ::OCPersistentStorage
+ *                                    for the modes the open handler must support.
  *
  * @return
  *     OC_STACK_OK                    No errors; Success.
@@ -416,6 +447,23 @@ OCStackResult OC_CALL OCBindResource(OCResourceHandle collectionHandle, OCResour
  */
 OCStackResult OC_CALL OCUnBindResource(OCResourceHandle collectionHandle, OCResourceHandle resourceHandle);
 
+/**
+ * This function limits how many resources of a collection handle a batch request at a time.
+ * The resources that return ::OC_EH_SLOW and respond later with ::OCDoResponse handle a batch
+ * request concurrently; once one of them has responded, the remaining resources get the
+ * request on the next ::OCProcess call, so that their entity handlers run on the stack thread.
+ * The stack does not run entity handlers on worker threads; this only caps how many of the
+ * slow resources work on a batch request at the same time.
+ *
+ * @param collectionHandle   Handle to the collection resource.
+ * @param maxConcurrency     Max number of resources handling a batch request at a time,
+ *                           0 for no limit (default).
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult OC_CALL OCSetCollectionBatchConcurrency(OCResourceHandle collectionHandle,
+                                                      uint16_t maxConcurrency);
+
 /**
  * This function binds a resource type to a resource.
  *
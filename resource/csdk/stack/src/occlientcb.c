@@ -24,6 +24,7 @@
 #include "logger.h"
 #include "trace.h"
 #include "oic_malloc.h"
+#include "ochashmap.h"
 #include <string.h>
 
 #ifdef HAVE_SYS_TIME_H
@@ -46,9 +47,166 @@
 //      This should be static variable after we make a presence feature separately.
 struct ClientCB *g_cbList = NULL;
 
+/** ClientCB -> ClientCB, keyed by token. */
+static oc_hashmap g_cbByToken = NULL;
+
+/** OCDoHandle -> ClientCB. */
+static oc_hashmap g_cbByHandle = NULL;
+
+/** ClientCB -> ClientCB, used to validate nodes passed to DeleteClientCB. */
+static oc_hashmap g_cbByNode = NULL;
+
+/** Callbacks with a non-zero TTL, in order of expiry. */
+static ClientCB *g_cbDeadlineHead = NULL;
+static ClientCB *g_cbDeadlineTail = NULL;
+
 //-------------------------------------------------------------------------------------------------
 // Local functions
 //-------------------------------------------------------------------------------------------------
+static uint32_t HashClientCBToken(const void *key)
+{
+    const ClientCB *cbNode = (const ClientCB *)key;
+    return oc_hashmap_hash_bytes(cbNode->token, cbNode->tokenLength, 0);
+}
+
+static bool EqualClientCBToken(const void *key1, const void *key2)
+{
+    const ClientCB *cbNode1 = (const ClientCB *)key1;
+    const ClientCB *cbNode2 = (const ClientCB *)key2;
+    return (cbNode1->tokenLength == cbNode2->tokenLength) &&
+           (memcmp(cbNode1->token, cbNode2->token, cbNode1->tokenLength) == 0);
+}
+
+static void TerminateClientCBIndex()
+{
+    oc_hashmap_free(g_cbByToken);
+    oc_hashmap_free(g_cbByHandle);
+    oc_hashmap_free(g_cbByNode);
+    g_cbByToken = NULL;
+    g_cbByHandle = NULL;
+    g_cbByNode = NULL;
+    g_cbDeadlineHead = NULL;
+    g_cbDeadlineTail = NULL;
+}
+
+static bool EnsureClientCBIndex()
+{
+    if (g_cbByToken)
+    {
+        return true;
+    }
+
+    g_cbByToken = oc_hashmap_new(HashClientCBToken, EqualClientCBToken);
+    g_cbByHandle = oc_hashmap_new(oc_hashmap_hash_pointer, oc_hashmap_equal_pointer);
+    g_cbByNode = oc_hashmap_new(oc_hashmap_hash_pointer, oc_hashmap_equal_pointer);
+
+    if (!g_cbByToken || !g_cbByHandle || !g_cbByNode)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to create client callback index");
+        TerminateClientCBIndex();
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Removes the node from the maps. A map entry is only removed if it refers to this
+ * node, since a later node with the same token replaces an earlier one.
+ */
+static void RemoveClientCBFromIndex(ClientCB *cbNode)
+{
+    if (oc_hashmap_get(g_cbByToken, cbNode) == cbNode)
+    {
+        oc_hashmap_remove(g_cbByToken, cbNode);
+    }
+    if (oc_hashmap_get(g_cbByHandle, cbNode->handle) == cbNode)
+    {
+        oc_hashmap_remove(g_cbByHandle, cbNode->handle);
+    }
+    oc_hashmap_remove(g_cbByNode, cbNode);
+}
+
+static bool AddClientCBToIndex(ClientCB *cbNode)
+{
+    if (!EnsureClientCBIndex())
+    {
+        return false;
+    }
+
+    if (!oc_hashmap_put(g_cbByNode, cbNode, cbNode) ||
+        !oc_hashmap_put(g_cbByToken, cbNode, cbNode) ||
+        !oc_hashmap_put(g_cbByHandle, cbNode->handle, cbNode))
+    {
+        RemoveClientCBFromIndex(cbNode);
+        return false;
+    }
+    return true;
+}
+
+static void RemoveClientCBDeadline(ClientCB *cbNode)
+{
+    if (cbNode->TTL == 0)
+    {
+        return;
+    }
+
+    if (cbNode->ttlPrev)
+    {
+        cbNode->ttlPrev->ttlNext = cbNode->ttlNext;
+    }
+    else
+    {
+        g_cbDeadlineHead = cbNode->ttlNext;
+    }
+    if (cbNode->ttlNext)
+    {
+        cbNode->ttlNext->ttlPrev = cbNode->ttlPrev;
+    }
+    else
+    {
+        g_cbDeadlineTail = cbNode->ttlPrev;
+    }
+    cbNode->ttlPrev = NULL;
+    cbNode->ttlNext = NULL;
+}
+
+/*
+ * Inserts the node into the deadline list. Deadlines are usually extended by the same
+ * timeout, so the position is searched from the tail.
+ */
+static void InsertClientCBDeadline(ClientCB *cbNode)
+{
+    if (cbNode->TTL == 0)
+    {
+        return;
+    }
+
+    ClientCB *prev = g_cbDeadlineTail;
+    while (prev && prev->TTL > cbNode->TTL)
+    {
+        prev = prev->ttlPrev;
+    }
+
+    cbNode->ttlPrev = prev;
+    cbNode->ttlNext = prev ? prev->ttlNext : g_cbDeadlineHead;
+    if (cbNode->ttlNext)
+    {
+        cbNode->ttlNext->ttlPrev = cbNode;
+    }
+    else
+    {
+        g_cbDeadlineTail = cbNode;
+    }
+    if (prev)
+    {
+        prev->ttlNext = cbNode;
+    }
+    else
+    {
+        g_cbDeadlineHead = cbNode;
+    }
+}
+
 static void DeleteClientCBInternal(ClientCB * cbNode)
 {
     assert(cbNode);
@@ -59,7 +217,9 @@ static void DeleteClientCBInternal(ClientCB * cbNode)
     OIC_TRACE_BUFFER("OIC_RI_CLIENTCB:DeleteClientCB:token:",
                      (const uint8_t *)cbNode->token, cbNode->tokenLength);
 
-    LL_DELETE(g_cbList, cbNode);
+    RemoveClientCBFromIndex(cbNode);
+    RemoveClientCBDeadline(cbNode);
+    DL_DELETE(g_cbList, cbNode);
     CADestroyToken(cbNode->token);
     OICFree(cbNode->devAddr);
     OICFree(cbNode->handle);
@@ -109,27 +269,32 @@ static void DeleteClientCBInternal(ClientCB * cbNode)
 }
 
 /*
- * This function checks if the node is past its time to live and
- * deletes it if timed-out. Calling this function with a  presence or observe
- * callback with ttl set to 0 will not delete anything as presence nodes have
- * their own mechanisms for timeouts. A null argument will cause the function to
- * silently return.
+ * This function deletes the nodes that are past their time to live. Presence and observe
+ * callbacks have a ttl of 0 and are never in the deadline list, as presence nodes have
+ * their own mechanisms for timeouts. The node passed as keep is not deleted, so that a
+ * callback that was just looked up stays valid for the caller. The delete callback of a
+ * node may delete other nodes, so the list is walked again from its head.
  */
-static void CheckAndDeleteTimedOutCB(ClientCB * cbNode)
+static void DeleteTimedOutCBs(const ClientCB *keep)
 {
-    assert(cbNode);
-
-    if (cbNode->TTL == 0)
+    if (!g_cbDeadlineHead)
     {
         return;
     }
     coap_tick_t now;
     coap_ticks(&now);
 
-    if (cbNode->TTL < now)
+    ClientCB *cbNode = g_cbDeadlineHead;
+    while (cbNode && cbNode->TTL < now)
     {
+        if (cbNode == keep)
+        {
+            cbNode = cbNode->ttlNext;
+            continue;
+        }
         OIC_LOG(INFO, TAG, "Deleting timed-out callback");
         DeleteClientCBInternal(cbNode);
+        cbNode = g_cbDeadlineHead;
     }
 }
 
@@ -190,7 +355,7 @@ OCStackResult AddClientCB(ClientCB** clientCB, OCCallbackData* cbData,
     if (!cbNode)// If it does not already exist, create new node.
 #endif // WITH_PRESENCE
     {
-        cbNode = (ClientCB*) OICMalloc(sizeof(ClientCB));
+        cbNode = (ClientCB*) OICCalloc(1, sizeof(ClientCB));
         if (!cbNode)
         {
             *clientCB = NULL;
@@ -273,9 +438,19 @@ OCStackResult AddClientCB(ClientCB** clientCB, OCCallbackData* cbData,
         }
         cbNode->requestUri = requestUri;    // I own it now
         cbNode->devAddr = devAddr;          // I own it now
+        if (!AddClientCBToIndex(cbNode))
+        {
+            OIC_LOG(ERROR, TAG, "Out of memory");
+            OICFree(cbNode->options);
+            OICFree(cbNode->payload);
+            OICFree(cbNode);
+            *clientCB = NULL;
+            goto exit;
+        }
+        InsertClientCBDeadline(cbNode);
         OIC_LOG_V(INFO, TAG, "Added Callback for uri : %s", requestUri);
         OIC_TRACE_MARK(%s:AddClientCB:uri:%s, TAG, requestUri);
-        LL_APPEND(g_cbList, cbNode);
+        DL_APPEND(g_cbList, cbNode);
         *clientCB = cbNode;
     }
 #ifdef WITH_PRESENCE
@@ -322,30 +497,34 @@ exit:
 
 void DeleteClientCB(ClientCB * cbNode)
 {
-    if (cbNode)
+    // The node may already have been deleted, e.g. by OCCancel from within its callback.
+    if (cbNode && oc_hashmap_get(g_cbByNode, cbNode))
     {
-        ClientCB* out = NULL;
-        ClientCB* tmp = NULL;
-        LL_FOREACH_SAFE(g_cbList, out, tmp)
-        {
-            if (cbNode == out)
-            {
-                DeleteClientCBInternal(out);
-                break;
-            }
-        }
+        DeleteClientCBInternal(cbNode);
     }
 }
 
 void DeleteClientCBList()
 {
-    ClientCB* out = NULL;
-    ClientCB* tmp = NULL;
-    LL_FOREACH_SAFE(g_cbList, out, tmp)
+    // The delete callback of a node may delete other nodes.
+    while (g_cbList)
     {
-        DeleteClientCBInternal(out);
+        DeleteClientCBInternal(g_cbList);
     }
     g_cbList = NULL;
+    TerminateClientCBIndex();
+}
+
+void SetClientCBTTL(ClientCB *cbNode, uint32_t ttl)
+{
+    if (!cbNode || cbNode->TTL == ttl)
+    {
+        return;
+    }
+
+    RemoveClientCBDeadline(cbNode);
+    cbNode->TTL = ttl;
+    InsertClientCBDeadline(cbNode);
 }
 
 ClientCB* GetClientCBUsingToken(const CAToken_t token,
@@ -360,18 +539,16 @@ ClientCB* GetClientCBUsingToken(const CAToken_t token,
     OIC_LOG (INFO, TAG, "Looking for token");
     OIC_LOG_BUFFER(INFO, TAG, (const uint8_t *)token, tokenLength);
 
-    ClientCB* out = NULL;
-    ClientCB* tmp = NULL;
-    LL_FOREACH_SAFE(g_cbList, out, tmp)
+    ClientCB key;
+    key.token = token;
+    key.tokenLength = tokenLength;
+    ClientCB *out = (ClientCB *)oc_hashmap_get(g_cbByToken, &key);
+    DeleteTimedOutCBs(out);
+
+    if (out)
     {
-        /* de-annotate below line if want to see all token in g_cbList */
-        //OIC_LOG_BUFFER(INFO, TAG, (const uint8_t *)out->token, tokenLength);
-        if (memcmp(out->token, token, tokenLength) == 0)
-        {
-            OIC_LOG(INFO, TAG, "Found in callback list");
-            return out;
-        }
-        CheckAndDeleteTimedOutCB(out);
+        OIC_LOG(INFO, TAG, "Found in callback list");
+        return out;
     }
 
     OIC_LOG(INFO, TAG, "Callback Not found!");
@@ -388,16 +565,13 @@ ClientCB* GetClientCBUsingHandle(const OCDoHandle handle)
 
     OIC_LOG(INFO, TAG,  "Looking for handle");
 
-    ClientCB* out = NULL;
-    ClientCB* tmp = NULL;
-    LL_FOREACH_SAFE(g_cbList, out, tmp)
+    ClientCB *out = (ClientCB *)oc_hashmap_get(g_cbByHandle, handle);
+    DeleteTimedOutCBs(out);
+
+    if (out)
     {
-        if (out->handle == handle)
-        {
-            OIC_LOG(INFO, TAG, "Found in callback list");
-            return out;
-        }
-        CheckAndDeleteTimedOutCB(out);
+        OIC_LOG(INFO, TAG, "Found in callback list");
+        return out;
     }
 
     OIC_LOG(INFO, TAG, "Callback Not found!");
@@ -416,17 +590,21 @@ ClientCB* GetClientCBUsingUri(const char *requestUri)
     OIC_LOG_V(INFO, TAG, "Looking for uri %s", requestUri);
 
     ClientCB* out = NULL;
-    ClientCB* tmp = NULL;
-    LL_FOREACH_SAFE(g_cbList, out, tmp)
+    DL_FOREACH(g_cbList, out)
     {
         /* de-annotate below line if want to see all uri in g_cbList */
         //OIC_LOG_V(INFO, TAG, "%s", out->requestUri);
         if (out->requestUri && strcmp(out->requestUri, requestUri ) == 0)
         {
-            OIC_LOG(INFO, TAG, "Found in callback list");
-            return out;
+            break;
         }
-        CheckAndDeleteTimedOutCB(out);
+    }
+    DeleteTimedOutCBs(out);
+
+    if (out)
+    {
+        OIC_LOG(INFO, TAG, "Found in callback list");
+        return out;
     }
 
     OIC_LOG(INFO, TAG, "Callback Not found!");
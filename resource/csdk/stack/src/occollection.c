@@ -26,6 +26,8 @@
 // Refer http://pubs.opengroup.org/onlinepubs/009695399/
 #define _POSIX_C_SOURCE 200112L
 
+#include <inttypes.h>
+
 #include "occollection.h"
 #include "ocpayload.h"
 #include "ocstack.h"
@@ -105,9 +107,9 @@ static OCStackResult SendResponse(const OCRepPayload *payload,
     return OCDoResponse(&response);
 }
 
-uint8_t GetNumOfResourcesInCollection(const OCResource *collResource)
+size_t GetNumOfResourcesInCollection(const OCResource *collResource)
 {
-    uint8_t size = 0;
+    size_t size = 0;
     for (OCChildResource *tempChildResource = collResource->rsrcChildResourcesHead;
         tempChildResource; tempChildResource = tempChildResource->next)
     {
@@ -129,7 +131,7 @@ static OCStackResult HandleLinkedListInterface(OCEntityHandlerRequest *ehRequest
         return OC_STACK_INVALID_PARAM;
     }
 
-    uint8_t size = GetNumOfResourcesInCollection(collResource);
+    size_t size = GetNumOfResourcesInCollection(collResource);
     OCRepPayload *colPayload = NULL;
     OCEntityHandlerResult ehResult = OC_EH_ERROR;
     int i = 0;
@@ -190,66 +192,141 @@ exit:
     return ret;
 }
 
-static OCStackResult HandleBatchInterface(OCEntityHandlerRequest *ehRequest)
+/**
+ * Passes a batch request on to the child resources that did not get it yet, until as many of
+ * them are handling it as the batch concurrency limit of the collection allows. Children that
+ * answer slowly are what runs concurrently; the others get the request when one of them
+ * responds, see ContinueBatchRequest.
+ *
+ * @return ::OC_STACK_SLOW_RESOURCE if the response to the request is not complete yet.
+ */
+static OCStackResult DispatchBatchRequest(OCServerRequest *request,
+                                          OCEntityHandlerRequest *ehRequest)
 {
-    if (!ehRequest)
+    OCStackResult stackRet = OC_STACK_OK;
+    OCResource *collResource = request->batchCollection;
+
+    OCChildResource *tempChildResource = collResource->rsrcChildResourcesHead;
+    for (uint32_t i = 0; tempChildResource && i < request->batchNext; i++)
     {
-        return OC_STACK_INVALID_PARAM;
+        tempChildResource = tempChildResource->next;
     }
 
-    OCStackResult stackRet = OC_STACK_OK;
-    char *storeQuery = NULL;
-    OCResource *collResource = (OCResource *)ehRequest->resource;
-
-    if (stackRet == OC_STACK_OK)
+    request->batchDispatching = 1;
+    for (; tempChildResource && request->batchPending; tempChildResource = tempChildResource->next)
     {
+        uint32_t handling = request->numResponses - request->batchPending;
+        if (collResource->batchConcurrency && handling >= collResource->batchConcurrency)
+        {
+            break;
+        }
 
-        if (collResource->rsrcChildResourcesHead)
+        OCResource* tempRsrcResource = tempChildResource->rsrcResource;
+        if (!tempRsrcResource)
         {
-            storeQuery = ehRequest->query;
-            ehRequest->query = NULL;
-            OIC_LOG_V(DEBUG, TAG, "Query : %s", ehRequest->query);
+            break;
         }
 
-        uint8_t numRes = 0;
-        for (OCChildResource *tempChildResource = collResource->rsrcChildResourcesHead;
-            tempChildResource; tempChildResource = tempChildResource->next, numRes++)
+        request->batchNext++;
+        request->batchPending--;
+        bool lastChild = (0 == request->batchPending);
+
+        // Note that all entity handlers called through a collection
+        // will get the same pointer to ehRequest, the only difference
+        // is ehRequest->resource
+        ehRequest->resource = (OCResourceHandle) tempRsrcResource;
+        OCEntityHandlerResult ehResult = tempRsrcResource->entityHandler(OC_REQUEST_FLAG,
+                                   ehRequest, tempRsrcResource->entityHandlerCallbackParam);
+
+        // if a single resource is slow, then entire response will be treated
+        // as slow response
+        if (ehResult == OC_EH_SLOW)
         {
-            OCResource* tempRsrcResource = tempChildResource->rsrcResource;
-            if (tempRsrcResource)
-            {
-                // Note that all entity handlers called through a collection
-                // will get the same pointer to ehRequest, the only difference
-                // is ehRequest->resource
-                ehRequest->resource = (OCResourceHandle) tempRsrcResource;
-                OCEntityHandlerResult ehResult = tempRsrcResource->entityHandler(OC_REQUEST_FLAG,
-                                           ehRequest, tempRsrcResource->entityHandlerCallbackParam);
-
-                // The default collection handler is returning as OK
-                if (stackRet != OC_STACK_SLOW_RESOURCE)
-                {
-                    stackRet = OC_STACK_OK;
-                }
-                // if a single resource is slow, then entire response will be treated
-                // as slow response
-                if (ehResult == OC_EH_SLOW)
-                {
-                    OIC_LOG(INFO, TAG, "This is a slow resource");
-                    ((OCServerRequest *)ehRequest->requestHandle)->slowFlag = 1;
-                    stackRet = EntityHandlerCodeToOCStackCode(ehResult);
-                }
-            }
-            else
-            {
-                break;
-            }
+            OIC_LOG(INFO, TAG, "This is a slow resource");
+            request->slowFlag = 1;
+            stackRet = EntityHandlerCodeToOCStackCode(ehResult);
         }
-        ehRequest->resource = (OCResourceHandle) collResource;
+        else if (lastChild)
+        {
+            // The response of the last child completed and deleted the request.
+            return stackRet;
+        }
+    }
+    request->batchDispatching = 0;
+
+    if (request->batchPending)
+    {
+        OIC_LOG_V(INFO, TAG, "%" PRIu32 " resources wait for batch request", request->batchPending);
+        request->slowFlag = 1;
+        stackRet = OC_STACK_SLOW_RESOURCE;
+    }
+    return stackRet;
+}
+
+static OCStackResult HandleBatchInterface(OCEntityHandlerRequest *ehRequest)
+{
+    if (!ehRequest)
+    {
+        return OC_STACK_INVALID_PARAM;
     }
+
+    OCServerRequest *request = (OCServerRequest *)ehRequest->requestHandle;
+    OCResource *collResource = (OCResource *)ehRequest->resource;
+    if (!collResource->rsrcChildResourcesHead)
+    {
+        return OC_STACK_OK;
+    }
+
+    char *storeQuery = ehRequest->query;
+    ehRequest->query = NULL;
+    OIC_LOG_V(DEBUG, TAG, "Query : %s", ehRequest->query);
+
+    request->batchCollection = collResource;
+    request->batchNext = 0;
+    request->batchPending = request->numResponses;
+    OCStackResult stackRet = DispatchBatchRequest(request, ehRequest);
+
+    ehRequest->resource = (OCResourceHandle) collResource;
     ehRequest->query = storeQuery;
     return stackRet;
 }
 
+void ContinueBatchRequest(OCServerRequest *request)
+{
+    if (!request || !request->batchCollection || request->batchDispatching
+        || !request->batchPending)
+    {
+        return;
+    }
+
+    OCEntityHandlerRequest ehRequest = {0};
+    OCStackResult result = FormOCEntityHandlerRequest(&ehRequest,
+                                     (OCRequestHandle)request,
+                                     request->method,
+                                     &request->devAddr,
+                                     (OCResourceHandle)request->batchCollection,
+                                     NULL,
+                                     PAYLOAD_TYPE_REPRESENTATION,
+                                     request->payloadFormat,
+                                     request->payload,
+                                     request->payloadSize,
+                                     request->numRcvdVendorSpecificHeaderOptions,
+                                     request->rcvdVendorSpecificHeaderOptions,
+                                     (OCObserveAction)(request->notificationFlag ? OC_OBSERVE_NO_OPTION :
+                                                       request->observationOption),
+                                     (OCObservationId)0,
+                                     request->coapID);
+    if (result == OC_STACK_OK)
+    {
+        DispatchBatchRequest(request, &ehRequest);
+    }
+    else
+    {
+        OIC_LOG(ERROR, TAG, "Failed to continue batch request");
+    }
+    OCPayloadDestroy(ehRequest.payload);
+}
+
 OCStackResult DefaultCollectionEntityHandler(OCEntityHandlerFlag flag, OCEntityHandlerRequest *ehRequest)
 {
     if (!ehRequest || !ehRequest->query)
@@ -306,7 +383,7 @@ OCStackResult DefaultCollectionEntityHandler(OCEntityHandlerFlag flag, OCEntityH
         result = BuildCollectionGroupActionCBORResponse(ehRequest->method, (OCResource *) ehRequest->resource, ehRequest);
     }
 exit:
-    if (result != OC_STACK_OK)
+    if (result != OC_STACK_OK && result != OC_STACK_SLOW_RESOURCE)
     {
         result = SendResponse(NULL, ehRequest, OC_EH_BAD_REQ);
     }
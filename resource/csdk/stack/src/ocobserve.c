@@ -31,7 +31,7 @@
 #include "ocserverrequest.h"
 #include "logger.h"
 
-#include <coap/utlist.h>
+#include "utlist.h"
 #include <coap/pdu.h>
 #include <coap/coap.h>
 
@@ -43,6 +43,27 @@
 #define VERIFY_NON_NULL(arg) { if (!arg) {OIC_LOG(FATAL, TAG, #arg " is NULL"); goto exit;} }
 
 static struct ResourceObserver * g_serverObsList = NULL;
+
+/**
+ * Observers of one resource that receive the same representation.
+ */
+typedef struct NotificationGroup
+{
+    /** Query of the observers.*/
+    char *query;
+
+    /** Accept format of the observers.*/
+    OCPayloadFormat acceptFormat;
+
+    /** Accept version of the observers.*/
+    uint16_t acceptVersion;
+
+    /** Response encoded for the first observer of the group.*/
+    OCEncodedNotification encoded;
+
+    /** next node in this list.*/
+    struct NotificationGroup *next;
+} NotificationGroup;
 /**
  * Determine observe QOS based on the QOS of the request.
  * The qos passed as a parameter overrides what the client requested.
@@ -101,11 +122,15 @@ static OCQualityOfService DetermineObserverQoS(OCMethod method,
  *
  * @param observer Observer that need to be notified.
  * @param qos Quality of service of resource.
+ * @param encoded Optional response shared with other observers. If a response was already
+ *                captured, it is sent without calling the entity handler. Otherwise the
+ *                response of the entity handler is captured into it.
  *
  * @return ::OC_STACK_OK on success, some other value upon failure.
  */
 static OCStackResult SendObserveNotification(ResourceObserver *observer,
-                                             OCQualityOfService qos)
+                                             OCQualityOfService qos,
+                                             OCEncodedNotification *encoded)
 {
     OCStackResult result = OC_STACK_ERROR;
     OCServerRequest * request = NULL;
@@ -120,8 +145,16 @@ static OCStackResult SendObserveNotification(ResourceObserver *observer,
     if (request)
     {
         request->observeResult = OC_STACK_OK;
-        if (result == OC_STACK_OK)
+        if (result == OC_STACK_OK && encoded && encoded->captured)
         {
+            result = SendEncodedNotification(request, encoded);
+            // Reset Observer TTL.
+            observer->TTL = GetTicks(MAX_OBSERVER_TTL_SECONDS * MILLISECONDS_PER_SECOND);
+        }
+        else if (result == OC_STACK_OK)
+        {
+            request->encodedNotification = encoded;
+
             ResourceHandling resHandling = OC_RESOURCE_VIRTUAL;
             OCResource *resource = NULL;
             result = DetermineResourceHandling (request, &resHandling, &resource);
@@ -131,12 +164,74 @@ static OCStackResult SendObserveNotification(ResourceObserver *observer,
                 // Reset Observer TTL.
                 observer->TTL = GetTicks(MAX_OBSERVER_TTL_SECONDS * MILLISECONDS_PER_SECOND);
             }
+
+            // A request that was not answered yet must not keep a reference to the
+            // notification, which only lives for the current fan-out.
+            if (encoded)
+            {
+                OCServerRequest *pending = GetServerRequestUsingToken(observer->token,
+                                                                      observer->tokenLength);
+                if (pending && pending->encodedNotification == encoded)
+                {
+                    pending->encodedNotification = NULL;
+                }
+            }
         }
     }
 
     return result;
 }
 
+/**
+ * Find the notification group of an observer, creating it if needed.
+ */
+static NotificationGroup *GetNotificationGroup(NotificationGroup **groups,
+                                               const ResourceObserver *observer)
+{
+    NotificationGroup *group = NULL;
+    LL_FOREACH(*groups, group)
+    {
+        if (group->acceptFormat == observer->acceptFormat &&
+            group->acceptVersion == observer->acceptVersion &&
+            ((!group->query && !observer->query) ||
+             (group->query && observer->query && 0 == strcmp(group->query, observer->query))))
+        {
+            return group;
+        }
+    }
+
+    group = (NotificationGroup *) OICCalloc(1, sizeof(NotificationGroup));
+    if (!group)
+    {
+        return NULL;
+    }
+    if (observer->query)
+    {
+        group->query = OICStrdup(observer->query);
+        if (!group->query)
+        {
+            OICFree(group);
+            return NULL;
+        }
+    }
+    group->acceptFormat = observer->acceptFormat;
+    group->acceptVersion = observer->acceptVersion;
+    LL_PREPEND(*groups, group);
+    return group;
+}
+
+static void DeleteNotificationGroups(NotificationGroup *groups)
+{
+    NotificationGroup *group = NULL;
+    NotificationGroup *tmp = NULL;
+    LL_FOREACH_SAFE(groups, group, tmp)
+    {
+        ClearEncodedNotification(&group->encoded);
+        OICFree(group->query);
+        OICFree(group);
+    }
+}
+
 #ifdef WITH_PRESENCE
 OCStackResult SendAllObserverNotification (OCMethod method, OCResource *resPtr, uint32_t maxAge,
         OCPresenceTrigger trigger, OCResourceType *resourceType, OCQualityOfService qos)
@@ -152,75 +247,76 @@ OCStackResult SendAllObserverNotification (OCMethod method, OCResource *resPtr,
     }
 
     OCStackResult result = OC_STACK_ERROR;
-    ResourceObserver * resourceObserver = g_serverObsList;
-    uint8_t numObs = 0;
+    ResourceObserver * resourceObserver = NULL;
+    ResourceObserver * tmp = NULL;
+    bool hasObservers = false;
     OCServerRequest * request = NULL;
     bool observeErrorFlag = false;
+    NotificationGroup *groups = NULL;
 
-    // Find clients that are observing this resource
-    while (resourceObserver)
+    // Notify the clients that are observing this resource
+    LL_FOREACH_SAFE2(resPtr->observersHead, resourceObserver, tmp, resourceNext)
     {
-        if (resourceObserver->resource == resPtr)
-        {
-            numObs++;
+        hasObservers = true;
 #ifdef WITH_PRESENCE
-            if (method != OC_REST_PRESENCE)
-            {
+        if (method != OC_REST_PRESENCE)
+        {
 #endif
-                qos = DetermineObserverQoS(method, resourceObserver, qos);
-                result = SendObserveNotification(resourceObserver, qos);
+            qos = DetermineObserverQoS(method, resourceObserver, qos);
+            NotificationGroup *group = GetNotificationGroup(&groups, resourceObserver);
+            result = SendObserveNotification(resourceObserver, qos,
+                                             group ? &group->encoded : NULL);
 #ifdef WITH_PRESENCE
-            }
-            else
+        }
+        else
+        {
+            OCEntityHandlerResponse ehResponse = {0};
+
+            //This is effectively the implementation for the presence entity handler.
+            OIC_LOG(DEBUG, TAG, "This notification is for Presence");
+            result = AddServerRequest(&request, 0, 0, 1, OC_REST_GET,
+                    0, resPtr->sequenceNum, qos, resourceObserver->query,
+                    NULL, OC_FORMAT_UNDEFINED, NULL,
+                    resourceObserver->token, resourceObserver->tokenLength,
+                    resourceObserver->resUri, 0, resourceObserver->acceptFormat,
+                    resourceObserver->acceptVersion, &resourceObserver->devAddr);
+
+            if (result == OC_STACK_OK)
             {
-                OCEntityHandlerResponse ehResponse = {0};
+                OCPresencePayload* presenceResBuf = OCPresencePayloadCreate(
+                        resPtr->sequenceNum, maxAge, trigger,
+                        resourceType ? resourceType->resourcetypename : NULL);
 
-                //This is effectively the implementation for the presence entity handler.
-                OIC_LOG(DEBUG, TAG, "This notification is for Presence");
-                result = AddServerRequest(&request, 0, 0, 1, OC_REST_GET,
-                        0, resPtr->sequenceNum, qos, resourceObserver->query,
-                        NULL, OC_FORMAT_UNDEFINED, NULL,
-                        resourceObserver->token, resourceObserver->tokenLength,
-                        resourceObserver->resUri, 0, resourceObserver->acceptFormat,
-                        resourceObserver->acceptVersion, &resourceObserver->devAddr);
+                if (!presenceResBuf)
+                {
+                    return OC_STACK_NO_MEMORY;
+                }
 
                 if (result == OC_STACK_OK)
                 {
-                    OCPresencePayload* presenceResBuf = OCPresencePayloadCreate(
-                            resPtr->sequenceNum, maxAge, trigger,
-                            resourceType ? resourceType->resourcetypename : NULL);
-
-                    if (!presenceResBuf)
-                    {
-                        return OC_STACK_NO_MEMORY;
-                    }
-
-                    if (result == OC_STACK_OK)
-                    {
-                        ehResponse.ehResult = OC_EH_OK;
-                        ehResponse.payload = (OCPayload*)presenceResBuf;
-                        ehResponse.persistentBufferFlag = 0;
-                        ehResponse.requestHandle = (OCRequestHandle) request;
-                        OICStrcpy(ehResponse.resourceUri, sizeof(ehResponse.resourceUri),
-                                resourceObserver->resUri);
-                        result = OCDoResponse(&ehResponse);
-                    }
-
-                    OCPresencePayloadDestroy(presenceResBuf);
+                    ehResponse.ehResult = OC_EH_OK;
+                    ehResponse.payload = (OCPayload*)presenceResBuf;
+                    ehResponse.persistentBufferFlag = 0;
+                    ehResponse.requestHandle = (OCRequestHandle) request;
+                    OICStrcpy(ehResponse.resourceUri, sizeof(ehResponse.resourceUri),
+                            resourceObserver->resUri);
+                    result = OCDoResponse(&ehResponse);
                 }
+
+                OCPresencePayloadDestroy(presenceResBuf);
             }
+        }
 #endif
 
-            // Since we are in a loop, set an error flag to indicate at least one error occurred.
-            if (result != OC_STACK_OK)
-            {
-                observeErrorFlag = true;
-            }
+        // Since we are in a loop, set an error flag to indicate at least one error occurred.
+        if (result != OC_STACK_OK)
+        {
+            observeErrorFlag = true;
         }
-        resourceObserver = resourceObserver->next;
     }
+    DeleteNotificationGroups(groups);
 
-    if (numObs == 0)
+    if (!hasObservers)
     {
         OIC_LOG(INFO, TAG, "Resource has no observers");
         result = OC_STACK_NO_OBSERVERS;
@@ -427,6 +523,7 @@ OCStackResult AddObserver (const char         *resUri,
         }
 
         LL_APPEND (g_serverObsList, obsNode);
+        LL_PREPEND2 (resHandle->observersHead, obsNode, resourceNext);
 
         return OC_STACK_OK;
     }
@@ -462,7 +559,7 @@ static void CheckTimedOutObserver(ResourceObserver* observer)
     {
         // Send confirmable notification message to observer.
         OIC_LOG(INFO, TAG, "Sending High-QoS notification to observer");
-        SendObserveNotification(observer, OC_HIGH_QOS);
+        SendObserveNotification(observer, OC_HIGH_QOS, NULL);
     }
 }
 
@@ -527,6 +624,7 @@ OCStackResult DeleteObserverUsingToken (CAToken_t token, uint8_t tokenLength)
         OIC_LOG_V(INFO, TAG, "deleting observer id  %u with token", obsNode->observeId);
         OIC_LOG_BUFFER(INFO, TAG, (const uint8_t *)obsNode->token, tokenLength);
         LL_DELETE (g_serverObsList, obsNode);
+        LL_DELETE2 (obsNode->resource->observersHead, obsNode, resourceNext);
         OICFree(obsNode->resUri);
         OICFree(obsNode->query);
         OICFree(obsNode->token);
@@ -562,6 +660,28 @@ OCStackResult DeleteObserverUsingDevAddr(const OCDevAddr *devAddr)
     return OC_STACK_OK;
 }
 
+OCStackResult DeleteObserverUsingResource(OCResource *resource)
+{
+    if (!resource)
+    {
+        return OC_STACK_INVALID_PARAM;
+    }
+
+    while (resource->observersHead)
+    {
+        ResourceObserver *obsNode = resource->observersHead;
+        OIC_LOG_V(INFO, TAG, "deleting observer id  %u of deleted resource", obsNode->observeId);
+        LL_DELETE (g_serverObsList, obsNode);
+        resource->observersHead = obsNode->resourceNext;
+        OICFree(obsNode->resUri);
+        OICFree(obsNode->query);
+        OICFree(obsNode->token);
+        OICFree(obsNode);
+    }
+
+    return OC_STACK_OK;
+}
+
 void DeleteObserverList()
 {
     ResourceObserver *out = NULL;
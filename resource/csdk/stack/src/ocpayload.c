@@ -34,11 +34,27 @@
 #include "logger.h"
 #include "ocendpoint.h"
 #include "cacommon.h"
+#include "ochashmap.h"
 
 #define TAG "OIC_RI_PAYLOAD"
 #define CSV_SEPARATOR ','
 #define MASK_SECURE_FAMS (OC_FLAG_SECURE | OC_MASK_FAMS)
 
+// Number of values from which the values of a representation are indexed by name
+#define REP_INDEX_THRESHOLD (16)
+
+/**
+ * Index of the values of a representation by name. Values linked to the list
+ * by other means than the OCRepPayload APIs are found by scanning past the tail,
+ * and a list with another head is not indexed anymore.
+ */
+struct OCRepPayloadIndex
+{
+    oc_hashmap names;
+    OCRepPayloadValue* head;
+    OCRepPayloadValue* tail;
+};
+
 static void OCFreeRepPayloadValueContents(OCRepPayloadValue* val);
 
 void OC_CALL OCPayloadDestroy(OCPayload* payload)
@@ -105,6 +121,53 @@ void OC_CALL OCRepPayloadAppend(OCRepPayload* parent, OCRepPayload* child)
     child->next = NULL;
 }
 
+static void OCRepPayloadFreeIndex(OCRepPayload* payload)
+{
+    if (payload->index)
+    {
+        oc_hashmap_free(payload->index->names);
+        OICFree(payload->index);
+        payload->index = NULL;
+    }
+}
+
+static bool OCRepPayloadIndexValue(struct OCRepPayloadIndex* index, OCRepPayloadValue* val)
+{
+    // The first of values with the same name is found, as by a scan of the list.
+    if (!oc_hashmap_get(index->names, val->name)
+        && !oc_hashmap_put(index->names, val->name, val))
+    {
+        return false;
+    }
+    index->tail = val;
+    return true;
+}
+
+static void OCRepPayloadBuildIndex(OCRepPayload* payload)
+{
+    OCRepPayloadFreeIndex(payload);
+
+    struct OCRepPayloadIndex* index =
+        (struct OCRepPayloadIndex*)OICCalloc(1, sizeof(struct OCRepPayloadIndex));
+    if (!index)
+    {
+        return;
+    }
+    index->names = oc_hashmap_new(oc_hashmap_hash_string, oc_hashmap_equal_string);
+    index->head = payload->values;
+
+    for (OCRepPayloadValue* val = payload->values; val; val = val->next)
+    {
+        if (!index->names || !OCRepPayloadIndexValue(index, val))
+        {
+            oc_hashmap_free(index->names);
+            OICFree(index);
+            return;
+        }
+    }
+    payload->index = index;
+}
+
 static OCRepPayloadValue* OC_CALL OCRepPayloadFindValue(const OCRepPayload* payload, const char* name)
 {
     if (!payload || !name)
@@ -113,6 +176,16 @@ static OCRepPayloadValue* OC_CALL OCRepPayloadFindValue(const OCRepPayload* payl
     }
 
     OCRepPayloadValue* val = payload->values;
+    if (payload->index && payload->index->head == payload->values)
+    {
+        val = (OCRepPayloadValue*)oc_hashmap_get(payload->index->names, name);
+        if (val)
+        {
+            return val;
+        }
+        val = payload->index->tail ? payload->index->tail->next : NULL;
+    }
+
     while(val)
     {
         if (0 == strcmp(val->name, name))
@@ -350,6 +423,49 @@ static OCRepPayloadValue* OC_CALL OCRepPayloadFindAndSetValue(OCRepPayload* payl
         return NULL;
     }
 
+    if (payload->index)
+    {
+        if (payload->index->head != payload->values)
+        {
+            OCRepPayloadFreeIndex(payload);
+        }
+        else
+        {
+            OCRepPayloadValue* val = OCRepPayloadFindValue(payload, name);
+            if (val)
+            {
+                OCFreeRepPayloadValueContents(val);
+                val->type = type;
+                return val;
+            }
+
+            OCRepPayloadValue* tail = payload->index->tail;
+            while (tail->next)
+            {
+                tail = tail->next;
+            }
+            tail->next = (OCRepPayloadValue*)OICCalloc(1, sizeof(OCRepPayloadValue));
+            if (!tail->next)
+            {
+                return NULL;
+            }
+            tail->next->name = OICStrdup(name);
+            if (!tail->next->name)
+            {
+                OICFree(tail->next);
+                tail->next = NULL;
+                return NULL;
+            }
+            tail->next->type = type;
+            if (!OCRepPayloadIndexValue(payload->index, tail->next))
+            {
+                OCRepPayloadFreeIndex(payload);
+            }
+            return tail->next;
+        }
+    }
+
+    size_t count = 0;
     OCRepPayloadValue* val = payload->values;
     if (val == NULL)
     {
@@ -392,10 +508,15 @@ static OCRepPayloadValue* OC_CALL OCRepPayloadFindAndSetValue(OCRepPayload* payl
                 return NULL;
             }
             val->next->type =type;
+            if (count + 2 >= REP_INDEX_THRESHOLD)
+            {
+                OCRepPayloadBuildIndex(payload);
+            }
             return val->next;
         }
 
         val = val->next;
+        count++;
     }
 
     OIC_LOG(ERROR, TAG, "FindAndSetValue reached point after while loop, pointer corruption?");
@@ -1600,6 +1721,10 @@ OCRepPayload* OC_CALL OCRepPayloadClone (const OCRepPayload* payload)
     clone->types = CloneOCStringLL (payload->types);
     clone->interfaces = CloneOCStringLL (payload->interfaces);
     clone->values = OCRepPayloadValueClone (payload->values);
+    if (payload->index)
+    {
+        OCRepPayloadBuildIndex(clone);
+    }
 
     return clone;
 }
@@ -1639,6 +1764,7 @@ void OC_CALL OCRepPayloadDestroy(OCRepPayload* payload)
     OCFreeOCStringLL(payload->types);
     OCFreeOCStringLL(payload->interfaces);
     OCFreeRepPayloadValue(payload->values);
+    OCRepPayloadFreeIndex(payload);
     OCRepPayloadDestroy(payload->next);
     OICFree(payload);
 }
@@ -36,8 +36,8 @@
 
 #define TAG "OIC_RI_PAYLOADCONVERT"
 
-// Arbitrarily chosen size that seems to contain the majority of packages
-#define INIT_SIZE (255)
+// Payloads up to one CoAP PDU are encoded on the stack
+#define INIT_SIZE (OC_ENCODE_BUFFER_SIZE)
 
 // Discovery Links Map Length.
 #define LINKS_MAP_LEN (4)
@@ -69,8 +69,8 @@ static int64_t AddTextStringToMap(CborEncoder *map, const char *key, size_t keyl
 static int64_t ConditionalAddTextStringToMap(CborEncoder *map, const char *key, size_t keylen,
         const char *value);
 
-OCStackResult OCConvertPayload(OCPayload* payload, OCPayloadFormat format,
-        uint8_t** outPayload, size_t* size)
+OCStackResult OCConvertPayloadToBuffer(OCPayload *payload, OCPayloadFormat format,
+        uint8_t *buffer, size_t bufferSize, uint8_t **outPayload, size_t *size)
 {
     // TinyCbor Version 47a78569c0 or better on master is required for the re-allocation
     // strategy to work.  If you receive the following assertion error, please do a git-pull
@@ -81,58 +81,28 @@ OCStackResult OCConvertPayload(OCPayload* payload, OCPayloadFormat format,
 
     OCStackResult ret = OC_STACK_INVALID_PARAM;
     int64_t err = CborErrorOutOfMemory;
-    uint8_t *out = NULL;
-    size_t curSize = INIT_SIZE;
+    uint8_t *out = buffer;
+    size_t curSize = buffer ? bufferSize : 0;
 
     VERIFY_PARAM_NON_NULL(TAG, payload, "Input param, payload is NULL");
     VERIFY_PARAM_NON_NULL(TAG, outPayload, "OutPayload parameter is NULL");
     VERIFY_PARAM_NON_NULL(TAG, size, "size parameter is NULL");
 
     OIC_LOG_V(INFO, TAG, "Converting payload of type %d", payload->type);
-    if (PAYLOAD_TYPE_SECURITY == payload->type)
-    {
-        size_t securityPayloadSize = ((OCSecurityPayload *)payload)->payloadSize;
-        if (securityPayloadSize > 0)
-        {
-            curSize = securityPayloadSize;
-        }
-    }
-    if (PAYLOAD_TYPE_INTROSPECTION == payload->type)
-    {
-        size_t introspectionPayloadSize = ((OCIntrospectionPayload *)payload)->cborPayload.len;
-        if (introspectionPayloadSize > 0)
-        {
-            curSize = introspectionPayloadSize;
-        }
-    }
-
-    ret = OC_STACK_NO_MEMORY;
 
-    for (;;)
+    // An encoder running out of space keeps counting, so a failed pass yields the exact size
+    // and the payload is encoded again into an allocation of that size.
+    err = OCConvertPayloadHelper(payload, format, out, &curSize);
+    if (CborErrorOutOfMemory == err)
     {
-        out = (uint8_t *)OICCalloc(1, curSize);
+        ret = OC_STACK_NO_MEMORY;
+        out = (uint8_t *)OICMalloc(curSize);
         VERIFY_PARAM_NON_NULL(TAG, out, "Failed to allocate payload");
         err = OCConvertPayloadHelper(payload, format, out, &curSize);
-
-        if (CborErrorOutOfMemory != err)
-        {
-            break;
-        }
-
-        OICFree(out);
     }
 
     if (err == CborNoError)
     {
-        if ((curSize < INIT_SIZE) &&
-            (PAYLOAD_TYPE_SECURITY != payload->type) &&
-            (PAYLOAD_TYPE_INTROSPECTION != payload->type))
-        {
-            uint8_t *out2 = (uint8_t *)OICRealloc(out, curSize);
-            VERIFY_PARAM_NON_NULL(TAG, out2, "Failed to increase payload size");
-            out = out2;
-        }
-
         *size = curSize;
         *outPayload = out;
         OIC_LOG_V(DEBUG, TAG, "Payload Size: %zd Payload : ", *size);
@@ -144,10 +114,49 @@ OCStackResult OCConvertPayload(OCPayload* payload, OCPayloadFormat format,
     ret = (OCStackResult)-err;
 
 exit:
-    OICFree(out);
+    if (out != buffer)
+    {
+        OICFree(out);
+    }
     return ret;
 }
 
+OCStackResult OCConvertPayload(OCPayload* payload, OCPayloadFormat format,
+        uint8_t** outPayload, size_t* size)
+{
+    uint8_t buffer[INIT_SIZE];
+    uint8_t *out = NULL;
+    size_t curSize = 0;
+
+    VERIFY_PARAM_NON_NULL(TAG, outPayload, "OutPayload parameter is NULL");
+    VERIFY_PARAM_NON_NULL(TAG, size, "size parameter is NULL");
+
+    OCStackResult ret = OCConvertPayloadToBuffer(payload, format, buffer, sizeof(buffer),
+                                                 &out, &curSize);
+    if (OC_STACK_OK != ret)
+    {
+        return ret;
+    }
+
+    if (out == buffer)
+    {
+        out = (uint8_t *)OICMalloc(curSize ? curSize : 1);
+        if (!out)
+        {
+            OIC_LOG(ERROR, TAG, "Failed to allocate payload");
+            return OC_STACK_NO_MEMORY;
+        }
+        memcpy(out, buffer, curSize);
+    }
+
+    *size = curSize;
+    *outPayload = out;
+    return OC_STACK_OK;
+
+exit:
+    return OC_STACK_INVALID_PARAM;
+}
+
 static int64_t OCConvertPayloadHelper(OCPayload* payload, OCPayloadFormat format,
         uint8_t* outPayload, size_t* size)
 {
@@ -195,6 +204,12 @@ static int64_t checkError(int64_t err, CborEncoder* encoder, uint8_t* outPayload
 static int64_t OCConvertSecurityPayload(OCSecurityPayload* payload, uint8_t* outPayload,
         size_t* size)
 {
+    if (payload->payloadSize > *size)
+    {
+        *size = payload->payloadSize;
+        return CborErrorOutOfMemory;
+    }
+
     memcpy(outPayload, payload->securityData, payload->payloadSize);
     *size = payload->payloadSize;
 
@@ -204,6 +219,12 @@ static int64_t OCConvertSecurityPayload(OCSecurityPayload* payload, uint8_t* out
 static int64_t OCConvertIntrospectionPayload(OCIntrospectionPayload *payload,
         uint8_t *outPayload, size_t *size)
 {
+    if (payload->cborPayload.len > *size)
+    {
+        *size = payload->cborPayload.len;
+        return CborErrorOutOfMemory;
+    }
+
     memcpy(outPayload, payload->cborPayload.bytes, payload->cborPayload.len);
     *size = payload->cborPayload.len;
 
@@ -44,6 +44,8 @@
  * The length of UINT64_MAX as a decimal string.
  */
 #define UINT64_MAX_STRLEN 20
+// Property names up to this size are parsed into a stack buffer
+#define PROPERTY_NAME_BUFFER_SIZE 64
 
 static OCStackResult OCParseDiscoveryPayload(OCPayload **outPayload, OCPayloadFormat format,
         CborValue *arrayVal);
@@ -1031,6 +1033,7 @@ exit:
 static CborError OCParseSingleRepPayload(OCRepPayload **outPayload, CborValue *objMap, bool isRoot)
 {
     CborError err = CborUnknownError;
+    char nameBuffer[PROPERTY_NAME_BUFFER_SIZE];
     char *name = NULL;
     bool res = false;
     VERIFY_PARAM_NON_NULL(TAG, outPayload, "Invalid Parameter outPayload");
@@ -1059,7 +1062,18 @@ static CborError OCParseSingleRepPayload(OCRepPayload **outPayload, CborValue *o
         {
             if (cbor_value_is_map(objMap) && cbor_value_is_text_string(&repMap))
             {
-                err = cbor_value_dup_text_string(&repMap, &name, &len, NULL);
+                // The name is copied by OCRepPayloadSet*, so a temporary buffer
+                // is only allocated for names that don't fit on the stack.
+                len = sizeof(nameBuffer);
+                err = cbor_value_copy_text_string(&repMap, nameBuffer, &len, NULL);
+                if (CborNoError == err)
+                {
+                    name = nameBuffer;
+                }
+                else if (CborErrorOutOfMemory == err)
+                {
+                    err = cbor_value_dup_text_string(&repMap, &name, &len, NULL);
+                }
                 VERIFY_CBOR_SUCCESS(TAG, err, "Failed finding tag name in the map");
                 err = cbor_value_advance(&repMap);
                 VERIFY_CBOR_SUCCESS(TAG, err, "Failed advancing rootMap");
@@ -1070,15 +1084,17 @@ static CborError OCParseSingleRepPayload(OCRepPayload **outPayload, CborValue *o
                     (0 == strcmp(OC_RSRVD_INTERFACE, name))))
                 {
                     err = cbor_value_advance(&repMap);
-                    free(name);  // Free *TinyCBOR allocated* string.
+                    if (name != nameBuffer)
+                    {
+                        free(name);  // Free *TinyCBOR allocated* string.
+                    }
                     name = NULL;
                     continue;
                 }
             }
             else if (cbor_value_is_array(objMap))
             {
-                name = (char*)OICCalloc(UINT64_MAX_STRLEN + 1, sizeof(char));
-                VERIFY_PARAM_NON_NULL(TAG, name, "Failed allocating tag name in the map");
+                name = nameBuffer;
 #ifdef PRIu64
                 snprintf(name, UINT64_MAX_STRLEN + 1, "%" PRIu64, arrayIndex);
 #else
@@ -1094,7 +1110,7 @@ static CborError OCParseSingleRepPayload(OCRepPayload **outPayload, CborValue *o
                 else
                 {
                     err = CborErrorDataTooLarge;
-                    OICFree(name);
+                    name = NULL;
                     continue;
                 }
 #endif
@@ -1181,7 +1197,10 @@ static CborError OCParseSingleRepPayload(OCRepPayload **outPayload, CborValue *o
                 err = cbor_value_advance(&repMap);
                 VERIFY_CBOR_SUCCESS(TAG, err, "Failed advance repMap");
             }
-            OICFree(name);
+            if (name != nameBuffer)
+            {
+                OICFree(name);
+            }
             name = NULL;
             ++arrayIndex;
         }
@@ -1194,7 +1213,10 @@ static CborError OCParseSingleRepPayload(OCRepPayload **outPayload, CborValue *o
     }
 
 exit:
-    OICFree(name);
+    if (name != nameBuffer)
+    {
+        OICFree(name);
+    }
     OCRepPayloadDestroy(*outPayload);
     *outPayload = NULL;
     return err;
@@ -39,6 +39,7 @@
 
 #include "ocresource.h"
 #include "ocresourcehandler.h"
+#include "ocresourceindex.h"
 #include "ocobserve.h"
 #include "occollection.h"
 #include "oic_malloc.h"
@@ -1304,17 +1305,12 @@ OCResource *OC_CALL FindResourceByUri(const char* resourceUri)
         return NULL;
     }
 
-    OCResource * pointer = headResource;
-    while (pointer)
+    OCResource *pointer = FindIndexedResourceByUri(resourceUri);
+    if (!pointer)
     {
-        if (strcmp(resourceUri, pointer->uri) == 0)
-        {
-            return pointer;
-        }
-        pointer = pointer->next;
+        OIC_LOG_V(INFO, TAG, "Resource %s not found", resourceUri);
     }
-    OIC_LOG_V(INFO, TAG, "Resource %s not found", resourceUri);
-    return NULL;
+    return pointer;
 }
 
 OCStackResult CheckRequestsEndpoint(const OCDevAddr *reqDevAddr,
@@ -1943,8 +1939,27 @@ static OCStackResult HandleVirtualResource (OCServerRequest *request, OCResource
 #ifdef MQ_BROKER
         prop = (OC_MQ_BROKER_URI == virtualUriInRequest) ? OC_MQ_BROKER : prop;
 #endif
-        for (; resource && discoveryResult == OC_STACK_OK; resource = resource->next)
+        // Narrow the candidates down through the resource index. Every candidate is still
+        // matched against the full filter below.
+        OCResource * const *candidates = NULL;
+        size_t candidateCount = 0;
+        if (resourceTypeQuery)
+        {
+            candidateCount = GetIndexedResourcesByType(resourceTypeQuery, &candidates);
+        }
+        else if (interfaceQuery && *interfaceQuery &&
+                 0 != strcmp(interfaceQuery, OC_RSRVD_INTERFACE_LL) &&
+                 0 != strcmp(interfaceQuery, OC_RSRVD_INTERFACE_DEFAULT))
+        {
+            candidateCount = GetIndexedResourcesByInterface(interfaceQuery, &candidates);
+        }
+        else
+        {
+            candidateCount = GetIndexedResources(&candidates);
+        }
+        for (size_t i = 0; i < candidateCount && discoveryResult == OC_STACK_OK; i++)
         {
+            resource = candidates[i];
             // This case will handle when no resource type and it is oic.if.ll.
             // Do not assume check if the query is ll
             if (!resourceTypeQuery &&
@@ -0,0 +1,356 @@
+//******************************************************************
+//
+// Copyright 2017 Open Connectivity Foundation
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <string.h>
+#include "ocstack.h"
+#include "ocresourceindex.h"
+#include "ochashmap.h"
+#include "oic_malloc.h"
+#include "oic_string.h"
+#include "logger.h"
+
+#define TAG "OIC_RI_RESOURCEINDEX"
+
+/** Initial capacity of a resource list. */
+#define RESOURCE_LIST_INITIAL_CAPACITY (8)
+
+/**
+ * Resources sorted by OCResource::indexOrder, i.e. in registration order.
+ */
+typedef struct
+{
+    /** Resource type or interface name; key of the list in its map. NULL for g_allResources. */
+    char *name;
+
+    OCResource **resources;
+
+    size_t count;
+
+    size_t capacity;
+} ResourceList;
+
+/** URI -> OCResource. Keys are the resource URIs. */
+static oc_hashmap g_resourcesByUri = NULL;
+
+/** OCResource -> OCResource, used to validate handles. */
+static oc_hashmap g_resourcesByHandle = NULL;
+
+/** Resource type name -> ResourceList. */
+static oc_hashmap g_resourcesByType = NULL;
+
+/** Interface name -> ResourceList. */
+static oc_hashmap g_resourcesByInterface = NULL;
+
+/** All indexed resources. */
+static ResourceList g_allResources = { NULL, NULL, 0, 0 };
+
+/** Order assigned to the next indexed resource. */
+static uint64_t g_nextIndexOrder = 0;
+
+static bool EnsureResourceIndex()
+{
+    if (g_resourcesByUri)
+    {
+        return true;
+    }
+
+    g_resourcesByUri = oc_hashmap_new(oc_hashmap_hash_string, oc_hashmap_equal_string);
+    g_resourcesByHandle = oc_hashmap_new(oc_hashmap_hash_pointer, oc_hashmap_equal_pointer);
+    g_resourcesByType = oc_hashmap_new(oc_hashmap_hash_string, oc_hashmap_equal_string);
+    g_resourcesByInterface = oc_hashmap_new(oc_hashmap_hash_string, oc_hashmap_equal_string);
+
+    if (!g_resourcesByUri || !g_resourcesByHandle || !g_resourcesByType || !g_resourcesByInterface)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to create resource index");
+        TerminateResourceIndex();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Binary search for the position of @p resource (or where it would be inserted) in @p list.
+ */
+static size_t FindResourceListPosition(const ResourceList *list, const OCResource *resource)
+{
+    size_t low = 0;
+    size_t high = list->count;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (list->resources[mid]->indexOrder < resource->indexOrder)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static bool InsertIntoResourceList(ResourceList *list, OCResource *resource)
+{
+    size_t position = FindResourceListPosition(list, resource);
+    if ((position < list->count) && (list->resources[position] == resource))
+    {
+        return true;
+    }
+
+    if (list->count == list->capacity)
+    {
+        size_t capacity = list->capacity ? list->capacity * 2 : RESOURCE_LIST_INITIAL_CAPACITY;
+        OCResource **resources = (OCResource **)OICRealloc(list->resources,
+                                                           capacity * sizeof(OCResource *));
+        if (!resources)
+        {
+            return false;
+        }
+        list->resources = resources;
+        list->capacity = capacity;
+    }
+
+    memmove(&list->resources[position + 1], &list->resources[position],
+            (list->count - position) * sizeof(OCResource *));
+    list->resources[position] = resource;
+    list->count++;
+    return true;
+}
+
+static void RemoveFromResourceList(ResourceList *list, const OCResource *resource)
+{
+    size_t position = FindResourceListPosition(list, resource);
+    if ((position < list->count) && (list->resources[position] == resource))
+    {
+        memmove(&list->resources[position], &list->resources[position + 1],
+                (list->count - position - 1) * sizeof(OCResource *));
+        list->count--;
+    }
+}
+
+static void FreeResourceList(ResourceList *list)
+{
+    if (list)
+    {
+        OICFree(list->name);
+        OICFree(list->resources);
+        OICFree(list);
+    }
+}
+
+static bool FreeResourceListVisitor(const void *key, void *value, void *context)
+{
+    OC_UNUSED(key);
+    OC_UNUSED(context);
+    FreeResourceList((ResourceList *)value);
+    return true;
+}
+
+static OCStackResult AddToNamedResourceList(oc_hashmap map, OCResource *resource,
+                                            const char *name)
+{
+    if (!map || !resource || !name || !IsResourceIndexed(resource))
+    {
+        return OC_STACK_INVALID_PARAM;
+    }
+
+    ResourceList *list = (ResourceList *)oc_hashmap_get(map, name);
+    if (!list)
+    {
+        list = (ResourceList *)OICCalloc(1, sizeof(ResourceList));
+        if (!list)
+        {
+            return OC_STACK_NO_MEMORY;
+        }
+        list->name = OICStrdup(name);
+        if (!list->name || !oc_hashmap_put(map, list->name, list))
+        {
+            FreeResourceList(list);
+            return OC_STACK_NO_MEMORY;
+        }
+    }
+
+    if (!InsertIntoResourceList(list, resource))
+    {
+        if (0 == list->count)
+        {
+            oc_hashmap_remove(map, list->name);
+            FreeResourceList(list);
+        }
+        return OC_STACK_NO_MEMORY;
+    }
+    return OC_STACK_OK;
+}
+
+static void RemoveFromNamedResourceList(oc_hashmap map, const OCResource *resource,
+                                        const char *name)
+{
+    ResourceList *list = (ResourceList *)oc_hashmap_get(map, name);
+    if (list)
+    {
+        RemoveFromResourceList(list, resource);
+        if (0 == list->count)
+        {
+            oc_hashmap_remove(map, list->name);
+            FreeResourceList(list);
+        }
+    }
+}
+
+OCStackResult AddResourceToIndex(OCResource *resource)
+{
+    if (!resource || !resource->uri)
+    {
+        return OC_STACK_INVALID_PARAM;
+    }
+
+    if (!EnsureResourceIndex())
+    {
+        return OC_STACK_NO_MEMORY;
+    }
+
+    if (oc_hashmap_get(g_resourcesByUri, resource->uri))
+    {
+        OIC_LOG_V(ERROR, TAG, "Resource %s already indexed", resource->uri);
+        return OC_STACK_INVALID_PARAM;
+    }
+
+    resource->indexOrder = g_nextIndexOrder++;
+
+    if (!InsertIntoResourceList(&g_allResources, resource))
+    {
+        return OC_STACK_NO_MEMORY;
+    }
+    if (!oc_hashmap_put(g_resourcesByUri, resource->uri, resource))
+    {
+        RemoveFromResourceList(&g_allResources, resource);
+        return OC_STACK_NO_MEMORY;
+    }
+    if (!oc_hashmap_put(g_resourcesByHandle, resource, resource))
+    {
+        oc_hashmap_remove(g_resourcesByUri, resource->uri);
+        RemoveFromResourceList(&g_allResources, resource);
+        return OC_STACK_NO_MEMORY;
+    }
+    return OC_STACK_OK;
+}
+
+void RemoveResourceFromIndex(OCResource *resource)
+{
+    if (!IsResourceIndexed(resource))
+    {
+        return;
+    }
+
+    for (OCResourceType *rt = resource->rsrcType; rt; rt = rt->next)
+    {
+        RemoveFromNamedResourceList(g_resourcesByType, resource, rt->resourcetypename);
+    }
+    for (OCResourceInterface *itf = resource->rsrcInterface; itf; itf = itf->next)
+    {
+        RemoveFromNamedResourceList(g_resourcesByInterface, resource, itf->name);
+    }
+
+    oc_hashmap_remove(g_resourcesByHandle, resource);
+    oc_hashmap_remove(g_resourcesByUri, resource->uri);
+    RemoveFromResourceList(&g_allResources, resource);
+}
+
+OCStackResult AddResourceTypeToIndex(OCResource *resource, const char *resourceTypeName)
+{
+    return AddToNamedResourceList(g_resourcesByType, resource, resourceTypeName);
+}
+
+OCStackResult AddResourceInterfaceToIndex(OCResource *resource, const char *interfaceName)
+{
+    return AddToNamedResourceList(g_resourcesByInterface, resource, interfaceName);
+}
+
+void TerminateResourceIndex()
+{
+    oc_hashmap_foreach(g_resourcesByType, FreeResourceListVisitor, NULL);
+    oc_hashmap_foreach(g_resourcesByInterface, FreeResourceListVisitor, NULL);
+
+    oc_hashmap_free(g_resourcesByUri);
+    oc_hashmap_free(g_resourcesByHandle);
+    oc_hashmap_free(g_resourcesByType);
+    oc_hashmap_free(g_resourcesByInterface);
+    g_resourcesByUri = NULL;
+    g_resourcesByHandle = NULL;
+    g_resourcesByType = NULL;
+    g_resourcesByInterface = NULL;
+
+    OICFree(g_allResources.resources);
+    memset(&g_allResources, 0, sizeof(g_allResources));
+}
+
+OCResource *FindIndexedResourceByUri(const char *uri)
+{
+    return (OCResource *)oc_hashmap_get(g_resourcesByUri, uri);
+}
+
+bool IsResourceIndexed(const OCResource *resource)
+{
+    return (NULL != oc_hashmap_get(g_resourcesByHandle, resource));
+}
+
+size_t GetIndexedResourceCount()
+{
+    return g_allResources.count;
+}
+
+OCResource *GetIndexedResourceAt(size_t index)
+{
+    return (index < g_allResources.count) ? g_allResources.resources[index] : NULL;
+}
+
+size_t GetIndexedResources(OCResource * const **resources)
+{
+    if (!resources)
+    {
+        return 0;
+    }
+    *resources = g_allResources.resources;
+    return g_allResources.count;
+}
+
+static size_t GetNamedResourceList(oc_hashmap map, const char *name,
+                                   OCResource * const **resources)
+{
+    if (!resources)
+    {
+        return 0;
+    }
+
+    ResourceList *list = (ResourceList *)oc_hashmap_get(map, name);
+    *resources = list ? list->resources : NULL;
+    return list ? list->count : 0;
+}
+
+size_t GetIndexedResourcesByType(const char *resourceTypeName, OCResource * const **resources)
+{
+    return GetNamedResourceList(g_resourcesByType, resourceTypeName, resources);
+}
+
+size_t GetIndexedResourcesByInterface(const char *interfaceName, OCResource * const **resources)
+{
+    return GetNamedResourceList(g_resourcesByInterface, interfaceName, resources);
+}
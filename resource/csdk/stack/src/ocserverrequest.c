@@ -24,8 +24,10 @@
 #include "ocserverrequest.h"
 #include "ocresourcehandler.h"
 #include "ocobserve.h"
+#include "occollection.h"
 #include "oic_malloc.h"
 #include "oic_string.h"
+#include "ocatomic.h"
 #include "ocpayload.h"
 #include "ocpayloadcbor.h"
 #include "logger.h"
@@ -73,6 +75,12 @@ RB_HEAD(ServerResponseTree, OCServerResponse) g_serverResponseTree =
                                                             RB_INITIALIZER(&g_serverResponseTree);
 RB_GENERATE(ServerResponseTree, OCServerResponse, entry, RBResponseTokenCmp)
 
+/**
+ * Number of batch requests waiting for ProcessBatchContinuations. Changed atomically along
+ * with the batchContinue flags, since application threads set them in OCDoResponse.
+ */
+static volatile int32_t g_batchContinuations = 0;
+
 //-------------------------------------------------------------------------------------------------
 // Local functions
 //-------------------------------------------------------------------------------------------------
@@ -85,8 +93,11 @@ static void DeleteServerRequestInternal (OCServerRequest * serverRequest)
 {
     assert(serverRequest);
 
+    if (oc_atomic_cmpxchg(&serverRequest->batchContinue, 1, 0))
+    {
+        oc_atomic_decrement(&g_batchContinuations);
+    }
     RB_REMOVE(ServerRequestTree, &g_serverRequestTree, serverRequest);
-    OICFree(serverRequest->requestToken);
     OICFree(serverRequest);
     serverRequest = NULL;
     OIC_LOG(INFO, TAG, "Server Request Removed");
@@ -320,8 +331,18 @@ OCStackResult AddServerRequest (OCServerRequest ** request,
 
     OIC_LOG_V(INFO, TAG, "AddServerRequest entry [%s:%u]", devAddr->addr, devAddr->port);
 
+    // The payload and the token are kept in the same allocation as the request; the payload
+    // is followed by a NULL and then by the token.
+    if (!payload)
+    {
+        payloadSize = 0;
+    }
+    if (!requestToken)
+    {
+        tokenLength = 0;
+    }
     OCServerRequest * serverRequest = (OCServerRequest *) OICCalloc(1, sizeof(OCServerRequest) +
-                                                            (payloadSize ? payloadSize : 1) - 1);
+                                                                    payloadSize + tokenLength);
     VERIFY_NON_NULL(serverRequest);
 
     serverRequest->coapID = coapMessageID;
@@ -341,12 +362,12 @@ OCStackResult AddServerRequest (OCServerRequest ** request,
     {
         OICStrcpy(serverRequest->query, sizeof(serverRequest->query), query);
     }
-    if (rcvdVendorSpecificHeaderOptions)
+    if (rcvdVendorSpecificHeaderOptions && numRcvdVendorSpecificHeaderOptions)
     {
         memcpy(serverRequest->rcvdVendorSpecificHeaderOptions, rcvdVendorSpecificHeaderOptions,
-            MAX_HEADER_OPTIONS * sizeof(OCHeaderOption));
+            numRcvdVendorSpecificHeaderOptions * sizeof(OCHeaderOption));
     }
-    if (payload && payloadSize)
+    if (payloadSize)
     {
         // destination is at least 1 greater than the source, so a NULL always exists in the
         // last character
@@ -357,16 +378,10 @@ OCStackResult AddServerRequest (OCServerRequest ** request,
 
     serverRequest->requestComplete = 0;
 
-    if (requestToken)
+    if (tokenLength)
     {
-        // If tokenLength is zero, the return value depends on the
-        // particular library implementation (it may or may not be a null pointer).
-        if (tokenLength)
-        {
-            serverRequest->requestToken = (CAToken_t) OICMalloc(tokenLength);
-            VERIFY_NON_NULL(serverRequest->requestToken);
-            memcpy(serverRequest->requestToken, requestToken, tokenLength);
-        }
+        serverRequest->requestToken = (CAToken_t) (serverRequest->payload + payloadSize + 1);
+        memcpy(serverRequest->requestToken, requestToken, tokenLength);
     }
     serverRequest->tokenLength = tokenLength;
 
@@ -494,12 +509,35 @@ OCStackResult FormOCEntityHandlerRequest(OCEntityHandlerRequest * entityHandlerR
     return OC_STACK_INVALID_PARAM;
 }
 
-OCStackResult HandleSingleResponse(OCEntityHandlerResponse * ehResponse)
+/*
+ * Moves an encoded payload from a local buffer to the heap.
+ */
+static bool OCDuplicateEncodedPayload(CAInfo_t *info)
+{
+    uint8_t *payload = (uint8_t *)OICMalloc(info->payloadSize ? info->payloadSize : 1);
+    if (!payload)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to keep the encoded payload");
+        return false;
+    }
+    memcpy(payload, info->payload, info->payloadSize);
+    info->payload = payload;
+    return true;
+}
+
+/**
+ * Send a single response. When @p encoded holds a captured response, its payload is sent
+ * instead of encoding ehResponse->payload.
+ */
+static OCStackResult SendSingleResponse(OCEntityHandlerResponse *ehResponse,
+                                        const OCEncodedNotification *encoded)
 {
     OCStackResult result = OC_STACK_ERROR;
     CAEndpoint_t responseEndpoint = {.adapter = CA_DEFAULT_ADAPTER};
     CAResponseInfo_t responseInfo = {.result = CA_EMPTY};
     CAHeaderOption_t* optionsPointer = NULL;
+    // Most payloads are encoded here; CA keeps its own copy of the payload it sends.
+    uint8_t encodeBuffer[OC_ENCODE_BUFFER_SIZE];
 
     if(!ehResponse || !ehResponse->requestHandle)
     {
@@ -644,8 +682,18 @@ OCStackResult HandleSingleResponse(OCEntityHandlerResponse * ehResponse)
     responseInfo.info.payloadSize = 0;
     responseInfo.info.payloadFormat = CA_FORMAT_UNDEFINED;
 
+    if (encoded)
+    {
+        // Reuse the payload encoded for another observer of the same representation.
+        responseInfo.result = encoded->result;
+        responseInfo.isMulticast = encoded->isMulticast;
+        responseInfo.info.payload = encoded->payload;
+        responseInfo.info.payloadSize = encoded->payloadSize;
+        responseInfo.info.payloadFormat = encoded->payloadFormat;
+        responseInfo.info.payloadVersion = encoded->payloadVersion;
+    }
     // Put the JSON prefix and suffix around the payload
-    if(ehResponse->payload)
+    else if(ehResponse->payload)
     {
         if (ehResponse->payload->type == PAYLOAD_TYPE_PRESENCE)
         {
@@ -662,7 +710,9 @@ OCStackResult HandleSingleResponse(OCEntityHandlerResponse * ehResponse)
                 // No preference set by the client, so default to CBOR then
             case OC_FORMAT_CBOR:
             case OC_FORMAT_VND_OCF_CBOR:
-                if((result = OCConvertPayload(ehResponse->payload, serverRequest->acceptFormat,
+                if((result = OCConvertPayloadToBuffer(ehResponse->payload,
+                                serverRequest->acceptFormat,
+                                encodeBuffer, sizeof(encodeBuffer),
                                 &responseInfo.info.payload, &responseInfo.info.payloadSize))
                         != OC_STACK_OK)
                 {
@@ -756,13 +806,65 @@ OCStackResult HandleSingleResponse(OCEntityHandlerResponse * ehResponse)
     result = OCSendResponse(&responseEndpoint, &responseInfo);
 #endif
 
-    OICFree(responseInfo.info.payload);
+    OCEncodedNotification *capture = serverRequest->encodedNotification;
+    if (encoded)
+    {
+        // The payload is owned by the captured notification.
+    }
+    else if (capture && !capture->captured && OC_EH_OK == ehResponse->ehResult
+             && (responseInfo.info.payload != encodeBuffer
+                 || OCDuplicateEncodedPayload(&responseInfo.info)))
+    {
+        // Keep the encoded payload so other observers of this representation can reuse it.
+        // Errors are not shared, so the next observer gets its own entity handler call.
+        capture->captured = true;
+        capture->ehResponse = *ehResponse;
+        capture->ehResponse.payload = NULL;
+        capture->ehResponse.requestHandle = NULL;
+        capture->result = responseInfo.result;
+        capture->payload = responseInfo.info.payload;
+        capture->payloadSize = responseInfo.info.payloadSize;
+        capture->payloadFormat = responseInfo.info.payloadFormat;
+        capture->payloadVersion = responseInfo.info.payloadVersion;
+        capture->isMulticast = responseInfo.isMulticast;
+    }
+    else if (responseInfo.info.payload != encodeBuffer)
+    {
+        OICFree(responseInfo.info.payload);
+    }
     OICFree(responseInfo.info.options);
     //Delete the request
     DeleteServerRequest(serverRequest);
     return result;
 }
 
+OCStackResult HandleSingleResponse(OCEntityHandlerResponse * ehResponse)
+{
+    return SendSingleResponse(ehResponse, NULL);
+}
+
+OCStackResult SendEncodedNotification(OCServerRequest *request,
+                                      const OCEncodedNotification *notification)
+{
+    if (!request || !notification || !notification->captured)
+    {
+        return OC_STACK_INVALID_PARAM;
+    }
+
+    OCEntityHandlerResponse ehResponse = notification->ehResponse;
+    ehResponse.requestHandle = (OCRequestHandle) request;
+    return SendSingleResponse(&ehResponse, notification);
+}
+
+void ClearEncodedNotification(OCEncodedNotification *notification)
+{
+    if (notification)
+    {
+        OICFree(notification->payload);
+        memset(notification, 0, sizeof(*notification));
+    }
+}
+
 OCStackResult HandleAggregateResponse(OCEntityHandlerResponse * ehResponse)
 {
     if(!ehResponse || !ehResponse->payload)
@@ -801,6 +903,12 @@ OCStackResult HandleAggregateResponse(OCEntityHandlerResponse * ehResponse)
         }
 
         OCRepPayload *newPayload = OCRepPayloadBatchClone((OCRepPayload *)ehResponse->payload);
+        if (!newPayload)
+        {
+            stackRet = OC_STACK_NO_MEMORY;
+            OIC_LOG(ERROR, TAG, "Error cloning payload");
+            goto exit;
+        }
 
         if(!serverResponse->payload)
         {
@@ -808,9 +916,10 @@ OCStackResult HandleAggregateResponse(OCEntityHandlerResponse * ehResponse)
         }
         else
         {
-            OCRepPayloadAppend((OCRepPayload*)serverResponse->payload,
-                    (OCRepPayload*)newPayload);
+            // Appending to the last fragment keeps large batches linear.
+            OCRepPayloadAppend(serverResponse->lastPayload, newPayload);
         }
+        serverResponse->lastPayload = newPayload;
 
         (serverRequest->numResponses)--;
 
@@ -828,9 +937,49 @@ OCStackResult HandleAggregateResponse(OCEntityHandlerResponse * ehResponse)
         {
             OIC_LOG(INFO, TAG, "More response fragments to come");
             stackRet = OC_STACK_OK;
+            // A child resource is done, let the next ones handle the batch request. While the
+            // request is being dispatched, the dispatch loop does that itself.
+            if (!serverRequest->batchDispatching && serverRequest->batchPending
+                && oc_atomic_cmpxchg(&serverRequest->batchContinue, 0, 1))
+            {
+                oc_atomic_increment(&g_batchContinuations);
+            }
         }
     }
 exit:
 
     return stackRet;
 }
+
+void ProcessBatchContinuations()
+{
+    while (0 < g_batchContinuations)
+    {
+        // Entity handlers may respond to and delete any server request, so look the next
+        // one up again every time.
+        OCServerRequest *request = NULL;
+        RB_FOREACH(request, ServerRequestTree, &g_serverRequestTree)
+        {
+            if (request->batchContinue)
+            {
+                break;
+            }
+        }
+        if (!request)
+        {
+            // A request was deleted before the count was updated.
+            break;
+        }
+
+        if (oc_atomic_cmpxchg(&request->batchContinue, 1, 0))
+        {
+            oc_atomic_decrement(&g_batchContinuations);
+            ContinueBatchRequest(request);
+        }
+    }
+}
+
+bool HasBatchContinuations()
+{
+    return 0 < g_batchContinuations;
+}
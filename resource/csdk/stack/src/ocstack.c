@@ -48,6 +48,7 @@
 #include "ocstack.h"
 #include "ocstackinternal.h"
 #include "ocresourcehandler.h"
+#include "ocresourceindex.h"
 #include "occlientcb.h"
 #include "ocobserve.h"
 #include "ocrandom.h"
@@ -69,6 +70,7 @@
 #include "oicgroup.h"
 #include "ocendpoint.h"
 #include "ocatomic.h"
+#include "octhread.h"
 #include "platform_features.h"
 #include "oic_platform.h"
 
@@ -157,6 +159,14 @@ static uint32_t PresenceTimeOut[] = {50, 75, 85, 95, 100};
 #endif
 
 static OCMode myStackMode;
+
+#ifdef WITH_PROCESS_EVENT
+/** Event signaled when OCProcessEvent has to be called before its last nextEventTime. */
+static oc_event g_processEvent = NULL;
+
+/** Guards g_processEvent, which application threads signal while it is replaced. */
+static oc_mutex g_processEventMutex = NULL;
+#endif
 #ifdef RA_ADAPTER
 //TODO: revisit this design
 static bool gRASetInfo = false;
@@ -420,6 +430,14 @@ static OCResourceType *findResourceType(OCResourceType * resourceTypeList,
  */
 static OCStackResult ResetPresenceTTL(ClientCB *cbNode, uint32_t maxAgeSeconds);
 
+#ifdef WITH_PROCESS_EVENT
+/**
+ * Signals the event registered with OCRegisterProcessEvent, if any.
+ * May be called from any thread.
+ */
+static void SignalProcessEvent();
+#endif
+
 /**
  * Set Header Option.
  * @param caHdrOpt            Pointer to existing options
@@ -1018,6 +1036,11 @@ static OCStackResult ResetPresenceTTL(ClientCB *cbNode, uint32_t maxAgeSeconds)
     cbNode->presence->TTLlevel = 0;
 
     OIC_LOG_V(DEBUG, TAG, "this TTL level %d", cbNode->presence->TTLlevel);
+
+#ifdef WITH_PROCESS_EVENT
+    // The presence timeouts changed; let OCProcessEvent compute a new nextEventTime.
+    SignalProcessEvent();
+#endif
     return OC_STACK_OK;
 }
 
@@ -1987,8 +2010,8 @@ void OC_CALL OCHandleResponse(const CAEndpoint_t* endPoint, const CAResponseInfo
                 else
                 {
                     // To keep discovery callbacks active.
-                    cbNode->TTL = GetTicks(MAX_CB_TIMEOUT_SECONDS *
-                                            MILLISECONDS_PER_SECOND);
+                    SetClientCBTTL(cbNode, GetTicks(MAX_CB_TIMEOUT_SECONDS *
+                                                    MILLISECONDS_PER_SECOND));
                 }
             }
 
@@ -2365,61 +2388,43 @@ void OCHandleRequests(const CAEndpoint_t* endPoint, const CARequestInfo_t* reque
     directResponseType = (directResponseType == CA_MSG_CONFIRM)
             ? CA_MSG_ACKNOWLEDGE : CA_MSG_NONCONFIRM;
 
-    char * uriWithoutQuery = NULL;
-    char * query = NULL;
-    OCStackResult requestResult = OC_STACK_ERROR;
-
-    requestResult = getQueryFromUri(requestInfo->info.resourceUri, &query, &uriWithoutQuery);
-
-    if (requestResult != OC_STACK_OK || !uriWithoutQuery)
+    // The URI and query are split straight into the request, and the payload and token
+    // are borrowed from requestInfo, which outlives this call. AddServerRequest copies
+    // what a server request needs after its entity handler has returned.
+    OCServerProtocolRequest serverRequest = { 0 };
+    const char *uri = requestInfo->info.resourceUri;
+    const char *delimiter = uri ? strchr(uri, '?') : NULL;
+    size_t uriLen = delimiter ? (size_t)(delimiter - uri) : (uri ? strlen(uri) : 0);
+    if (!uriLen)
     {
-        OIC_LOG_V(ERROR, TAG, "getQueryFromUri() failed with OC error code %d\n", requestResult);
+        OIC_LOG(ERROR, TAG, "Request URI is empty.");
         return;
     }
-    OIC_LOG_V(INFO, TAG, "URI without query: %s", uriWithoutQuery);
-    OIC_LOG_V(INFO, TAG, "Query : %s", query);
-
-    OCServerProtocolRequest serverRequest = { 0 };
-    if (strlen(uriWithoutQuery) < MAX_URI_LENGTH)
-    {
-        OICStrcpy(serverRequest.resourceUrl, sizeof(serverRequest.resourceUrl), uriWithoutQuery);
-        OICFree(uriWithoutQuery);
-    }
-    else
+    if (uriLen >= sizeof(serverRequest.resourceUrl))
     {
         OIC_LOG(ERROR, TAG, "URI length exceeds MAX_URI_LENGTH.");
-        OICFree(uriWithoutQuery);
-        OICFree(query);
         return;
     }
+    memcpy(serverRequest.resourceUrl, uri, uriLen);
 
-    if (query)
+    if (delimiter)
     {
-        if (strlen(query) < MAX_QUERY_LENGTH)
-        {
-            OICStrcpy(serverRequest.query, sizeof(serverRequest.query), query);
-            OICFree(query);
-        }
-        else
+        size_t queryLen = strlen(delimiter + 1);
+        if (queryLen >= sizeof(serverRequest.query))
         {
             OIC_LOG(ERROR, TAG, "Query length exceeds MAX_QUERY_LENGTH.");
-            OICFree(query);
             return;
         }
+        memcpy(serverRequest.query, delimiter + 1, queryLen);
     }
+    OIC_LOG_V(INFO, TAG, "URI without query: %s", serverRequest.resourceUrl);
+    OIC_LOG_V(INFO, TAG, "Query : %s", serverRequest.query);
 
     if ((requestInfo->info.payload) && (0 < requestInfo->info.payloadSize))
     {
         serverRequest.payloadFormat = CAToOCPayloadFormat(requestInfo->info.payloadFormat);
         serverRequest.reqTotalSize = requestInfo->info.payloadSize;
-        serverRequest.payload = (uint8_t *) OICMalloc(requestInfo->info.payloadSize);
-        if (!serverRequest.payload)
-        {
-            OIC_LOG(ERROR, TAG, "Allocation for payload failed.");
-            return;
-        }
-        memcpy (serverRequest.payload, requestInfo->info.payload,
-                requestInfo->info.payloadSize);
+        serverRequest.payload = (uint8_t *) requestInfo->info.payload;
     }
     else
     {
@@ -2447,7 +2452,6 @@ void OCHandleRequests(const CAEndpoint_t* endPoint, const CARequestInfo_t* reque
                                     requestInfo->info.options, requestInfo->info.token,
                                     requestInfo->info.tokenLength, requestInfo->info.resourceUri,
                                     CA_RESPONSE_DATA);
-            OICFree(serverRequest.payload);
             return;
     }
 
@@ -2458,20 +2462,7 @@ void OCHandleRequests(const CAEndpoint_t* endPoint, const CARequestInfo_t* reque
     if (serverRequest.tokenLength)
     {
         // Non empty token
-        serverRequest.requestToken = (CAToken_t)OICMalloc(requestInfo->info.tokenLength);
-
-        if (!serverRequest.requestToken)
-        {
-            OIC_LOG(FATAL, TAG, "Allocation for token failed.");
-            SendDirectStackResponse(endPoint, requestInfo->info.messageId, CA_INTERNAL_SERVER_ERROR,
-                                    directResponseType, requestInfo->info.numOptions,
-                                    requestInfo->info.options, requestInfo->info.token,
-                                    requestInfo->info.tokenLength, requestInfo->info.resourceUri,
-                                    CA_RESPONSE_DATA);
-            OICFree(serverRequest.payload);
-            return;
-        }
-        memcpy(serverRequest.requestToken, requestInfo->info.token, requestInfo->info.tokenLength);
+        serverRequest.requestToken = requestInfo->info.token;
     }
 
     serverRequest.acceptFormat = CAToOCPayloadFormat(requestInfo->info.acceptFormat);
@@ -2514,8 +2505,6 @@ void OCHandleRequests(const CAEndpoint_t* endPoint, const CARequestInfo_t* reque
                                 requestInfo->info.options, requestInfo->info.token,
                                 requestInfo->info.tokenLength, requestInfo->info.resourceUri,
                                 CA_RESPONSE_DATA);
-        OICFree(serverRequest.payload);
-        OICFree(serverRequest.requestToken);
         return;
     }
     serverRequest.numRcvdVendorSpecificHeaderOptions = tempNum;
@@ -2525,7 +2514,7 @@ void OCHandleRequests(const CAEndpoint_t* endPoint, const CARequestInfo_t* reque
                sizeof(CAHeaderOption_t) * tempNum);
     }
 
-    requestResult = HandleStackRequests (&serverRequest);
+    OCStackResult requestResult = HandleStackRequests (&serverRequest);
 
     if (requestResult == OC_STACK_SLOW_RESOURCE)
     {
@@ -2554,10 +2543,6 @@ void OCHandleRequests(const CAEndpoint_t* endPoint, const CARequestInfo_t* reque
                                 requestInfo->info.tokenLength, requestInfo->info.resourceUri,
                                 CA_RESPONSE_DATA);
     }
-    // requestToken is fed to HandleStackRequests, which then goes to AddServerRequest.
-    // The token is copied in there, and is thus still owned by this function.
-    OICFree(serverRequest.payload);
-    OICFree(serverRequest.requestToken);
     OIC_LOG(INFO, TAG, "Exit OCHandleRequests");
 }
 
@@ -2919,6 +2904,10 @@ OCStackResult OCDeInitializeInternal()
     DeleteObserverList();
     // Free memory dynamically allocated for resources
     deleteAllResources();
+#ifdef RD_SERVER
+    // Close the RD database used for discovery
+    OCRDDatabaseDiscoveryClose();
+#endif
     // Remove all the client callbacks
     DeleteClientCBList();
     // Terminate connectivity-abstraction layer.
@@ -2933,6 +2922,15 @@ OCStackResult OCDeInitializeInternal()
     CAUtilConfig_t configs = {(CATransportBTFlags_t)CA_DEFAULT_BT_FLAGS};
     CAUtilSetBTConfigure(configs);
 
+#ifdef WITH_PROCESS_EVENT
+    // Otherwise it is freed when the event is unregistered.
+    if (!g_processEvent)
+    {
+        oc_mutex_free(g_processEventMutex);
+        g_processEventMutex = NULL;
+    }
+#endif
+
     stackState = OC_STACK_UNINITIALIZED;
     return OC_STACK_OK;
 }
@@ -3847,6 +3845,8 @@ OCStackResult OC_CALL OCRegisterPersistentStorageHandler(OCPersistentStorage* pe
         }
     }
     g_PersistentStorageHandler = persistentStorageHandler;
+    // The layout known for a database may not match the storage of the new handler.
+    ResetPSDatabaseStates();
     return OC_STACK_OK;
 }
 
@@ -3857,7 +3857,34 @@ OCPersistentStorage *OC_CALL OCGetPersistentStorageHandler()
 
 #ifdef WITH_PRESENCE
 
-OCStackResult OCProcessPresence()
+/**
+ * Lowers nextEventTime to the time until the next presence timeout of cbNode is due.
+ */
+static void UpdatePresenceEventTime(const ClientCB *cbNode, uint32_t now, uint32_t *nextEventTime)
+{
+    if (!nextEventTime || cbNode->presence->TTLlevel > PresenceTimeOutSize)
+    {
+        return;
+    }
+
+    uint32_t milliSeconds = 0;
+    if (cbNode->presence->TTLlevel < PresenceTimeOutSize)
+    {
+        uint32_t timeOut = cbNode->presence->timeOut[cbNode->presence->TTLlevel];
+        if (timeOut > now)
+        {
+            milliSeconds = (uint32_t)(((uint64_t)(timeOut - now) * MILLISECONDS_PER_SECOND +
+                                       COAP_TICKS_PER_SECOND - 1) / COAP_TICKS_PER_SECOND);
+        }
+    }
+
+    if (milliSeconds < *nextEventTime)
+    {
+        *nextEventTime = milliSeconds;
+    }
+}
+
+OCStackResult OCProcessPresence(uint32_t *nextEventTime)
 {
     OCStackResult result = OC_STACK_OK;
 
@@ -3916,6 +3943,7 @@ OCStackResult OCProcessPresence()
 
         if (now < cbNode->presence->timeOut[cbNode->presence->TTLlevel])
         {
+            UpdatePresenceEventTime(cbNode, now, nextEventTime);
             continue;
         }
 
@@ -3942,6 +3970,7 @@ OCStackResult OCProcessPresence()
 
         cbNode->presence->TTLlevel++;
         OIC_LOG_V(DEBUG, TAG, "moving to TTL level %d", cbNode->presence->TTLlevel);
+        UpdatePresenceEventTime(cbNode, now, nextEventTime);
     }
 exit:
     if (result != OC_STACK_OK)
@@ -3953,7 +3982,13 @@ exit:
 }
 #endif // WITH_PRESENCE
 
-OCStackResult OC_CALL OCProcess()
+/**
+ * Does the work of OCProcess and OCProcessEvent.
+ *
+ * @param nextEventTime  Lowered to the number of milliseconds until the next timer is due.
+ *                       NULL if the caller does not need it.
+ */
+static OCStackResult ProcessStack(uint32_t *nextEventTime)
 {
     if (stackState == OC_STACK_UNINITIALIZED)
     {
@@ -3961,20 +3996,91 @@ OCStackResult OC_CALL OCProcess()
         return OC_STACK_ERROR;
     }
 #ifdef WITH_PRESENCE
-    OCProcessPresence();
+    OCProcessPresence(nextEventTime);
 #endif
     CAHandleRequestResponse();
+    ProcessBatchContinuations();
 
 #ifdef ROUTING_GATEWAY
     RMProcess();
+    // The routing manager timers have a resolution of a second.
+    if (nextEventTime && *nextEventTime > MILLISECONDS_PER_SECOND)
+    {
+        *nextEventTime = MILLISECONDS_PER_SECOND;
+    }
 #endif
 
 #ifdef TCP_ADAPTER
-    ProcessKeepAlive();
+    ProcessKeepAlive(nextEventTime);
 #endif
     return OC_STACK_OK;
 }
 
+OCStackResult OC_CALL OCProcess()
+{
+    return ProcessStack(NULL);
+}
+
+#ifdef WITH_PROCESS_EVENT
+OCStackResult OC_CALL OCProcessEvent(uint32_t *nextEventTime)
+{
+    if (!nextEventTime)
+    {
+        return OC_STACK_INVALID_PARAM;
+    }
+
+    *nextEventTime = UINT32_MAX;
+    return ProcessStack(nextEventTime);
+}
+
+void OC_CALL OCRegisterProcessEvent(oc_event event)
+{
+    // The first registration happens before other threads use the stack.
+    if (event && !g_processEventMutex)
+    {
+        g_processEventMutex = oc_mutex_new();
+        if (!g_processEventMutex)
+        {
+            OIC_LOG(ERROR, TAG, "Failed to create process event mutex");
+        }
+    }
+
+    // Once this returns, no thread signals the previous event any more.
+    if (g_processEventMutex)
+    {
+        oc_mutex_lock(g_processEventMutex);
+    }
+    g_processEvent = event;
+    if (g_processEventMutex)
+    {
+        oc_mutex_unlock(g_processEventMutex);
+    }
+    CARegisterProcessEvent(event);
+
+    if (!event && (OC_STACK_INITIALIZED != stackState))
+    {
+        oc_mutex_free(g_processEventMutex);
+        g_processEventMutex = NULL;
+    }
+}
+
+static void SignalProcessEvent()
+{
+    if (g_processEventMutex)
+    {
+        oc_mutex_lock(g_processEventMutex);
+    }
+    if (g_processEvent)
+    {
+        oc_event_signal(g_processEvent);
+    }
+    if (g_processEventMutex)
+    {
+        oc_mutex_unlock(g_processEventMutex);
+    }
+}
+#endif // WITH_PROCESS_EVENT
+
 #ifdef WITH_PRESENCE
 OCStackResult OC_CALL OCStartPresence(const uint32_t ttl)
 {
@@ -4169,21 +4275,11 @@ OCStackResult OC_CALL OCCreateResourceWithEp(OCResourceHandle *handle,
         return OC_STACK_INVALID_PARAM;
     }
 
-    // If the headResource is NULL, then no resources have been created...
-    pointer = headResource;
-    if (pointer)
+    // Repeated URLs are not allowed.  If a repeat is found, exit with an error
+    if (FindIndexedResourceByUri(uri))
     {
-        // At least one resources is in the resource list, so we need to search for
-        // repeated URLs, which are not allowed.  If a repeat is found, exit with an error
-        while (pointer)
-        {
-            if (strncmp(uri, pointer->uri, MAX_URI_LENGTH) == 0)
-            {
-                OIC_LOG_V(ERROR, TAG, "Resource %s already exists", uri);
-                return OC_STACK_INVALID_PARAM;
-            }
-            pointer = pointer->next;
-        }
+        OIC_LOG_V(ERROR, TAG, "Resource %s already exists", uri);
+        return OC_STACK_INVALID_PARAM;
     }
     // Create the pointer and insert it into the resource list
     pointer = (OCResource *) OICCalloc(1, sizeof(OCResource));
@@ -4204,6 +4300,13 @@ OCStackResult OC_CALL OCCreateResourceWithEp(OCResourceHandle *handle,
         goto exit;
     }
 
+    result = AddResourceToIndex(pointer);
+    if (result != OC_STACK_OK)
+    {
+        OIC_LOG(ERROR, TAG, "Error indexing resource");
+        goto exit;
+    }
+
     // Set resource to nonsecure if caller did not specify
     if ((resourceProperties & OC_MASK_RESOURCE_SECURE) == 0)
     {
@@ -4437,6 +4540,24 @@ OCStackResult OC_CALL OCUnBindResource(
     return OC_STACK_ERROR;
 }
 
+OCStackResult OC_CALL OCSetCollectionBatchConcurrency(OCResourceHandle collectionHandle,
+                                                      uint16_t maxConcurrency)
+{
+    OIC_LOG_V(INFO, TAG, "Entering OCSetCollectionBatchConcurrency: %u", maxConcurrency);
+
+    VERIFY_NON_NULL(collectionHandle, ERROR, OC_STACK_ERROR);
+
+    OCResource *resource = findResource((OCResource *) collectionHandle);
+    if (!resource)
+    {
+        OIC_LOG(ERROR, TAG, "Collection handle not found");
+        return OC_STACK_INVALID_PARAM;
+    }
+
+    resource->batchConcurrency = maxConcurrency;
+    return OC_STACK_OK;
+}
+
 static bool ValidateResourceTypeInterface(const char *resourceItemName)
 {
     if (!resourceItemName)
@@ -4508,8 +4629,16 @@ OCStackResult BindResourceTypeToResource(OCResource* resource,
     pointer->resourcetypename = str;
     pointer->next = NULL;
 
+    // Index first, so that a failure leaves the resource unchanged.
+    result = AddResourceTypeToIndex(resource, resourceTypeName);
+    if (result != OC_STACK_OK)
+    {
+        goto exit;
+    }
+
     insertResourceType(resource, pointer);
-    result = OC_STACK_OK;
+    pointer = NULL;
+    str = NULL;
 
 exit:
     if (result != OC_STACK_OK)
@@ -4553,10 +4682,28 @@ OCStackResult BindResourceInterfaceToResource(OCResource* resource,
     }
     pointer->name = str;
 
+    // The default interface is always bound first; bind it now rather than from
+    // insertResourceInterface, which cannot report a failure.
+    if (!resource->rsrcInterface && strcmp(resourceInterfaceName, OC_RSRVD_INTERFACE_DEFAULT))
+    {
+        result = BindResourceInterfaceToResource(resource, OC_RSRVD_INTERFACE_DEFAULT);
+        if (result != OC_STACK_OK)
+        {
+            goto exit;
+        }
+    }
+
+    // Index first, so that a failure leaves the resource unchanged.
+    result = AddResourceInterfaceToIndex(resource, resourceInterfaceName);
+    if (result != OC_STACK_OK)
+    {
+        goto exit;
+    }
+
     // Bind the resourceinterface to the resource
     insertResourceInterface(resource, pointer);
-
-    result = OC_STACK_OK;
+    pointer = NULL;
+    str = NULL;
 
     exit:
     if (result != OC_STACK_OK)
@@ -4655,27 +4802,14 @@ OCStackResult OC_CALL OCBindResourceInterfaceToResource(OCResourceHandle handle,
 
 OCStackResult OC_CALL OCGetNumberOfResources(uint8_t *numResources)
 {
-    OCResource *pointer = headResource;
-
     VERIFY_NON_NULL(numResources, ERROR, OC_STACK_INVALID_PARAM);
-    *numResources = 0;
-    while (pointer)
-    {
-        *numResources = *numResources + 1;
-        pointer = pointer->next;
-    }
+    *numResources = (uint8_t) GetIndexedResourceCount();
     return OC_STACK_OK;
 }
 
 OCResourceHandle OC_CALL OCGetResourceHandle(uint8_t index)
 {
-    OCResource *pointer = headResource;
-
-    for( uint8_t i = 0; i < index && pointer; ++i)
-    {
-        pointer = pointer->next;
-    }
-    return (OCResourceHandle) pointer;
+    return (OCResourceHandle) GetIndexedResourceAt(index);
 }
 
 OCStackResult OC_CALL OCDeleteResource(OCResourceHandle handle)
@@ -5048,6 +5182,14 @@ OCStackResult OC_CALL OCDoResponse(OCEntityHandlerResponse *ehResponse)
         result = serverRequest->ehResponseHandler(ehResponse);
     }
 
+#ifdef WITH_PROCESS_EVENT
+    // Batch requests wait for OCProcessEvent to pass them on to more child resources.
+    if (HasBatchContinuations())
+    {
+        SignalProcessEvent();
+    }
+#endif
+
     OIC_TRACE_END();
     return result;
 }
@@ -5300,17 +5442,7 @@ void insertResource(OCResource *resource)
 
 OCResource *findResource(OCResource *resource)
 {
-    OCResource *pointer = headResource;
-
-    while (pointer)
-    {
-        if (pointer == resource)
-        {
-            return resource;
-        }
-        pointer = pointer->next;
-    }
-    return NULL;
+    return IsResourceIndexed(resource) ? resource : NULL;
 }
 
 void deleteAllResources()
@@ -5346,6 +5478,8 @@ void deleteAllResources()
     deleteResource((OCResource *) presenceResource.handle);
     memset(&presenceResource, 0, sizeof(presenceResource));
 #endif // WITH_PRESENCE
+
+    TerminateResourceIndex();
 }
 
 OCStackResult deleteResource(OCResource *resource)
@@ -5403,6 +5537,8 @@ OCStackResult deleteResource(OCResource *resource)
                 prev->next = temp->next;
             }
 
+            DeleteObserverUsingResource(temp);
+            RemoveResourceFromIndex(temp);
             deleteResourceElements(temp);
             OICFree(temp);
             temp = NULL;
@@ -6069,18 +6205,12 @@ OCResourceHandle OC_CALL OCGetResourceHandleAtUri(const char *uri)
         return NULL;
     }
 
-    OCResource *pointer = headResource;
-
-    while (pointer)
+    OCResource *pointer = FindIndexedResourceByUri(uri);
+    if (pointer)
     {
-        if (strncmp(uri, pointer->uri, MAX_URI_LENGTH) == 0)
-        {
-            OIC_LOG_V(DEBUG, TAG, "Found Resource %s", uri);
-            return pointer;
-        }
-        pointer = pointer->next;
+        OIC_LOG_V(DEBUG, TAG, "Found Resource %s", uri);
     }
-    return NULL;
+    return pointer;
 }
 
 static OCStackResult SetHeaderOption(CAHeaderOption_t *caHdrOpt, size_t numOptions,
@@ -26,7 +26,7 @@
 #include "oic_string.h"
 #include "oic_time.h"
 #include "ocrandom.h"
-#include "uarraylist.h"
+#include "ochashmap.h"
 #include "ocstackinternal.h"
 #include "ocpayloadcbor.h"
 #include "ocpayload.h"
@@ -39,6 +39,7 @@
 #define TAG "OIC_RI_KEEPALIVE"
 
 static const uint64_t USECS_PER_SEC = 1000000;
+static const uint64_t USECS_PER_MSEC = 1000;
 
 //-----------------------------------------------------------------------------
 // Macros
@@ -77,6 +78,17 @@ static const uint64_t USECS_PER_SEC = 1000000;
  */
 #define DEFAULT_INTERVAL_COUNT  6
 
+/**
+ * Number of slots of the KeepAlive timer wheel. Together with the tick length
+ * it spans more than the max interval, so a slot rarely holds timers of later rounds.
+ */
+#define KEEPALIVE_WHEEL_SLOTS 1024
+
+/**
+ * Time span of a timer wheel slot. in microseconds.
+ */
+static const uint64_t KEEPALIVE_WHEEL_TICK = 4 * 1000000;
+
 /**
  * KeepAlive key to parser Payload Table.
  */
@@ -97,15 +109,10 @@ static bool g_isKeepAliveInitialized = false;
  */
 static OCResourceHandle g_keepAliveHandle = NULL;
 
-/**
- * KeepAlive table which holds connection interval.
- */
-static u_arraylist_t *g_keepAliveConnectionTable = NULL;
-
 /**
  * KeepAlive table entries.
  */
-typedef struct
+typedef struct KeepAliveEntry
 {
     OCMode mode;                    /**< host Mode of Operation. */
     CAEndpoint_t remoteAddr;        /**< destination Address. */
@@ -115,8 +122,33 @@ typedef struct
     int64_t *intervalInfo;          /**< interval values for KeepAlive. */
     bool sentPingMsg;               /**< if oic client already sent ping message. */
     uint64_t timeStamp;             /**< last sent or received ping message. in microseconds. */
+    uint64_t dueTime;               /**< time the KeepAlive timer is due. in microseconds. */
+    bool scheduled;                 /**< if the entry is in the timer wheel. */
+    size_t slot;                    /**< timer wheel slot of the entry. */
+    struct KeepAliveEntry *prev;    /**< previous entry in the same slot. */
+    struct KeepAliveEntry *next;    /**< next entry in the same slot. */
 } KeepAliveEntry_t;
 
+/**
+ * KeepAlive table which holds connection interval, keyed by remote address and port.
+ */
+static oc_hashmap g_keepAliveConnectionTable = NULL;
+
+/**
+ * KeepAlive timer wheel; each slot lists the entries due within one tick.
+ */
+static KeepAliveEntry_t *g_keepAliveWheel[KEEPALIVE_WHEEL_SLOTS];
+
+/**
+ * First tick of the timer wheel that is not completely processed.
+ */
+static uint64_t g_keepAliveWheelTick = 0;
+
+/**
+ * Number of entries in the timer wheel.
+ */
+static size_t g_keepAliveScheduledCount = 0;
+
 /**
  * Send disconnect message to remove connection.
  */
@@ -183,10 +215,22 @@ OCStackResult HandleKeepAliveResponse(const CAEndpoint_t *endPoint,
  * @param[in]   endpoint    Remote Endpoint information (like ipaddress,
  *                          port, reference uri and transport type) to
  *                          which the ping message has to be sent.
- * @param[out]  index       index of array list.
  * @return  KeepAlive entry to send ping message.
  */
-static KeepAliveEntry_t *GetEntryFromEndpoint(const CAEndpoint_t *endpoint, size_t *index);
+static KeepAliveEntry_t *GetEntryFromEndpoint(const CAEndpoint_t *endpoint);
+
+/**
+ * (Re)schedules the KeepAlive timer of an entry after its timeStamp,
+ * interval or sentPingMsg changed.
+ * @param[in]   entry       KeepAlive entry.
+ */
+static void ScheduleKeepAliveEntry(KeepAliveEntry_t *entry);
+
+/**
+ * Removes the KeepAlive timer of an entry from the timer wheel.
+ * @param[in]   entry       KeepAlive entry.
+ */
+static void UnscheduleKeepAliveEntry(KeepAliveEntry_t *entry);
 
 /**
  * Add keepalive entry.
@@ -237,6 +281,22 @@ static OCStackResult AddResourceTypeNameToPayload(OCRepPayload *payload);
  */
 static OCStackResult AddResourceInterfaceNameToPayload(OCRepPayload *payload);
 
+static uint32_t HashKeepAliveEndpoint(const void *key)
+{
+    const CAEndpoint_t *endpoint = (const CAEndpoint_t *)key;
+    uint32_t hash = oc_hashmap_hash_bytes(&endpoint->port, sizeof(endpoint->port), 0);
+    return oc_hashmap_hash_bytes(endpoint->addr,
+                                 strlen(endpoint->addr), hash);
+}
+
+static bool EqualKeepAliveEndpoint(const void *key1, const void *key2)
+{
+    const CAEndpoint_t *endpoint1 = (const CAEndpoint_t *)key1;
+    const CAEndpoint_t *endpoint2 = (const CAEndpoint_t *)key2;
+    return (endpoint1->port == endpoint2->port)
+           && !strncmp(endpoint1->addr, endpoint2->addr, sizeof(endpoint1->addr));
+}
+
 OCStackResult InitializeKeepAlive(OCMode mode)
 {
     OIC_LOG(DEBUG, TAG, "InitializeKeepAlive IN");
@@ -259,13 +319,15 @@ OCStackResult InitializeKeepAlive(OCMode mode)
 
     if (!g_keepAliveConnectionTable)
     {
-        g_keepAliveConnectionTable = u_arraylist_create();
+        g_keepAliveConnectionTable = oc_hashmap_new(HashKeepAliveEndpoint,
+                                                    EqualKeepAliveEndpoint);
         if (NULL == g_keepAliveConnectionTable)
         {
             OIC_LOG(ERROR, TAG, "Creating KeepAlive Table failed");
             TerminateKeepAlive(mode);
             return OC_STACK_ERROR;
         }
+        g_keepAliveWheelTick = OICGetCurrentTime(TIME_IN_US) / KEEPALIVE_WHEEL_TICK;
     }
 
     g_isKeepAliveInitialized = true;
@@ -296,7 +358,19 @@ OCStackResult TerminateKeepAlive(OCMode mode)
 
     if (NULL != g_keepAliveConnectionTable)
     {
-        u_arraylist_destroy(g_keepAliveConnectionTable);
+        // Every entry of the table is in the timer wheel.
+        for (size_t i = 0; i < KEEPALIVE_WHEEL_SLOTS; i++)
+        {
+            while (g_keepAliveWheel[i])
+            {
+                KeepAliveEntry_t *entry = g_keepAliveWheel[i];
+                g_keepAliveWheel[i] = entry->next;
+                OICFree(entry->intervalInfo);
+                OICFree(entry);
+            }
+        }
+        g_keepAliveScheduledCount = 0;
+        oc_hashmap_free(g_keepAliveConnectionTable);
         g_keepAliveConnectionTable = NULL;
     }
 
@@ -405,8 +479,7 @@ OCStackResult SendKeepAliveResponse(OCServerRequest *request,
     CAEndpoint_t endpoint = {.adapter = CA_DEFAULT_ADAPTER};
     CopyDevAddrToEndpoint(&request->devAddr, &endpoint);
 
-    size_t index = 0;
-    KeepAliveEntry_t *entry = GetEntryFromEndpoint(&endpoint, &index);
+    KeepAliveEntry_t *entry = GetEntryFromEndpoint(&endpoint);
     int64_t interval = (entry) ? entry->interval : 0;
 
     // Create KeepAlive payload to send response message.
@@ -457,8 +530,7 @@ OCEntityHandlerResult HandleKeepAlivePOSTRequest(OCServerRequest *request,
     CAEndpoint_t endpoint = { .adapter = CA_DEFAULT_ADAPTER };
     CopyDevAddrToEndpoint(&request->devAddr, &endpoint);
 
-    size_t index = 0;
-    KeepAliveEntry_t *entry = GetEntryFromEndpoint(&endpoint, &index);
+    KeepAliveEntry_t *entry = GetEntryFromEndpoint(&endpoint);
     if (!entry)
     {
         OIC_LOG(ERROR, TAG, "Received the first keepalive message from client");
@@ -480,6 +552,7 @@ OCEntityHandlerResult HandleKeepAlivePOSTRequest(OCServerRequest *request,
     entry->interval = interval;
     OIC_LOG_V(DEBUG, TAG, "Received interval is [%" PRId64 "]", entry->interval);
     entry->timeStamp = OICGetCurrentTime(TIME_IN_US);
+    ScheduleKeepAliveEntry(entry);
 
     OCPayloadDestroy(ocPayload);
 
@@ -495,8 +568,7 @@ OCStackResult HandleKeepAliveResponse(const CAEndpoint_t *endPoint,
     OIC_LOG(DEBUG, TAG, "HandleKeepAliveResponse IN");
 
     // Get entry from KeepAlive table.
-    size_t index = 0;
-    KeepAliveEntry_t *entry = GetEntryFromEndpoint(endPoint, &index);
+    KeepAliveEntry_t *entry = GetEntryFromEndpoint(endPoint);
     if (!entry)
     {
         // Receive response message about find /oic/ping request.
@@ -535,6 +607,7 @@ OCStackResult HandleKeepAliveResponse(const CAEndpoint_t *endPoint,
     {
         // Set sentPingMsg values with false.
         entry->sentPingMsg = false;
+        ScheduleKeepAliveEntry(entry);
 
         // Check the received interval value.
         int64_t interval = 0;
@@ -546,75 +619,224 @@ OCStackResult HandleKeepAliveResponse(const CAEndpoint_t *endPoint,
     return OC_STACK_OK;
 }
 
-void ProcessKeepAlive()
+/**
+ * Time the KeepAlive timer of entry is due. in microseconds.
+ */
+static uint64_t GetKeepAliveDueTime(const KeepAliveEntry_t *entry)
 {
-    if (!g_isKeepAliveInitialized)
+    uint64_t timeout = KEEPALIVE_RESPONSE_TIMEOUT_SEC * USECS_PER_SEC;
+    if (!(OC_CLIENT == entry->mode && entry->sentPingMsg))
+    {
+        timeout *= entry->interval;
+    }
+    return entry->timeStamp + timeout;
+}
+
+void UnscheduleKeepAliveEntry(KeepAliveEntry_t *entry)
+{
+    if (!entry->scheduled)
     {
-        OIC_LOG(ERROR, TAG, "KeepAlive not initialized");
         return;
     }
 
-    size_t len = u_arraylist_length(g_keepAliveConnectionTable);
+    if (entry->prev)
+    {
+        entry->prev->next = entry->next;
+    }
+    else
+    {
+        g_keepAliveWheel[entry->slot] = entry->next;
+    }
+    if (entry->next)
+    {
+        entry->next->prev = entry->prev;
+    }
+    entry->prev = NULL;
+    entry->next = NULL;
+    entry->scheduled = false;
+    g_keepAliveScheduledCount--;
+}
 
-    for (size_t i = 0; i < len; i++)
+void ScheduleKeepAliveEntry(KeepAliveEntry_t *entry)
+{
+    UnscheduleKeepAliveEntry(entry);
+
+    entry->dueTime = GetKeepAliveDueTime(entry);
+
+    // Timers that are already due go to the first slot still to be processed.
+    uint64_t tick = entry->dueTime / KEEPALIVE_WHEEL_TICK;
+    if (tick < g_keepAliveWheelTick)
     {
-        KeepAliveEntry_t *entry = (KeepAliveEntry_t *)u_arraylist_get(g_keepAliveConnectionTable,
-                                                                      i);
-        if (NULL == entry)
+        tick = g_keepAliveWheelTick;
+    }
+
+    entry->slot = (size_t)(tick % KEEPALIVE_WHEEL_SLOTS);
+    entry->next = g_keepAliveWheel[entry->slot];
+    if (entry->next)
+    {
+        entry->next->prev = entry;
+    }
+    g_keepAliveWheel[entry->slot] = entry;
+    entry->scheduled = true;
+    g_keepAliveScheduledCount++;
+}
+
+/**
+ * Handles the KeepAlive timer of an entry that is due.
+ */
+static void HandleKeepAliveTimeout(KeepAliveEntry_t *entry)
+{
+    if (OC_CLIENT == entry->mode)
+    {
+        if (entry->sentPingMsg)
         {
-            continue;
+            /*
+             * If an OIC Client does not receive the response within 1 minutes,
+             * terminate the connection.
+             * In this case the timeStamp means last time sent ping message.
+             */
+            OIC_LOG(DEBUG, TAG, "Client does not receive the response within 1 minutes.");
+
+            // Send message to disconnect session.
+            SendDisconnectMessage(entry);
+            return;
         }
 
-        uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
-        if (OC_CLIENT == entry->mode)
+        // Increase interval value.
+        IncreaseInterval(entry);
+
+        OCStackResult result = SendPingMessage(entry);
+        if (OC_STACK_OK != result)
         {
-            if (entry->sentPingMsg)
-            {
-                /*
-                 * If an OIC Client does not receive the response within 1 minutes,
-                 * terminate the connection.
-                 * In this case the timeStamp means last time sent ping message.
-                 */
-                if ((KEEPALIVE_RESPONSE_TIMEOUT_SEC * USECS_PER_SEC) <= currentTime - entry->timeStamp)
-                {
-                    OIC_LOG(DEBUG, TAG, "Client does not receive the response within 1 minutes.");
+            // The timer is rescheduled with the increased interval from the last ping,
+            // so sending is tried again once that interval has passed.
+            OIC_LOG(ERROR, TAG, "Failed to send ping request");
+        }
+        ScheduleKeepAliveEntry(entry);
+    }
+    else if (OC_SERVER == entry->mode)
+    {
+        /*
+         * If an OIC Server does not receive a PUT request to ping resource
+         * within the specified interval time, terminate the connection.
+         * In this case the timeStamp means last time received ping message.
+         */
+        OIC_LOG(DEBUG, TAG, "Server does not receive a PUT request.");
+        SendDisconnectMessage(entry);
+    }
+    else
+    {
+        ScheduleKeepAliveEntry(entry);
+    }
+}
 
-                    // Send message to disconnect session.
-                    SendDisconnectMessage(entry);
-                }
-            }
-            else
+/**
+ * Lowers nextEventTime to the time until the next KeepAlive timer is due.
+ * The wheel is walked from the first slot still to be processed up to the first slot
+ * that holds a timer of the current round; timers of later rounds in the slots passed
+ * on the way are taken into account as well.
+ */
+static void UpdateKeepAliveEventTime(uint64_t currentTime, uint32_t *nextEventTime)
+{
+    if (!g_keepAliveScheduledCount)
+    {
+        return;
+    }
+
+    uint64_t dueTime = UINT64_MAX;
+    for (size_t i = 0; i < KEEPALIVE_WHEEL_SLOTS; i++)
+    {
+        uint64_t tick = g_keepAliveWheelTick + i;
+        bool found = false;
+        for (KeepAliveEntry_t *entry = g_keepAliveWheel[tick % KEEPALIVE_WHEEL_SLOTS]; entry;
+             entry = entry->next)
+        {
+            if (entry->dueTime < dueTime)
             {
-                if ((entry->interval * KEEPALIVE_RESPONSE_TIMEOUT_SEC * USECS_PER_SEC)
-                        <= currentTime - entry->timeStamp)
-                {
-                    // Increase interval value.
-                    IncreaseInterval(entry);
-
-                    OCStackResult result = SendPingMessage(entry);
-                    if (OC_STACK_OK != result)
-                    {
-                        OIC_LOG(ERROR, TAG, "Failed to send ping request");
-                        continue;
-                    }
-                }
+                dueTime = entry->dueTime;
             }
+            found = found || (entry->dueTime / KEEPALIVE_WHEEL_TICK <= tick);
         }
-        else if (OC_SERVER == entry->mode)
+        if (found)
         {
-            /*
-             * If an OIC Server does not receive a PUT request to ping resource
-             * within the specified interval time, terminate the connection.
-             * In this case the timeStamp means last time received ping message.
-             */
-            if ((entry->interval * KEEPALIVE_RESPONSE_TIMEOUT_SEC * USECS_PER_SEC)
-                    <= currentTime - entry->timeStamp)
+            break;
+        }
+    }
+
+    if (UINT64_MAX == dueTime)
+    {
+        return;
+    }
+
+    uint64_t milliSeconds = (dueTime > currentTime) ?
+        (dueTime - currentTime + USECS_PER_MSEC - 1) / USECS_PER_MSEC : 0;
+    if (milliSeconds < *nextEventTime)
+    {
+        *nextEventTime = (uint32_t)milliSeconds;
+    }
+}
+
+void ProcessKeepAlive(uint32_t *nextEventTime)
+{
+    ProcessKeepAliveTimers(OICGetCurrentTime(TIME_IN_US), nextEventTime);
+}
+
+void ProcessKeepAliveTimers(uint64_t currentTime, uint32_t *nextEventTime)
+{
+    if (!g_isKeepAliveInitialized)
+    {
+        OIC_LOG(ERROR, TAG, "KeepAlive not initialized");
+        return;
+    }
+
+    uint64_t currentTick = currentTime / KEEPALIVE_WHEEL_TICK;
+    if (currentTick < g_keepAliveWheelTick)
+    {
+        currentTick = g_keepAliveWheelTick;
+    }
+
+    // Only the slots of the ticks passed since the last call can hold due timers;
+    // collect those first, as handling a timer reschedules or removes its entry.
+    // Nothing is due while the wheel is empty.
+    uint64_t lastTick = currentTick;
+    if (lastTick - g_keepAliveWheelTick >= KEEPALIVE_WHEEL_SLOTS)
+    {
+        lastTick = g_keepAliveWheelTick + KEEPALIVE_WHEEL_SLOTS - 1;
+    }
+
+    KeepAliveEntry_t *dueEntries = NULL;
+    for (uint64_t tick = g_keepAliveWheelTick;
+         g_keepAliveScheduledCount && tick <= lastTick; tick++)
+    {
+        KeepAliveEntry_t *entry = g_keepAliveWheel[tick % KEEPALIVE_WHEEL_SLOTS];
+        while (entry)
+        {
+            KeepAliveEntry_t *next = entry->next;
+            if (entry->dueTime <= currentTime)
             {
-                OIC_LOG(DEBUG, TAG, "Server does not receive a PUT request.");
-                SendDisconnectMessage(entry);
+                UnscheduleKeepAliveEntry(entry);
+                entry->next = dueEntries;
+                dueEntries = entry;
             }
+            entry = next;
         }
     }
+
+    // The slot of the current tick may still get timers due later in this tick.
+    g_keepAliveWheelTick = currentTick;
+
+    while (dueEntries)
+    {
+        KeepAliveEntry_t *entry = dueEntries;
+        dueEntries = entry->next;
+        entry->next = NULL;
+        HandleKeepAliveTimeout(entry);
+    }
+
+    if (nextEventTime)
+    {
+        UpdateKeepAliveEventTime(currentTime, nextEventTime);
+    }
 }
 
 void IncreaseInterval(KeepAliveEntry_t *entry)
@@ -639,14 +861,16 @@ OCStackResult SendDisconnectMessage(const KeepAliveEntry_t *entry)
      * If CA get the empty message from RI, CA will disconnect a connection.
      */
 
-    OCStackResult result = RemoveKeepAliveEntry(&entry->remoteAddr);
+    // Removing the entry frees it.
+    CAEndpoint_t remoteAddr = entry->remoteAddr;
+    OCStackResult result = RemoveKeepAliveEntry(&remoteAddr);
     if (result != OC_STACK_OK)
     {
         return result;
     }
 
     CARequestInfo_t requestInfo = { .method = CA_POST };
-    result = CASendRequest(&entry->remoteAddr, &requestInfo);
+    result = CASendRequest(&remoteAddr, &requestInfo);
     return CAResultToOCResult(result);
 }
 
@@ -672,6 +896,7 @@ OCStackResult SendPingMessage(KeepAliveEntry_t *entry)
     // Update timeStamp with time sent ping message for next ping message.
     entry->timeStamp = OICGetCurrentTime(TIME_IN_US);
     entry->sentPingMsg = true;
+    ScheduleKeepAliveEntry(entry);
 
     OIC_LOG_V(DEBUG, TAG, "Client sent ping message, interval [%" PRId64 "]", entry->interval);
 
@@ -698,7 +923,7 @@ OCStackApplicationResult PingRequestCallback(void* ctx, OCDoHandle handle,
     return OC_STACK_DELETE_TRANSACTION;
 }
 
-KeepAliveEntry_t *GetEntryFromEndpoint(const CAEndpoint_t *endpoint, size_t *index)
+KeepAliveEntry_t *GetEntryFromEndpoint(const CAEndpoint_t *endpoint)
 {
     if (!g_keepAliveConnectionTable)
     {
@@ -706,27 +931,13 @@ KeepAliveEntry_t *GetEntryFromEndpoint(const CAEndpoint_t *endpoint, size_t *ind
         return NULL;
     }
 
-    size_t len = u_arraylist_length(g_keepAliveConnectionTable);
-
-    for (size_t i = 0; i < len; i++)
+    KeepAliveEntry_t *entry = (KeepAliveEntry_t *)oc_hashmap_get(g_keepAliveConnectionTable,
+                                                                 endpoint);
+    if (entry)
     {
-        KeepAliveEntry_t *entry = (KeepAliveEntry_t *)u_arraylist_get(g_keepAliveConnectionTable,
-                                                                      i);
-        if (NULL == entry)
-        {
-            continue;
-        }
-
-        if (!strncmp(entry->remoteAddr.addr, endpoint->addr, sizeof(entry->remoteAddr.addr))
-                && (entry->remoteAddr.port == endpoint->port))
-        {
-            OIC_LOG(DEBUG, TAG, "Connection Info found in KeepAlive table");
-            *index = i;
-            return entry;
-        }
+        OIC_LOG(DEBUG, TAG, "Connection Info found in KeepAlive table");
     }
-
-    return NULL;
+    return entry;
 }
 
 KeepAliveEntry_t *AddKeepAliveEntry(const CAEndpoint_t *endpoint, OCMode mode,
@@ -766,7 +977,7 @@ KeepAliveEntry_t *AddKeepAliveEntry(const CAEndpoint_t *endpoint, OCMode mode,
     }
     entry->interval = entry->intervalInfo[0];
 
-    bool result = u_arraylist_add(g_keepAliveConnectionTable, (void *)entry);
+    bool result = oc_hashmap_put(g_keepAliveConnectionTable, &entry->remoteAddr, entry);
     if (!result)
     {
         OIC_LOG(ERROR, TAG, "Adding node to head failed");
@@ -774,6 +985,7 @@ KeepAliveEntry_t *AddKeepAliveEntry(const CAEndpoint_t *endpoint, OCMode mode,
         OICFree(entry);
         return NULL;
     }
+    ScheduleKeepAliveEntry(entry);
 
     return entry;
 }
@@ -782,8 +994,7 @@ OCStackResult RemoveKeepAliveEntry(const CAEndpoint_t *endpoint)
 {
     VERIFY_NON_NULL(endpoint, FATAL, OC_STACK_INVALID_PARAM);
 
-    size_t index = 0;
-    KeepAliveEntry_t *entry = GetEntryFromEndpoint(endpoint, &index);
+    KeepAliveEntry_t *entry = GetEntryFromEndpoint(endpoint);
     if (!entry)
     {
         OIC_LOG(ERROR, TAG, "There is no entry in keepalive table.");
@@ -791,12 +1002,13 @@ OCStackResult RemoveKeepAliveEntry(const CAEndpoint_t *endpoint)
     }
 
     KeepAliveEntry_t *removedEntry = (KeepAliveEntry_t *)
-                                        u_arraylist_remove(g_keepAliveConnectionTable, index);
+                                        oc_hashmap_remove(g_keepAliveConnectionTable, endpoint);
     if (NULL == removedEntry)
     {
         OIC_LOG(ERROR, TAG, "Removed Entry is NULL");
         return OC_STACK_ERROR;
     }
+    UnscheduleKeepAliveEntry(removedEntry);
 
     OIC_LOG_V(DEBUG, TAG, "Remove Connection Info from KeepAlive table, "
              "remote addr=%s port:%d", removedEntry->remoteAddr.addr,
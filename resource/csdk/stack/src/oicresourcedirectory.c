@@ -28,6 +28,7 @@
 
 #include "octypes.h"
 #include "ocstack.h"
+#include "ocstackinternal.h"
 #include "ocrandom.h"
 #include "logger.h"
 #include "ocpayload.h"
@@ -51,13 +52,51 @@ static const char *gRDPath = "RD.db";
 
 static sqlite3 *gRDDB = NULL;
 
+/*
+ * Statements of the discovery queries. They are prepared once for the connection,
+ * which is kept open across discovery requests.
+ */
+typedef enum
+{
+    RD_DEVICES_STMT = 0,
+    RD_LINKS_STMT,
+    RD_LINKS_BY_RT_STMT,
+    RD_LINKS_BY_IF_STMT,
+    RD_LINKS_BY_RT_IF_STMT,
+    RD_LINK_RT_STMT,
+    RD_LINK_IF_STMT,
+    RD_LINK_EP_STMT,
+    RD_STMT_COUNT
+} RDStatement;
+
+static const char *gRDStatementSql[RD_STMT_COUNT] =
+{
+    "SELECT ID,di FROM RD_DEVICE_LIST",
+    "SELECT * FROM RD_DEVICE_LINK_LIST WHERE DEVICE_ID=@deviceId",
+    "SELECT * FROM RD_DEVICE_LINK_LIST WHERE DEVICE_ID=@deviceId "
+        "AND ins IN (SELECT LINK_ID FROM RD_LINK_RT WHERE rt=@resourceType)",
+    "SELECT * FROM RD_DEVICE_LINK_LIST WHERE DEVICE_ID=@deviceId "
+        "AND ins IN (SELECT LINK_ID FROM RD_LINK_IF WHERE if=@interfaceType)",
+    "SELECT * FROM RD_DEVICE_LINK_LIST WHERE DEVICE_ID=@deviceId "
+        "AND ins IN (SELECT LINK_ID FROM RD_LINK_RT WHERE rt=@resourceType) "
+        "AND ins IN (SELECT LINK_ID FROM RD_LINK_IF WHERE if=@interfaceType)",
+    "SELECT rt FROM RD_LINK_RT WHERE LINK_ID=@id",
+    "SELECT if FROM RD_LINK_IF WHERE LINK_ID=@id",
+    "SELECT ep,pri FROM RD_LINK_EP WHERE LINK_ID=@id"
+};
+
+static sqlite3_stmt *gRDStatements[RD_STMT_COUNT] = { NULL };
+
+/* Column indices of RD_DEVICE_LIST table */
+static const uint8_t id_index = 0;
+static const uint8_t di_index = 1;
+
 /* Column indices of RD_DEVICE_LINK_LIST table */
 static const uint8_t ins_index = 0;
 static const uint8_t href_index = 1;
 static const uint8_t rel_index = 2;
 static const uint8_t anchor_index = 3;
 static const uint8_t bm_index = 4;
-static const uint8_t d_index = 5;
 
 /* Column indices of RD_LINK_RT table */
 static const uint8_t rt_value_index = 0;
@@ -85,6 +124,7 @@ OCStackResult OC_CALL OCRDDatabaseSetStorageFilename(const char *filename)
         return OC_STACK_INVALID_PARAM;
     }
     gRDPath = filename;
+    OCRDDatabaseDiscoveryClose();
     return OC_STACK_OK;
 }
 
@@ -101,6 +141,76 @@ static void errorCallback(void *arg, int errCode, const char *errMsg)
     OIC_LOG_V(ERROR, TAG, "SQLLite Error: %s : %d", errMsg, errCode);
 }
 
+void OCRDDatabaseDiscoveryClose()
+{
+    for (size_t i = 0; i < RD_STMT_COUNT; i++)
+    {
+        sqlite3_finalize(gRDStatements[i]);
+        gRDStatements[i] = NULL;
+    }
+    sqlite3_close(gRDDB);
+    gRDDB = NULL;
+}
+
+/* Opens the database unless it is open and its file has not been replaced since. */
+static OCStackResult OpenDatabase()
+{
+    if (gRDDB)
+    {
+        int moved = 0;
+        if (SQLITE_OK == sqlite3_file_control(gRDDB, "main", SQLITE_FCNTL_HAS_MOVED, &moved)
+            && !moved)
+        {
+            return OC_STACK_OK;
+        }
+        OCRDDatabaseDiscoveryClose();
+    }
+
+    if (SQLITE_OK == sqlite3_config(SQLITE_CONFIG_LOG, errorCallback))
+    {
+        OIC_LOG_V(INFO, TAG, "SQLite debugging log initialized.");
+    }
+
+    /*
+     * The RD server writes the database in WAL mode. A read-only connection cannot open
+     * it when the shared memory file does not exist yet, so writes are disabled instead.
+     */
+    OCStackResult result = OC_STACK_OK;
+    VERIFY_SQLITE(sqlite3_open_v2(OCRDDatabaseGetStorageFilename(), &gRDDB,
+                    SQLITE_OPEN_READWRITE, NULL));
+    VERIFY_SQLITE(sqlite3_exec(gRDDB, "PRAGMA query_only = ON", NULL, NULL, NULL));
+
+exit:
+    if (OC_STACK_OK != result)
+    {
+        OCRDDatabaseDiscoveryClose();
+    }
+    return result;
+}
+
+/* Returns the prepared statement, it must be reset with ResetStatement after use. */
+static int GetStatement(RDStatement id, sqlite3_stmt **stmt)
+{
+    int res = SQLITE_OK;
+    if (!gRDStatements[id])
+    {
+        res = sqlite3_prepare_v2(gRDDB, gRDStatementSql[id], -1, &gRDStatements[id], NULL);
+    }
+    *stmt = gRDStatements[id];
+    return res;
+}
+
+static int ResetStatement(sqlite3_stmt *stmt)
+{
+    if (!stmt)
+    {
+        return SQLITE_OK;
+    }
+    int res = sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return res;
+}
+
 static OCStackResult appendStringLL(OCStringLL **type, const unsigned char *value)
 {
     OCStackResult result;
@@ -147,7 +257,6 @@ static OCStackResult ResourcePayloadCreate(sqlite3_stmt *stmt, OCDiscoveryPayloa
     sqlite3_stmt *stmtRT = NULL;
     sqlite3_stmt *stmtIF = NULL;
     sqlite3_stmt *stmtEP = NULL;
-    sqlite3_stmt *stmtDI = NULL;
     while (SQLITE_ROW == res)
     {
         resourcePayload = (OCResourcePayload *)OICCalloc(1, sizeof(OCResourcePayload));
@@ -158,8 +267,7 @@ static OCStackResult ResourcePayloadCreate(sqlite3_stmt *stmt, OCDiscoveryPayloa
         const unsigned char *rel = sqlite3_column_text(stmt, rel_index);
         const unsigned char *anchor = sqlite3_column_text(stmt, anchor_index);
         sqlite3_int64 bitmap = sqlite3_column_int64(stmt, bm_index);
-        sqlite3_int64 deviceId = sqlite3_column_int64(stmt, d_index);
-        OIC_LOG_V(DEBUG, TAG, " %s %" PRId64, uri, (int64_t) deviceId);
+        OIC_LOG_V(DEBUG, TAG, " %s", uri);
 
         resourcePayload->uri = OICStrdup((char *)uri);
         VERIFY_NON_NULL(resourcePayload->uri)
@@ -174,9 +282,7 @@ static OCStackResult ResourcePayloadCreate(sqlite3_stmt *stmt, OCDiscoveryPayloa
             VERIFY_NON_NULL(resourcePayload->anchor);
         }
 
-        const char rt[] = "SELECT rt FROM RD_LINK_RT WHERE LINK_ID=@id";
-        int rtSize = (int)sizeof(rt);
-        VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, rt, rtSize, &stmtRT, NULL));
+        VERIFY_SQLITE(GetStatement(RD_LINK_RT_STMT, &stmtRT));
         VERIFY_SQLITE(sqlite3_bind_int64(stmtRT, sqlite3_bind_parameter_index(stmtRT, "@id"), id));
         while (SQLITE_ROW == sqlite3_step(stmtRT))
         {
@@ -187,12 +293,10 @@ static OCStackResult ResourcePayloadCreate(sqlite3_stmt *stmt, OCDiscoveryPayloa
                 goto exit;
             }
         }
-        VERIFY_SQLITE(sqlite3_finalize(stmtRT));
+        VERIFY_SQLITE(ResetStatement(stmtRT));
         stmtRT = NULL;
 
-        const char itf[] = "SELECT if FROM RD_LINK_IF WHERE LINK_ID=@id";
-        int itfSize = (int)sizeof(itf);
-        VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, itf, itfSize, &stmtIF, NULL));
+        VERIFY_SQLITE(GetStatement(RD_LINK_IF_STMT, &stmtIF));
         VERIFY_SQLITE(sqlite3_bind_int64(stmtIF, sqlite3_bind_parameter_index(stmtIF, "@id"), id));
         while (SQLITE_ROW == sqlite3_step(stmtIF))
         {
@@ -203,14 +307,12 @@ static OCStackResult ResourcePayloadCreate(sqlite3_stmt *stmt, OCDiscoveryPayloa
                 goto exit;
             }
         }
-        VERIFY_SQLITE(sqlite3_finalize(stmtIF));
+        VERIFY_SQLITE(ResetStatement(stmtIF));
         stmtIF = NULL;
 
         resourcePayload->bitmap = (uint8_t)(bitmap & (OC_OBSERVABLE | OC_DISCOVERABLE));
 
-        const char ep[] = "SELECT ep,pri FROM RD_LINK_EP WHERE LINK_ID=@id";
-        int epSize = (int)sizeof(ep);
-        VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, ep, epSize, &stmtEP, NULL));
+        VERIFY_SQLITE(GetStatement(RD_LINK_EP_STMT, &stmtEP));
         VERIFY_SQLITE(sqlite3_bind_int64(stmtEP, sqlite3_bind_parameter_index(stmtEP, "@id"), id));
         while (SQLITE_ROW == sqlite3_step(stmtEP))
         {
@@ -232,27 +334,9 @@ static OCStackResult ResourcePayloadCreate(sqlite3_stmt *stmt, OCDiscoveryPayloa
             *tmp = epPayload;
             epPayload = NULL;
         }
-        VERIFY_SQLITE(sqlite3_finalize(stmtEP));
+        VERIFY_SQLITE(ResetStatement(stmtEP));
         stmtEP = NULL;
 
-        const char di[] = "SELECT di FROM RD_DEVICE_LIST "
-            "INNER JOIN RD_DEVICE_LINK_LIST ON RD_DEVICE_LINK_LIST.DEVICE_ID = RD_DEVICE_LIST.ID "
-            "WHERE RD_DEVICE_LINK_LIST.DEVICE_ID=@deviceId";
-        int diSize = (int)sizeof(di);
-        const uint8_t di_index = 0;
-        VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, di, diSize, &stmtDI, NULL));
-        VERIFY_SQLITE(sqlite3_bind_int64(stmtDI, sqlite3_bind_parameter_index(stmtDI, "@deviceId"), deviceId));
-        res = sqlite3_step(stmtDI);
-        if (SQLITE_ROW == res || SQLITE_DONE == res)
-        {
-            const unsigned char *tempDi = sqlite3_column_text(stmtDI, di_index);
-            OIC_LOG_V(DEBUG, TAG, " %s", tempDi);
-            discPayload->sid = OICStrdup((char *)tempDi);
-            VERIFY_NON_NULL(discPayload->sid);
-        }
-        VERIFY_SQLITE(sqlite3_finalize(stmtDI));
-        stmtDI = NULL;
-
         OCDiscoveryPayloadAddNewResource(discPayload, resourcePayload);
         resourcePayload = NULL;
         res = sqlite3_step(stmt);
@@ -260,17 +344,16 @@ static OCStackResult ResourcePayloadCreate(sqlite3_stmt *stmt, OCDiscoveryPayloa
     result = OC_STACK_OK;
 
 exit:
-    sqlite3_finalize(stmtDI);
-    sqlite3_finalize(stmtEP);
-    sqlite3_finalize(stmtIF);
-    sqlite3_finalize(stmtRT);
+    ResetStatement(stmtEP);
+    ResetStatement(stmtIF);
+    ResetStatement(stmtRT);
     OICFree(epPayload);
     OCDiscoveryResourceDestroy(resourcePayload);
     return result;
 }
 
 static OCStackResult CheckResources(const char *interfaceType, const char *resourceType,
-        OCDiscoveryPayload *discPayload)
+        sqlite3_int64 deviceId, OCDiscoveryPayload *discPayload)
 {
     if (!interfaceType && !resourceType)
     {
@@ -281,86 +364,51 @@ static OCStackResult CheckResources(const char *interfaceType, const char *resou
         return OC_STACK_INTERNAL_SERVER_ERROR;
     }
 
-    size_t sidLength = strlen(discPayload->sid);
     size_t resourceTypeLength = resourceType ? strlen(resourceType) : 0;
     size_t interfaceTypeLength = interfaceType ? strlen(interfaceType) : 0;
 
-    if ((sidLength > INT_MAX) ||
-        (resourceTypeLength > INT_MAX) ||
+    if ((resourceTypeLength > INT_MAX) ||
         (interfaceTypeLength > INT_MAX))
     {
         return OC_STACK_INVALID_QUERY;
     }
 
+    /* All links implement the ll and baseline interfaces */
+    if (interfaceType && (0 == strcmp(interfaceType, OC_RSRVD_INTERFACE_LL) ||
+                0 == strcmp(interfaceType, OC_RSRVD_INTERFACE_DEFAULT)))
+    {
+        interfaceType = NULL;
+    }
+
+    RDStatement id;
+    if (resourceType)
+    {
+        id = interfaceType ? RD_LINKS_BY_RT_IF_STMT : RD_LINKS_BY_RT_STMT;
+    }
+    else
+    {
+        id = interfaceType ? RD_LINKS_BY_IF_STMT : RD_LINKS_STMT;
+    }
+
     OCStackResult result = OC_STACK_OK;
     sqlite3_stmt *stmt = NULL;
+    VERIFY_SQLITE(GetStatement(id, &stmt));
+    VERIFY_SQLITE(sqlite3_bind_int64(stmt, sqlite3_bind_parameter_index(stmt, "@deviceId"),
+                    deviceId));
     if (resourceType)
     {
-        if (!interfaceType || 0 == strcmp(interfaceType, OC_RSRVD_INTERFACE_LL) ||
-                0 == strcmp(interfaceType, OC_RSRVD_INTERFACE_DEFAULT))
-        {
-            const char input[] = "SELECT * FROM RD_DEVICE_LINK_LIST "
-                                "INNER JOIN RD_DEVICE_LIST ON RD_DEVICE_LINK_LIST.DEVICE_ID=RD_DEVICE_LIST.ID "
-                                "INNER JOIN RD_LINK_RT ON RD_DEVICE_LINK_LIST.INS=RD_LINK_RT.LINK_ID "
-                                "WHERE RD_DEVICE_LIST.di LIKE @di AND RD_LINK_RT.rt LIKE @resourceType";
-            int inputSize = (int)sizeof(input);
-            VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, input, inputSize, &stmt, NULL));
-            VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@di"),
-                            discPayload->sid, (int)sidLength, SQLITE_STATIC));
-            VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@resourceType"),
-                            resourceType, (int)resourceTypeLength, SQLITE_STATIC));
-        }
-        else
-        {
-            const char input[] = "SELECT * FROM RD_DEVICE_LINK_LIST "
-                                "INNER JOIN RD_DEVICE_LIST ON RD_DEVICE_LINK_LIST.DEVICE_ID=RD_DEVICE_LIST.ID "
-                                "INNER JOIN RD_LINK_RT ON RD_DEVICE_LINK_LIST.INS=RD_LINK_RT.LINK_ID "
-                                "INNER JOIN RD_LINK_IF ON RD_DEVICE_LINK_LIST.INS=RD_LINK_IF.LINK_ID "
-                                "WHERE RD_DEVICE_LIST.di LIKE @di "
-                                "AND RD_LINK_RT.rt LIKE @resourceType "
-                                "AND RD_LINK_IF.if LIKE @interfaceType";
-            int inputSize = (int)sizeof(input);
-            VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, input, inputSize, &stmt, NULL));
-            VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@di"),
-                            discPayload->sid, (int)sidLength, SQLITE_STATIC));
-            VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@resourceType"),
-                            resourceType, (int)resourceTypeLength, SQLITE_STATIC));
-            VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@interfaceType"),
-                            interfaceType, (int)interfaceTypeLength, SQLITE_STATIC));
-        }
-        result = ResourcePayloadCreate(stmt, discPayload);
+        VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@resourceType"),
+                        resourceType, (int)resourceTypeLength, SQLITE_STATIC));
     }
-    else if (interfaceType)
+    if (interfaceType)
     {
-        if (0 == strcmp(interfaceType, OC_RSRVD_INTERFACE_LL) ||
-                0 == strcmp(interfaceType, OC_RSRVD_INTERFACE_DEFAULT))
-        {
-            const char input[] = "SELECT * FROM RD_DEVICE_LINK_LIST "
-                                "INNER JOIN RD_DEVICE_LIST ON RD_DEVICE_LINK_LIST.DEVICE_ID=RD_DEVICE_LIST.ID "
-                                "WHERE RD_DEVICE_LIST.di LIKE @di";
-            int inputSize = (int)sizeof(input);
-            VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, input, inputSize, &stmt, NULL));
-            VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@di"),
-                            discPayload->sid, (int)sidLength, SQLITE_STATIC));
-        }
-        else
-        {
-            const char input[] = "SELECT * FROM RD_DEVICE_LINK_LIST "
-                                "INNER JOIN RD_DEVICE_LIST ON RD_DEVICE_LINK_LIST.DEVICE_ID=RD_DEVICE_LIST.ID "
-                                "INNER JOIN RD_LINK_IF ON RD_DEVICE_LINK_LIST.INS=RD_LINK_IF.LINK_ID "
-                                "WHERE RD_DEVICE_LIST.di LIKE @di AND RD_LINK_IF.if LIKE @interfaceType";
-            int inputSize = (int)sizeof(input);
-            VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, input, inputSize, &stmt, NULL));
-            VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@di"),
-                            discPayload->sid, (int)sidLength, SQLITE_STATIC));
-            VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@interfaceType"),
-                            interfaceType, (int)interfaceTypeLength, SQLITE_STATIC));
-        }
-        result = ResourcePayloadCreate(stmt, discPayload);
+        VERIFY_SQLITE(sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@interfaceType"),
+                        interfaceType, (int)interfaceTypeLength, SQLITE_STATIC));
     }
+    result = ResourcePayloadCreate(stmt, discPayload);
 
 exit:
-    sqlite3_finalize(stmt);
+    ResetStatement(stmt);
     return result;
 }
 
@@ -384,24 +432,17 @@ OCStackResult OC_CALL OCRDDatabaseDiscoveryPayloadCreate(const char *interfaceTy
         goto exit;
     }
 
-    if (SQLITE_OK == sqlite3_config(SQLITE_CONFIG_LOG, errorCallback))
-    {
-        OIC_LOG_V(INFO, TAG, "SQLite debugging log initialized.");
-    }
-    sqlite3_open_v2(OCRDDatabaseGetStorageFilename(), &gRDDB, SQLITE_OPEN_READONLY, NULL);
-    if (!gRDDB)
+    result = OpenDatabase();
+    if (OC_STACK_OK != result)
     {
-        result = OC_STACK_ERROR;
         goto exit;
     }
 
     const char *serverID = OCGetServerInstanceIDString();
-    const char input[] = "SELECT di FROM RD_DEVICE_LIST";
-    int inputSize = (int)sizeof(input);
-    const uint8_t di_index = 0;
-    VERIFY_SQLITE(sqlite3_prepare_v2(gRDDB, input, inputSize, &stmt, NULL));
+    VERIFY_SQLITE(GetStatement(RD_DEVICES_STMT, &stmt));
     while (SQLITE_ROW == sqlite3_step(stmt))
     {
+        sqlite3_int64 deviceId = sqlite3_column_int64(stmt, id_index);
         const unsigned char *di = sqlite3_column_text(stmt, di_index);
         if (0 == strcmp((const char *)di, serverID))
         {
@@ -413,7 +454,7 @@ OCStackResult OC_CALL OCRDDatabaseDiscoveryPayloadCreate(const char *interfaceTy
         (*tail)->sid = (char *)OICCalloc(1, UUID_STRING_SIZE);
         VERIFY_NON_NULL((*tail)->sid);
         memcpy((*tail)->sid, di, UUID_STRING_SIZE);
-        result = CheckResources(interfaceType, resourceType, *tail);
+        result = CheckResources(interfaceType, resourceType, deviceId, *tail);
         if (OC_STACK_OK == result)
         {
             tail = &(*tail)->next;
@@ -433,8 +474,7 @@ exit:
         head = NULL;
     }
     *payload = head;
-    sqlite3_finalize(stmt);
-    sqlite3_close(gRDDB);
+    ResetStatement(stmt);
     return result;
 }
 #endif
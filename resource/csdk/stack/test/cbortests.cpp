@@ -46,6 +46,7 @@ extern "C"
 #include <string.h>
 
 #include <iostream>
+#include <string>
 #include <stdint.h>
 
 #include "gtest_helper.h"
@@ -310,3 +311,81 @@ TEST(CborHeterogeneousArrayTest, ConvertParseTest)
     OICFree(payload_cbor);
     OCPayloadDestroy(payload_out);
 }
+
+TEST(CborConvertToBufferTest, EncodesIntoBufferOrExactAllocation)
+{
+    OCRepPayload* payload_in = OCRepPayloadCreate();
+    ASSERT_TRUE(payload_in != NULL);
+    EXPECT_TRUE(OCRepPayloadSetPropString(payload_in, "member", "value"));
+
+    uint8_t *payload_cbor = NULL;
+    size_t payload_cbor_size = 0;
+    EXPECT_EQ(OC_STACK_OK, OCConvertPayload((OCPayload*) payload_in, OC_FORMAT_CBOR,
+            &payload_cbor, &payload_cbor_size));
+
+    // Fits: encoded into the buffer
+    uint8_t buffer[OC_ENCODE_BUFFER_SIZE];
+    uint8_t *out = NULL;
+    size_t size = 0;
+    EXPECT_EQ(OC_STACK_OK, OCConvertPayloadToBuffer((OCPayload*) payload_in, OC_FORMAT_CBOR,
+            buffer, sizeof(buffer), &out, &size));
+    EXPECT_EQ(&buffer[0], out);
+    ASSERT_EQ(payload_cbor_size, size);
+    EXPECT_EQ(0, memcmp(payload_cbor, out, size));
+
+    // Does not fit: encoded into an allocation
+    out = NULL;
+    size = 0;
+    EXPECT_EQ(OC_STACK_OK, OCConvertPayloadToBuffer((OCPayload*) payload_in, OC_FORMAT_CBOR,
+            buffer, payload_cbor_size - 1, &out, &size));
+    EXPECT_NE(&buffer[0], out);
+    ASSERT_EQ(payload_cbor_size, size);
+    EXPECT_EQ(0, memcmp(payload_cbor, out, size));
+    OICFree(out);
+
+    // No buffer
+    out = NULL;
+    size = 0;
+    EXPECT_EQ(OC_STACK_OK, OCConvertPayloadToBuffer((OCPayload*) payload_in, OC_FORMAT_CBOR,
+            NULL, 0, &out, &size));
+    ASSERT_EQ(payload_cbor_size, size);
+    EXPECT_EQ(0, memcmp(payload_cbor, out, size));
+    OICFree(out);
+
+    OICFree(payload_cbor);
+    OCRepPayloadDestroy(payload_in);
+}
+
+TEST(CborParseNameTest, ShortAndLongNames)
+{
+    const char *shortName = "name";
+    std::string longName(100, 'n');
+    std::string exactName(64, 'e');
+
+    OCRepPayload* payload_in = OCRepPayloadCreate();
+    ASSERT_TRUE(payload_in != NULL);
+    EXPECT_TRUE(OCRepPayloadSetPropInt(payload_in, shortName, 1));
+    EXPECT_TRUE(OCRepPayloadSetPropInt(payload_in, longName.c_str(), 2));
+    EXPECT_TRUE(OCRepPayloadSetPropInt(payload_in, exactName.c_str(), 3));
+
+    uint8_t *payload_cbor = NULL;
+    size_t payload_cbor_size = 0;
+    EXPECT_EQ(OC_STACK_OK, OCConvertPayload((OCPayload*) payload_in, OC_FORMAT_CBOR,
+            &payload_cbor, &payload_cbor_size));
+    OCRepPayloadDestroy(payload_in);
+
+    OCPayload* payload_out = NULL;
+    EXPECT_EQ(OC_STACK_OK, OCParsePayload(&payload_out, OC_FORMAT_CBOR, PAYLOAD_TYPE_REPRESENTATION,
+                                          payload_cbor, payload_cbor_size));
+
+    int64_t value = 0;
+    EXPECT_TRUE(OCRepPayloadGetPropInt((OCRepPayload*) payload_out, shortName, &value));
+    EXPECT_EQ(1, value);
+    EXPECT_TRUE(OCRepPayloadGetPropInt((OCRepPayload*) payload_out, longName.c_str(), &value));
+    EXPECT_EQ(2, value);
+    EXPECT_TRUE(OCRepPayloadGetPropInt((OCRepPayload*) payload_out, exactName.c_str(), &value));
+    EXPECT_EQ(3, value);
+
+    OICFree(payload_cbor);
+    OCPayloadDestroy(payload_out);
+}
@@ -0,0 +1,310 @@
+//******************************************************************
+//
+// Copyright 2017 Open Connectivity Foundation All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+//-----------------------------------------------------------------------------
+// Measures what an incoming request costs on its way from the received CoAP
+// datagram to the entity handler: the heap bytes and allocations made by CA
+// while parsing the PDU into a CARequestInfo_t, and by the RI layer until the
+// entity handler is called. Every copy of the URI, options, token and payload
+// on this path is made into a new allocation, except for the URI and query
+// that the RI layer splits into fixed arrays.
+//
+// Usage: requestbench [requests] [payload size]
+//-----------------------------------------------------------------------------
+
+#include "iotivity_config.h"
+
+extern "C"
+{
+    #include "ocstack.h"
+    #include "ocstackinternal.h"
+    #include "ocpayload.h"
+    #include "ocpayloadcbor.h"
+    #include "oic_malloc.h"
+    #include "oic_string.h"
+    #include "caprotocolmessage.h"
+    #include "caremotehandler.h"
+}
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define DEFAULT_REQUEST_COUNT 10000
+#define DEFAULT_PAYLOAD_SIZE 256
+#define BENCH_RESOURCE_URI "/bench/request"
+#define BENCH_REQUEST_URI BENCH_RESOURCE_URI "?if=" OC_RSRVD_INTERFACE_DEFAULT
+
+//-----------------------------------------------------------------------------
+// Heap accounting. Only allocations of the benchmark thread are counted, so the
+// CA threads that run at the same time are not.
+//-----------------------------------------------------------------------------
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t num, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+}
+
+typedef struct
+{
+    size_t allocations;
+    size_t bytes;
+} HeapStats;
+
+static __thread bool t_counting = false;
+static HeapStats g_heapStats;
+
+static void CountAllocation(size_t size)
+{
+    if (t_counting)
+    {
+        g_heapStats.allocations++;
+        g_heapStats.bytes += size;
+    }
+}
+
+extern "C" void *malloc(size_t size)
+{
+    CountAllocation(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t num, size_t size)
+{
+    CountAllocation(num * size);
+    return __libc_calloc(num, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    CountAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+//-----------------------------------------------------------------------------
+// Server side
+//-----------------------------------------------------------------------------
+static HeapStats g_handlerStats;
+static size_t g_handledRequests = 0;
+
+static OCEntityHandlerResult BenchEntityHandler(OCEntityHandlerFlag flag,
+                                                OCEntityHandlerRequest *entityHandlerRequest,
+                                                void *callbackParam)
+{
+    (void)flag;
+    (void)callbackParam;
+
+    // Everything up to here belongs to the request path.
+    t_counting = false;
+    g_handlerStats = g_heapStats;
+    g_handledRequests++;
+
+    OCEntityHandlerResponse response;
+    memset(&response, 0, sizeof(response));
+    response.requestHandle = entityHandlerRequest->requestHandle;
+    response.ehResult = OC_EH_OK;
+    if (OC_STACK_OK != OCDoResponse(&response))
+    {
+        return OC_EH_ERROR;
+    }
+    return OC_EH_OK;
+}
+
+//-----------------------------------------------------------------------------
+// Client side
+//-----------------------------------------------------------------------------
+static bool MakeRequestDatagram(CAMethod_t method, const CAEndpoint_t *endpoint,
+                                const uint8_t *payload, size_t payloadSize,
+                                std::vector<uint8_t> &datagram)
+{
+    char token[] = "benchtok";
+    char uri[] = BENCH_REQUEST_URI;
+    CAInfo_t info;
+    memset(&info, 0, sizeof(info));
+    info.type = CA_MSG_NONCONFIRM;
+    info.messageId = 1;
+    info.token = token;
+    info.tokenLength = (uint8_t)strlen(token);
+    info.resourceUri = uri;
+    info.acceptFormat = CA_FORMAT_APPLICATION_CBOR;
+    if (payloadSize)
+    {
+        info.payload = (CAPayload_t)payload;
+        info.payloadSize = payloadSize;
+        info.payloadFormat = CA_FORMAT_APPLICATION_CBOR;
+    }
+
+    CAPDUOptions_t options;
+    coap_transport_t transport = COAP_UDP;
+    coap_pdu_t *pdu = CAGeneratePDU(method, &info, endpoint, &options, &transport);
+    if (!pdu)
+    {
+        return false;
+    }
+    const uint8_t *bytes = (const uint8_t *)pdu->transport_hdr;
+    datagram.assign(bytes, bytes + pdu->length);
+    coap_delete_pdu(pdu);
+    return true;
+}
+
+static bool EncodeRequestPayload(size_t size, uint8_t **payload, size_t *payloadSize)
+{
+    OCRepPayload *rep = OCRepPayloadCreate();
+    if (!rep)
+    {
+        return false;
+    }
+    std::string value(size, 'v');
+    bool encoded = OCRepPayloadSetPropString(rep, "value", value.c_str())
+                   && (OC_STACK_OK == OCConvertPayload((OCPayload *)rep, OC_FORMAT_CBOR,
+                                                       payload, payloadSize));
+    OCRepPayloadDestroy(rep);
+    return encoded;
+}
+
+// Feeds the datagram through CA's parser and the RI request handling, the way
+// a received request goes, and prints the average cost per request.
+static bool RunRequests(const char *name, const CAEndpoint_t *endpoint,
+                        std::vector<uint8_t> &datagram, size_t count)
+{
+    HeapStats caTotal = { 0, 0 };
+    HeapStats riTotal = { 0, 0 };
+    size_t handled = g_handledRequests;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+    {
+        // A new message ID for every request, as a client would use.
+        uint16_t messageId = (uint16_t)(i + 1);
+        datagram[2] = (uint8_t)(messageId >> 8);
+        datagram[3] = (uint8_t)(messageId & 0xFF);
+
+        memset(&g_heapStats, 0, sizeof(g_heapStats));
+        memset(&g_handlerStats, 0, sizeof(g_handlerStats));
+        t_counting = true;
+
+        uint32_t code = CA_NOT_FOUND;
+        coap_pdu_t *pdu = CAParsePDU((const char *)datagram.data(), datagram.size(), &code,
+                                     endpoint);
+        CARequestInfo_t *requestInfo = (CARequestInfo_t *)OICCalloc(1, sizeof(*requestInfo));
+        if (!pdu || !requestInfo
+            || CA_STATUS_OK != CAGetRequestInfoFromPDU(pdu, endpoint, requestInfo))
+        {
+            t_counting = false;
+            coap_delete_pdu(pdu);
+            OICFree(requestInfo);
+            fprintf(stderr, "%s: failed to parse the request\n", name);
+            return false;
+        }
+        coap_delete_pdu(pdu);
+        HeapStats caStats = g_heapStats;
+
+        OCHandleRequests(endpoint, requestInfo);
+        t_counting = false;
+        CADestroyRequestInfoInternal(requestInfo);
+
+        caTotal.allocations += caStats.allocations;
+        caTotal.bytes += caStats.bytes;
+        riTotal.allocations += g_handlerStats.allocations - caStats.allocations;
+        riTotal.bytes += g_handlerStats.bytes - caStats.bytes;
+
+        // Let the CA threads send the responses.
+        OCProcess();
+    }
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+
+    if (g_handledRequests - handled != count)
+    {
+        fprintf(stderr, "%s: %zu of %zu requests reached the entity handler\n",
+                name, g_handledRequests - handled, count);
+        return false;
+    }
+
+    printf("%-6s %8zu %10zu %10.1f %10.1f %10.1f %10.1f %10.0f\n", name, count,
+           datagram.size(),
+           (double)caTotal.bytes / count, (double)caTotal.allocations / count,
+           (double)riTotal.bytes / count, (double)riTotal.allocations / count,
+           (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / count);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? (size_t)strtoul(argv[1], NULL, 10) : DEFAULT_REQUEST_COUNT;
+    size_t payloadSize = (argc > 2) ? (size_t)strtoul(argv[2], NULL, 10) : DEFAULT_PAYLOAD_SIZE;
+    if (!count)
+    {
+        fprintf(stderr, "Usage: %s [requests] [payload size]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (OC_STACK_OK != OCInit(NULL, 0, OC_SERVER))
+    {
+        fprintf(stderr, "OCInit failed\n");
+        return EXIT_FAILURE;
+    }
+
+    OCResourceHandle handle = NULL;
+    if (OC_STACK_OK != OCCreateResource(&handle, "core.bench", OC_RSRVD_INTERFACE_DEFAULT,
+                                        BENCH_RESOURCE_URI, BenchEntityHandler, NULL,
+                                        OC_DISCOVERABLE))
+    {
+        fprintf(stderr, "OCCreateResource failed\n");
+        OCStop();
+        return EXIT_FAILURE;
+    }
+
+    // Responses go to the discard port of the loopback address.
+    CAEndpoint_t endpoint;
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.adapter = CA_ADAPTER_IP;
+    endpoint.flags = CA_IPV4;
+    OICStrcpy(endpoint.addr, sizeof(endpoint.addr), "127.0.0.1");
+    endpoint.port = 9;
+
+    uint8_t *payload = NULL;
+    size_t encodedSize = 0;
+    std::vector<uint8_t> getDatagram;
+    std::vector<uint8_t> postDatagram;
+    bool ok = EncodeRequestPayload(payloadSize, &payload, &encodedSize)
+              && MakeRequestDatagram(CA_GET, &endpoint, NULL, 0, getDatagram)
+              && MakeRequestDatagram(CA_POST, &endpoint, payload, encodedSize, postDatagram);
+    OICFree(payload);
+    if (!ok)
+    {
+        fprintf(stderr, "Failed to create the requests\n");
+        OCStop();
+        return EXIT_FAILURE;
+    }
+
+    // The RI bytes of POST include the representation parsed from the payload.
+    printf("%-6s %8s %10s %10s %10s %10s %10s %10s\n", "method", "requests", "PDU bytes",
+           "CA bytes", "CA allocs", "RI bytes", "RI allocs", "ns/request");
+    ok = RunRequests("GET", &endpoint, getDatagram, count)
+         && RunRequests("POST", &endpoint, postDatagram, count);
+
+    OCStop();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
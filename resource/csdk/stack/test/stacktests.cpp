@@ -29,6 +29,14 @@ extern "C"
     #include "oic_string.h"
     #include "oic_time.h"
     #include "ocresourcehandler.h"
+    #include "ocobserve.h"
+    #include "occollection.h"
+    #include "ocserverrequest.h"
+    #include "ocpayloadcbor.h"
+    #include "utlist.h"
+#ifdef TCP_ADAPTER
+    #include "oickeepalive.h"
+#endif
 }
 
 #include <gtest/gtest.h>
@@ -48,6 +56,8 @@ extern "C"
 #include <string.h>
 
 #include <iostream>
+#include <string>
+#include <vector>
 #include <stdint.h>
 
 #include "gtest_helper.h"
@@ -181,6 +191,75 @@ uint8_t InitResourceIndex()
 #endif
 }
 
+#define TEST_TOKEN_LENGTH 4
+
+/**
+ * Fills in the address of a made-up peer on the loopback interface.
+ */
+static void GetTestDevAddr(OCDevAddr *devAddr, OCTransportAdapter adapter, uint16_t port)
+{
+    memset(devAddr, 0, sizeof(*devAddr));
+    devAddr->adapter = adapter;
+    devAddr->flags = OC_IP_USE_V4;
+    OICStrcpy(devAddr->addr, sizeof(devAddr->addr), "127.0.0.1");
+    devAddr->port = port;
+}
+
+/**
+ * Fills in a made-up token of TEST_TOKEN_LENGTH bytes, told apart by its id.
+ */
+static void GetTestToken(uint8_t *token, uint8_t id)
+{
+    token[0] = 0x7e;
+    token[1] = 0x57;
+    token[2] = 0x00;
+    token[3] = id;
+}
+
+/**
+ * Adds a server request as if the peer at devAddr had sent it.
+ */
+static OCServerRequest *AddTestServerRequest(OCMethod method, const char *uri, const char *query,
+                                             uint8_t tokenId, OCDevAddr *devAddr,
+                                             uint8_t *payload, size_t size)
+{
+    char uriBuffer[MAX_URI_LENGTH];
+    char queryBuffer[MAX_QUERY_LENGTH];
+    OICStrcpy(uriBuffer, sizeof(uriBuffer), uri);
+    OICStrcpy(queryBuffer, sizeof(queryBuffer), query ? query : "");
+    uint8_t token[TEST_TOKEN_LENGTH];
+    GetTestToken(token, tokenId);
+
+    OCServerRequest *request = NULL;
+    EXPECT_EQ(OC_STACK_OK, AddServerRequest(&request, 0, 0, 0, method, 0,
+                                            OC_OBSERVE_NO_OPTION, OC_LOW_QOS,
+                                            query ? queryBuffer : NULL, NULL,
+                                            OC_FORMAT_CBOR, payload, (CAToken_t) token,
+                                            sizeof(token), uriBuffer, size, OC_FORMAT_CBOR,
+                                            OC_SPEC_VERSION_VALUE, devAddr));
+    return request;
+}
+
+/**
+ * Responds to a request with a representation holding a count.
+ */
+static OCStackResult RespondWithCount(OCRequestHandle requestHandle,
+                                      OCEntityHandlerResult ehResult, int count)
+{
+    OCRepPayload *payload = OCRepPayloadCreate();
+    EXPECT_TRUE(payload != NULL);
+    EXPECT_TRUE(OCRepPayloadSetPropInt(payload, "count", count));
+
+    OCEntityHandlerResponse response;
+    memset(&response, 0, sizeof(response));
+    response.requestHandle = requestHandle;
+    response.ehResult = ehResult;
+    response.payload = (OCPayload*) payload;
+    OCStackResult result = OCDoResponse(&response);
+    OCRepPayloadDestroy(payload);
+    return result;
+}
+
 extern "C" uint32_t g_ocStackStartCount;
 
 OCDeviceProperties* getTestDeviceProps()
@@ -303,6 +382,27 @@ TEST(StackStart, StackStartSuccessiveInits)
     EXPECT_EQ(0u, g_ocStackStartCount);
 }
 
+#ifdef WITH_PROCESS_EVENT
+TEST(StackStart, ProcessEvent)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    uint32_t nextEventTime = 0;
+    EXPECT_EQ(OC_STACK_INVALID_PARAM, OCProcessEvent(NULL));
+    EXPECT_EQ(OC_STACK_ERROR, OCProcessEvent(&nextEventTime));
+
+    oc_event processEvent = oc_event_new();
+    ASSERT_TRUE(NULL != processEvent);
+    OCRegisterProcessEvent(processEvent);
+    EXPECT_EQ(OC_STACK_OK, OCInit("127.0.0.1", 5683, OC_SERVER));
+    EXPECT_EQ(OC_STACK_OK, OCProcessEvent(&nextEventTime));
+    // Nothing is due yet.
+    EXPECT_LT(0u, nextEventTime);
+    OCRegisterProcessEvent(NULL);
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+    oc_event_free(processEvent);
+}
+#endif
+
 TEST(StackStart, SetPlatformInfoValid)
 {
     itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
@@ -1893,6 +1993,161 @@ TEST(StackBind, BindContainedResourceBad)
     EXPECT_EQ(OC_STACK_OK, OCStop());
 }
 
+TEST(StackBind, SetCollectionBatchConcurrency)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting SetCollectionBatchConcurrency test");
+    InitStack(OC_SERVER);
+
+    OCResourceHandle containerHandle;
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&containerHandle,
+                                            "core.led",
+                                            "core.rw",
+                                            "/a/kitchen",
+                                            0,
+                                            NULL,
+                                            OC_DISCOVERABLE|OC_OBSERVABLE));
+
+    EXPECT_EQ(OC_STACK_ERROR, OCSetCollectionBatchConcurrency((OCResourceHandle) 0, 4));
+    EXPECT_EQ(OC_STACK_INVALID_PARAM,
+              OCSetCollectionBatchConcurrency((OCResourceHandle) &containerHandle, 4));
+    EXPECT_EQ(OC_STACK_OK, OCSetCollectionBatchConcurrency(containerHandle, 4));
+    EXPECT_EQ(4, ((OCResource *) containerHandle)->batchConcurrency);
+    EXPECT_EQ(OC_STACK_OK, OCSetCollectionBatchConcurrency(containerHandle, 0));
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+static int g_batchChildRequests = 0;
+
+static OCStackResult RespondToBatch(OCRequestHandle requestHandle)
+{
+    return RespondWithCount(requestHandle, OC_EH_OK, g_batchChildRequests);
+}
+
+// Child resources with a non-NULL ctx are slow; the test responds for them later.
+static OCEntityHandlerResult BatchChildRequest(OCEntityHandlerFlag flag,
+        OCEntityHandlerRequest *request, void *ctx)
+{
+    OC_UNUSED(flag);
+    g_batchChildRequests++;
+    if (ctx)
+    {
+        return OC_EH_SLOW;
+    }
+    EXPECT_EQ(OC_STACK_OK, RespondToBatch(request->requestHandle));
+    return OC_EH_OK;
+}
+
+static OCResourceHandle CreateBatchCollection(int numChildren, bool slow)
+{
+    OCResourceHandle collection = NULL;
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&collection, "core.led", "core.rw", "/a/batch",
+                                            0, NULL, OC_DISCOVERABLE));
+    for (int i = 0; i < numChildren; i++)
+    {
+        char uri[MAX_URI_LENGTH];
+        snprintf(uri, sizeof(uri), "/a/batch/%d", i);
+        OCResourceHandle child = NULL;
+        EXPECT_EQ(OC_STACK_OK, OCCreateResource(&child, "core.led", "core.rw", uri,
+                                                BatchChildRequest, slow ? &g_batchChildRequests : NULL,
+                                                OC_DISCOVERABLE));
+        EXPECT_EQ(OC_STACK_OK, OCBindResource(collection, child));
+    }
+    return collection;
+}
+
+#define BATCH_TOKEN_ID 0xba
+
+static OCServerRequest *GetBatchRequest()
+{
+    uint8_t token[TEST_TOKEN_LENGTH];
+    GetTestToken(token, BATCH_TOKEN_ID);
+    return GetServerRequestUsingToken((CAToken_t) token, sizeof(token));
+}
+
+static OCStackResult SendBatchRequest(OCResourceHandle collection)
+{
+    OCDevAddr devAddr;
+    GetTestDevAddr(&devAddr, OC_ADAPTER_IP, 5700);
+    OCServerRequest *request = AddTestServerRequest(OC_REST_GET, "/a/batch",
+                                                    OC_RSRVD_INTERFACE "=" OC_RSRVD_INTERFACE_BATCH,
+                                                    BATCH_TOKEN_ID, &devAddr, NULL, 0);
+    if (!request)
+    {
+        return OC_STACK_NO_MEMORY;
+    }
+
+    OCEntityHandlerRequest ehRequest;
+    EXPECT_EQ(OC_STACK_OK, FormOCEntityHandlerRequest(&ehRequest, (OCRequestHandle) request,
+                                                      OC_REST_GET, &request->devAddr,
+                                                      collection, request->query,
+                                                      PAYLOAD_TYPE_REPRESENTATION,
+                                                      OC_FORMAT_CBOR, NULL, 0, 0, NULL,
+                                                      OC_OBSERVE_NO_OPTION, 0, 0));
+    return DefaultCollectionEntityHandler(OC_REQUEST_FLAG, &ehRequest);
+}
+
+TEST(StackCollection, BatchCappedSlowChildren)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting BatchCappedSlowChildren test");
+    InitStack(OC_SERVER);
+
+    OCResourceHandle collection = CreateBatchCollection(5, true);
+    EXPECT_EQ(OC_STACK_OK, OCSetCollectionBatchConcurrency(collection, 2));
+
+    g_batchChildRequests = 0;
+    EXPECT_EQ(OC_STACK_SLOW_RESOURCE, SendBatchRequest(collection));
+    EXPECT_EQ(2, g_batchChildRequests);
+
+    // The next children get the request on the stack thread, not inside OCDoResponse.
+    OCServerRequest *request = GetBatchRequest();
+    ASSERT_TRUE(request != NULL);
+    EXPECT_EQ(OC_STACK_OK, RespondToBatch((OCRequestHandle) request));
+    EXPECT_EQ(OC_STACK_OK, RespondToBatch((OCRequestHandle) request));
+    EXPECT_EQ(2, g_batchChildRequests);
+    EXPECT_TRUE(HasBatchContinuations());
+
+    EXPECT_EQ(OC_STACK_OK, OCProcess());
+    EXPECT_EQ(4, g_batchChildRequests);
+    EXPECT_FALSE(HasBatchContinuations());
+
+    EXPECT_EQ(OC_STACK_OK, RespondToBatch((OCRequestHandle) request));
+    EXPECT_EQ(OC_STACK_OK, OCProcess());
+    EXPECT_EQ(5, g_batchChildRequests);
+
+    // All children have the request; the last responses complete it.
+    EXPECT_EQ(OC_STACK_OK, RespondToBatch((OCRequestHandle) request));
+    EXPECT_FALSE(HasBatchContinuations());
+    EXPECT_TRUE(GetBatchRequest() != NULL);
+    EXPECT_EQ(OC_STACK_OK, RespondToBatch((OCRequestHandle) request));
+    EXPECT_TRUE(GetBatchRequest() == NULL);
+    EXPECT_EQ(5, g_batchChildRequests);
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+TEST(StackCollection, BatchMoreThan255Children)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting BatchMoreThan255Children test");
+    InitStack(OC_SERVER);
+
+    OCResourceHandle collection = CreateBatchCollection(300, false);
+    EXPECT_EQ(300u, GetNumOfResourcesInCollection((OCResource *) collection));
+    // Children that respond right away don't count against the limit.
+    EXPECT_EQ(OC_STACK_OK, OCSetCollectionBatchConcurrency(collection, 1));
+
+    g_batchChildRequests = 0;
+    EXPECT_EQ(OC_STACK_OK, SendBatchRequest(collection));
+    EXPECT_EQ(300, g_batchChildRequests);
+    EXPECT_TRUE(GetBatchRequest() == NULL);
+    EXPECT_FALSE(HasBatchContinuations());
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
 TEST(StackBind, BindContainedResourceGood)
 {
     itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
@@ -2330,6 +2585,436 @@ TEST(StackResourceAccess, DeleteMiddleResource)
     EXPECT_EQ(OC_STACK_OK, OCStop());
 }
 
+TEST(StackResourceAccess, GetResourceHandleAtUriAfterDelete)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting GetResourceHandleAtUriAfterDelete test");
+    InitStack(OC_SERVER);
+
+    const int numCreated = 300;
+    std::vector<OCResourceHandle> handles(numCreated);
+    for (int i = 0; i < numCreated; i++)
+    {
+        std::string uri = "/a/led" + std::to_string(i);
+        EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handles[i],
+                                                "core.led",
+                                                "core.rw",
+                                                uri.c_str(),
+                                                0,
+                                                NULL,
+                                                OC_DISCOVERABLE|OC_OBSERVABLE));
+    }
+
+    EXPECT_EQ(handles[0], OCGetResourceHandleAtUri("/a/led0"));
+    EXPECT_EQ(handles[numCreated - 1], OCGetResourceHandleAtUri("/a/led299"));
+
+    EXPECT_EQ(OC_STACK_OK, OCDeleteResource(handles[150]));
+    EXPECT_EQ(NULL, OCGetResourceHandleAtUri("/a/led150"));
+    EXPECT_EQ(NULL, OCGetResourceUri(handles[150]));
+    EXPECT_EQ(OC_STACK_NO_RESOURCE, OCDeleteResource(handles[150]));
+    EXPECT_EQ(handles[151], OCGetResourceHandleAtUri("/a/led151"));
+
+    // The URI can be registered again once the old resource is gone.
+    OCResourceHandle handle;
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle,
+                                            "core.led",
+                                            "core.rw",
+                                            "/a/led150",
+                                            0,
+                                            NULL,
+                                            OC_DISCOVERABLE|OC_OBSERVABLE));
+    EXPECT_EQ(handle, OCGetResourceHandleAtUri("/a/led150"));
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+static OCEntityHandlerResult g_observeResult = OC_EH_OK;
+static int g_observeRequests = 0;
+
+static OCEntityHandlerResult ObserveRequest(OCEntityHandlerFlag flag,
+        OCEntityHandlerRequest *request, void *ctx)
+{
+    OC_UNUSED(flag);
+    OC_UNUSED(ctx);
+    g_observeRequests++;
+    EXPECT_EQ(OC_STACK_OK, RespondWithCount(request->requestHandle, g_observeResult,
+                                            g_observeRequests));
+    return OC_EH_OK;
+}
+
+static void AddTestObserver(OCResourceHandle handle, uint8_t id, const char *query)
+{
+    OCDevAddr devAddr;
+    GetTestDevAddr(&devAddr, OC_ADAPTER_IP, 5683 + id);
+    uint8_t token[TEST_TOKEN_LENGTH];
+    GetTestToken(token, id);
+    EXPECT_EQ(OC_STACK_OK, AddObserver(OCGetResourceUri(handle), query, id,
+                                       (CAToken_t) token, sizeof(token),
+                                       (OCResource *) handle, OC_LOW_QOS,
+                                       OC_FORMAT_CBOR, 0, &devAddr));
+}
+
+static int CountObservers(OCResourceHandle handle)
+{
+    int count = 0;
+    for (ResourceObserver *observer = ((OCResource *) handle)->observersHead; observer;
+         observer = observer->resourceNext)
+    {
+        EXPECT_EQ((OCResource *) handle, observer->resource);
+        count++;
+    }
+    return count;
+}
+
+TEST(StackObserve, ObserversIndexedPerResource)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting ObserversIndexedPerResource test");
+    InitStack(OC_SERVER);
+
+    OCResourceHandle handle0;
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle0, "core.led", "core.rw", "/a/led0",
+                                            ObserveRequest, NULL, OC_OBSERVABLE));
+    OCResourceHandle handle1;
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle1, "core.led", "core.rw", "/a/led1",
+                                            ObserveRequest, NULL, OC_OBSERVABLE));
+
+    AddTestObserver(handle0, 1, NULL);
+    AddTestObserver(handle1, 2, NULL);
+    AddTestObserver(handle0, 3, NULL);
+    EXPECT_EQ(2, CountObservers(handle0));
+    EXPECT_EQ(1, CountObservers(handle1));
+
+    uint8_t token[TEST_TOKEN_LENGTH];
+    GetTestToken(token, 3);
+    EXPECT_EQ(OC_STACK_OK, DeleteObserverUsingToken((CAToken_t) token, sizeof(token)));
+    EXPECT_EQ(1, CountObservers(handle0));
+    EXPECT_EQ(1, CountObservers(handle1));
+
+    // Deleting a resource drops only its own observers.
+    EXPECT_EQ(OC_STACK_OK, OCDeleteResource(handle0));
+    token[3] = 1;
+    EXPECT_TRUE(NULL == GetObserverUsingToken((CAToken_t) token, sizeof(token)));
+    token[3] = 2;
+    EXPECT_TRUE(NULL != GetObserverUsingToken((CAToken_t) token, sizeof(token)));
+    EXPECT_EQ(1, CountObservers(handle1));
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+TEST(StackObserve, NotificationEncodedOncePerQuery)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting NotificationEncodedOncePerQuery test");
+    InitStack(OC_SERVER);
+
+    OCResourceHandle handle;
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle, "core.led", "core.rw", "/a/led",
+                                            ObserveRequest, NULL, OC_OBSERVABLE));
+    AddTestObserver(handle, 1, NULL);
+    AddTestObserver(handle, 2, NULL);
+    AddTestObserver(handle, 3, NULL);
+    AddTestObserver(handle, 4, "if=oic.if.baseline");
+
+    g_observeResult = OC_EH_OK;
+    g_observeRequests = 0;
+    EXPECT_EQ(OC_STACK_OK, OCNotifyAllObservers(handle, OC_NA_QOS));
+    EXPECT_EQ(2, g_observeRequests);
+    EXPECT_EQ(4, CountObservers(handle));
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+TEST(StackObserve, NotificationErrorNotShared)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting NotificationErrorNotShared test");
+    InitStack(OC_SERVER);
+
+    OCResourceHandle handle;
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle, "core.led", "core.rw", "/a/led",
+                                            ObserveRequest, NULL, OC_OBSERVABLE));
+    AddTestObserver(handle, 1, NULL);
+    AddTestObserver(handle, 2, NULL);
+    AddTestObserver(handle, 3, NULL);
+
+    // Each observer of a failing resource gets its own entity handler call.
+    g_observeResult = OC_EH_INTERNAL_SERVER_ERROR;
+    g_observeRequests = 0;
+    OCNotifyAllObservers(handle, OC_NA_QOS);
+    EXPECT_EQ(3, g_observeRequests);
+
+    g_observeResult = OC_EH_OK;
+    g_observeRequests = 0;
+    EXPECT_EQ(OC_STACK_OK, OCNotifyAllObservers(handle, OC_NA_QOS));
+    EXPECT_EQ(1, g_observeRequests);
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+static std::vector<intptr_t> g_deletedCallbacks;
+static ClientCB *g_deleteWithCallback = NULL;
+
+static void DeleteTestCallback(void *context)
+{
+    g_deletedCallbacks.push_back((intptr_t) context);
+    if (g_deleteWithCallback)
+    {
+        ClientCB *cbNode = g_deleteWithCallback;
+        g_deleteWithCallback = NULL;
+        DeleteClientCB(cbNode);
+    }
+}
+
+static ClientCB *AddTestClientCB(intptr_t id, uint32_t ttl)
+{
+    OCCallbackData cbData = { (void *) id, NULL, DeleteTestCallback };
+    CAToken_t token = NULL;
+    EXPECT_EQ(CA_STATUS_OK, CAGenerateToken(&token, CA_MAX_TOKEN_LEN));
+    OCDoHandle handle = (OCDoHandle) OICMalloc(sizeof(uint8_t));
+    EXPECT_TRUE(handle != NULL);
+
+    ClientCB *cbNode = NULL;
+    EXPECT_EQ(OC_STACK_OK, AddClientCB(&cbNode, &cbData, CA_MSG_CONFIRM,
+                                       token, CA_MAX_TOKEN_LEN, NULL, 0, NULL, 0,
+                                       CA_FORMAT_UNDEFINED, &handle, OC_REST_GET, NULL,
+                                       OICStrdup("/a/led"), NULL, ttl));
+    EXPECT_TRUE(cbNode != NULL);
+    return cbNode;
+}
+
+TEST(StackClientCB, LookupByTokenAndHandle)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting LookupByTokenAndHandle test");
+    InitStack(OC_CLIENT);
+
+    const uint32_t ttl = GetTicks(MAX_CB_TIMEOUT_SECONDS * MILLISECONDS_PER_SECOND);
+    std::vector<ClientCB *> cbNodes;
+    for (intptr_t i = 0; i < 100; i++)
+    {
+        cbNodes.push_back(AddTestClientCB(i, ttl));
+    }
+
+    for (ClientCB *cbNode : cbNodes)
+    {
+        // Tokens are matched by value, not by pointer.
+        uint8_t token[CA_MAX_TOKEN_LEN];
+        memcpy(token, cbNode->token, sizeof(token));
+        EXPECT_EQ(cbNode, GetClientCBUsingToken((CAToken_t) token, sizeof(token)));
+        EXPECT_EQ(cbNode, GetClientCBUsingHandle(cbNode->handle));
+    }
+
+    uint8_t token[CA_MAX_TOKEN_LEN];
+    memcpy(token, cbNodes[50]->token, sizeof(token));
+    OCDoHandle handle = cbNodes[50]->handle;
+    DeleteClientCB(cbNodes[50]);
+    EXPECT_TRUE(NULL == GetClientCBUsingToken((CAToken_t) token, sizeof(token)));
+    EXPECT_TRUE(NULL == GetClientCBUsingHandle(handle));
+    EXPECT_EQ(cbNodes[51], GetClientCBUsingHandle(cbNodes[51]->handle));
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+    g_deletedCallbacks.clear();
+}
+
+TEST(StackClientCB, DeleteTimedOutInTTLOrder)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting DeleteTimedOutInTTLOrder test");
+    InitStack(OC_CLIENT);
+    g_deletedCallbacks.clear();
+
+    const uint32_t ttl = GetTicks(MAX_CB_TIMEOUT_SECONDS * MILLISECONDS_PER_SECOND);
+    ClientCB *live = AddTestClientCB(0, ttl);
+    ClientCB *cbNode1 = AddTestClientCB(1, ttl);
+    ClientCB *cbNode2 = AddTestClientCB(2, ttl);
+    ClientCB *cbNode3 = AddTestClientCB(3, ttl);
+    ClientCB *looked = AddTestClientCB(4, ttl);
+
+    // Deadlines in the past, out of insertion order.
+    SetClientCBTTL(cbNode2, 1);
+    SetClientCBTTL(cbNode3, 2);
+    SetClientCBTTL(cbNode1, 3);
+    SetClientCBTTL(looked, 4);
+
+    // The callback that is looked up is kept even though it timed out.
+    EXPECT_EQ(looked, GetClientCBUsingHandle(looked->handle));
+    EXPECT_EQ(std::vector<intptr_t>({ 2, 3, 1 }), g_deletedCallbacks);
+    EXPECT_EQ(live, GetClientCBUsingHandle(live->handle));
+
+    // Observe callbacks do not time out.
+    SetClientCBTTL(looked, 0);
+    EXPECT_EQ(live, GetClientCBUsingHandle(live->handle));
+    EXPECT_EQ(looked, GetClientCBUsingHandle(looked->handle));
+    EXPECT_EQ(3u, g_deletedCallbacks.size());
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+    g_deletedCallbacks.clear();
+}
+
+TEST(StackClientCB, DeleteWhileIterating)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting DeleteWhileIterating test");
+    InitStack(OC_CLIENT);
+    g_deletedCallbacks.clear();
+
+    const uint32_t ttl = GetTicks(MAX_CB_TIMEOUT_SECONDS * MILLISECONDS_PER_SECOND);
+    std::vector<ClientCB *> cbNodes;
+    for (intptr_t i = 0; i < 10; i++)
+    {
+        cbNodes.push_back(AddTestClientCB(i, ttl));
+    }
+
+    ClientCB *out = NULL;
+    ClientCB *tmp = NULL;
+    DL_FOREACH_SAFE(g_cbList, out, tmp)
+    {
+        if ((intptr_t) out->context % 2)
+        {
+            DeleteClientCB(out);
+        }
+    }
+    EXPECT_EQ(std::vector<intptr_t>({ 1, 3, 5, 7, 9 }), g_deletedCallbacks);
+    for (size_t i = 0; i < cbNodes.size(); i += 2)
+    {
+        EXPECT_EQ(cbNodes[i], GetClientCBUsingHandle(cbNodes[i]->handle));
+    }
+
+    // Timing out a callback whose delete callback deletes the next timed out one.
+    g_deletedCallbacks.clear();
+    SetClientCBTTL(cbNodes[2], 1);
+    SetClientCBTTL(cbNodes[4], 2);
+    SetClientCBTTL(cbNodes[6], 3);
+    g_deleteWithCallback = cbNodes[4];
+    EXPECT_EQ(cbNodes[0], GetClientCBUsingHandle(cbNodes[0]->handle));
+    EXPECT_EQ(std::vector<intptr_t>({ 2, 4, 6 }), g_deletedCallbacks);
+    EXPECT_EQ(cbNodes[8], GetClientCBUsingHandle(cbNodes[8]->handle));
+
+    // Deleting all callbacks copes with delete callbacks that delete others.
+    g_deletedCallbacks.clear();
+    g_deleteWithCallback = cbNodes[8];
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+    EXPECT_EQ(std::vector<intptr_t>({ 0, 8 }), g_deletedCallbacks);
+    g_deletedCallbacks.clear();
+}
+
+#ifdef TCP_ADAPTER
+static const uint64_t KEEPALIVE_USECS_PER_SEC = 1000000;
+
+static const uint16_t KEEPALIVE_TEST_PORT = 5699;
+
+static void PostKeepAlive(int64_t interval)
+{
+    static uint8_t requestId = 0;
+
+    OCRepPayload *payload = OCRepPayloadCreate();
+    ASSERT_TRUE(payload != NULL);
+    EXPECT_TRUE(OCRepPayloadSetPropInt(payload, "in", interval));
+    uint8_t *cbor = NULL;
+    size_t size = 0;
+    EXPECT_EQ(OC_STACK_OK, OCConvertPayload((OCPayload *) payload, OC_FORMAT_CBOR,
+                                            &cbor, &size));
+    OCRepPayloadDestroy(payload);
+
+    OCDevAddr devAddr;
+    GetTestDevAddr(&devAddr, OC_ADAPTER_TCP, KEEPALIVE_TEST_PORT);
+    OCServerRequest *request = AddTestServerRequest(OC_REST_POST, KEEPALIVE_RESOURCE_URI, NULL,
+                                                    ++requestId, &devAddr, cbor, size);
+    OICFree(cbor);
+    ASSERT_TRUE(request != NULL);
+
+    OCResource *resource = (OCResource *) OCGetResourceHandleAtUri(KEEPALIVE_RESOURCE_URI);
+    ASSERT_TRUE(resource != NULL);
+    HandleKeepAliveRequest(request, resource);
+}
+
+static uint32_t GetNextKeepAliveEvent(uint64_t currentTime)
+{
+    uint32_t nextEventTime = UINT32_MAX;
+    ProcessKeepAliveTimers(currentTime, &nextEventTime);
+    return nextEventTime;
+}
+
+TEST(StackKeepAlive, AddEntry)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting KeepAlive AddEntry test");
+    InitStack(OC_SERVER);
+
+    uint64_t start = OICGetCurrentTime(TIME_IN_US);
+    EXPECT_EQ(UINT32_MAX, GetNextKeepAliveEvent(start));
+
+    // The first ping of a client adds its entry, due when the interval has passed.
+    PostKeepAlive(2);
+    uint32_t nextEventTime = GetNextKeepAliveEvent(start);
+    EXPECT_LE(120000u, nextEventTime);
+    EXPECT_GT(125000u, nextEventTime);
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+TEST(StackKeepAlive, RescheduleEntry)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting KeepAlive RescheduleEntry test");
+    InitStack(OC_SERVER);
+
+    uint64_t start = OICGetCurrentTime(TIME_IN_US);
+    PostKeepAlive(2);
+    PostKeepAlive(8);
+    uint32_t nextEventTime = GetNextKeepAliveEvent(start);
+    EXPECT_LE(480000u, nextEventTime);
+    EXPECT_GT(485000u, nextEventTime);
+
+    // Nothing is left due at the old time, so the entry is still there afterwards.
+    nextEventTime = GetNextKeepAliveEvent(start + 130 * KEEPALIVE_USECS_PER_SEC);
+    EXPECT_LE(350000u, nextEventTime);
+    EXPECT_GT(355000u, nextEventTime);
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+TEST(StackKeepAlive, TimeoutRemovesEntry)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting KeepAlive TimeoutRemovesEntry test");
+    InitStack(OC_SERVER);
+
+    uint64_t start = OICGetCurrentTime(TIME_IN_US);
+    PostKeepAlive(2);
+    uint32_t nextEventTime = GetNextKeepAliveEvent(start + 100 * KEEPALIVE_USECS_PER_SEC);
+    EXPECT_LE(20000u, nextEventTime);
+    EXPECT_GT(25000u, nextEventTime);
+
+    // A server disconnects a client that did not ping within the interval.
+    EXPECT_EQ(UINT32_MAX, GetNextKeepAliveEvent(start + 130 * KEEPALIVE_USECS_PER_SEC));
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+TEST(StackKeepAlive, RemoveEntryOnDisconnect)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting KeepAlive RemoveEntryOnDisconnect test");
+    InitStack(OC_SERVER);
+
+    uint64_t start = OICGetCurrentTime(TIME_IN_US);
+    PostKeepAlive(2);
+    EXPECT_NE(UINT32_MAX, GetNextKeepAliveEvent(start));
+
+    OCDevAddr devAddr;
+    GetTestDevAddr(&devAddr, OC_ADAPTER_TCP, KEEPALIVE_TEST_PORT);
+    CAEndpoint_t endpoint;
+    memset(&endpoint, 0, sizeof(endpoint));
+    CopyDevAddrToEndpoint(&devAddr, &endpoint);
+    HandleKeepAliveConnCB(&endpoint, false, false);
+    EXPECT_EQ(UINT32_MAX, GetNextKeepAliveEvent(start));
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+#endif
+
 // Visual Studio versions earlier than 2015 have bugs in is_pod and report the wrong answer.
 #if !defined(_MSC_VER) || (_MSC_VER >= 1900)
 TEST(PODTests, OCHeaderOption)
@@ -2437,6 +3122,44 @@ TEST(StackPayload, CloneByteString)
     OCRepPayloadDestroy(clone);
 }
 
+TEST(StackPayload, ManyValuesKeepOrder)
+{
+    const int count = 40;
+    char name[16];
+
+    OCRepPayload *payload = OCRepPayloadCreate();
+    ASSERT_TRUE(payload != NULL);
+    for (int i = 0; i < count; ++i)
+    {
+        snprintf(name, sizeof(name), "prop%d", i);
+        EXPECT_TRUE(OCRepPayloadSetPropInt(payload, name, i));
+    }
+    EXPECT_TRUE(OCRepPayloadSetPropInt(payload, "prop7", 700));
+
+    OCRepPayload *clone = OCRepPayloadClone(payload);
+    ASSERT_TRUE(clone != NULL);
+    OCRepPayloadDestroy(payload);
+
+    int64_t value = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        snprintf(name, sizeof(name), "prop%d", i);
+        EXPECT_TRUE(OCRepPayloadGetPropInt(clone, name, &value));
+        EXPECT_EQ((7 == i) ? 700 : i, (int)value);
+    }
+    EXPECT_FALSE(OCRepPayloadGetPropInt(clone, "prop40", &value));
+
+    int i = 0;
+    for (OCRepPayloadValue *val = clone->values; val; val = val->next, ++i)
+    {
+        snprintf(name, sizeof(name), "prop%d", i);
+        EXPECT_STREQ(name, val->name);
+    }
+    EXPECT_EQ(count, i);
+
+    OCRepPayloadDestroy(clone);
+}
+
 TEST(StackUri, Rfc6874_Noop_1)
 {
     char validIPv6Address[] = "FF01:0:0:0:0:0:0:FB";
@@ -30,6 +30,9 @@
 #include <IClientWrapper.h>
 #include <InitializeException.h>
 #include <ResourceInitException.h>
+#ifdef WITH_PROCESS_EVENT
+#include <ocevent.h>
+#endif
 
 namespace OC
 {
@@ -257,6 +260,9 @@ namespace OC
         std::thread m_listeningThread;
         bool m_threadRun;
         std::weak_ptr<std::recursive_mutex> m_csdkLock;
+#ifdef WITH_PROCESS_EVENT
+        oc_event m_processEvent;
+#endif
 
     private:
         PlatformConfig  m_cfg;
@@ -25,6 +25,9 @@
 #include <mutex>
 
 #include <IServerWrapper.h>
+#ifdef WITH_PROCESS_EVENT
+#include <ocevent.h>
+#endif
 
 namespace OC
 {
@@ -95,6 +98,9 @@ namespace OC
         std::thread m_processThread;
         bool m_threadRun;
         std::weak_ptr<std::recursive_mutex> m_csdkLock;
+#ifdef WITH_PROCESS_EVENT
+        oc_event m_processEvent;
+#endif
         PlatformConfig  m_cfg;
     };
 }
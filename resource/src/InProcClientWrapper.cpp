@@ -38,6 +38,9 @@ namespace OC
     InProcClientWrapper::InProcClientWrapper(
         std::weak_ptr<std::recursive_mutex> csdkLock, PlatformConfig cfg)
             : m_threadRun(false), m_csdkLock(csdkLock),
+#ifdef WITH_PROCESS_EVENT
+              m_processEvent(NULL),
+#endif
               m_cfg { cfg }
     {
         // if the config type is server, we ought to never get called.  If the config type
@@ -65,6 +68,18 @@ namespace OC
         {
             if (false == m_threadRun)
             {
+#ifdef WITH_PROCESS_EVENT
+                if (!m_processEvent)
+                {
+                    m_processEvent = oc_event_new();
+                    if (!m_processEvent)
+                    {
+                        OIC_LOG(ERROR, TAG, "oc_event_new failed!");
+                        return OC_STACK_ERROR;
+                    }
+                    OCRegisterProcessEvent(m_processEvent);
+                }
+#endif
                 m_threadRun = true;
                 m_listeningThread = std::thread(&InProcClientWrapper::listeningFunc, this);
             }
@@ -79,8 +94,24 @@ namespace OC
         if (m_threadRun && m_listeningThread.joinable())
         {
             m_threadRun = false;
+#ifdef WITH_PROCESS_EVENT
+            if (m_processEvent)
+            {
+                oc_event_signal(m_processEvent);
+            }
+#endif
             m_listeningThread.join();
         }
+
+#ifdef WITH_PROCESS_EVENT
+        if (m_processEvent)
+        {
+            // Unregistering waits for a signal in progress, so the event can be freed now.
+            OCRegisterProcessEvent(NULL);
+            oc_event_free(m_processEvent);
+            m_processEvent = NULL;
+        }
+#endif
         return OC_STACK_OK;
     }
 
@@ -89,11 +120,18 @@ namespace OC
         while(m_threadRun)
         {
             OCStackResult result;
+#ifdef WITH_PROCESS_EVENT
+            uint32_t nextEventTime = 0;
+#endif
             auto cLock = m_csdkLock.lock();
             if (cLock)
             {
                 std::lock_guard<std::recursive_mutex> lock(*cLock);
+#ifdef WITH_PROCESS_EVENT
+                result = OCProcessEvent(&nextEventTime);
+#else
                 result = OCProcess();
+#endif
             }
             else
             {
@@ -103,10 +141,19 @@ namespace OC
             if (result != OC_STACK_OK)
             {
                 // TODO: do something with result if failed?
+#ifdef WITH_PROCESS_EVENT
+                // Keep polling until the stack can be processed.
+                nextEventTime = 10;
+#endif
             }
 
+#ifdef WITH_PROCESS_EVENT
+            // Sleep until a message is received or a timer of the stack is due.
+            oc_event_wait_for(m_processEvent, nextEventTime);
+#else
             // To minimize CPU utilization we may wish to do this with sleep
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
+#endif
         }
     }
 
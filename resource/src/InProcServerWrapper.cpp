@@ -261,6 +261,9 @@ namespace OC
     InProcServerWrapper::InProcServerWrapper(
         std::weak_ptr<std::recursive_mutex> csdkLock, PlatformConfig cfg)
      : m_threadRun(false), m_csdkLock(csdkLock),
+#ifdef WITH_PROCESS_EVENT
+       m_processEvent(NULL),
+#endif
        m_cfg { cfg }
     {
     }
@@ -271,6 +274,18 @@ namespace OC
 
         if (false == m_threadRun)
         {
+#ifdef WITH_PROCESS_EVENT
+            if (!m_processEvent)
+            {
+                m_processEvent = oc_event_new();
+                if (!m_processEvent)
+                {
+                    OIC_LOG(ERROR, TAG, "oc_event_new failed!");
+                    return OC_STACK_ERROR;
+                }
+                OCRegisterProcessEvent(m_processEvent);
+            }
+#endif
             m_threadRun = true;
             m_processThread = std::thread(&InProcServerWrapper::processFunc, this);
         }
@@ -284,9 +299,25 @@ namespace OC
         if(m_processThread.joinable())
         {
             m_threadRun = false;
+#ifdef WITH_PROCESS_EVENT
+            if (m_processEvent)
+            {
+                oc_event_signal(m_processEvent);
+            }
+#endif
             m_processThread.join();
         }
 
+#ifdef WITH_PROCESS_EVENT
+        if (m_processEvent)
+        {
+            // Unregistering waits for a signal in progress, so the event can be freed now.
+            OCRegisterProcessEvent(NULL);
+            oc_event_free(m_processEvent);
+            m_processEvent = NULL;
+        }
+#endif
+
         return OC_STACK_OK;
     }
 
@@ -296,10 +327,17 @@ namespace OC
         while(cLock && m_threadRun)
         {
             OCStackResult result;
+#ifdef WITH_PROCESS_EVENT
+            uint32_t nextEventTime = 0;
+#endif
 
             {
                 std::lock_guard<std::recursive_mutex> lock(*cLock);
+#ifdef WITH_PROCESS_EVENT
+                result = OCProcessEvent(&nextEventTime);
+#else
                 result = OCProcess();
+#endif
             }
 
             if(OC_STACK_ERROR == result)
@@ -308,7 +346,18 @@ namespace OC
                 // ...the value of variable result is simply ignored for now.
             }
 
+#ifdef WITH_PROCESS_EVENT
+            if (OC_STACK_OK != result)
+            {
+                // Keep polling until the stack can be processed.
+                nextEventTime = 10;
+            }
+
+            // Sleep until a message is received or a timer of the stack is due.
+            oc_event_wait_for(m_processEvent, nextEventTime);
+#else
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
+#endif
         }
     }
 
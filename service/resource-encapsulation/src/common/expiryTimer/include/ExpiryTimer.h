@@ -39,6 +39,27 @@ namespace OIC
             typedef std::function< void(Id) > Callback;
             typedef long long DelayInMilliSec;
 
+            /**
+             * Snapshot of the timer service shared by all timers.
+             */
+            struct Stats
+            {
+                /** Number of posted tasks not expired yet. */
+                size_t numOfPending;
+
+                /** Number of expired tasks waiting for a worker. */
+                size_t numOfQueued;
+
+                /** Highest numOfQueued seen so far. */
+                size_t maxNumOfQueued;
+
+                /** Time between expiry and start of the last callback. */
+                DelayInMilliSec lastLag;
+
+                /** Highest lastLag seen so far. */
+                DelayInMilliSec maxLag;
+            };
+
         public:
             ExpiryTimer();
             ~ExpiryTimer();
@@ -56,6 +77,16 @@ namespace OIC
             size_t getNumOfPending();
             size_t getNumOfPending() const;
 
+            /**
+             * Sets the number of worker threads running the callbacks of all timers.
+             * It must not be called from a callback.
+             *
+             * @throw RCSInvalidParameterException If numOfWorkers is zero.
+             */
+            static void setNumOfWorkers(size_t numOfWorkers);
+
+            static Stats getStats();
+
         private:
             void sweep();
 
@@ -98,6 +98,16 @@ namespace OIC
             return ret;
         }
 
+        void ExpiryTimer::setNumOfWorkers(size_t numOfWorkers)
+        {
+            ExpiryTimerImpl::getInstance()->setNumOfWorkers(numOfWorkers);
+        }
+
+        ExpiryTimer::Stats ExpiryTimer::getStats()
+        {
+            return ExpiryTimerImpl::getInstance()->getStats();
+        }
+
         void ExpiryTimer::sweep()
         {
             for (auto it = m_tasks.begin(); it != m_tasks.end();)
@@ -30,17 +30,30 @@ namespace OIC
         namespace
         {
             constexpr ExpiryTimerImpl::Id INVALID_ID{ 0U };
+
+            constexpr size_t DEFAULT_NUM_OF_WORKERS{ 4 };
         }
 
         ExpiryTimerImpl::ExpiryTimerImpl() :
                 m_tasks{ },
+                m_taskIds{ },
                 m_thread{ },
                 m_mutex{ },
                 m_cond{ },
                 m_stop{ false },
                 m_mt{ std::random_device{ }() },
-                m_dist{ }
+                m_dist{ },
+                m_expiredTasks{ },
+                m_workers{ },
+                m_numOfWorkers{ 0 },
+                m_workerMutex{ },
+                m_workerCond{ },
+                m_configMutex{ },
+                m_maxNumOfQueued{ 0 },
+                m_lastLag{ 0 },
+                m_maxLag{ 0 }
         {
+            setNumOfWorkers(DEFAULT_NUM_OF_WORKERS);
             m_thread = std::thread(&ExpiryTimerImpl::run, this);
         }
 
@@ -49,10 +62,24 @@ namespace OIC
             {
                 std::lock_guard< std::mutex > lock{ m_mutex };
                 m_tasks.clear();
+                m_taskIds.clear();
                 m_stop = true;
             }
             m_cond.notify_all();
             m_thread.join();
+
+            std::lock_guard< std::mutex > configLock{ m_configMutex };
+            {
+                std::lock_guard< std::mutex > lock{ m_workerMutex };
+                m_expiredTasks.clear();
+                m_numOfWorkers = 0;
+            }
+            m_workerCond.notify_all();
+
+            for (auto& worker : m_workers)
+            {
+                worker.join();
+            }
         }
 
         ExpiryTimerImpl* ExpiryTimerImpl::getInstance()
@@ -73,7 +100,7 @@ namespace OIC
                 throw RCSInvalidParameterException{ "callback is empty." };
             }
 
-            return addTask(convertToTime(Milliseconds{ delay }), std::move(cb), generateId());
+            return addTask(convertToTime(Milliseconds{ delay }), std::move(cb));
         }
 
         bool ExpiryTimerImpl::cancel(Id id)
@@ -82,15 +109,11 @@ namespace OIC
 
             std::lock_guard< std::mutex > lock{ m_mutex };
 
-            for(auto it = m_tasks.begin(); it != m_tasks.end(); ++it)
-            {
-                if(it->second->getId() == id)
-                {
-                    m_tasks.erase(it);
-                    return true;
-                }
-            }
-            return false;
+            auto it = m_taskIds.find(id);
+            if (it == m_taskIds.end()) return false;
+
+            eraseTask(it->second);
+            return true;
         }
 
         size_t ExpiryTimerImpl::cancelAll(
@@ -99,19 +122,65 @@ namespace OIC
             std::lock_guard< std::mutex > lock{ m_mutex };
             size_t erased { 0 };
 
-            for(auto it = m_tasks.begin(); it != m_tasks.end();)
+            for (const auto& task : tasks)
             {
-                if(tasks.count(it->second))
+                auto it = m_taskIds.find(task->getId());
+
+                if (it != m_taskIds.end() && it->second->second == task)
                 {
-                    it = m_tasks.erase(it);
+                    eraseTask(it->second);
                     ++erased;
                 }
-                else
+            }
+            return erased;
+        }
+
+        void ExpiryTimerImpl::setNumOfWorkers(size_t numOfWorkers)
+        {
+            if (numOfWorkers == 0)
+            {
+                throw RCSInvalidParameterException{ "number of workers can't be zero." };
+            }
+
+            std::lock_guard< std::mutex > configLock{ m_configMutex };
+            std::vector< std::thread > stopped;
+            {
+                std::lock_guard< std::mutex > lock{ m_workerMutex };
+                m_numOfWorkers = numOfWorkers;
+
+                while (m_workers.size() < numOfWorkers)
                 {
-                    ++it;
+                    m_workers.emplace_back(&ExpiryTimerImpl::runWorker, this, m_workers.size());
+                }
+                while (m_workers.size() > numOfWorkers)
+                {
+                    stopped.push_back(std::move(m_workers.back()));
+                    m_workers.pop_back();
                 }
             }
-            return erased;
+            m_workerCond.notify_all();
+
+            for (auto& worker : stopped)
+            {
+                worker.join();
+            }
+        }
+
+        ExpiryTimer::Stats ExpiryTimerImpl::getStats()
+        {
+            ExpiryTimer::Stats stats{ };
+            {
+                std::lock_guard< std::mutex > lock{ m_mutex };
+                stats.numOfPending = m_tasks.size();
+            }
+
+            std::lock_guard< std::mutex > lock{ m_workerMutex };
+            stats.numOfQueued = m_expiredTasks.size();
+            stats.maxNumOfQueued = m_maxNumOfQueued;
+            stats.lastLag = m_lastLag.count();
+            stats.maxLag = m_maxLag.count();
+
+            return stats;
         }
 
         ExpiryTimerImpl::Milliseconds ExpiryTimerImpl::convertToTime(Milliseconds delay)
@@ -120,53 +189,63 @@ namespace OIC
             return std::chrono::duration_cast< Milliseconds >(now.time_since_epoch()) + delay;
         }
 
-        std::shared_ptr< TimerTask > ExpiryTimerImpl::addTask(
-                Milliseconds delay, Callback cb, Id id)
+        std::shared_ptr< TimerTask > ExpiryTimerImpl::addTask(Milliseconds delay, Callback cb)
         {
             std::lock_guard< std::mutex > lock{ m_mutex };
 
-            auto newTask = std::make_shared< TimerTask >(id, std::move(cb));
-            m_tasks.insert({ delay, newTask });
-            m_cond.notify_all();
+            auto newTask = std::make_shared< TimerTask >(generateId(), std::move(cb));
+            auto it = m_tasks.insert({ delay, newTask });
+            m_taskIds[newTask->getId()] = it;
 
-            return newTask;
-        }
-
-        bool ExpiryTimerImpl::containsId(Id id) const
-        {
-            for (const auto& info : m_tasks)
+            if (it == m_tasks.begin())
             {
-                if (info.second->getId() == id) return true;
+                m_cond.notify_all();
             }
-            return false;
+
+            return newTask;
         }
 
         ExpiryTimerImpl::Id ExpiryTimerImpl::generateId()
         {
             Id newId = m_dist(m_mt);
 
-            std::lock_guard< std::mutex > lock{ m_mutex };
-
-            while (newId == INVALID_ID || containsId(newId))
+            while (newId == INVALID_ID || m_taskIds.count(newId))
             {
                 newId = m_dist(m_mt);
             }
             return newId;
         }
 
+        void ExpiryTimerImpl::eraseTask(TaskMap::iterator it)
+        {
+            m_taskIds.erase(it->second->getId());
+            m_tasks.erase(it);
+        }
+
         void ExpiryTimerImpl::executeExpired()
         {
             if (m_tasks.empty()) return;
 
             auto now = std::chrono::system_clock::now().time_since_epoch();
 
+            std::lock_guard< std::mutex > lock{ m_workerMutex };
+
             auto it = m_tasks.begin();
             for (; it != m_tasks.end() && it->first <= now; ++it)
             {
-                it->second->execute();
+                Id id{ it->second->getId() };
+
+                m_taskIds.erase(id);
+                m_expiredTasks.push_back({ id, it->second->expire(), it->first });
             }
 
             m_tasks.erase(m_tasks.begin(), it);
+
+            if (m_expiredTasks.size() > m_maxNumOfQueued)
+            {
+                m_maxNumOfQueued = m_expiredTasks.size();
+            }
+            m_workerCond.notify_all();
         }
 
         ExpiryTimerImpl::Milliseconds ExpiryTimerImpl::remainingTimeForNext() const
@@ -195,6 +274,34 @@ namespace OIC
             }
         }
 
+        void ExpiryTimerImpl::runWorker(size_t index)
+        {
+            std::unique_lock< std::mutex > lock{ m_workerMutex };
+
+            while (index < m_numOfWorkers)
+            {
+                if (m_expiredTasks.empty())
+                {
+                    m_workerCond.wait(lock);
+                    continue;
+                }
+
+                ExpiredTask task{ std::move(m_expiredTasks.front()) };
+                m_expiredTasks.pop_front();
+
+                m_lastLag = std::chrono::duration_cast< Milliseconds >(
+                        std::chrono::system_clock::now().time_since_epoch()) - task.expiryTime;
+                if (m_lastLag > m_maxLag)
+                {
+                    m_maxLag = m_lastLag;
+                }
+
+                lock.unlock();
+                task.callback(task.id);
+                lock.lock();
+            }
+        }
+
 
         TimerTask::TimerTask(ExpiryTimerImpl::Id id, ExpiryTimerImpl::Callback cb) :
             m_id{ id },
@@ -202,16 +309,14 @@ namespace OIC
         {
         }
 
-        void TimerTask::execute()
+        ExpiryTimerImpl::Callback TimerTask::expire()
         {
-            if (isExecuted()) return;
-
-            ExpiryTimerImpl::Id id { m_id };
             m_id = INVALID_ID;
 
-            std::thread(std::move(m_callback), id).detach();
-
+            ExpiryTimerImpl::Callback cb{ std::move(m_callback) };
             m_callback = ExpiryTimerImpl::Callback{ };
+
+            return cb;
         }
 
         bool TimerTask::isExecuted() const
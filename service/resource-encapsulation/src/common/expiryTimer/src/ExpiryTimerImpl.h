@@ -27,10 +27,15 @@
 #include <thread>
 #include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <random>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include <atomic>
 
+#include "ExpiryTimer.h"
+
 namespace OIC
 {
     namespace Service
@@ -47,6 +52,14 @@ namespace OIC
 
         private:
             typedef std::chrono::milliseconds Milliseconds;
+            typedef std::multimap< Milliseconds, std::shared_ptr< TimerTask > > TaskMap;
+
+            struct ExpiredTask
+            {
+                Id id;
+                Callback callback;
+                Milliseconds expiryTime;
+            };
 
         private:
             ExpiryTimerImpl();
@@ -63,17 +76,29 @@ namespace OIC
             bool cancel(Id);
             size_t cancelAll(const std::unordered_set< std::shared_ptr<TimerTask > >&);
 
+            /**
+             * Sets the number of worker threads running expired callbacks.
+             * It must not be called from a callback.
+             */
+            void setNumOfWorkers(size_t);
+
+            ExpiryTimer::Stats getStats();
+
         private:
             static Milliseconds convertToTime(Milliseconds);
 
-            std::shared_ptr< TimerTask > addTask(Milliseconds, Callback, Id);
+            std::shared_ptr< TimerTask > addTask(Milliseconds, Callback);
 
             /**
              * @pre The lock must be acquired with m_mutex.
              */
-            bool containsId(Id) const;
             Id generateId();
 
+            /**
+             * @pre The lock must be acquired with m_mutex.
+             */
+            void eraseTask(TaskMap::iterator);
+
             /**
              * @pre The lock must be acquired with m_mutex.
              */
@@ -85,9 +110,11 @@ namespace OIC
             Milliseconds remainingTimeForNext() const;
 
             void run();
+            void runWorker(size_t index);
 
         private:
-            std::multimap< Milliseconds, std::shared_ptr< TimerTask > > m_tasks;
+            TaskMap m_tasks;
+            std::unordered_map< Id, TaskMap::iterator > m_taskIds;
 
             std::thread m_thread;
             std::mutex m_mutex;
@@ -97,6 +124,16 @@ namespace OIC
             std::mt19937 m_mt;
             std::uniform_int_distribution< Id > m_dist;
 
+            std::deque< ExpiredTask > m_expiredTasks;
+            std::vector< std::thread > m_workers;
+            size_t m_numOfWorkers;
+            std::mutex m_workerMutex;
+            std::condition_variable m_workerCond;
+            std::mutex m_configMutex;
+
+            size_t m_maxNumOfQueued;
+            Milliseconds m_lastLag;
+            Milliseconds m_maxLag;
         };
 
         class TimerTask
@@ -114,7 +151,7 @@ namespace OIC
             ExpiryTimerImpl::Id getId() const;
 
         private:
-            void execute();
+            ExpiryTimerImpl::Callback expire();
 
         private:
             std::atomic< ExpiryTimerImpl::Id > m_id;
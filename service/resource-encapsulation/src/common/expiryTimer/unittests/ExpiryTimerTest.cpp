@@ -363,3 +363,43 @@ TEST_F(ExpiryTimerTest, AllTasksAreCancelledAfterTimerDestroyed)
 
     Wait(200);
 }
+
+TEST_F(ExpiryTimerTest, SetNumOfWorkersThrowsIfZero)
+{
+    ASSERT_THROW(ExpiryTimer::setNumOfWorkers(0), RCSException);
+}
+
+TEST_F(ExpiryTimerTest, CallbacksBeInvokedWithSingleWorker)
+{
+    constexpr int numOfTask{ 10 };
+    std::atomic_int called{ 0 };
+
+    ExpiryTimer::setNumOfWorkers(1);
+
+    for (int i=0; i<numOfTask; ++i)
+    {
+        timer.post(1,
+                [this, &called](ExpiryTimer::Id)
+                {
+                    if (++called == numOfTask) Proceed();
+                });
+    }
+
+    Wait();
+    ExpiryTimer::setNumOfWorkers(4);
+
+    ASSERT_EQ(numOfTask, called);
+}
+
+TEST_F(ExpiryTimerTest, StatsCountPendingTasks)
+{
+    FunctionObject* functor = mocks.Mock< FunctionObject >();
+
+    mocks.NeverCall(functor, FunctionObject::execute);
+
+    const size_t numOfPending = ExpiryTimer::getStats().numOfPending;
+
+    timer.post(1000, std::bind(&FunctionObject::execute, functor, std::placeholders::_1));
+
+    ASSERT_EQ(numOfPending + 1, ExpiryTimer::getStats().numOfPending);
+}